@@ -0,0 +1,994 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <settings/settings.h>
+#include <sys/byteorder.h>
+#include <date_time.h>
+#include <pm_config.h>
+
+#include "batch_store.h"
+#include "cloud/cloud_codec/cloud_codec.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(batch_store, CONFIG_BATCH_STORE_LOG_LEVEL);
+
+#define BATCH_STORE_SETTINGS_KEY		"batch_store"
+#define BATCH_STORE_SETTINGS_RELEASED_KEY	"released"
+
+/* FCB magic, "BTST". Bump the version if the record format changes. */
+#define BATCH_STORE_MAGIC	0x54535442
+#define BATCH_STORE_VERSION	1
+
+/* Flash pages are 4 kB on nRF91, and FCB supports up to 255 sectors. */
+#define SECTOR_COUNT_MAX	MIN(PM_BATCH_STORAGE_SIZE / 0x1000, UINT8_MAX)
+
+BUILD_ASSERT(SECTOR_COUNT_MAX >= 2, "The batch store partition must hold two flash pages");
+
+/* Record header: data type (1 byte), entry count (1 byte), sequence number (4 bytes, LE). */
+#define RECORD_HEADER_SIZE	6
+#define RECORD_TYPE_OFFSET	0
+#define RECORD_COUNT_OFFSET	1
+#define RECORD_SEQ_OFFSET	2
+
+/* Room left in the record buffer for padding the record to the flash write alignment. */
+#define RECORD_PADDING_MAX	8
+
+/* Fixed point scale factors for stored values. Coordinates are stored in units of 1e-7
+ * degrees, other decimal values in units of 0.01, which is the resolution of the values
+ * that are encoded by the cloud codecs.
+ */
+#define SCALE_COORDINATE	10000000.0
+#define SCALE_DECIMAL		100.0
+
+/* Modem dynamic data freshness flags. */
+#define MODEM_AREA_CODE_FRESH	BIT(0)
+#define MODEM_CELL_ID_FRESH	BIT(1)
+#define MODEM_RSRP_FRESH	BIT(2)
+#define MODEM_IP_ADDRESS_FRESH	BIT(3)
+#define MODEM_MCCMNC_FRESH	BIT(4)
+
+/* Number of delta-encoded values per entry, excluding the timestamp. */
+#define DELTA_VALUES_MAX	6
+
+/* Values of the previous entry in a record, which the values of the next entry are
+ * encoded relative to. Reset at the start of each record.
+ */
+struct delta_state {
+	int64_t ts;
+	int64_t val[DELTA_VALUES_MAX];
+};
+
+/* The writer and reader keep the first error and ignore further calls after it, so that
+ * entries can be encoded and decoded without checking every value.
+ */
+struct record_writer {
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+	int err;
+};
+
+struct record_reader {
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+	int err;
+};
+
+static struct fcb fcb;
+static struct flash_sector sectors[SECTOR_COUNT_MAX];
+static uint8_t record_buf[CONFIG_BATCH_STORE_RECORD_SIZE] __aligned(4);
+static bool initialized;
+
+/* Sequence number of the next record that is written and of the last released record. */
+static uint32_t next_seq;
+static uint32_t released_seq;
+
+/* Location of the last released record. Records are read from the location after it. */
+static struct fcb_entry read_loc;
+
+/* The record that has been read but not yet released. */
+static struct fcb_entry inflight_loc;
+static uint32_t inflight_seq;
+static bool inflight;
+
+static int settings_set(const char *key, size_t len_rd, settings_read_cb read_cb,
+			void *cb_arg)
+{
+	ssize_t len;
+
+	if (strcmp(key, BATCH_STORE_SETTINGS_RELEASED_KEY)) {
+		return -ENOENT;
+	}
+
+	if (len_rd != sizeof(released_seq)) {
+		return -EINVAL;
+	}
+
+	len = read_cb(cb_arg, &released_seq, sizeof(released_seq));
+	if (len != sizeof(released_seq)) {
+		LOG_ERR("Failed to read released sequence number");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(batch_store, BATCH_STORE_SETTINGS_KEY, NULL, settings_set,
+			       NULL, NULL);
+
+/* Returns true if seq is at or before ref, taking wraparound into account. */
+static bool seq_is_before_or_equal(uint32_t seq, uint32_t ref)
+{
+	return (int32_t)(seq - ref) <= 0;
+}
+
+static int64_t to_fixed(double val, double scale)
+{
+	double scaled = val * scale;
+
+	return (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+static double from_fixed(int64_t val, double scale)
+{
+	return (double)val / scale;
+}
+
+static void put_byte(struct record_writer *w, uint8_t val)
+{
+	if (w->err) {
+		return;
+	}
+
+	if (w->len >= w->size) {
+		w->err = -ENOBUFS;
+		return;
+	}
+
+	w->buf[w->len++] = val;
+}
+
+static void put_uvarint(struct record_writer *w, uint64_t val)
+{
+	while (val >= 0x80) {
+		put_byte(w, (uint8_t)(val | 0x80));
+		val >>= 7;
+	}
+
+	put_byte(w, (uint8_t)val);
+}
+
+/* Zigzag encoding keeps small negative deltas short. */
+static void put_varint(struct record_writer *w, int64_t val)
+{
+	put_uvarint(w, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+static void put_delta(struct record_writer *w, int64_t val, int64_t *prev)
+{
+	put_varint(w, val - *prev);
+	*prev = val;
+}
+
+static void put_str(struct record_writer *w, const char *str)
+{
+	size_t len = strlen(str);
+
+	put_uvarint(w, len);
+
+	for (size_t i = 0; i < len; i++) {
+		put_byte(w, str[i]);
+	}
+}
+
+static void put_timestamp(struct record_writer *w, int64_t ts, bool unix_ts,
+			  struct delta_state *prev)
+{
+	int err;
+
+	if (!unix_ts) {
+		err = date_time_uptime_to_unix_time_ms(&ts);
+		if (err && !w->err) {
+			w->err = err;
+		}
+	}
+
+	put_delta(w, ts, &prev->ts);
+}
+
+static uint8_t get_byte(struct record_reader *r)
+{
+	if (r->err) {
+		return 0;
+	}
+
+	if (r->pos >= r->len) {
+		r->err = -EBADMSG;
+		return 0;
+	}
+
+	return r->buf[r->pos++];
+}
+
+static uint64_t get_uvarint(struct record_reader *r)
+{
+	uint64_t val = 0;
+	uint8_t byte;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		byte = get_byte(r);
+		val |= (uint64_t)(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) {
+			return val;
+		}
+	}
+
+	r->err = -EBADMSG;
+	return 0;
+}
+
+static int64_t get_varint(struct record_reader *r)
+{
+	uint64_t val = get_uvarint(r);
+
+	return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+static int64_t get_delta(struct record_reader *r, int64_t *prev)
+{
+	*prev += get_varint(r);
+
+	return *prev;
+}
+
+static void get_str(struct record_reader *r, char *str, size_t size)
+{
+	uint64_t len = get_uvarint(r);
+
+	if (!r->err && len >= size) {
+		r->err = -EBADMSG;
+	}
+
+	if (r->err) {
+		str[0] = '\0';
+		return;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		str[i] = get_byte(r);
+	}
+
+	str[len] = '\0';
+}
+
+static size_t entry_size(enum batch_store_data_type type)
+{
+	switch (type) {
+	case BATCH_STORE_GPS:
+		return sizeof(struct cloud_data_gps);
+	case BATCH_STORE_SENSOR:
+		return sizeof(struct cloud_data_sensors);
+	case BATCH_STORE_MODEM_DYNAMIC:
+		return sizeof(struct cloud_data_modem_dynamic);
+	case BATCH_STORE_UI:
+		return sizeof(struct cloud_data_ui);
+	case BATCH_STORE_ACCELEROMETER:
+		return sizeof(struct cloud_data_accelerometer);
+	case BATCH_STORE_BATTERY:
+		return sizeof(struct cloud_data_battery);
+	default:
+		return 0;
+	}
+}
+
+static bool entry_queued(enum batch_store_data_type type, const void *entry)
+{
+	switch (type) {
+	case BATCH_STORE_GPS:
+		return ((const struct cloud_data_gps *)entry)->queued;
+	case BATCH_STORE_SENSOR:
+		return ((const struct cloud_data_sensors *)entry)->queued;
+	case BATCH_STORE_MODEM_DYNAMIC:
+		return ((const struct cloud_data_modem_dynamic *)entry)->queued;
+	case BATCH_STORE_UI:
+		return ((const struct cloud_data_ui *)entry)->queued;
+	case BATCH_STORE_ACCELEROMETER:
+		return ((const struct cloud_data_accelerometer *)entry)->queued;
+	case BATCH_STORE_BATTERY:
+		return ((const struct cloud_data_battery *)entry)->queued;
+	default:
+		return false;
+	}
+}
+
+static void entry_unqueue(enum batch_store_data_type type, void *entry)
+{
+	switch (type) {
+	case BATCH_STORE_GPS:
+		((struct cloud_data_gps *)entry)->queued = false;
+		break;
+	case BATCH_STORE_SENSOR:
+		((struct cloud_data_sensors *)entry)->queued = false;
+		break;
+	case BATCH_STORE_MODEM_DYNAMIC:
+		((struct cloud_data_modem_dynamic *)entry)->queued = false;
+		break;
+	case BATCH_STORE_UI:
+		((struct cloud_data_ui *)entry)->queued = false;
+		break;
+	case BATCH_STORE_ACCELEROMETER:
+		((struct cloud_data_accelerometer *)entry)->queued = false;
+		break;
+	case BATCH_STORE_BATTERY:
+		((struct cloud_data_battery *)entry)->queued = false;
+		break;
+	default:
+		break;
+	}
+}
+
+static void entry_encode(struct record_writer *w, enum batch_store_data_type type,
+			 const void *entry, struct delta_state *prev)
+{
+	switch (type) {
+	case BATCH_STORE_GPS: {
+		const struct cloud_data_gps *data = entry;
+
+		put_timestamp(w, data->gps_ts, data->unix_ts, prev);
+		put_byte(w, data->format);
+
+		if (data->format == CLOUD_CODEC_GPS_FORMAT_PVT) {
+			put_delta(w, to_fixed(data->pvt.lat, SCALE_COORDINATE), &prev->val[0]);
+			put_delta(w, to_fixed(data->pvt.longi, SCALE_COORDINATE), &prev->val[1]);
+			put_delta(w, to_fixed(data->pvt.alt, SCALE_DECIMAL), &prev->val[2]);
+			put_delta(w, to_fixed(data->pvt.acc, SCALE_DECIMAL), &prev->val[3]);
+			put_delta(w, to_fixed(data->pvt.spd, SCALE_DECIMAL), &prev->val[4]);
+			put_delta(w, to_fixed(data->pvt.hdg, SCALE_DECIMAL), &prev->val[5]);
+		} else {
+			put_str(w, data->nmea);
+		}
+		break;
+	}
+	case BATCH_STORE_SENSOR: {
+		const struct cloud_data_sensors *data = entry;
+
+		put_timestamp(w, data->env_ts, data->unix_ts, prev);
+		put_delta(w, to_fixed(data->temp, SCALE_DECIMAL), &prev->val[0]);
+		put_delta(w, to_fixed(data->hum, SCALE_DECIMAL), &prev->val[1]);
+		break;
+	}
+	case BATCH_STORE_MODEM_DYNAMIC: {
+		const struct cloud_data_modem_dynamic *data = entry;
+		uint8_t flags = (data->area_code_fresh ? MODEM_AREA_CODE_FRESH : 0) |
+				(data->cell_id_fresh ? MODEM_CELL_ID_FRESH : 0) |
+				(data->rsrp_fresh ? MODEM_RSRP_FRESH : 0) |
+				(data->ip_address_fresh ? MODEM_IP_ADDRESS_FRESH : 0) |
+				(data->mccmnc_fresh ? MODEM_MCCMNC_FRESH : 0);
+
+		put_timestamp(w, data->ts, data->unix_ts, prev);
+		put_byte(w, flags);
+
+		if (flags & MODEM_AREA_CODE_FRESH) {
+			put_delta(w, data->area, &prev->val[0]);
+		}
+
+		if (flags & MODEM_CELL_ID_FRESH) {
+			put_delta(w, data->cell, &prev->val[1]);
+		}
+
+		if (flags & MODEM_RSRP_FRESH) {
+			put_delta(w, data->rsrp, &prev->val[2]);
+		}
+
+		if (flags & MODEM_IP_ADDRESS_FRESH) {
+			put_str(w, data->ip);
+		}
+
+		if (flags & MODEM_MCCMNC_FRESH) {
+			put_str(w, data->mccmnc);
+		}
+		break;
+	}
+	case BATCH_STORE_UI: {
+		const struct cloud_data_ui *data = entry;
+
+		put_timestamp(w, data->btn_ts, data->unix_ts, prev);
+		put_delta(w, data->btn, &prev->val[0]);
+		break;
+	}
+	case BATCH_STORE_ACCELEROMETER: {
+		const struct cloud_data_accelerometer *data = entry;
+
+		put_timestamp(w, data->ts, data->unix_ts, prev);
+
+		for (size_t i = 0; i < ARRAY_SIZE(data->values); i++) {
+			put_delta(w, to_fixed(data->values[i], SCALE_DECIMAL), &prev->val[i]);
+		}
+		break;
+	}
+	case BATCH_STORE_BATTERY: {
+		const struct cloud_data_battery *data = entry;
+
+		put_timestamp(w, data->bat_ts, data->unix_ts, prev);
+		put_delta(w, data->bat, &prev->val[0]);
+		break;
+	}
+	default:
+		w->err = -EINVAL;
+		break;
+	}
+}
+
+static void entry_decode(struct record_reader *r, enum batch_store_data_type type,
+			 void *entry, struct delta_state *prev)
+{
+	switch (type) {
+	case BATCH_STORE_GPS: {
+		struct cloud_data_gps *data = entry;
+
+		data->gps_ts = get_delta(r, &prev->ts);
+		data->format = get_byte(r);
+
+		if (data->format == CLOUD_CODEC_GPS_FORMAT_PVT) {
+			data->pvt.lat = from_fixed(get_delta(r, &prev->val[0]), SCALE_COORDINATE);
+			data->pvt.longi = from_fixed(get_delta(r, &prev->val[1]),
+						     SCALE_COORDINATE);
+			data->pvt.alt = from_fixed(get_delta(r, &prev->val[2]), SCALE_DECIMAL);
+			data->pvt.acc = from_fixed(get_delta(r, &prev->val[3]), SCALE_DECIMAL);
+			data->pvt.spd = from_fixed(get_delta(r, &prev->val[4]), SCALE_DECIMAL);
+			data->pvt.hdg = from_fixed(get_delta(r, &prev->val[5]), SCALE_DECIMAL);
+		} else {
+			get_str(r, data->nmea, sizeof(data->nmea));
+		}
+
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	case BATCH_STORE_SENSOR: {
+		struct cloud_data_sensors *data = entry;
+
+		data->env_ts = get_delta(r, &prev->ts);
+		data->temp = from_fixed(get_delta(r, &prev->val[0]), SCALE_DECIMAL);
+		data->hum = from_fixed(get_delta(r, &prev->val[1]), SCALE_DECIMAL);
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	case BATCH_STORE_MODEM_DYNAMIC: {
+		struct cloud_data_modem_dynamic *data = entry;
+		uint8_t flags;
+
+		data->ts = get_delta(r, &prev->ts);
+		flags = get_byte(r);
+
+		if (flags & MODEM_AREA_CODE_FRESH) {
+			data->area = get_delta(r, &prev->val[0]);
+			data->area_code_fresh = true;
+		}
+
+		if (flags & MODEM_CELL_ID_FRESH) {
+			data->cell = get_delta(r, &prev->val[1]);
+			data->cell_id_fresh = true;
+		}
+
+		if (flags & MODEM_RSRP_FRESH) {
+			data->rsrp = get_delta(r, &prev->val[2]);
+			data->rsrp_fresh = true;
+		}
+
+		if (flags & MODEM_IP_ADDRESS_FRESH) {
+			get_str(r, data->ip, sizeof(data->ip));
+			data->ip_address_fresh = true;
+		}
+
+		if (flags & MODEM_MCCMNC_FRESH) {
+			get_str(r, data->mccmnc, sizeof(data->mccmnc));
+			data->mccmnc_fresh = true;
+		}
+
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	case BATCH_STORE_UI: {
+		struct cloud_data_ui *data = entry;
+
+		data->btn_ts = get_delta(r, &prev->ts);
+		data->btn = get_delta(r, &prev->val[0]);
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	case BATCH_STORE_ACCELEROMETER: {
+		struct cloud_data_accelerometer *data = entry;
+
+		data->ts = get_delta(r, &prev->ts);
+
+		for (size_t i = 0; i < ARRAY_SIZE(data->values); i++) {
+			data->values[i] = from_fixed(get_delta(r, &prev->val[i]), SCALE_DECIMAL);
+		}
+
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	case BATCH_STORE_BATTERY: {
+		struct cloud_data_battery *data = entry;
+
+		data->bat_ts = get_delta(r, &prev->ts);
+		data->bat = get_delta(r, &prev->val[0]);
+		data->queued = true;
+		data->unix_ts = true;
+		break;
+	}
+	default:
+		r->err = -EINVAL;
+		break;
+	}
+}
+
+static void read_loc_reset(void)
+{
+	memset(&read_loc, 0, sizeof(read_loc));
+}
+
+static int record_seq_read(const struct fcb_entry *loc, uint32_t *seq)
+{
+	int err;
+	uint8_t header[RECORD_HEADER_SIZE];
+
+	if (loc->fe_data_len < RECORD_HEADER_SIZE) {
+		return -EBADMSG;
+	}
+
+	err = flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)), header, sizeof(header));
+	if (err) {
+		return err;
+	}
+
+	*seq = sys_get_le32(&header[RECORD_SEQ_OFFSET]);
+
+	return 0;
+}
+
+static int sector_unreleased_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	bool *unreleased = arg;
+	uint32_t seq;
+	int err;
+
+	err = record_seq_read(&loc_ctx->loc, &seq);
+	if (err) {
+		/* Records that can not be read are never released, do not keep the sector
+		 * because of them.
+		 */
+		return 0;
+	}
+
+	if (!seq_is_before_or_equal(seq, released_seq)) {
+		*unreleased = true;
+		return 1;
+	}
+
+	return 0;
+}
+
+static void sector_rotated(struct flash_sector *sector)
+{
+	/* The read location may point into the erased sector, read from the oldest record
+	 * and skip released records instead.
+	 */
+	read_loc_reset();
+
+	if (inflight && inflight_loc.fe_sector == sector) {
+		LOG_WRN("Record %u was erased while being sent", inflight_seq);
+		inflight_loc.fe_sector = NULL;
+	}
+}
+
+/* Erase the oldest sectors as long as all records in them have been released. */
+static void trim(void)
+{
+	int err;
+
+	while (fcb.f_oldest != fcb.f_active.fe_sector) {
+		struct flash_sector *oldest = fcb.f_oldest;
+		bool unreleased = false;
+
+		err = fcb_walk(&fcb, oldest, sector_unreleased_cb, &unreleased);
+		if (err || unreleased) {
+			return;
+		}
+
+		err = fcb_rotate(&fcb);
+		if (err) {
+			LOG_ERR("fcb_rotate, error: %d", err);
+			return;
+		}
+
+		sector_rotated(oldest);
+		LOG_DBG("Erased released batch store sector");
+	}
+}
+
+static int record_write(enum batch_store_data_type type, struct record_writer *w,
+			size_t count)
+{
+	int err;
+	struct fcb_entry loc;
+	struct flash_sector *oldest;
+	size_t len = ROUND_UP(w->len, fcb.f_align);
+
+	record_buf[RECORD_TYPE_OFFSET] = type;
+	record_buf[RECORD_COUNT_OFFSET] = count;
+	sys_put_le32(next_seq, &record_buf[RECORD_SEQ_OFFSET]);
+	memset(&record_buf[w->len], 0, len - w->len);
+
+	err = fcb_append(&fcb, len, &loc);
+	if (err == -ENOSPC) {
+		LOG_WRN("Batch store is full, erasing the oldest stored entries");
+
+		oldest = fcb.f_oldest;
+
+		err = fcb_rotate(&fcb);
+		if (err) {
+			LOG_ERR("fcb_rotate, error: %d", err);
+			return err;
+		}
+
+		sector_rotated(oldest);
+
+		err = fcb_append(&fcb, len, &loc);
+	}
+
+	if (err) {
+		LOG_ERR("fcb_append, error: %d", err);
+		return err;
+	}
+
+	err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), record_buf, len);
+	if (err) {
+		LOG_ERR("flash_area_write, error: %d", err);
+		return err;
+	}
+
+	err = fcb_append_finish(&fcb, &loc);
+	if (err) {
+		LOG_ERR("fcb_append_finish, error: %d", err);
+		return err;
+	}
+
+	LOG_DBG("Record %u stored, type: %d, entries: %d, bytes: %d", next_seq, type, count,
+		len);
+
+	next_seq++;
+
+	return 0;
+}
+
+static void record_start(struct record_writer *w, struct delta_state *prev)
+{
+	w->buf = record_buf;
+	w->size = sizeof(record_buf) - RECORD_PADDING_MAX;
+	w->len = RECORD_HEADER_SIZE;
+	w->err = 0;
+
+	memset(prev, 0, sizeof(*prev));
+}
+
+int batch_store_ringbuffer_add(enum batch_store_data_type type, void *buf, size_t buf_count,
+			       int head)
+{
+	int err;
+	size_t count = 0;
+	size_t size = entry_size(type);
+	uint8_t *entries = buf;
+	struct record_writer w;
+	struct delta_state prev;
+
+	if (buf == NULL || size == 0 || buf_count == 0) {
+		return -EINVAL;
+	}
+
+	if (!entry_queued(type, &entries[((head + 1) % buf_count) * size])) {
+		return 0;
+	}
+
+	if (!initialized) {
+		return -ENODEV;
+	}
+
+	/* Stored entries are timestamped with UNIX time so that they stay valid across
+	 * reboots.
+	 */
+	if (!date_time_is_valid()) {
+		return -EAGAIN;
+	}
+
+	record_start(&w, &prev);
+
+	/* Store entries oldest first, starting after the head. */
+	for (size_t i = 1; i <= buf_count; i++) {
+		void *entry = &entries[((head + i) % buf_count) * size];
+		size_t len = w.len;
+		struct delta_state prev_saved = prev;
+
+		if (!entry_queued(type, entry)) {
+			continue;
+		}
+
+		entry_encode(&w, type, entry, &prev);
+
+		if ((w.err == -ENOBUFS) && (count > 0)) {
+			/* Write the entries that fit and encode this one into a new record. */
+			w.len = len;
+			w.err = 0;
+			prev = prev_saved;
+
+			err = record_write(type, &w, count);
+			if (err) {
+				return err;
+			}
+
+			count = 0;
+			record_start(&w, &prev);
+			entry_encode(&w, type, entry, &prev);
+		}
+
+		if (w.err == -ENOBUFS) {
+			/* Drop the entry, it would fail to be stored every time. */
+			LOG_ERR("Entry does not fit in a record, dropping it");
+
+			entry_unqueue(type, entry);
+			w.len = len;
+			w.err = 0;
+			prev = prev_saved;
+			continue;
+		} else if (w.err) {
+			LOG_ERR("Failed to encode entry, error: %d", w.err);
+			return w.err;
+		}
+
+		entry_unqueue(type, entry);
+		count++;
+
+		if (count == UINT8_MAX) {
+			err = record_write(type, &w, count);
+			if (err) {
+				return err;
+			}
+
+			count = 0;
+			record_start(&w, &prev);
+		}
+	}
+
+	if (count > 0) {
+		return record_write(type, &w, count);
+	}
+
+	return 0;
+}
+
+static int record_decode(const uint8_t *data, size_t len, struct batch_store_chunk *chunk)
+{
+	struct record_reader r = {
+		.buf = data,
+		.len = len,
+		.pos = RECORD_HEADER_SIZE
+	};
+	struct delta_state prev = {0};
+	enum batch_store_data_type type = data[RECORD_TYPE_OFFSET];
+	size_t count = data[RECORD_COUNT_OFFSET];
+	size_t size = entry_size(type);
+	uint8_t *entries;
+
+	if (size == 0 || count == 0) {
+		return -EBADMSG;
+	}
+
+	entries = k_calloc(count, size);
+	if (entries == NULL) {
+		return -ENOMEM;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		entry_decode(&r, type, &entries[i * size], &prev);
+	}
+
+	if (r.err) {
+		k_free(entries);
+		return r.err;
+	}
+
+	chunk->type = type;
+	chunk->buf = entries;
+	chunk->count = count;
+
+	return 0;
+}
+
+static int released_seq_save(uint32_t seq)
+{
+	int err;
+
+	released_seq = seq;
+
+	err = settings_save_one(BATCH_STORE_SETTINGS_KEY "/" BATCH_STORE_SETTINGS_RELEASED_KEY,
+				&released_seq, sizeof(released_seq));
+	if (err) {
+		LOG_WRN("settings_save_one, error: %d", err);
+		return err;
+	}
+
+	trim();
+
+	return 0;
+}
+
+int batch_store_chunk_get(struct batch_store_chunk *chunk)
+{
+	int err;
+	uint32_t seq;
+	struct fcb_entry loc = read_loc;
+
+	if (chunk == NULL) {
+		return -EINVAL;
+	}
+
+	if (!initialized) {
+		return -ENODEV;
+	}
+
+	if (inflight) {
+		return -EBUSY;
+	}
+
+	while (fcb_getnext(&fcb, &loc) == 0) {
+		if ((loc.fe_data_len < RECORD_HEADER_SIZE) ||
+		    (loc.fe_data_len > sizeof(record_buf))) {
+			LOG_WRN("Skipping record of invalid length: %d", loc.fe_data_len);
+			continue;
+		}
+
+		err = flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), record_buf,
+				      loc.fe_data_len);
+		if (err) {
+			LOG_ERR("flash_area_read, error: %d", err);
+			return err;
+		}
+
+		seq = sys_get_le32(&record_buf[RECORD_SEQ_OFFSET]);
+
+		if (seq_is_before_or_equal(seq, released_seq)) {
+			read_loc = loc;
+			continue;
+		}
+
+		err = record_decode(record_buf, loc.fe_data_len, chunk);
+		if (err == -ENOMEM) {
+			return err;
+		} else if (err) {
+			/* All earlier records are released, release this one as well so that
+			 * its sector can be erased.
+			 */
+			LOG_WRN("Dropping record %u that could not be decoded, error: %d",
+				seq, err);
+
+			read_loc = loc;
+			released_seq_save(seq);
+
+			/* Releasing may have erased the sector of the record. */
+			loc = read_loc;
+			continue;
+		}
+
+		inflight_loc = loc;
+		inflight_seq = seq;
+		inflight = true;
+
+		LOG_DBG("Record %u read, type: %d, entries: %d", seq, chunk->type,
+			chunk->count);
+
+		return 0;
+	}
+
+	return -ENODATA;
+}
+
+void batch_store_chunk_free(struct batch_store_chunk *chunk)
+{
+	k_free(chunk->buf);
+	chunk->buf = NULL;
+	chunk->count = 0;
+}
+
+int batch_store_chunk_release(void)
+{
+	if (!inflight) {
+		return -EINVAL;
+	}
+
+	inflight = false;
+
+	/* The sector of the record is gone if the store filled up while it was being sent. */
+	if (inflight_loc.fe_sector != NULL) {
+		read_loc = inflight_loc;
+	}
+
+	return released_seq_save(inflight_seq);
+}
+
+void batch_store_chunk_rewind(void)
+{
+	inflight = false;
+}
+
+int batch_store_init(void)
+{
+	int err;
+	uint32_t sector_count = ARRAY_SIZE(sectors);
+	struct fcb_entry loc = {0};
+	uint32_t seq;
+	uint32_t seq_max = 0;
+	bool found = false;
+
+	err = settings_load_subtree(BATCH_STORE_SETTINGS_KEY);
+	if (err) {
+		LOG_ERR("settings_load_subtree, error: %d", err);
+		return err;
+	}
+
+	err = flash_area_get_sectors(PM_BATCH_STORAGE_ID, &sector_count, sectors);
+	if (err) {
+		LOG_ERR("flash_area_get_sectors, error: %d", err);
+		return err;
+	}
+
+	fcb.f_magic = BATCH_STORE_MAGIC;
+	fcb.f_version = BATCH_STORE_VERSION;
+	fcb.f_sector_cnt = sector_count;
+	fcb.f_scratch_cnt = 0;
+	fcb.f_sectors = sectors;
+
+	err = fcb_init(PM_BATCH_STORAGE_ID, &fcb);
+	if (err) {
+		LOG_ERR("fcb_init, error: %d", err);
+		return err;
+	}
+
+	/* Continue numbering after the newest stored record. */
+	while (fcb_getnext(&fcb, &loc) == 0) {
+		if (record_seq_read(&loc, &seq)) {
+			continue;
+		}
+
+		if (!found || !seq_is_before_or_equal(seq, seq_max)) {
+			seq_max = seq;
+			found = true;
+		}
+	}
+
+	next_seq = (found && !seq_is_before_or_equal(seq_max, released_seq)) ?
+		   seq_max + 1 : released_seq + 1;
+
+	read_loc_reset();
+	initialized = true;
+
+	LOG_DBG("Batch store initialized, %d sectors, next record: %u, last released: %u",
+		sector_count, next_seq, released_seq);
+
+	trim();
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ *@brief Batch store library header.
+ */
+
+#ifndef BATCH_STORE_H__
+#define BATCH_STORE_H__
+
+#include <zephyr.h>
+#include <stdint.h>
+
+/**@file
+ *
+ * @defgroup batch_store Batch store
+ * @brief    Library that persists data module ringbuffer entries in flash.
+ *
+ * Entries are stored in records in a flash circular buffer. Each record holds entries of
+ * one data type. Timestamps are converted to UNIX time and stored as deltas from the
+ * previous entry in the record, numeric values are stored as deltas in fixed point.
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Data types that can be stored. */
+enum batch_store_data_type {
+	BATCH_STORE_GPS,
+	BATCH_STORE_SENSOR,
+	BATCH_STORE_MODEM_DYNAMIC,
+	BATCH_STORE_UI,
+	BATCH_STORE_ACCELEROMETER,
+	BATCH_STORE_BATTERY,
+
+	BATCH_STORE_TYPE_COUNT
+};
+
+/** @brief Structure containing the entries of a record read from the store. */
+struct batch_store_chunk {
+	/** Data type of the entries. */
+	enum batch_store_data_type type;
+	/** Array of entries, of the cloud codec structure matching the data type. All entries
+	 *  are queued and have UNIX timestamps. Allocated on the heap.
+	 */
+	void *buf;
+	/** Number of entries in the array. */
+	size_t count;
+};
+
+/**
+ * @brief Initialize the batch store. Restores the position of the last uploaded record from
+ *	  settings. Settings must be initialized before this function is called.
+ *
+ * @return 0 on success or negative error value on failure.
+ */
+int batch_store_init(void);
+
+/**
+ * @brief Move the entries of a full ringbuffer to the store.
+ *
+ * The ringbuffer is full when the entry after the head is still queued, meaning that the
+ * next entry would overwrite data that has not been sent. In that case all queued entries
+ * are encoded into one or more records, oldest first, and unqueued. Otherwise the function
+ * does nothing.
+ *
+ * @param[in] type Data type of the ringbuffer.
+ * @param[in, out] buf Ringbuffer, of the cloud codec structure matching the data type.
+ * @param[in] buf_count Number of entries in the ringbuffer.
+ * @param[in] head Index of the newest entry in the ringbuffer.
+ *
+ * @retval 0 If the ringbuffer is not full or the entries were stored.
+ * @retval -EAGAIN If the entries can not be stored because there is no valid date time
+ *		   to timestamp them with.
+ * @return Otherwise a negative error value.
+ */
+int batch_store_ringbuffer_add(enum batch_store_data_type type, void *buf, size_t buf_count,
+			       int head);
+
+/**
+ * @brief Read the oldest record that has not been released from the store.
+ *
+ * Only one record can be read at a time. The record must be released with
+ * @ref batch_store_chunk_release when it has been sent, or rewound with
+ * @ref batch_store_chunk_rewind if it is not going to be sent.
+ *
+ * @param[out] chunk Entries of the record. The entry array must be freed with
+ *		     @ref batch_store_chunk_free.
+ *
+ * @retval 0 If a record was read.
+ * @retval -ENODATA If there are no stored records.
+ * @retval -EBUSY If the previously read record has not been released or rewound.
+ * @return Otherwise a negative error value.
+ */
+int batch_store_chunk_get(struct batch_store_chunk *chunk);
+
+/**
+ * @brief Free the entry array of a chunk.
+ *
+ * @param[in] chunk Chunk returned by @ref batch_store_chunk_get.
+ */
+void batch_store_chunk_free(struct batch_store_chunk *chunk);
+
+/**
+ * @brief Release the record last read from the store after it has been sent. The flash
+ *	  sector holding the record is erased when all records in it are released.
+ *
+ * @return 0 on success or negative error value on failure.
+ */
+int batch_store_chunk_release(void);
+
+/**
+ * @brief Rewind the store so that the record last read is read again by the next call to
+ *	  @ref batch_store_chunk_get.
+ */
+void batch_store_chunk_rewind(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_STORE_H__ */
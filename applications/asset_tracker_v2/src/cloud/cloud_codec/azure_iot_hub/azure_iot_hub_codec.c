@@ -411,98 +411,22 @@ int cloud_codec_encode_batch_data(
 				size_t accel_buf_count,
 				size_t bat_buf_count)
 {
-	int err;
-	char *buffer;
-	bool object_added = false;
-
-	cJSON *root_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_MODEM_DYNAMIC,
-					 modem_dyn_buf, modem_dyn_buf_count,
-					 DATA_MODEM_DYNAMIC);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_GPS,
-					 gps_buf, gps_buf_count,
-					 DATA_GPS);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_SENSOR,
-					 sensor_buf, sensor_buf_count,
-					 DATA_ENVIRONMENTALS);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_UI,
-					 ui_buf, ui_buf_count,
-					 DATA_BUTTON);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_BATTERY,
-					 bat_buf, bat_buf_count,
-					 DATA_BATTERY);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	err = json_common_batch_data_add(root_obj, JSON_COMMON_ACCELEROMETER,
-					 accel_buf, accel_buf_count,
-					 DATA_MOVEMENT);
-	if (err == 0) {
-		object_added = true;
-	} else if (err != -ENODATA) {
-		goto exit;
-	}
-
-	if (!object_added) {
-		err = -ENODATA;
-		LOG_DBG("No data to encode, JSON string empty...");
-		goto exit;
-	} else {
-		/* At this point err can be either 0 or -ENODATA. Explicitly set err to 0 if
-		 * objects has been added to the rootj object.
-		 */
-		err = 0;
-	}
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
-
-		err = -ENOMEM;
-		goto exit;
-	}
-
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded batch message:\n", root_obj);
-	}
-
-	output->buf = buffer;
-	output->len = strlen(buffer);
-
-exit:
-	cJSON_Delete(root_obj);
-	return err;
+	struct json_common_batch_buf bufs[] = {
+		{ JSON_COMMON_MODEM_DYNAMIC, modem_dyn_buf, modem_dyn_buf_count,
+		  DATA_MODEM_DYNAMIC },
+		{ JSON_COMMON_GPS, gps_buf, gps_buf_count, DATA_GPS },
+		{ JSON_COMMON_SENSOR, sensor_buf, sensor_buf_count, DATA_ENVIRONMENTALS },
+		{ JSON_COMMON_UI, ui_buf, ui_buf_count, DATA_BUTTON },
+		{ JSON_COMMON_BATTERY, bat_buf, bat_buf_count, DATA_BATTERY },
+		{ JSON_COMMON_ACCELEROMETER, accel_buf, accel_buf_count, DATA_MOVEMENT },
+	};
+	struct json_common_batch batch = {
+		.bufs = bufs,
+		.count = ARRAY_SIZE(bufs),
+	};
+
+	/* Batch messages are written directly to the output buffer, without building a
+	 * cJSON tree.
+	 */
+	return json_common_batch_encode(output, &batch);
 }
@@ -36,6 +36,10 @@ struct cloud_data_battery {
 	int64_t bat_ts;
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 };
 
 struct cloud_data_gps_pvt {
@@ -79,6 +83,10 @@ struct cloud_data_gps {
 
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 };
 
 /** Structure containing boolean variables used to enable/disable inclusion of the corresponding
@@ -118,6 +126,10 @@ struct cloud_data_accelerometer {
 	double values[3];
 	/** Flag signifying that the data entry is to be published. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 };
 
 struct cloud_data_sensors {
@@ -129,6 +141,10 @@ struct cloud_data_sensors {
 	double hum;
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 };
 
 struct cloud_data_modem_static {
@@ -169,6 +185,10 @@ struct cloud_data_modem_dynamic {
 	char mccmnc[7];
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 
 	/** Flags to signify if the corresponding data value is fresh and can be used. */
 	bool area_code_fresh	: 1;
@@ -185,6 +205,10 @@ struct cloud_data_ui {
 	int64_t btn_ts;
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
+	/** Flag signifying that the timestamp is UNIX time. Set for entries restored from
+	 *  the batch store.
+	 */
+	bool unix_ts : 1;
 };
 
 struct cloud_codec_data {
@@ -7,6 +7,7 @@
 #include <zephyr.h>
 #include <cJSON.h>
 #include <date_time.h>
+#include <json_writer.h>
 
 #include "cloud_codec.h"
 #include "json_common.h"
@@ -16,6 +17,16 @@
 #include <logging/log.h>
 LOG_MODULE_REGISTER(json_common, CONFIG_CLOUD_CODEC_LOG_LEVEL);
 
+static int timestamp_to_unix(int64_t *ts, bool unix_ts)
+{
+	/* Entries restored from the batch store are timestamped with UNIX time already. */
+	if (unix_ts) {
+		return 0;
+	}
+
+	return date_time_uptime_to_unix_time_ms(ts);
+}
+
 static int op_code_handle(cJSON *parent, enum json_common_op_code op,
 			  const char *object_label, cJSON *child, cJSON **parent_ref)
 {
@@ -171,7 +182,7 @@ int json_common_modem_dynamic_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->ts);
+	err = timestamp_to_unix(&data->ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -284,7 +295,7 @@ int json_common_sensor_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->env_ts);
+	err = timestamp_to_unix(&data->env_ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -347,7 +358,7 @@ int json_common_gps_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->gps_ts);
+	err = timestamp_to_unix(&data->gps_ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -452,7 +463,7 @@ int json_common_accel_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->ts);
+	err = timestamp_to_unix(&data->ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -521,7 +532,7 @@ int json_common_ui_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->btn_ts);
+	err = timestamp_to_unix(&data->btn_ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -890,7 +901,7 @@ int json_common_battery_data_add(cJSON *parent,
 		return -ENODATA;
 	}
 
-	err = date_time_uptime_to_unix_time_ms(&data->bat_ts);
+	err = timestamp_to_unix(&data->bat_ts, data->unix_ts);
 	if (err) {
 		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 		return err;
@@ -1198,3 +1209,405 @@ int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type,
 	json_add_obj(parent, object_label, array_obj);
 	return 0;
 }
+
+/* Close an entry written to a batch message. If the entry does not fit in the message it is
+ * removed from the output again.
+ */
+static int entry_end(struct json_writer *w, const struct json_writer_mark *mark)
+{
+	int err = w->err;
+
+	if (json_writer_fits(w)) {
+		return 0;
+	}
+
+	json_writer_rewind(w, mark);
+
+	return err ? err : -ENOBUFS;
+}
+
+static int modem_dynamic_data_write(struct json_writer *w, struct cloud_data_modem_dynamic *data)
+{
+	int err;
+	int64_t ts = data->ts;
+	uint32_t mccmnc = 0;
+	char *end_ptr;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if (!data->rsrp_fresh && !data->area_code_fresh && !data->mccmnc_fresh &&
+	    !data->cell_id_fresh && !data->ip_address_fresh) {
+		if (!json_writer_dry_run(w)) {
+			data->queued = false;
+			LOG_WRN("No valid dynamic modem data values present, entry unqueued");
+		}
+		return -ENODATA;
+	}
+
+	if (data->mccmnc_fresh) {
+		/* Convert mccmnc to unsigned long integer. */
+		errno = 0;
+		mccmnc = strtoul(data->mccmnc, &end_ptr, 10);
+
+		if ((errno == ERANGE) || (*end_ptr != '\0')) {
+			LOG_ERR("MCCMNC string could not be converted.");
+			return -ENOTEMPTY;
+		}
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, DATA_VALUE);
+
+	if (data->rsrp_fresh) {
+		json_writer_num(w, MODEM_RSRP, data->rsrp);
+	}
+
+	if (data->area_code_fresh) {
+		json_writer_num(w, MODEM_AREA_CODE, data->area);
+	}
+
+	if (data->mccmnc_fresh) {
+		json_writer_num(w, MODEM_MCCMNC, mccmnc);
+	}
+
+	if (data->cell_id_fresh) {
+		json_writer_num(w, MODEM_CELL_ID, data->cell);
+	}
+
+	if (data->ip_address_fresh) {
+		json_writer_str(w, MODEM_IP_ADDRESS, data->ip);
+	}
+
+	json_writer_obj_end(w);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int sensor_data_write(struct json_writer *w, struct cloud_data_sensors *data)
+{
+	int err;
+	int64_t ts = data->env_ts;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, DATA_VALUE);
+	json_writer_num(w, DATA_TEMPERATURE, data->temp);
+	json_writer_num(w, DATA_HUMID, data->hum);
+	json_writer_obj_end(w);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int gps_data_write(struct json_writer *w, struct cloud_data_gps *data)
+{
+	int err;
+	int64_t ts = data->gps_ts;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	if ((data->format != CLOUD_CODEC_GPS_FORMAT_PVT) &&
+	    (data->format != CLOUD_CODEC_GPS_FORMAT_NMEA)) {
+		LOG_WRN("GPS data format not set");
+		return -EINVAL;
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+
+	if (data->format == CLOUD_CODEC_GPS_FORMAT_PVT) {
+		json_writer_obj_start(w, DATA_VALUE);
+		json_writer_num(w, DATA_GPS_LONGITUDE, data->pvt.longi);
+		json_writer_num(w, DATA_GPS_LATITUDE, data->pvt.lat);
+		json_writer_num(w, DATA_GPS_ACCURACY, data->pvt.acc);
+		json_writer_num(w, DATA_GPS_ALTITUDE, data->pvt.alt);
+		json_writer_num(w, DATA_GPS_SPEED, data->pvt.spd);
+		json_writer_num(w, DATA_GPS_HEADING, data->pvt.hdg);
+		json_writer_obj_end(w);
+	} else {
+		json_writer_str(w, DATA_VALUE, data->nmea);
+	}
+
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int accel_data_write(struct json_writer *w, struct cloud_data_accelerometer *data)
+{
+	int err;
+	int64_t ts = data->ts;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, DATA_VALUE);
+	json_writer_num(w, DATA_MOVEMENT_X, data->values[0]);
+	json_writer_num(w, DATA_MOVEMENT_Y, data->values[1]);
+	json_writer_num(w, DATA_MOVEMENT_Z, data->values[2]);
+	json_writer_obj_end(w);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int ui_data_write(struct json_writer *w, struct cloud_data_ui *data)
+{
+	int err;
+	int64_t ts = data->btn_ts;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+	json_writer_num(w, DATA_VALUE, data->btn);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+static int battery_data_write(struct json_writer *w, struct cloud_data_battery *data)
+{
+	int err;
+	int64_t ts = data->bat_ts;
+	struct json_writer_mark mark;
+
+	if (!data->queued) {
+		return -ENODATA;
+	}
+
+	err = timestamp_to_unix(&ts, data->unix_ts);
+	if (err) {
+		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+		return err;
+	}
+
+	json_writer_mark(w, &mark);
+	json_writer_obj_start(w, NULL);
+	json_writer_num(w, DATA_VALUE, data->bat);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+
+	err = entry_end(w, &mark);
+	if (err) {
+		return err;
+	}
+
+	if (!json_writer_dry_run(w)) {
+		data->queued = false;
+	}
+
+	return 0;
+}
+
+int json_common_batch_data_write(struct json_writer *w, enum json_common_buffer_type type,
+				 void *buf, size_t buf_count, const char *object_label)
+{
+	int err = 0;
+	bool entry_added = false;
+	struct json_writer_mark array_mark;
+
+	if (w == NULL || object_label == NULL) {
+		LOG_WRN("Missing writer or object label");
+		return -EINVAL;
+	}
+
+	json_writer_mark(w, &array_mark);
+	json_writer_arr_start(w, object_label);
+
+	for (int i = 0; i < buf_count; i++) {
+		switch (type) {
+		case JSON_COMMON_UI:
+			err = ui_data_write(w, &((struct cloud_data_ui *)buf)[i]);
+			break;
+		case JSON_COMMON_MODEM_DYNAMIC:
+			err = modem_dynamic_data_write(w,
+					&((struct cloud_data_modem_dynamic *)buf)[i]);
+			break;
+		case JSON_COMMON_GPS:
+			err = gps_data_write(w, &((struct cloud_data_gps *)buf)[i]);
+			break;
+		case JSON_COMMON_SENSOR:
+			err = sensor_data_write(w, &((struct cloud_data_sensors *)buf)[i]);
+			break;
+		case JSON_COMMON_ACCELEROMETER:
+			err = accel_data_write(w, &((struct cloud_data_accelerometer *)buf)[i]);
+			break;
+		case JSON_COMMON_BATTERY:
+			err = battery_data_write(w, &((struct cloud_data_battery *)buf)[i]);
+			break;
+		default:
+			LOG_WRN("Unsupported buffer type: %d", type);
+			err = -EINVAL;
+			break;
+		}
+
+		if (err == 0) {
+			entry_added = true;
+		} else if (err == -ENOBUFS) {
+			/* The message is full, remaining entries are left queued. */
+			break;
+		} else if (err != -ENODATA) {
+			LOG_ERR("Failed writing data to array");
+			json_writer_rewind(w, &array_mark);
+			return err;
+		}
+	}
+
+	if (!entry_added) {
+		json_writer_rewind(w, &array_mark);
+		return -ENODATA;
+	}
+
+	json_writer_arr_end(w);
+	return 0;
+}
+
+static int batch_write(struct json_writer *w, void *ctx)
+{
+	int err;
+	bool object_added = false;
+	struct json_common_batch *batch = ctx;
+
+	json_writer_obj_start(w, NULL);
+
+	for (size_t i = 0; i < batch->count; i++) {
+		err = json_common_batch_data_write(w, batch->bufs[i].type, batch->bufs[i].buf,
+						   batch->bufs[i].count,
+						   batch->bufs[i].object_label);
+		if (err == 0) {
+			object_added = true;
+		} else if (err != -ENODATA) {
+			return err;
+		}
+	}
+
+	json_writer_obj_end(w);
+
+	return object_added ? 0 : -ENODATA;
+}
+
+int json_common_batch_encode(struct cloud_codec_data *output, struct json_common_batch *batch)
+{
+	int err;
+
+	if (output == NULL || batch == NULL) {
+		return -EINVAL;
+	}
+
+	err = json_writer_encode_alloc(batch_write, batch, CONFIG_CLOUD_CODEC_BATCH_BUFFER_SIZE,
+				       &output->buf, &output->len);
+	if (err == -ENODATA) {
+		LOG_DBG("No data to encode, JSON string empty...");
+		return err;
+	} else if (err) {
+		LOG_ERR("Failed to encode batch message, error: %d", err);
+		return err;
+	}
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
+		printk("Encoded batch message:\n%s\n", output->buf);
+	}
+
+	return 0;
+}
@@ -24,6 +24,7 @@ extern "C" {
 
 #include <zephyr.h>
 #include <cJSON.h>
+#include <json_writer.h>
 
 #include "cloud_codec.h"
 #include "json_protocol_names.h"
@@ -43,6 +44,24 @@ enum json_common_buffer_type {
 	JSON_COMMON_COUNT
 };
 
+/** @brief Buffer of entries to be encoded in a batch message. */
+struct json_common_batch_buf {
+	/** Type of data in the buffer. */
+	enum json_common_buffer_type type;
+	/** Pointer to the data buffer. */
+	void *buf;
+	/** Number of entries in the data buffer. */
+	size_t count;
+	/** Name of the array that the entries are encoded to. */
+	const char *object_label;
+};
+
+/** @brief Buffers to be encoded in a batch message, in the order they are encoded. */
+struct json_common_batch {
+	const struct json_common_batch_buf *bufs;
+	size_t count;
+};
+
 /** @brief Operation to be carried out with the passed in data. */
 enum json_common_op_code {
 	JSON_COMMON_INVALID,
@@ -283,6 +302,43 @@ void json_common_config_get(cJSON *parent, struct cloud_data_cfg *data);
 int json_common_batch_data_add(cJSON *parent, enum json_common_buffer_type type, void *buf,
 			       size_t buf_count, const char *object_label);
 
+/**
+ * @brief Write queued entries in the passed in buffer to a streaming JSON writer as an array.
+ *
+ * The output is the same as from @ref json_common_batch_data_add, without building a cJSON
+ * tree. Entries are written until one does not fit in the writer's buffer, the remaining
+ * entries are left queued. Entries are only unqueued when the writer writes to a buffer, not
+ * when it calculates the output length.
+ *
+ * @param[in, out] w Writer that the array is written to.
+ * @param[in] type Type of data passed in to the function. Static modem data is not supported.
+ * @param[in] buf Pointer to data buffer that is to be encoded.
+ * @param[in] buf_count Number of entries in passed in data buffer.
+ * @param[in] object_label Name of the array.
+ *
+ * @return 0 on success. -ENODATA if no entries were written. Otherwise a negative error
+ *         code is returned.
+ */
+int json_common_batch_data_write(struct json_writer *w, enum json_common_buffer_type type,
+				 void *buf, size_t buf_count, const char *object_label);
+
+/**
+ * @brief Encode queued entries in the passed in buffers to a batch message, without building
+ *        a cJSON tree.
+ *
+ * The message is written directly to a buffer allocated with the exact size of the message,
+ * which is the buffer that is published by the cloud module. If the queued entries do not fit
+ * in CONFIG_CLOUD_CODEC_BATCH_BUFFER_SIZE bytes, only the entries that fit are encoded and
+ * unqueued. The function must be called again to encode the rest.
+ *
+ * @param[out] output Encoded message. The buffer must be freed with k_free().
+ * @param[in] batch Buffers to be encoded.
+ *
+ * @return 0 on success. -ENODATA if there are no queued entries. Otherwise a negative error
+ *         code is returned.
+ */
+int json_common_batch_encode(struct cloud_codec_data *output, struct json_common_batch *batch);
+
 #ifdef __cplusplus
 }
 #endif
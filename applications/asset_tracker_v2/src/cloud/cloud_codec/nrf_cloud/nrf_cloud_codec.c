@@ -13,6 +13,7 @@
 #include <date_time.h>
 #include <net/nrf_cloud_cell_pos.h>
 #include <cloud_codec.h>
+#include <json_writer.h>
 
 #include "cJSON.h"
 #include "json_helpers.h"
@@ -59,14 +60,18 @@ static bool has_shadow_update_been_handled(cJSON *root_obj)
 	return retval;
 }
 
-static int add_meta_data(cJSON *parent, const char *app_id, int64_t *timestamp)
+static int add_meta_data(cJSON *parent, const char *app_id, int64_t *timestamp,
+			 bool unix_ts)
 {
 	int err;
 
-	err = date_time_uptime_to_unix_time_ms(timestamp);
-	if (err) {
-		LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
-		return err;
+	/* Entries restored from the batch store are timestamped with UNIX time already. */
+	if (!unix_ts) {
+		err = date_time_uptime_to_unix_time_ms(timestamp);
+		if (err) {
+			LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
+			return err;
+		}
 	}
 
 	err = json_add_str(parent, DATA_ID, app_id);
@@ -91,7 +96,7 @@ static int add_meta_data(cJSON *parent, const char *app_id, int64_t *timestamp)
 }
 
 static int add_data(cJSON *parent, const char *app_id, const char *str_val,
-		    int64_t *timestamp, bool queued, const char *object_name)
+		    int64_t *timestamp, bool unix_ts, bool queued, const char *object_name)
 {
 	int err;
 
@@ -107,7 +112,7 @@ static int add_data(cJSON *parent, const char *app_id, const char *str_val,
 		goto exit;
 	}
 
-	err = add_meta_data(data_obj, app_id, timestamp);
+	err = add_meta_data(data_obj, app_id, timestamp, unix_ts);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
 		goto exit;
@@ -126,105 +131,218 @@ exit:
 	return err;
 }
 
-static int add_batch_data(cJSON *array, enum batch_data_type type, void *buf, size_t buf_count)
+/* Write a data message to a batch message array. The fields are written in the same order as
+ * done by add_data().
+ */
+static void batch_message_write(struct json_writer *w, const char *app_id, const char *str_val,
+				int64_t ts)
+{
+	json_writer_obj_start(w, NULL);
+	json_writer_str(w, DATA_TYPE, str_val);
+	json_writer_str(w, DATA_ID, app_id);
+	json_writer_str(w, DATA_GROUP, MESSAGE_TYPE_DATA);
+	json_writer_num(w, DATA_TIMESTAMP, ts);
+	json_writer_obj_end(w);
+}
+
+/* Write the queued entries of a buffer to a batch message array. Entries are written until one
+ * does not fit in the message, the remaining entries are left queued.
+ */
+static int batch_data_write(struct json_writer *w, enum batch_data_type type, void *buf,
+			    size_t buf_count)
 {
+	bool entry_added = false;
+
 	for (int i = 0; i < buf_count; i++) {
+		int err, len;
+		int64_t ts;
+		bool unix_ts;
+		struct json_writer_mark mark;
+		char button[2];
+		char rsrp[5];
+		char humidity[7];
+		char temperature[7];
+		const char *app_id;
+		const char *str_val;
+
 		switch (type) {
 		case GPS: {
-			int err;
-			struct cloud_data_gps *data = (struct cloud_data_gps *)buf;
+			struct cloud_data_gps *data = &((struct cloud_data_gps *)buf)[i];
 
-			err =  add_data(array, APP_ID_GPS, data[i].nmea,
-					&data[i].gps_ts, data[i].queued, NULL);
-			if (err && err != -ENODATA) {
-				return err;
+			if (!data->queued) {
+				continue;
 			}
 
-			data[i].queued = false;
+			app_id = APP_ID_GPS;
+			str_val = data->nmea;
+			ts = data->gps_ts;
+			unix_ts = data->unix_ts;
 			break;
 		}
 		case ENVIRONMENTALS: {
-			int err, len;
-			char humidity[7];
-			char temperature[7];
-			struct cloud_data_sensors *data = (struct cloud_data_sensors *)buf;
-			int64_t ts_temp = data[i].env_ts;
+			struct cloud_data_sensors *data = &((struct cloud_data_sensors *)buf)[i];
+
+			if (!data->queued) {
+				continue;
+			}
 
-			len = snprintk(humidity, sizeof(humidity), "%.2f", data[i].hum);
+			len = snprintk(humidity, sizeof(humidity), "%.2f", data->hum);
 			if ((len < 0) || (len >= sizeof(humidity))) {
 				LOG_ERR("Cannot convert humidity to string, buffer to small");
 				return -ENOMEM;
 			}
 
-			len = snprintk(temperature, sizeof(temperature), "%.2f", data[i].temp);
+			len = snprintk(temperature, sizeof(temperature), "%.2f", data->temp);
 			if ((len < 0) || (len >= sizeof(temperature))) {
 				LOG_ERR("Cannot convert temperature to string, buffer to small");
 				return -ENOMEM;
 			}
 
-			err = add_data(array, APP_ID_HUMIDITY, humidity,
-				       &data[i].env_ts, data[i].queued, NULL);
-			if (err && err != -ENODATA) {
-				return err;
-			}
-
-			err =  add_data(array, APP_ID_TEMPERATURE, temperature,
-					&ts_temp, data[i].queued, NULL);
-			if (err && err != -ENODATA) {
-				return err;
-			}
-
-			data[i].queued = false;
+			app_id = APP_ID_HUMIDITY;
+			str_val = humidity;
+			ts = data->env_ts;
+			unix_ts = data->unix_ts;
 			break;
 		}
 		case BUTTON: {
-			int err, len;
-			char button[2];
-			struct cloud_data_ui *data = (struct cloud_data_ui *)buf;
+			struct cloud_data_ui *data = &((struct cloud_data_ui *)buf)[i];
 
-			len = snprintk(button, sizeof(button), "%d", data[i].btn);
+			if (!data->queued) {
+				continue;
+			}
+
+			len = snprintk(button, sizeof(button), "%d", data->btn);
 			if ((len < 0) || (len >= sizeof(button))) {
 				LOG_ERR("Cannot convert button number to string, buffer to small");
 				return -ENOMEM;
 			}
 
-			err =  add_data(array, APP_ID_BUTTON, button,
-					&data[i].btn_ts, data[i].queued, NULL);
-			if (err && err != -ENODATA) {
-				return err;
-			}
-
-			data[i].queued = false;
+			app_id = APP_ID_BUTTON;
+			str_val = button;
+			ts = data->btn_ts;
+			unix_ts = data->unix_ts;
 			break;
 		}
 		case RSRP: {
-			int err, len;
-			char rsrp[5];
 			struct cloud_data_modem_dynamic *data =
-						(struct cloud_data_modem_dynamic *)buf;
+						&((struct cloud_data_modem_dynamic *)buf)[i];
+
+			if (!data->queued) {
+				continue;
+			}
 
-			len = snprintk(rsrp, sizeof(rsrp), "%d", data[i].rsrp);
+			len = snprintk(rsrp, sizeof(rsrp), "%d", data->rsrp);
 			if ((len < 0) || (len >= sizeof(rsrp))) {
 				LOG_ERR("Cannot convert RSRP value to string, buffer to small");
 				return -ENOMEM;
 			}
 
-			err =  add_data(array, APP_ID_RSRP, rsrp,
-					&data[i].ts, data[i].queued, NULL);
-			if (err && err != -ENODATA) {
+			app_id = APP_ID_RSRP;
+			str_val = rsrp;
+			ts = data->ts;
+			unix_ts = data->unix_ts;
+			break;
+		}
+		default:
+			LOG_ERR("Unknown batch data type");
+			return -EINVAL;
+		}
+
+		/* Entries restored from the batch store are timestamped with UNIX time already.
+		 * The timestamp is converted on a copy so that entries that do not fit in this
+		 * message are converted again when they are encoded in the next.
+		 */
+		if (!unix_ts) {
+			err = date_time_uptime_to_unix_time_ms(&ts);
+			if (err) {
+				LOG_ERR("date_time_uptime_to_unix_time_ms, error: %d", err);
 				return err;
 			}
+		}
+
+		json_writer_mark(w, &mark);
+		batch_message_write(w, app_id, str_val, ts);
 
-			data[i].queued = false;
+		if (type == ENVIRONMENTALS) {
+			batch_message_write(w, APP_ID_TEMPERATURE, temperature, ts);
+		}
+
+		if (!json_writer_fits(w)) {
+			json_writer_rewind(w, &mark);
 			break;
 		}
+
+		entry_added = true;
+
+		if (json_writer_dry_run(w)) {
+			continue;
+		}
+
+		switch (type) {
+		case GPS:
+			((struct cloud_data_gps *)buf)[i].queued = false;
+			break;
+		case ENVIRONMENTALS:
+			((struct cloud_data_sensors *)buf)[i].queued = false;
+			break;
+		case BUTTON:
+			((struct cloud_data_ui *)buf)[i].queued = false;
+			break;
+		case RSRP:
+			((struct cloud_data_modem_dynamic *)buf)[i].queued = false;
+			break;
 		default:
-			LOG_ERR("Unknown batch data type");
-			return -EINVAL;
+			break;
 		}
 	}
 
-	return 0;
+	return entry_added ? 0 : -ENODATA;
+}
+
+/* Buffers encoded in a batch message, passed to batch_write(). */
+struct batch_data {
+	struct cloud_data_gps *gps_buf;
+	struct cloud_data_sensors *sensor_buf;
+	struct cloud_data_modem_dynamic *modem_dyn_buf;
+	struct cloud_data_ui *ui_buf;
+	size_t gps_buf_count;
+	size_t sensor_buf_count;
+	size_t modem_dyn_buf_count;
+	size_t ui_buf_count;
+};
+
+static int batch_write(struct json_writer *w, void *ctx)
+{
+	int err;
+	bool message_added = false;
+	struct batch_data *batch = ctx;
+	struct {
+		enum batch_data_type type;
+		void *buf;
+		size_t count;
+		const char *name;
+	} bufs[] = {
+		{ GPS, batch->gps_buf, batch->gps_buf_count, "GPS" },
+		{ ENVIRONMENTALS, batch->sensor_buf, batch->sensor_buf_count, "environmental" },
+		{ BUTTON, batch->ui_buf, batch->ui_buf_count, "button" },
+		{ RSRP, batch->modem_dyn_buf, batch->modem_dyn_buf_count, "RSRP" },
+	};
+
+	json_writer_arr_start(w, NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(bufs); i++) {
+		err = batch_data_write(w, bufs[i].type, bufs[i].buf, bufs[i].count);
+		if (err == 0) {
+			message_added = true;
+		} else if (err != -ENODATA) {
+			LOG_ERR("Failed adding %s data to array, error: %d", bufs[i].name, err);
+			return err;
+		}
+	}
+
+	json_writer_arr_end(w);
+
+	return message_added ? 0 : -ENODATA;
 }
 
 int cloud_codec_encode_neighbor_cells(struct cloud_codec_data *output,
@@ -442,8 +560,8 @@ int cloud_codec_encode_data(struct cloud_codec_data *output,
 
 	/* GPS NMEA */
 
-	err = add_data(root_obj, APP_ID_GPS, gps_buf->nmea, &gps_buf->gps_ts, gps_buf->queued,
-		       OBJECT_MSG_GPS);
+	err = add_data(root_obj, APP_ID_GPS, gps_buf->nmea, &gps_buf->gps_ts, gps_buf->unix_ts,
+		       gps_buf->queued, OBJECT_MSG_GPS);
 	if (err == 0) {
 		msg_obj_added = true;
 	} else if (err != -ENODATA) {
@@ -476,16 +594,16 @@ int cloud_codec_encode_data(struct cloud_codec_data *output,
 	 */
 	int64_t ts_temp = sensor_buf->env_ts;
 
-	err = add_data(root_obj, APP_ID_HUMIDITY, humidity, &sensor_buf->env_ts, sensor_buf->queued,
-		       OBJECT_MSG_HUMID);
+	err = add_data(root_obj, APP_ID_HUMIDITY, humidity, &sensor_buf->env_ts,
+		       sensor_buf->unix_ts, sensor_buf->queued, OBJECT_MSG_HUMID);
 	if (err == 0) {
 		msg_obj_added = true;
 	} else if (err != -ENODATA) {
 		goto add_object;
 	}
 
-	err = add_data(root_obj, APP_ID_TEMPERATURE, temperature, &ts_temp, sensor_buf->queued,
-		       OBJECT_MSG_TEMP);
+	err = add_data(root_obj, APP_ID_TEMPERATURE, temperature, &ts_temp,
+		       sensor_buf->unix_ts, sensor_buf->queued, OBJECT_MSG_TEMP);
 	if (err == 0) {
 		msg_obj_added = true;
 	} else if (err != -ENODATA) {
@@ -514,7 +632,8 @@ int cloud_codec_encode_data(struct cloud_codec_data *output,
 			goto add_object;
 		}
 
-		err = add_data(root_obj, APP_ID_RSRP, rsrp, &rsrp_ts, true, OBJECT_MSG_RSRP);
+		err = add_data(root_obj, APP_ID_RSRP, rsrp, &rsrp_ts, modem_dyn_buf->unix_ts, true,
+			       OBJECT_MSG_RSRP);
 		if (err == 0) {
 			msg_obj_added = true;
 		} else if (err != -ENODATA) {
@@ -677,7 +796,7 @@ int cloud_codec_encode_ui_data(struct cloud_codec_data *output,
 		goto exit;
 	}
 
-	err = add_meta_data(root_obj, APP_ID_BUTTON, &ui_buf->btn_ts);
+	err = add_meta_data(root_obj, APP_ID_BUTTON, &ui_buf->btn_ts, ui_buf->unix_ts);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
 		goto exit;
@@ -721,68 +840,33 @@ int cloud_codec_encode_batch_data(
 				size_t bat_buf_count)
 {
 	int err;
-	char *buffer;
-
-	cJSON *root_array = cJSON_CreateArray();
-
-	if (root_array == NULL) {
-		return -ENOMEM;
-	}
-
-	err = add_batch_data(root_array, GPS, gps_buf, gps_buf_count);
-	if (err) {
-		LOG_ERR("Failed adding GPS data to array, error: %d", err);
-		goto exit;
-	}
-
-	err = add_batch_data(root_array, ENVIRONMENTALS, sensor_buf, sensor_buf_count);
-	if (err) {
-		LOG_ERR("Failed adding environmental data to array, error: %d", err);
-		goto exit;
-	}
-
-	err = add_batch_data(root_array, BUTTON, ui_buf, ui_buf_count);
-	if (err) {
-		LOG_ERR("Failed adding button data to array, error: %d", err);
-		goto exit;
-	}
-
-	err = add_batch_data(root_array, RSRP, modem_dyn_buf, modem_dyn_buf_count);
-	if (err) {
-		LOG_ERR("Failed adding RSRP data to array, error: %d", err);
-		goto exit;
-	}
-
-	if (cJSON_GetArraySize(root_array) == 0) {
-		err = -ENODATA;
+	struct batch_data batch = {
+		.gps_buf = gps_buf,
+		.sensor_buf = sensor_buf,
+		.modem_dyn_buf = modem_dyn_buf,
+		.ui_buf = ui_buf,
+		.gps_buf_count = gps_buf_count,
+		.sensor_buf_count = sensor_buf_count,
+		.modem_dyn_buf_count = modem_dyn_buf_count,
+		.ui_buf_count = ui_buf_count,
+	};
+
+	/* Batch messages are written directly to the output buffer, without building a
+	 * cJSON tree. Only the messages that fit in CONFIG_CLOUD_CODEC_BATCH_BUFFER_SIZE bytes
+	 * are encoded, the remaining entries are left queued for the next call.
+	 */
+	err = json_writer_encode_alloc(batch_write, &batch, CONFIG_CLOUD_CODEC_BATCH_BUFFER_SIZE,
+				       &output->buf, &output->len);
+	if (err == -ENODATA) {
 		LOG_DBG("No data to encode, JSON string empty...");
-		goto exit;
-	} else {
-		/* At this point err can be either 0 or -ENODATA. Explicitly set err to 0 if
-		 * objects has been added to the root object to avoid propagating -ENODATA.
-		 */
-		err = 0;
+	} else if (err) {
+		LOG_ERR("Failed to encode batch message, error: %d", err);
+	} else if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
+		printk("Encoded batch message:\n%s\n", output->buf);
 	}
 
-	buffer = cJSON_PrintUnformatted(root_array);
-	if (buffer == NULL) {
-		LOG_ERR("Failed to allocate memory for JSON string");
-
-		err = -ENOMEM;
-		goto exit;
-	}
-
-	if (IS_ENABLED(CONFIG_CLOUD_CODEC_LOG_LEVEL_DBG)) {
-		json_print_obj("Encoded batch message:\n", root_array);
-	}
-
-	output->buf = buffer;
-	output->len = strlen(buffer);
-
-exit:
 	/* Clear buffers that are not handled by this function. */
 	memset(bat_buf, 0, bat_buf_count * sizeof(struct cloud_data_battery));
 	memset(accel_buf, 0, accel_buf_count * sizeof(struct cloud_data_accelerometer));
-	cJSON_Delete(root_array);
 	return err;
 }
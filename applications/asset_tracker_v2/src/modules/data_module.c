@@ -19,6 +19,7 @@
 #endif
 
 #include "cloud/cloud_codec/cloud_codec.h"
+#include "batch_store/batch_store.h"
 
 #define MODULE data_module
 
@@ -65,7 +66,9 @@ static enum state_type {
 
 /* Ringbuffers. All data received by the Data module are stored in ringbuffers.
  * Upon a LTE connection loss the device will keep sampling/storing data in
- * the buffers, and empty the buffers in batches upon a reconnect.
+ * the buffers, and empty the buffers in batches upon a reconnect. If the batch
+ * store is enabled, a full ringbuffer is moved to flash instead of having its
+ * oldest entry overwritten.
  */
 static struct cloud_data_gps gps_buf[CONFIG_DATA_GPS_BUFFER_COUNT];
 static struct cloud_data_sensors sensors_buf[CONFIG_DATA_SENSOR_BUFFER_COUNT];
@@ -125,6 +128,7 @@ enum data_type {
 	UNUSED,
 	GENERIC,
 	BATCH,
+	STORED_BATCH,
 	UI,
 	NEIGHBOR_CELLS,
 	AGPS_REQUEST,
@@ -158,6 +162,7 @@ static struct module_data self = {
 
 /* Forward declarations */
 static void data_send_work_fn(struct k_work *work);
+static void stored_batch_send(void);
 static int config_settings_handler(const char *key, size_t len,
 				   settings_read_cb read_cb, void *cb_arg);
 
@@ -322,6 +327,11 @@ static void data_list_clear_and_free(struct ack_data *list, size_t list_count)
 {
 	for (size_t i = 0; i < list_count; i++) {
 		if (list[i].ptr != NULL) {
+			if (IS_ENABLED(CONFIG_BATCH_STORE) && (list[i].type == STORED_BATCH)) {
+				/* Read the dropped record from flash again on the next upload. */
+				batch_store_chunk_rewind();
+			}
+
 			k_free(list[i].ptr);
 			data_list_clear_entry(&list[i]);
 		}
@@ -383,6 +393,8 @@ static void data_resend(void)
 				evt->type = DATA_EVT_DATA_SEND;
 				break;
 			case BATCH:
+				/* Fall through */
+			case STORED_BATCH:
 				evt->type = DATA_EVT_DATA_SEND_BATCH;
 				break;
 			case CONFIG:
@@ -424,6 +436,21 @@ static void data_resend(void)
 	}
 }
 
+static void stored_batch_ack(void)
+{
+	int err;
+
+	err = batch_store_chunk_release();
+	if (err) {
+		LOG_WRN("batch_store_chunk_release, error: %d", err);
+	}
+
+	/* Continue emptying the batch store while connected. */
+	if (state == STATE_CLOUD_CONNECTED) {
+		stored_batch_send();
+	}
+}
+
 static void data_ack(void *ptr, bool sent)
 {
 	/* Move data from pending to failed data list if incoming data is
@@ -433,6 +460,8 @@ static void data_ack(void *ptr, bool sent)
 
 	for (size_t i = 0; i < ARRAY_SIZE(pending_data); i++) {
 		if (pending_data[i].ptr == ptr) {
+			bool stored_batch = (pending_data[i].type == STORED_BATCH);
+
 			if (sent) {
 				k_free(ptr);
 				LOG_DBG("Pending data ACKed: %p",
@@ -447,6 +476,10 @@ static void data_ack(void *ptr, bool sent)
 						     pending_data[i].type);
 			}
 			data_list_clear_entry(&pending_data[i]);
+
+			if (IS_ENABLED(CONFIG_BATCH_STORE) && stored_batch && sent) {
+				stored_batch_ack();
+			}
 			return;
 		}
 	}
@@ -490,6 +523,14 @@ static int setup(void)
 		return err;
 	}
 
+	if (IS_ENABLED(CONFIG_BATCH_STORE)) {
+		err = batch_store_init();
+		if (err) {
+			LOG_ERR("batch_store_init, error: %d", err);
+			return err;
+		}
+	}
+
 	return 0;
 }
 
@@ -548,6 +589,156 @@ static void data_send(enum data_module_event_type event,
 	data->len = 0;
 }
 
+/* Move a full ringbuffer to the batch store before its oldest entry is overwritten. */
+static void ringbuffer_store(enum batch_store_data_type type, void *buf, size_t buf_count,
+			     int head)
+{
+	int err;
+
+	if (!IS_ENABLED(CONFIG_BATCH_STORE)) {
+		return;
+	}
+
+	err = batch_store_ringbuffer_add(type, buf, buf_count, head);
+	if (err == -EAGAIN) {
+		LOG_DBG("No valid date time, oldest buffered entry is overwritten");
+	} else if (err) {
+		LOG_ERR("batch_store_ringbuffer_add, error: %d", err);
+	}
+}
+
+static int stored_batch_encode(struct cloud_codec_data *codec, void **bufs, size_t *counts)
+{
+	return cloud_codec_encode_batch_data(codec,
+					     bufs[BATCH_STORE_GPS],
+					     bufs[BATCH_STORE_SENSOR],
+					     bufs[BATCH_STORE_MODEM_DYNAMIC],
+					     bufs[BATCH_STORE_UI],
+					     bufs[BATCH_STORE_ACCELEROMETER],
+					     bufs[BATCH_STORE_BATTERY],
+					     counts[BATCH_STORE_GPS],
+					     counts[BATCH_STORE_SENSOR],
+					     counts[BATCH_STORE_MODEM_DYNAMIC],
+					     counts[BATCH_STORE_UI],
+					     counts[BATCH_STORE_ACCELEROMETER],
+					     counts[BATCH_STORE_BATTERY]);
+}
+
+/* Encode all batch messages of a record. A record that does not fit in one batch message
+ * is encoded in several, each holding at least one entry, so there are at most as many
+ * messages as entries.
+ */
+static int stored_batch_parts_encode(struct batch_store_chunk *chunk,
+				     struct cloud_codec_data *parts, size_t *part_cnt)
+{
+	int err = 0;
+	void *bufs[BATCH_STORE_TYPE_COUNT] = {0};
+	size_t counts[BATCH_STORE_TYPE_COUNT] = {0};
+
+	bufs[chunk->type] = chunk->buf;
+	counts[chunk->type] = chunk->count;
+
+	*part_cnt = 0;
+
+	while (*part_cnt < chunk->count) {
+		err = stored_batch_encode(&parts[*part_cnt], bufs, counts);
+		if (err) {
+			break;
+		}
+
+		(*part_cnt)++;
+	}
+
+	if ((err == -ENODATA) && (*part_cnt > 0)) {
+		err = 0;
+	}
+
+	if (err) {
+		for (size_t i = 0; i < *part_cnt; i++) {
+			k_free(parts[i].buf);
+		}
+		*part_cnt = 0;
+	}
+
+	return err;
+}
+
+/* Encode and send the oldest record in the batch store. One record is sent at a time,
+ * the next is sent when the previous has been acknowledged.
+ */
+static void stored_batch_send(void)
+{
+	int err;
+	struct batch_store_chunk chunk;
+	struct cloud_codec_data *parts;
+	size_t part_cnt = 0;
+
+	if (!IS_ENABLED(CONFIG_BATCH_STORE)) {
+		return;
+	}
+
+	do {
+		err = batch_store_chunk_get(&chunk);
+		if ((err == -ENODATA) || (err == -EBUSY)) {
+			/* Batch store is empty or a record is already being sent. */
+			return;
+		} else if (err) {
+			LOG_ERR("batch_store_chunk_get, error: %d", err);
+			SEND_ERROR(data, DATA_EVT_ERROR, err);
+			return;
+		}
+
+		/* All messages of the record are encoded before any is sent. If encoding
+		 * fails, nothing has been sent and the whole record is sent after the store
+		 * is rewound. The record is released when the last message has been
+		 * acknowledged.
+		 */
+		parts = k_calloc(MAX(chunk.count, 1), sizeof(*parts));
+		if (parts == NULL) {
+			err = -ENOMEM;
+		} else {
+			err = stored_batch_parts_encode(&chunk, parts, &part_cnt);
+		}
+
+		batch_store_chunk_free(&chunk);
+
+		switch (err) {
+		case 0:
+			LOG_DBG("Stored batch data encoded successfully, messages: %zu",
+				part_cnt);
+
+			for (size_t i = 0; i < part_cnt - 1; i++) {
+				data_send(DATA_EVT_DATA_SEND_BATCH, BATCH, &parts[i]);
+			}
+			data_send(DATA_EVT_DATA_SEND_BATCH, STORED_BATCH, &parts[part_cnt - 1]);
+			break;
+		case -ENODATA:
+			/* The record holds data that is not supported by the cloud codec,
+			 * release it and continue with the next.
+			 */
+			LOG_DBG("No stored batch data to encode");
+
+			err = batch_store_chunk_release();
+			if (err) {
+				LOG_WRN("batch_store_chunk_release, error: %d", err);
+				k_free(parts);
+				return;
+			}
+
+			err = -ENODATA;
+			break;
+		default:
+			LOG_ERR("Error batch-encoding stored data: %d", err);
+			batch_store_chunk_rewind();
+			SEND_ERROR(data, DATA_EVT_ERROR, err);
+			k_free(parts);
+			return;
+		}
+
+		k_free(parts);
+	} while (err == -ENODATA);
+}
+
 /* This function allocates buffer on the heap, which needs to be freed after use. */
 static void data_encode(void)
 {
@@ -606,32 +797,39 @@ static void data_encode(void)
 		return;
 	}
 
-	err = cloud_codec_encode_batch_data(&codec,
-					gps_buf,
-					sensors_buf,
-					modem_dyn_buf,
-					ui_buf,
-					accel_buf,
-					bat_buf,
-					ARRAY_SIZE(gps_buf),
-					ARRAY_SIZE(sensors_buf),
-					ARRAY_SIZE(modem_dyn_buf),
-					ARRAY_SIZE(ui_buf),
-					ARRAY_SIZE(accel_buf),
-					ARRAY_SIZE(bat_buf));
-	switch (err) {
-	case 0:
-		LOG_DBG("Batch data encoded successfully");
-		data_send(DATA_EVT_DATA_SEND_BATCH, BATCH, &codec);
-		break;
-	case -ENODATA:
-		LOG_DBG("No batch data to encode, ringbuffers are empty");
-		break;
-	default:
-		LOG_ERR("Error batch-enconding data: %d", err);
-		SEND_ERROR(data, DATA_EVT_ERROR, err);
-		return;
-	}
+	/* Batch messages are limited in size by the cloud codec. Entries that do not fit in a
+	 * message are left queued, encode until all ringbuffers are empty.
+	 */
+	do {
+		err = cloud_codec_encode_batch_data(&codec,
+						gps_buf,
+						sensors_buf,
+						modem_dyn_buf,
+						ui_buf,
+						accel_buf,
+						bat_buf,
+						ARRAY_SIZE(gps_buf),
+						ARRAY_SIZE(sensors_buf),
+						ARRAY_SIZE(modem_dyn_buf),
+						ARRAY_SIZE(ui_buf),
+						ARRAY_SIZE(accel_buf),
+						ARRAY_SIZE(bat_buf));
+		switch (err) {
+		case 0:
+			LOG_DBG("Batch data encoded successfully");
+			data_send(DATA_EVT_DATA_SEND_BATCH, BATCH, &codec);
+			break;
+		case -ENODATA:
+			LOG_DBG("No batch data to encode, ringbuffers are empty");
+			break;
+		default:
+			LOG_ERR("Error batch-enconding data: %d", err);
+			SEND_ERROR(data, DATA_EVT_ERROR, err);
+			return;
+		}
+	} while (err == 0);
+
+	stored_batch_send();
 }
 
 #if defined(CONFIG_NRF_CLOUD_AGPS) && !defined(CONFIG_NRF_CLOUD_MQTT)
@@ -1112,6 +1310,7 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
+		ringbuffer_store(BATCH_STORE_UI, ui_buf, ARRAY_SIZE(ui_buf), head_ui_buf);
 		cloud_codec_populate_ui_buffer(ui_buf, &new_ui_data,
 					       &head_ui_buf,
 					       ARRAY_SIZE(ui_buf));
@@ -1180,6 +1379,8 @@ static void on_all_states(struct data_msg_data *msg)
 		strcpy(new_modem_data.ip, msg->module.modem.data.modem_dynamic.ip_address);
 		strcpy(new_modem_data.mccmnc, msg->module.modem.data.modem_dynamic.mccmnc);
 
+		ringbuffer_store(BATCH_STORE_MODEM_DYNAMIC, modem_dyn_buf,
+				 ARRAY_SIZE(modem_dyn_buf), head_modem_dyn_buf);
 		cloud_codec_populate_modem_dynamic_buffer(
 						modem_dyn_buf,
 						&new_modem_data,
@@ -1200,6 +1401,7 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
+		ringbuffer_store(BATCH_STORE_BATTERY, bat_buf, ARRAY_SIZE(bat_buf), head_bat_buf);
 		cloud_codec_populate_bat_buffer(bat_buf, &new_battery_data,
 						&head_bat_buf,
 						ARRAY_SIZE(bat_buf));
@@ -1215,6 +1417,8 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
+		ringbuffer_store(BATCH_STORE_SENSOR, sensors_buf, ARRAY_SIZE(sensors_buf),
+				 head_sensor_buf);
 		cloud_codec_populate_sensor_buffer(sensors_buf,
 						   &new_sensor_data,
 						   &head_sensor_buf,
@@ -1236,6 +1440,8 @@ static void on_all_states(struct data_msg_data *msg)
 			.queued = true
 		};
 
+		ringbuffer_store(BATCH_STORE_ACCELEROMETER, accel_buf, ARRAY_SIZE(accel_buf),
+				 head_accel_buf);
 		cloud_codec_populate_accel_buffer(accel_buf, &new_movement_data,
 						  &head_accel_buf,
 						  ARRAY_SIZE(accel_buf));
@@ -1275,6 +1481,7 @@ static void on_all_states(struct data_msg_data *msg)
 			return;
 		}
 
+		ringbuffer_store(BATCH_STORE_GPS, gps_buf, ARRAY_SIZE(gps_buf), head_gps_buf);
 		cloud_codec_populate_gps_buffer(gps_buf, &new_gps_data,
 						&head_gps_buf,
 						ARRAY_SIZE(gps_buf));
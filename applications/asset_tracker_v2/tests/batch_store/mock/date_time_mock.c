@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+
+#include "date_time.h"
+#include "mock.h"
+
+static bool time_valid = true;
+
+void date_time_mock_valid_set(bool valid)
+{
+	time_valid = valid;
+}
+
+bool date_time_is_valid(void)
+{
+	return time_valid;
+}
+
+/* Mocking function that converts the input uptime with a fixed offset. */
+int date_time_uptime_to_unix_time_ms(int64_t *uptime)
+{
+	if (!time_valid) {
+		return -ENODATA;
+	}
+
+	*uptime += DATE_TIME_MOCK_OFFSET_MS;
+
+	return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* In-memory flash circular buffer. Follows the behavior of the FCB that the batch store
+ * relies on: entries are read oldest first, an append that does not fit in the last free
+ * sector fails with -ENOSPC, entries that were not finished are skipped, and the sectors
+ * are recovered from flash by fcb_init().
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <sys/byteorder.h>
+#include <pm_config.h>
+
+#include "mock.h"
+
+#define SECTOR_SIZE		0x1000
+#define SECTOR_COUNT		(PM_BATCH_STORAGE_SIZE / SECTOR_SIZE)
+#define ALIGN			4
+#define ERASED			0xff
+
+/* Sector header: magic (4 bytes, LE), version (1 byte), pad (1 byte), id (2 bytes, LE). */
+#define SECTOR_HEADER_SIZE	8
+
+/* Entry: data length (2 bytes, LE) and padding, data, and a trailer that is written when
+ * the entry is finished.
+ */
+#define ENTRY_HEADER_SIZE	ALIGN
+#define ENTRY_TRAILER_SIZE	ALIGN
+#define ENTRY_LEN_ERASED	0xffff
+#define ENTRY_FINISHED		0x00
+
+static uint8_t flash[PM_BATCH_STORAGE_SIZE];
+
+static const struct flash_area area = {
+	.fa_id = PM_BATCH_STORAGE_ID,
+	.fa_size = PM_BATCH_STORAGE_SIZE,
+};
+
+void flash_mock_erase(void)
+{
+	memset(flash, ERASED, sizeof(flash));
+}
+
+int flash_area_get_sectors(int fa_id, uint32_t *count, struct flash_sector *sectors)
+{
+	if (fa_id != PM_BATCH_STORAGE_ID || *count < SECTOR_COUNT) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < SECTOR_COUNT; i++) {
+		sectors[i].fs_off = i * SECTOR_SIZE;
+		sectors[i].fs_size = SECTOR_SIZE;
+	}
+
+	*count = SECTOR_COUNT;
+
+	return 0;
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst, size_t len)
+{
+	if (fa != &area || off < 0 || (off + len) > sizeof(flash)) {
+		return -EINVAL;
+	}
+
+	memcpy(dst, &flash[off], len);
+
+	return 0;
+}
+
+/* Like NOR flash, writing can only clear bits. */
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src, size_t len)
+{
+	const uint8_t *data = src;
+
+	if (fa != &area || off < 0 || (off + len) > sizeof(flash) || (off % ALIGN)) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		flash[off + i] &= data[i];
+	}
+
+	return 0;
+}
+
+static size_t entry_size(uint16_t len)
+{
+	return ENTRY_HEADER_SIZE + ROUND_UP(len, ALIGN) + ENTRY_TRAILER_SIZE;
+}
+
+static struct flash_sector *sector_next(struct fcb *fcb, struct flash_sector *sector)
+{
+	sector++;
+
+	if (sector >= &fcb->f_sectors[fcb->f_sector_cnt]) {
+		sector = &fcb->f_sectors[0];
+	}
+
+	return sector;
+}
+
+static void sector_init(struct fcb *fcb, struct flash_sector *sector, uint16_t id)
+{
+	uint8_t *header = &flash[sector->fs_off];
+
+	sys_put_le32(fcb->f_magic, &header[0]);
+	header[4] = fcb->f_version;
+	header[5] = 0;
+	sys_put_le16(id, &header[6]);
+}
+
+static bool sector_valid(struct fcb *fcb, struct flash_sector *sector, uint16_t *id)
+{
+	uint8_t *header = &flash[sector->fs_off];
+
+	if ((sys_get_le32(&header[0]) != fcb->f_magic) || (header[4] != fcb->f_version)) {
+		return false;
+	}
+
+	*id = sys_get_le16(&header[6]);
+
+	return true;
+}
+
+/* Offset of the first free location in a sector. */
+static uint32_t sector_end(struct flash_sector *sector)
+{
+	uint32_t off = SECTOR_HEADER_SIZE;
+	uint16_t len;
+
+	while ((off + ENTRY_HEADER_SIZE) <= sector->fs_size) {
+		len = sys_get_le16(&flash[sector->fs_off + off]);
+		if (len == ENTRY_LEN_ERASED) {
+			break;
+		}
+
+		off += entry_size(len);
+	}
+
+	return off;
+}
+
+int fcb_init(int f_area_id, struct fcb *fcb)
+{
+	struct flash_sector *oldest = NULL;
+	struct flash_sector *newest = NULL;
+	uint16_t oldest_id = 0;
+	uint16_t newest_id = 0;
+	uint16_t id;
+
+	if (f_area_id != PM_BATCH_STORAGE_ID || fcb->f_sector_cnt == 0) {
+		return -EINVAL;
+	}
+
+	fcb->fap = &area;
+	fcb->f_align = ALIGN;
+	fcb->f_erase_value = ERASED;
+
+	for (size_t i = 0; i < fcb->f_sector_cnt; i++) {
+		struct flash_sector *sector = &fcb->f_sectors[i];
+
+		if (!sector_valid(fcb, sector, &id)) {
+			continue;
+		}
+
+		if (!oldest || (int16_t)(id - oldest_id) < 0) {
+			oldest = sector;
+			oldest_id = id;
+		}
+
+		if (!newest || (int16_t)(id - newest_id) > 0) {
+			newest = sector;
+			newest_id = id;
+		}
+	}
+
+	if (!newest) {
+		oldest = newest = &fcb->f_sectors[0];
+		newest_id = 0;
+		sector_init(fcb, newest, newest_id);
+	}
+
+	fcb->f_oldest = oldest;
+	fcb->f_active.fe_sector = newest;
+	fcb->f_active.fe_elem_off = sector_end(newest);
+	fcb->f_active_id = newest_id;
+
+	return 0;
+}
+
+int fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *loc)
+{
+	struct flash_sector *sector = fcb->f_active.fe_sector;
+	uint32_t off = fcb->f_active.fe_elem_off;
+
+	if ((SECTOR_HEADER_SIZE + entry_size(len)) > SECTOR_SIZE) {
+		return -EINVAL;
+	}
+
+	if ((off + entry_size(len)) > sector->fs_size) {
+		sector = sector_next(fcb, sector);
+		if (sector == fcb->f_oldest) {
+			return -ENOSPC;
+		}
+
+		sector_init(fcb, sector, fcb->f_active_id + 1);
+		fcb->f_active.fe_sector = sector;
+		fcb->f_active_id++;
+		off = SECTOR_HEADER_SIZE;
+	}
+
+	sys_put_le16(len, &flash[sector->fs_off + off]);
+
+	loc->fe_sector = sector;
+	loc->fe_elem_off = off;
+	loc->fe_data_off = off + ENTRY_HEADER_SIZE;
+	loc->fe_data_len = len;
+
+	fcb->f_active.fe_elem_off = off + entry_size(len);
+
+	return 0;
+}
+
+int fcb_append_finish(struct fcb *fcb, struct fcb_entry *append_loc)
+{
+	uint32_t off = append_loc->fe_sector->fs_off + append_loc->fe_data_off +
+		       ROUND_UP(append_loc->fe_data_len, ALIGN);
+
+	flash[off] = ENTRY_FINISHED;
+
+	return 0;
+}
+
+int fcb_getnext(struct fcb *fcb, struct fcb_entry *loc)
+{
+	struct flash_sector *sector = loc->fe_sector;
+	uint32_t off;
+	uint16_t len;
+
+	if (sector == NULL) {
+		sector = fcb->f_oldest;
+		off = SECTOR_HEADER_SIZE;
+	} else if (loc->fe_elem_off == 0) {
+		off = SECTOR_HEADER_SIZE;
+	} else {
+		off = loc->fe_elem_off + entry_size(loc->fe_data_len);
+	}
+
+	while (true) {
+		len = ENTRY_LEN_ERASED;
+		if ((off + ENTRY_HEADER_SIZE) <= sector->fs_size) {
+			len = sys_get_le16(&flash[sector->fs_off + off]);
+		}
+
+		if (len == ENTRY_LEN_ERASED) {
+			if (sector == fcb->f_active.fe_sector) {
+				return -ENOTSUP;
+			}
+
+			sector = sector_next(fcb, sector);
+			off = SECTOR_HEADER_SIZE;
+			continue;
+		}
+
+		if (flash[sector->fs_off + off + ENTRY_HEADER_SIZE + ROUND_UP(len, ALIGN)] !=
+		    ENTRY_FINISHED) {
+			off += entry_size(len);
+			continue;
+		}
+
+		loc->fe_sector = sector;
+		loc->fe_elem_off = off;
+		loc->fe_data_off = off + ENTRY_HEADER_SIZE;
+		loc->fe_data_len = len;
+
+		return 0;
+	}
+}
+
+int fcb_walk(struct fcb *fcb, struct flash_sector *sector, fcb_walk_cb cb, void *cb_arg)
+{
+	struct fcb_entry_ctx entry_ctx = {
+		.loc.fe_sector = sector,
+		.fap = fcb->fap,
+	};
+	int err;
+
+	while (fcb_getnext(fcb, &entry_ctx.loc) == 0) {
+		if (sector && entry_ctx.loc.fe_sector != sector) {
+			return 0;
+		}
+
+		err = cb(&entry_ctx, cb_arg);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int fcb_rotate(struct fcb *fcb)
+{
+	struct flash_sector *sector;
+
+	memset(&flash[fcb->f_oldest->fs_off], ERASED, fcb->f_oldest->fs_size);
+
+	if (fcb->f_oldest == fcb->f_active.fe_sector) {
+		sector = sector_next(fcb, fcb->f_oldest);
+		sector_init(fcb, sector, fcb->f_active_id + 1);
+		fcb->f_active.fe_sector = sector;
+		fcb->f_active.fe_elem_off = SECTOR_HEADER_SIZE;
+		fcb->f_active_id++;
+	}
+
+	fcb->f_oldest = sector_next(fcb, fcb->f_oldest);
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MOCK_H__
+#define MOCK_H__
+
+#include <stdbool.h>
+
+/* Offset added to uptime to convert it to UNIX time. */
+#define DATE_TIME_MOCK_OFFSET_MS	1563968747000LL
+
+/* Set whether date time is valid. */
+void date_time_mock_valid_set(bool valid);
+
+/* Erase the batch store partition. */
+void flash_mock_erase(void);
+
+/* Delete all stored settings. */
+void settings_mock_clear(void);
+
+#endif /* MOCK_H__ */
@@ -0,0 +1,9 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Partition of the batch store, stored in RAM by the flash mock. */
+#define PM_BATCH_STORAGE_ID	0
+#define PM_BATCH_STORAGE_SIZE	0x3000
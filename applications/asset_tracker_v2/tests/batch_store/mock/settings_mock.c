@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Settings backend that keeps the stored values in RAM, so that they survive a simulated
+ * reboot of the batch store.
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <settings/settings.h>
+
+#include "mock.h"
+
+#define ENTRY_COUNT		4
+#define ENTRY_NAME_SIZE		32
+#define ENTRY_VALUE_SIZE	16
+
+static struct {
+	char name[ENTRY_NAME_SIZE];
+	uint8_t value[ENTRY_VALUE_SIZE];
+	size_t len;
+} entries[ENTRY_COUNT];
+
+void settings_mock_clear(void)
+{
+	memset(entries, 0, sizeof(entries));
+}
+
+static ssize_t entry_read(void *cb_arg, void *data, size_t len)
+{
+	size_t index = (size_t)cb_arg;
+
+	len = MIN(len, entries[index].len);
+	memcpy(data, entries[index].value, len);
+
+	return len;
+}
+
+static int mock_load(struct settings_store *cs, const struct settings_load_arg *arg)
+{
+	for (size_t i = 0; i < ENTRY_COUNT; i++) {
+		if (entries[i].name[0] == '\0') {
+			continue;
+		}
+
+		settings_call_set_handler(entries[i].name, entries[i].len, entry_read,
+					  (void *)i, arg);
+	}
+
+	return 0;
+}
+
+static int mock_save(struct settings_store *cs, const char *name, const char *value,
+		     size_t val_len)
+{
+	size_t free = ENTRY_COUNT;
+
+	if (strlen(name) >= ENTRY_NAME_SIZE || val_len > ENTRY_VALUE_SIZE) {
+		return -ENOMEM;
+	}
+
+	for (size_t i = 0; i < ENTRY_COUNT; i++) {
+		if (!strcmp(entries[i].name, name)) {
+			free = i;
+			break;
+		}
+
+		if ((free == ENTRY_COUNT) && (entries[i].name[0] == '\0')) {
+			free = i;
+		}
+	}
+
+	if (free == ENTRY_COUNT) {
+		return -ENOMEM;
+	}
+
+	if (value == NULL || val_len == 0) {
+		memset(&entries[free], 0, sizeof(entries[free]));
+		return 0;
+	}
+
+	strcpy(entries[free].name, name);
+	memcpy(entries[free].value, value, val_len);
+	entries[free].len = val_len;
+
+	return 0;
+}
+
+static const struct settings_store_itf mock_itf = {
+	.csi_load = mock_load,
+	.csi_save = mock_save,
+};
+
+static struct settings_store mock_store = {
+	.cs_itf = &mock_itf,
+};
+
+int settings_backend_init(void)
+{
+	settings_dst_register(&mock_store);
+	settings_src_register(&mock_store);
+
+	return 0;
+}
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+#include <string.h>
+#include <math.h>
+#include <settings/settings.h>
+
+#include "batch_store.h"
+#include "cloud_codec.h"
+#include "mock.h"
+
+#define BATTERY_COUNT		8
+#define BATTERY_TS_STEP		1000
+#define GPS_COUNT		40
+
+static struct cloud_data_battery battery_buf[BATTERY_COUNT];
+
+static void battery_buf_fill(uint16_t first, int64_t ts)
+{
+	for (size_t i = 0; i < BATTERY_COUNT; i++) {
+		battery_buf[i].bat = first + i;
+		battery_buf[i].bat_ts = ts + i * BATTERY_TS_STEP;
+		battery_buf[i].queued = true;
+		battery_buf[i].unix_ts = false;
+	}
+}
+
+/* Fill the battery ringbuffer with the newest entry last and move it to the store. */
+static void battery_store(uint16_t first)
+{
+	int err;
+
+	battery_buf_fill(first, first * BATTERY_TS_STEP);
+
+	err = batch_store_ringbuffer_add(BATCH_STORE_BATTERY, battery_buf, BATTERY_COUNT,
+					 BATTERY_COUNT - 1);
+	zassert_equal(err, 0, "Failed to store entries, error: %d", err);
+}
+
+/* Read a battery record and check that it holds the entries stored by battery_store(). */
+static void battery_chunk_check(struct batch_store_chunk *chunk, uint16_t first)
+{
+	struct cloud_data_battery *data = chunk->buf;
+
+	zassert_equal(chunk->type, BATCH_STORE_BATTERY, "Wrong data type");
+	zassert_equal(chunk->count, BATTERY_COUNT, "Wrong entry count");
+
+	for (size_t i = 0; i < chunk->count; i++) {
+		zassert_equal(data[i].bat, first + i, "Wrong value of entry %d", i);
+		zassert_equal(data[i].bat_ts,
+			      (first + i) * BATTERY_TS_STEP + DATE_TIME_MOCK_OFFSET_MS,
+			      "Wrong timestamp of entry %d", i);
+		zassert_true(data[i].queued, "Entry %d is not queued", i);
+		zassert_true(data[i].unix_ts, "Entry %d is not in UNIX time", i);
+	}
+}
+
+static void battery_chunk_expect(uint16_t first)
+{
+	int err;
+	struct batch_store_chunk chunk;
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+
+	battery_chunk_check(&chunk, first);
+	batch_store_chunk_free(&chunk);
+
+	err = batch_store_chunk_release();
+	zassert_equal(err, 0, "Failed to release record, error: %d", err);
+}
+
+static void store_empty_expect(void)
+{
+	struct batch_store_chunk chunk;
+
+	zassert_equal(batch_store_chunk_get(&chunk), -ENODATA, "Store is not empty");
+}
+
+static void test_setup(void)
+{
+	int err;
+
+	flash_mock_erase();
+	settings_mock_clear();
+	date_time_mock_valid_set(true);
+
+	err = settings_subsys_init();
+	zassert_equal(err, 0, "Failed to initialize settings, error: %d", err);
+
+	err = batch_store_init();
+	zassert_equal(err, 0, "Failed to initialize batch store, error: %d", err);
+}
+
+static void test_ringbuffer_not_full(void)
+{
+	int err;
+
+	battery_buf_fill(0, 0);
+	battery_buf[0].queued = false;
+
+	/* The entry after the head has been sent, so there is room for a new entry. */
+	err = batch_store_ringbuffer_add(BATCH_STORE_BATTERY, battery_buf, BATTERY_COUNT,
+					 BATTERY_COUNT - 1);
+	zassert_equal(err, 0, "Unexpected error: %d", err);
+
+	for (size_t i = 1; i < BATTERY_COUNT; i++) {
+		zassert_true(battery_buf[i].queued, "Entry %d was unqueued", i);
+	}
+
+	store_empty_expect();
+}
+
+static void test_ringbuffer_order(void)
+{
+	int err;
+	int head = 2;
+	struct batch_store_chunk chunk;
+	struct cloud_data_battery *data;
+
+	battery_buf_fill(0, 0);
+
+	err = batch_store_ringbuffer_add(BATCH_STORE_BATTERY, battery_buf, BATTERY_COUNT, head);
+	zassert_equal(err, 0, "Failed to store entries, error: %d", err);
+
+	for (size_t i = 0; i < BATTERY_COUNT; i++) {
+		zassert_false(battery_buf[i].queued, "Entry %d is still queued", i);
+	}
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+	zassert_equal(chunk.count, BATTERY_COUNT, "Wrong entry count");
+
+	/* Oldest first, starting after the head. */
+	data = chunk.buf;
+	for (size_t i = 0; i < chunk.count; i++) {
+		zassert_equal(data[i].bat, (head + 1 + i) % BATTERY_COUNT,
+			      "Wrong order of entry %d", i);
+	}
+
+	batch_store_chunk_free(&chunk);
+	zassert_equal(batch_store_chunk_release(), 0, "Failed to release record");
+	store_empty_expect();
+}
+
+static void test_no_date_time(void)
+{
+	int err;
+
+	battery_buf_fill(0, 0);
+	date_time_mock_valid_set(false);
+
+	err = batch_store_ringbuffer_add(BATCH_STORE_BATTERY, battery_buf, BATTERY_COUNT,
+					 BATTERY_COUNT - 1);
+	zassert_equal(err, -EAGAIN, "Unexpected error: %d", err);
+
+	for (size_t i = 0; i < BATTERY_COUNT; i++) {
+		zassert_true(battery_buf[i].queued, "Entry %d was unqueued", i);
+	}
+
+	store_empty_expect();
+}
+
+static void test_gps_round_trip(void)
+{
+	int err;
+	struct batch_store_chunk chunk;
+	struct cloud_data_gps *data;
+	struct cloud_data_gps buf[3] = {
+		[0] = {
+			.gps_ts = 1000,
+			.format = CLOUD_CODEC_GPS_FORMAT_PVT,
+			.pvt = {
+				.lat = 63.4305149,
+				.longi = -10.3950528,
+				.alt = 57.25,
+				.acc = 4.5,
+				.spd = 0.12,
+				.hdg = 359.99,
+			},
+			.queued = true,
+		},
+		[1] = {
+			.gps_ts = 1563968748000,
+			.format = CLOUD_CODEC_GPS_FORMAT_PVT,
+			.pvt = {
+				.lat = -33.8688197,
+				.longi = 151.2092955,
+				.alt = -12.5,
+				.acc = 100.0,
+				.spd = 27.78,
+				.hdg = 0.0,
+			},
+			.queued = true,
+			.unix_ts = true,
+		},
+		[2] = {
+			.gps_ts = 3000,
+			.format = CLOUD_CODEC_GPS_FORMAT_NMEA,
+			.nmea = "$GPGGA,181908.00,3404.7041778,N,07044.3966270,W,4,13*40",
+			.queued = true,
+		},
+	};
+
+	err = batch_store_ringbuffer_add(BATCH_STORE_GPS, buf, ARRAY_SIZE(buf), 2);
+	zassert_equal(err, 0, "Failed to store entries, error: %d", err);
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+	zassert_equal(chunk.type, BATCH_STORE_GPS, "Wrong data type");
+	zassert_equal(chunk.count, ARRAY_SIZE(buf), "Wrong entry count");
+
+	data = chunk.buf;
+
+	zassert_equal(data[0].gps_ts, 1000 + DATE_TIME_MOCK_OFFSET_MS, "Wrong timestamp");
+	zassert_equal(data[1].gps_ts, 1563968748000, "UNIX timestamp was converted");
+	zassert_equal(data[2].gps_ts, 3000 + DATE_TIME_MOCK_OFFSET_MS, "Wrong timestamp");
+
+	for (size_t i = 0; i < 2; i++) {
+		zassert_equal(data[i].format, CLOUD_CODEC_GPS_FORMAT_PVT, "Wrong format");
+		zassert_true(fabs(data[i].pvt.lat - buf[i].pvt.lat) < 1e-7, "Wrong latitude");
+		zassert_true(fabs(data[i].pvt.longi - buf[i].pvt.longi) < 1e-7,
+			     "Wrong longitude");
+		zassert_true(fabsf(data[i].pvt.alt - buf[i].pvt.alt) < 0.01, "Wrong altitude");
+		zassert_true(fabsf(data[i].pvt.acc - buf[i].pvt.acc) < 0.01, "Wrong accuracy");
+		zassert_true(fabsf(data[i].pvt.spd - buf[i].pvt.spd) < 0.01, "Wrong speed");
+		zassert_true(fabsf(data[i].pvt.hdg - buf[i].pvt.hdg) < 0.01, "Wrong heading");
+		zassert_true(data[i].unix_ts, "Entry is not in UNIX time");
+	}
+
+	zassert_equal(data[2].format, CLOUD_CODEC_GPS_FORMAT_NMEA, "Wrong format");
+	zassert_true(strcmp(data[2].nmea, buf[2].nmea) == 0, "Wrong NMEA string");
+
+	batch_store_chunk_free(&chunk);
+	zassert_equal(batch_store_chunk_release(), 0, "Failed to release record");
+}
+
+static void test_modem_dynamic_round_trip(void)
+{
+	int err;
+	struct batch_store_chunk chunk;
+	struct cloud_data_modem_dynamic *data;
+	struct cloud_data_modem_dynamic buf[2] = {
+		[0] = {
+			.ts = 1000,
+			.area = 12345,
+			.cell = 0x0123abcd,
+			.rsrp = -115,
+			.ip = "10.81.183.99",
+			.mccmnc = "24202",
+			.queued = true,
+			.area_code_fresh = true,
+			.cell_id_fresh = true,
+			.rsrp_fresh = true,
+			.ip_address_fresh = true,
+			.mccmnc_fresh = true,
+		},
+		[1] = {
+			.ts = 2000,
+			.rsrp = -80,
+			.queued = true,
+			.rsrp_fresh = true,
+		},
+	};
+
+	err = batch_store_ringbuffer_add(BATCH_STORE_MODEM_DYNAMIC, buf, ARRAY_SIZE(buf), 1);
+	zassert_equal(err, 0, "Failed to store entries, error: %d", err);
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+	zassert_equal(chunk.type, BATCH_STORE_MODEM_DYNAMIC, "Wrong data type");
+	zassert_equal(chunk.count, ARRAY_SIZE(buf), "Wrong entry count");
+
+	data = chunk.buf;
+
+	zassert_equal(data[0].area, buf[0].area, "Wrong area code");
+	zassert_equal(data[0].cell, buf[0].cell, "Wrong cell ID");
+	zassert_equal(data[0].rsrp, buf[0].rsrp, "Wrong RSRP");
+	zassert_true(strcmp(data[0].ip, buf[0].ip) == 0, "Wrong IP address");
+	zassert_true(strcmp(data[0].mccmnc, buf[0].mccmnc) == 0, "Wrong MCCMNC");
+	zassert_true(data[0].area_code_fresh && data[0].cell_id_fresh &&
+		     data[0].rsrp_fresh && data[0].ip_address_fresh && data[0].mccmnc_fresh,
+		     "Fresh flags were not restored");
+
+	/* Only the fresh values are stored. */
+	zassert_equal(data[1].ts, 2000 + DATE_TIME_MOCK_OFFSET_MS, "Wrong timestamp");
+	zassert_equal(data[1].rsrp, buf[1].rsrp, "Wrong RSRP");
+	zassert_true(data[1].rsrp_fresh, "RSRP is not fresh");
+	zassert_false(data[1].area_code_fresh || data[1].cell_id_fresh ||
+		      data[1].ip_address_fresh || data[1].mccmnc_fresh,
+		      "Stale values were restored as fresh");
+
+	batch_store_chunk_free(&chunk);
+	zassert_equal(batch_store_chunk_release(), 0, "Failed to release record");
+}
+
+static void test_record_split(void)
+{
+	int err;
+	size_t records = 0;
+	size_t entries = 0;
+	struct batch_store_chunk chunk;
+	struct cloud_data_gps *data;
+	static struct cloud_data_gps buf[GPS_COUNT];
+
+	for (size_t i = 0; i < GPS_COUNT; i++) {
+		buf[i].gps_ts = i * 1000;
+		buf[i].format = CLOUD_CODEC_GPS_FORMAT_PVT;
+		buf[i].pvt.lat = 63.43 + i * 0.001;
+		buf[i].pvt.longi = 10.39 - i * 0.001;
+		buf[i].pvt.alt = 50 + i;
+		buf[i].queued = true;
+	}
+
+	/* The entries do not fit in one record and are spread over several. */
+	err = batch_store_ringbuffer_add(BATCH_STORE_GPS, buf, GPS_COUNT, GPS_COUNT - 1);
+	zassert_equal(err, 0, "Failed to store entries, error: %d", err);
+
+	while (batch_store_chunk_get(&chunk) == 0) {
+		data = chunk.buf;
+
+		for (size_t i = 0; i < chunk.count; i++) {
+			zassert_equal(data[i].gps_ts,
+				      (entries + i) * 1000 + DATE_TIME_MOCK_OFFSET_MS,
+				      "Wrong order of entry %d", entries + i);
+		}
+
+		entries += chunk.count;
+		records++;
+
+		batch_store_chunk_free(&chunk);
+		zassert_equal(batch_store_chunk_release(), 0, "Failed to release record");
+	}
+
+	zassert_equal(entries, GPS_COUNT, "Entries were lost");
+	zassert_true(records > 1, "Entries were not split");
+}
+
+static void test_rewind(void)
+{
+	int err;
+	struct batch_store_chunk chunk;
+	struct batch_store_chunk busy;
+
+	battery_store(0);
+	battery_store(100);
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+	battery_chunk_check(&chunk, 0);
+	batch_store_chunk_free(&chunk);
+
+	/* Only one record can be read at a time. */
+	zassert_equal(batch_store_chunk_get(&busy), -EBUSY, "Read while busy");
+
+	/* The record is read again after a rewind. */
+	batch_store_chunk_rewind();
+	battery_chunk_expect(0);
+	battery_chunk_expect(100);
+	store_empty_expect();
+
+	zassert_equal(batch_store_chunk_release(), -EINVAL, "Released without a record");
+}
+
+static void test_reboot(void)
+{
+	int err;
+
+	battery_store(0);
+	battery_store(100);
+	battery_store(200);
+
+	battery_chunk_expect(0);
+
+	/* Released records stay released, and new records are added after the stored
+	 * ones.
+	 */
+	err = batch_store_init();
+	zassert_equal(err, 0, "Failed to initialize batch store, error: %d", err);
+
+	battery_store(300);
+
+	battery_chunk_expect(100);
+	battery_chunk_expect(200);
+	battery_chunk_expect(300);
+	store_empty_expect();
+
+	/* Nothing is sent again after a reboot once everything was released. */
+	err = batch_store_init();
+	zassert_equal(err, 0, "Failed to initialize batch store, error: %d", err);
+
+	store_empty_expect();
+}
+
+static void test_overfill(void)
+{
+	int err;
+	uint16_t first;
+	uint16_t expected;
+	size_t records = 0;
+	size_t stored = 400;
+	struct batch_store_chunk chunk;
+	struct cloud_data_battery *data;
+
+	/* Store more records than the partition can hold, the oldest are erased. */
+	for (size_t i = 0; i < stored; i++) {
+		battery_store(i * BATTERY_COUNT);
+	}
+
+	err = batch_store_chunk_get(&chunk);
+	zassert_equal(err, 0, "Failed to read record, error: %d", err);
+
+	data = chunk.buf;
+	first = data[0].bat;
+	zassert_true(first > 0, "Oldest records were not dropped");
+
+	batch_store_chunk_rewind();
+	batch_store_chunk_free(&chunk);
+
+	/* The remaining records are read in order, up to the newest one. */
+	expected = first;
+	while (batch_store_chunk_get(&chunk) == 0) {
+		battery_chunk_check(&chunk, expected);
+		expected += BATTERY_COUNT;
+		records++;
+
+		batch_store_chunk_free(&chunk);
+		zassert_equal(batch_store_chunk_release(), 0, "Failed to release record");
+	}
+
+	zassert_equal(expected, stored * BATTERY_COUNT, "Newest record is missing");
+	zassert_true(records < stored, "No records were dropped");
+	zassert_true(records > stored / 4, "Too many records were dropped");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(batch_store,
+		ztest_unit_test_setup_teardown(test_ringbuffer_not_full, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_ringbuffer_order, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_no_date_time, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gps_round_trip, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_modem_dynamic_round_trip, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_record_split, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_rewind, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_reboot, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_overfill, test_setup,
+					       unit_test_noop)
+	);
+
+	ztest_run_test_suite(batch_store);
+}
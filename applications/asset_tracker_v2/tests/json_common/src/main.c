@@ -948,6 +948,184 @@ static void test_encode_batch_data_object(void)
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
 
+/* Test used to verify that batch messages written with the streaming JSON writer are identical to
+ * batch messages built with cJSON.
+ */
+static void test_encode_batch_data_stream(void)
+{
+	int ret;
+	struct cloud_codec_data output;
+	struct cloud_data_battery battery[2] = {
+		[0].bat = 3600,
+		[0].bat_ts = 1000,
+		[0].queued = true,
+		/* Second entry */
+		[1].bat = 3700,
+		[1].bat_ts = 1000,
+		[1].queued = true
+	};
+	struct cloud_data_gps gps[2] = {
+		[0].pvt.longi = 10.1234567,
+		[0].pvt.lat = 62.7654321,
+		[0].pvt.acc = 24.5,
+		[0].pvt.alt = 170,
+		[0].pvt.spd = 1.25,
+		[0].pvt.hdg = 176,
+		[0].gps_ts = 1000,
+		[0].queued = true,
+		[0].format = CLOUD_CODEC_GPS_FORMAT_PVT,
+		/* Second entry */
+		[1].nmea = "$GPGGA,181908.00,6325.6414,N,01023.3520,E,1,06,1.5,58.9,M,39.5,M,,*6C",
+		[1].gps_ts = 1000,
+		[1].queued = true,
+		[1].format = CLOUD_CODEC_GPS_FORMAT_NMEA
+	};
+	struct cloud_data_modem_dynamic modem_dynamic[2] = {
+		[0].rsrp = -8,
+		[0].area = 12,
+		[0].mccmnc = "24202",
+		[0].cell = 33703719,
+		[0].ip = "10.81.183.99",
+		[0].ts = 1000,
+		[0].queued = true,
+		[0].area_code_fresh = true,
+		[0].cell_id_fresh = true,
+		[0].rsrp_fresh = true,
+		[0].ip_address_fresh = true,
+		[0].mccmnc_fresh = true,
+		/* Second entry, only RSRP is fresh. */
+		[1].rsrp = -5,
+		[1].ts = 1000,
+		[1].queued = true,
+		[1].rsrp_fresh = true
+	};
+	struct cloud_data_ui ui[2] = {
+		[0].btn = 1,
+		[0].btn_ts = 1000,
+		[0].queued = true,
+		/* Second entry is not queued. */
+		[1].btn = 2,
+		[1].btn_ts = 1000,
+		[1].queued = false
+	};
+	struct cloud_data_accelerometer accelerometer[2] = {
+		[0].values[0] = 1.5,
+		[0].values[1] = -2,
+		[0].values[2] = 9.81,
+		[0].ts = 1000,
+		[0].queued = true,
+		/* Second entry has a UNIX timestamp already. */
+		[1].values[0] = 1,
+		[1].values[1] = 2,
+		[1].values[2] = 3,
+		[1].ts = 1563968700000,
+		[1].queued = true,
+		[1].unix_ts = true
+	};
+	struct cloud_data_sensors environmental[2] = {
+		[0].hum = 50,
+		[0].temp = 23.4,
+		[0].env_ts = 1000,
+		[0].queued = true,
+		/* Second entry */
+		[1].hum = 49.5,
+		[1].temp = 23,
+		[1].env_ts = 1000,
+		[1].queued = true
+	};
+	struct json_common_batch_buf bufs[] = {
+		{ JSON_COMMON_BATTERY, battery, ARRAY_SIZE(battery), DATA_BATTERY },
+		{ JSON_COMMON_UI, ui, ARRAY_SIZE(ui), DATA_BUTTON },
+		{ JSON_COMMON_GPS, gps, ARRAY_SIZE(gps), DATA_GPS },
+		{ JSON_COMMON_SENSOR, environmental, ARRAY_SIZE(environmental),
+		  DATA_ENVIRONMENTALS },
+		{ JSON_COMMON_ACCELEROMETER, accelerometer, ARRAY_SIZE(accelerometer),
+		  DATA_MOVEMENT },
+		{ JSON_COMMON_MODEM_DYNAMIC, modem_dynamic, ARRAY_SIZE(modem_dynamic),
+		  DATA_MODEM_DYNAMIC },
+	};
+	struct json_common_batch batch = {
+		.bufs = bufs,
+		.count = ARRAY_SIZE(bufs)
+	};
+
+	ret = json_common_batch_encode(&output, &batch);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+	zassert_equal(output.len, strlen(output.buf), "Output length is wrong");
+
+	/* All entries should be unqueued. Requeue them to encode them with cJSON. */
+	zassert_false(battery[0].queued || battery[1].queued, "Entry not unqueued");
+	zassert_false(gps[0].queued || gps[1].queued, "Entry not unqueued");
+	zassert_false(environmental[0].queued || environmental[1].queued, "Entry not unqueued");
+	zassert_false(accelerometer[0].queued || accelerometer[1].queued, "Entry not unqueued");
+	zassert_false(modem_dynamic[0].queued || modem_dynamic[1].queued, "Entry not unqueued");
+	zassert_false(ui[0].queued, "Entry not unqueued");
+
+	battery[0].queued = battery[1].queued = true;
+	ui[0].queued = true;
+	gps[0].queued = gps[1].queued = true;
+	environmental[0].queued = environmental[1].queued = true;
+	accelerometer[0].queued = accelerometer[1].queued = true;
+	modem_dynamic[0].queued = modem_dynamic[1].queued = true;
+
+	for (size_t i = 0; i < ARRAY_SIZE(bufs); i++) {
+		ret = json_common_batch_data_add(dummy.root_obj, bufs[i].type, bufs[i].buf,
+						 bufs[i].count, bufs[i].object_label);
+		zassert_equal(0, ret, "Return value %d is wrong", ret);
+	}
+
+	ret = encoded_output_check(dummy.root_obj, output.buf, -1);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	k_free(output.buf);
+
+	/* No queued entries left. */
+	ret = json_common_batch_encode(&output, &batch);
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
+}
+
+/* Test used to verify that batches that do not fit in one message are split into several. */
+static void test_encode_batch_data_stream_chunked(void)
+{
+	int ret;
+	int messages = 0;
+	size_t entries = 0;
+	struct cloud_codec_data output;
+	static struct cloud_data_battery battery[100];
+	struct json_common_batch_buf bufs[] = {
+		{ JSON_COMMON_BATTERY, battery, ARRAY_SIZE(battery), DATA_BATTERY },
+	};
+	struct json_common_batch batch = {
+		.bufs = bufs,
+		.count = ARRAY_SIZE(bufs)
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(battery); i++) {
+		battery[i].bat = 3600 + i;
+		battery[i].bat_ts = 1000;
+		battery[i].queued = true;
+	}
+
+	while ((ret = json_common_batch_encode(&output, &batch)) == 0) {
+		char *entry = output.buf;
+
+		zassert_true(output.len < CONFIG_CLOUD_CODEC_BATCH_BUFFER_SIZE,
+			     "Message is too large");
+
+		while ((entry = strstr(entry, "\"" DATA_VALUE "\"")) != NULL) {
+			entries++;
+			entry++;
+		}
+
+		k_free(output.buf);
+		messages++;
+	}
+
+	zassert_equal(-ENODATA, ret, "Return value %d is wrong.", ret);
+	zassert_true(messages > 1, "Batch was not split");
+	zassert_equal(ARRAY_SIZE(battery), entries, "Wrong number of entries encoded");
+}
+
 /* Test used to verify encoding and decoding of data structures that contain floating point
  * values. Floating point values cannot be exactly represented in binary so they cannot be compared
  * with a predefined JSON string schema.
@@ -1286,6 +1464,10 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_encode_batch_data_object,
 					       test_setup_object,
 					       test_teardown_object),
+		ztest_unit_test_setup_teardown(test_encode_batch_data_stream,
+					       test_setup_object,
+					       test_teardown_object),
+		ztest_unit_test(test_encode_batch_data_stream_chunked),
 
 		/* GPS floating point values comparison */
 		ztest_unit_test_setup_teardown(test_floating_point_encoding_gps,
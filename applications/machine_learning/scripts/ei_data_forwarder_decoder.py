@@ -0,0 +1,162 @@
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""Decode binary frames sent by the nRF Machine Learning data forwarder.
+
+The decoded sensor samples are written as lines of comma-separated values,
+which is the format expected by Edge Impulse's data forwarder.
+"""
+
+import argparse
+import logging
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER_SIZE = 4
+FRAME_CRC_SIZE = 2
+
+FRAME_FORMATS = {
+    0x01: ('f', 4, 1),
+    0x02: ('h', 2, 100),
+}
+
+
+def crc16_ccitt(seed, data):
+    # Same algorithm as Zephyr's crc16_ccitt().
+    for b in data:
+        e = (seed ^ b) & 0xFF
+        f = (e ^ (e << 4)) & 0xFF
+        seed = (seed >> 8) ^ (f << 8) ^ (f << 3) ^ (f >> 4)
+        seed &= 0xFFFF
+    return seed
+
+
+class FrameDecoder:
+    def __init__(self):
+        self.buf = bytearray()
+        self.expected_seq = None
+        self.lost_cnt = 0
+        self.crc_err_cnt = 0
+
+    def _frame_len(self):
+        if len(self.buf) < FRAME_HEADER_SIZE:
+            return None
+
+        fmt = FRAME_FORMATS.get(self.buf[1])
+        if fmt is None:
+            return 0
+
+        return FRAME_HEADER_SIZE + self.buf[3] * fmt[1] + FRAME_CRC_SIZE
+
+    def _decode(self, frame):
+        fmt_char, value_size, scale = FRAME_FORMATS[frame[1]]
+        seq = frame[2]
+        cnt = frame[3]
+
+        if self.expected_seq is not None and seq != self.expected_seq:
+            lost = (seq - self.expected_seq) & 0xFF
+            self.lost_cnt += lost
+            logging.warning('Lost {} frame(s)'.format(lost))
+        self.expected_seq = (seq + 1) & 0xFF
+
+        values = struct.unpack_from('<{}{}'.format(cnt, fmt_char), frame,
+                                    FRAME_HEADER_SIZE)
+        return [v / scale for v in values]
+
+    def feed(self, data):
+        self.buf += data
+        samples = []
+
+        while True:
+            sync_idx = self.buf.find(FRAME_SYNC)
+            if sync_idx < 0:
+                self.buf.clear()
+                break
+            del self.buf[:sync_idx]
+
+            frame_len = self._frame_len()
+            if frame_len is None:
+                break
+            if frame_len == 0:
+                # Unknown format, look for the next sync byte.
+                del self.buf[:1]
+                continue
+            if len(self.buf) < frame_len:
+                break
+
+            frame = bytes(self.buf[:frame_len])
+            crc_pos = frame_len - FRAME_CRC_SIZE
+            crc = struct.unpack_from('<H', frame, crc_pos)[0]
+
+            if crc16_ccitt(0xFFFF, frame[:crc_pos]) != crc:
+                self.crc_err_cnt += 1
+                del self.buf[:1]
+                continue
+
+            del self.buf[:frame_len]
+            samples.append(self._decode(frame))
+
+        return samples
+
+
+def open_input(args):
+    if args.port:
+        import serial
+        return serial.Serial(args.port, args.baudrate, timeout=0.1)
+
+    if args.file == '-':
+        return sys.stdin.buffer
+
+    return open(args.file, 'rb')
+
+
+def open_output(args):
+    if args.output == '-':
+        return sys.stdout
+
+    return open(args.output, 'w', newline='')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decode binary frames of the nRF Machine Learning data forwarder to CSV')
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('-p', '--port', help='Serial port used to receive frames')
+    src.add_argument('-f', '--file', help='File with received frames ("-" for stdin)')
+    parser.add_argument('-b', '--baudrate', type=int, default=115200,
+                        help='Serial port baudrate')
+    parser.add_argument('-o', '--output', default='-',
+                        help='Output file or serial device for CSV lines (default: stdout)')
+    parser.add_argument('--debug', action='store_true', help='Enable debug logs')
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.DEBUG if args.debug else logging.INFO,
+                        format='%(levelname)s: %(message)s')
+
+    decoder = FrameDecoder()
+    inp = open_input(args)
+    out = open_output(args)
+
+    try:
+        while True:
+            data = inp.read(256) if args.port else inp.read1(256)
+            if not data:
+                if args.port:
+                    continue
+                break
+
+            for sample in decoder.feed(data):
+                out.write(','.join('{:.2f}'.format(v) for v in sample) + '\r\n')
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+
+    logging.debug('Lost frames: {}, CRC errors: {}'.format(decoder.lost_cnt,
+                                                           decoder.crc_err_cnt))
+
+
+if __name__ == '__main__':
+    main()
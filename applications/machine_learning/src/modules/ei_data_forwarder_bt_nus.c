@@ -209,29 +209,15 @@ static void send_queued_fn(struct k_work *w)
 	}
 }
 
-static bool handle_sensor_event(const struct sensor_event *event)
+static void forward_sample(const float *data_ptr, size_t data_cnt)
 {
-	if ((event->descr != handled_sensor_event_descr) &&
-	    strcmp(event->descr, handled_sensor_event_descr)) {
-		return false;
-	}
-
-	if ((state != STATE_ACTIVE) || !is_nus_conn_valid(nus_conn, conn_state)) {
-		return false;
-	}
-
-	__ASSERT_NO_MSG(sensor_event_get_data_cnt(event) > 0);
-
 	static uint8_t buf[DATA_BUF_SIZE];
-	int pos = ei_data_forwarder_parse_data(sensor_event_get_data_ptr(event),
-					       sensor_event_get_data_cnt(event),
-					       (char *)buf,
-					       sizeof(buf));
+	int pos = ei_data_forwarder_parse_data(data_ptr, data_cnt, (char *)buf, sizeof(buf));
 
 	if (pos < 0) {
 		LOG_ERR("EI data forwader parsing error: %d", pos);
 		report_error();
-		return false;
+		return;
 	}
 
 	if (pipeline_cnt < PIPELINE_MAX_CNT) {
@@ -253,6 +239,28 @@ static bool handle_sensor_event(const struct sensor_event *event)
 			sys_slist_append(&send_queue, &packet->node);
 		}
 	}
+}
+
+static bool handle_sensor_event(const struct sensor_event *event)
+{
+	if ((event->descr != handled_sensor_event_descr) &&
+	    strcmp(event->descr, handled_sensor_event_descr)) {
+		return false;
+	}
+
+	if ((state != STATE_ACTIVE) || !is_nus_conn_valid(nus_conn, conn_state)) {
+		return false;
+	}
+
+	__ASSERT_NO_MSG(sensor_event_get_data_cnt(event) > 0);
+
+	const float *data_ptr = sensor_event_get_data_ptr(event);
+	size_t sample_data_cnt = sensor_event_get_sample_data_cnt(event);
+
+	/* Every sample is forwarded in a separate packet. */
+	for (size_t i = 0; (i < event->sample_cnt) && (state == STATE_ACTIVE); i++) {
+		forward_sample(&data_ptr[i * sample_data_cnt], sample_data_cnt);
+	}
 
 	return false;
 }
@@ -97,6 +97,9 @@ static bool handle_sensor_event(const struct sensor_event *event)
 
 	__ASSERT_NO_MSG(sensor_event_get_data_cnt(event) > 0);
 
+	const float *data_ptr = sensor_event_get_data_ptr(event);
+	size_t sample_data_cnt = sensor_event_get_sample_data_cnt(event);
+
 	/* Ensure that previous sensor_event was sent. */
 	if (!atomic_cas(&uart_busy, false, true)) {
 		LOG_WRN("UART not ready");
@@ -106,17 +109,23 @@ static bool handle_sensor_event(const struct sensor_event *event)
 	}
 
 	static uint8_t buf[UART_BUF_SIZE];
+	int pos = 0;
+
+	/* Every sample is forwarded as a separate line or frame. */
+	for (size_t i = 0; i < event->sample_cnt; i++) {
+		int len = ei_data_forwarder_parse_data(&data_ptr[i * sample_data_cnt],
+						       sample_data_cnt,
+						       (char *)&buf[pos],
+						       sizeof(buf) - pos);
+
+		if (len < 0) {
+			atomic_cas(&uart_busy, true, false);
+			LOG_ERR("EI data forwader parsing error: %d", len);
+			report_error();
+			return false;
+		}
 
-	int pos = ei_data_forwarder_parse_data(sensor_event_get_data_ptr(event),
-					       sensor_event_get_data_cnt(event),
-					       (char *)buf,
-					       sizeof(buf));
-
-	if (pos < 0) {
-		atomic_cas(&uart_busy, true, false);
-		LOG_ERR("EI data forwader parsing error: %d", pos);
-		report_error();
-		return false;
+		pos += len;
 	}
 
 	int err = uart_tx(dev, buf, pos, SYS_FOREVER_MS);
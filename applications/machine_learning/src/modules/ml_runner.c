@@ -132,7 +132,8 @@ static void start_prediction(void)
 		}
 	}
 
-	if (ml_control & ML_FIRST_PREDICTION) {
+	if ((ml_control & ML_FIRST_PREDICTION) ||
+	    IS_ENABLED(CONFIG_EI_WRAPPER_CONTINUOUS)) {
 		window_shift = 0;
 		frame_shift = 0;
 	} else {
@@ -202,12 +203,17 @@ static bool handle_sensor_event(const struct sensor_event *event)
 		return false;
 	}
 
-	int err = ei_wrapper_add_data(sensor_event_get_data_ptr(event),
-				      sensor_event_get_data_cnt(event));
+	const float *data_ptr = sensor_event_get_data_ptr(event);
+	size_t sample_data_cnt = sensor_event_get_sample_data_cnt(event);
 
-	if (err) {
-		LOG_ERR("Cannot add data for EI wrapper (err %d)", err);
-		report_error();
+	for (size_t i = 0; i < event->sample_cnt; i++) {
+		int err = ei_wrapper_add_data(&data_ptr[i * sample_data_cnt], sample_data_cnt);
+
+		if (err) {
+			LOG_ERR("Cannot add data for EI wrapper (err %d)", err);
+			report_error();
+			break;
+		}
 	}
 
 	return false;
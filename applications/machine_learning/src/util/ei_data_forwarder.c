@@ -6,8 +6,21 @@
 
 #include <zephyr.h>
 #include <stdio.h>
+#include <math.h>
+#include <sys/byteorder.h>
+#include <sys/crc.h>
 #include "ei_data_forwarder.h"
 
+#define FRAME_SYNC		0xA5
+#define FRAME_HEADER_SIZE	4
+#define FRAME_CRC_SIZE		sizeof(uint16_t)
+
+#define FRAME_FORMAT_FLOAT32	0x01
+#define FRAME_FORMAT_INT16	0x02
+
+/* Fixed-point values keep the precision of the CSV format (two decimal places). */
+#define INT16_SCALE		100
+
 
 static int snprintf_error_check(int res, size_t buf_size)
 {
@@ -20,8 +33,8 @@ static int snprintf_error_check(int res, size_t buf_size)
 	return 0;
 }
 
-int ei_data_forwarder_parse_data(const float *data_ptr, size_t data_cnt,
-				 char *buf, size_t buf_size)
+static int parse_data_csv(const float *data_ptr, size_t data_cnt,
+			  char *buf, size_t buf_size)
 {
 	int pos = 0;
 
@@ -47,3 +60,88 @@ int ei_data_forwarder_parse_data(const float *data_ptr, size_t data_cnt,
 
 	return pos;
 }
+
+static int put_value_float32(float value, uint8_t *buf)
+{
+	uint32_t raw;
+
+	BUILD_ASSERT(sizeof(raw) == sizeof(value));
+	memcpy(&raw, &value, sizeof(raw));
+	sys_put_le32(raw, buf);
+
+	return sizeof(raw);
+}
+
+static int put_value_int16(float value, uint8_t *buf)
+{
+	/* Converting NaN to an integer is undefined behavior. */
+	if (!isfinite(value)) {
+		return -EINVAL;
+	}
+
+	float scaled = value * INT16_SCALE;
+
+	scaled += (scaled < 0) ? (-0.5f) : (0.5f);
+
+	if ((scaled < INT16_MIN) || (scaled > INT16_MAX)) {
+		return -ERANGE;
+	}
+
+	sys_put_le16((int16_t)scaled, buf);
+
+	return sizeof(int16_t);
+}
+
+static int parse_data_binary(const float *data_ptr, size_t data_cnt,
+			     uint8_t *buf, size_t buf_size)
+{
+	static uint8_t seq;
+
+	const bool use_int16 = IS_ENABLED(CONFIG_ML_APP_EI_DATA_FORWARDER_FORMAT_INT16);
+	size_t value_size = use_int16 ? sizeof(int16_t) : sizeof(float);
+
+	if (data_cnt > UINT8_MAX) {
+		return -EINVAL;
+	}
+
+	if (buf_size < (FRAME_HEADER_SIZE + data_cnt * value_size + FRAME_CRC_SIZE)) {
+		return -ENOBUFS;
+	}
+
+	int pos = 0;
+
+	buf[pos++] = FRAME_SYNC;
+	buf[pos++] = use_int16 ? FRAME_FORMAT_INT16 : FRAME_FORMAT_FLOAT32;
+	buf[pos++] = seq;
+	buf[pos++] = data_cnt;
+
+	for (size_t i = 0; i < data_cnt; i++) {
+		int len = use_int16 ? put_value_int16(data_ptr[i], &buf[pos]) :
+				      put_value_float32(data_ptr[i], &buf[pos]);
+
+		if (len < 0) {
+			return len;
+		}
+		pos += len;
+	}
+
+	sys_put_le16(crc16_ccitt(0xffff, buf, pos), &buf[pos]);
+	pos += FRAME_CRC_SIZE;
+
+	/* Sequence number is updated for every encoded frame, also if the transport drops it
+	 * later. The gaps let the decoder detect lost frames.
+	 */
+	seq++;
+
+	return pos;
+}
+
+int ei_data_forwarder_parse_data(const float *data_ptr, size_t data_cnt,
+				 char *buf, size_t buf_size)
+{
+	if (IS_ENABLED(CONFIG_ML_APP_EI_DATA_FORWARDER_FORMAT_CSV)) {
+		return parse_data_csv(data_ptr, data_cnt, buf, buf_size);
+	}
+
+	return parse_data_binary(data_ptr, data_cnt, (uint8_t *)buf, buf_size);
+}
@@ -8,6 +8,18 @@
 #define _EI_DATA_FORWARDER_H_
 
 
+/** Convert sensor data to the format used to forward it to the host.
+ *
+ * Depending on the selected data format, the data is converted either into a single line of
+ * comma-separated values or into a binary frame.
+ *
+ * @param[in]  data_ptr Pointer to the sensor data.
+ * @param[in]  data_cnt Number of sensor values.
+ * @param[out] buf      Buffer used to store the result.
+ * @param[in]  buf_size Size of the buffer.
+ *
+ * @return Number of bytes written to the buffer or a (negative) error code.
+ */
 int ei_data_forwarder_parse_data(const float *data_ptr, size_t data_cnt,
 				 char *buf, size_t buf_size);
 
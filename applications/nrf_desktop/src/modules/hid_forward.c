@@ -43,6 +43,7 @@ BUILD_ASSERT(CFG_CHAN_MAX_RSP_POLL_CNT <= UCHAR_MAX);
 struct enqueued_report {
 	sys_snode_t node;
 	struct hid_report_event *report;
+	uint32_t timestamp;
 };
 
 struct counted_list {
@@ -84,11 +85,36 @@ struct hids_peripheral {
 	uint8_t sub_id;
 };
 
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+enum hid_forward_opt {
+	HID_FORWARD_OPT_LAT_STATS,
+	HID_FORWARD_OPT_LAT_RESET,
+
+	HID_FORWARD_OPT_COUNT
+};
+
+static const char * const opt_descr[] = {
+	[HID_FORWARD_OPT_LAT_STATS] = "lat_stats",
+	[HID_FORWARD_OPT_LAT_RESET] = "lat_reset"
+};
+
+struct latency_stats {
+	uint32_t report_cnt;
+	uint32_t merged_cnt;
+	uint64_t latency_sum;
+	uint32_t latency_max;
+};
+#endif
+
 static struct subscriber subscribers[CONFIG_USB_HID_DEVICE_COUNT];
 static bt_addr_le_t peripheral_address[CONFIG_BT_MAX_PAIRED];
 static struct hids_peripheral peripherals[CONFIG_BT_MAX_CONN];
 static bool suspended;
 
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+static struct latency_stats lat_stats;
+#endif
+
 
 static void hogp_out_rep_write_cb(struct bt_hogp *hogp, struct bt_hogp_rep_info *rep, uint8_t err);
 static int send_hid_out_report(struct bt_hogp *hogp, const uint8_t *data, size_t size);
@@ -179,6 +205,24 @@ static size_t next_id(size_t id, size_t max)
 	return (id + 1) % max;
 }
 
+static void latency_stats_report(uint32_t timestamp)
+{
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+	uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() - timestamp);
+
+	lat_stats.report_cnt++;
+	lat_stats.latency_sum += latency;
+	lat_stats.latency_max = MAX(lat_stats.latency_max, latency);
+#endif
+}
+
+static void latency_stats_merged(void)
+{
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+	lat_stats.merged_cnt++;
+#endif
+}
+
 static int get_input_report_idx(uint8_t report_id)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(input_reports); i++) {
@@ -346,7 +390,8 @@ static void migrate_enqueued_reports(struct enqueued_reports *dst_reports,
 
 static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 			       size_t irep_idx,
-			       struct hid_report_event *report)
+			       struct hid_report_event *report,
+			       uint32_t timestamp)
 {
 	__ASSERT_NO_MSG(irep_idx < ARRAY_SIZE(enqueued_reports->reports));
 
@@ -368,11 +413,73 @@ static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 		__ASSERT_NO_MSG(false);
 	} else {
 		item->report = report;
+		item->timestamp = timestamp;
 		sys_slist_append(&reports->list, &item->node);
 		reports->count++;
 	}
 }
 
+static int16_t mouse_report_x_get(const uint8_t *xy)
+{
+	/* Sign extend the 12-bit value. */
+	return (int16_t)((xy[0] | (xy[1] << 8)) << 4) >> 4;
+}
+
+static int16_t mouse_report_y_get(const uint8_t *xy)
+{
+	return (int16_t)(((xy[1] >> 4) | (xy[2] << 4)) << 4) >> 4;
+}
+
+static void mouse_report_xy_set(uint8_t *xy, int16_t x, int16_t y)
+{
+	xy[0] = x & 0xff;
+	xy[1] = ((y << 4) & 0xf0) | ((x >> 8) & 0x0f);
+	xy[2] = (y >> 4) & 0xff;
+}
+
+static bool merge_mouse_report(struct enqueued_reports *enqueued_reports,
+			       size_t irep_idx, const uint8_t *data, size_t size)
+{
+	/* Mouse report: buttons bitmask, wheel, 12-bit X and 12-bit Y. */
+	BUILD_ASSERT(REPORT_SIZE_MOUSE == 5);
+
+	struct counted_list *reports = &enqueued_reports->reports[irep_idx];
+	sys_snode_t *node = sys_slist_peek_tail(&reports->list);
+
+	if (!node || (size != REPORT_SIZE_MOUSE)) {
+		return false;
+	}
+
+	struct enqueued_report *item = CONTAINER_OF(node, __typeof__(*item), node);
+	uint8_t *prev = &item->report->dyndata.data[sizeof(uint8_t)];
+
+	__ASSERT_NO_MSG(item->report->dyndata.data[0] == REPORT_ID_MOUSE);
+
+	if (prev[0] != data[0]) {
+		/* Buttons state changed, the change cannot be merged. */
+		return false;
+	}
+
+	int16_t wheel = (int8_t)prev[1] + (int8_t)data[1];
+	int16_t x = mouse_report_x_get(&prev[2]) + mouse_report_x_get(&data[2]);
+	int16_t y = mouse_report_y_get(&prev[2]) + mouse_report_y_get(&data[2]);
+
+	if ((wheel < MOUSE_REPORT_WHEEL_MIN) || (wheel > MOUSE_REPORT_WHEEL_MAX) ||
+	    (x < MOUSE_REPORT_XY_MIN) || (x > MOUSE_REPORT_XY_MAX) ||
+	    (y < MOUSE_REPORT_XY_MIN) || (y > MOUSE_REPORT_XY_MAX)) {
+		/* Merged values would not fit into the report. */
+		return false;
+	}
+
+	prev[1] = wheel;
+	mouse_report_xy_set(&prev[2], x, y);
+
+	/* The enqueued report keeps the timestamp of the older data. */
+	latency_stats_merged();
+
+	return true;
+}
+
 static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 			       const uint8_t *data, size_t size)
 {
@@ -401,6 +508,14 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 		return;
 	}
 
+	uint32_t timestamp = k_cycle_get_32();
+
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_MERGE_MOUSE_REPORTS) &&
+	    sub->busy && (report_id == REPORT_ID_MOUSE) &&
+	    merge_mouse_report(&per->enqueued_reports, irep_idx, data, size)) {
+		return;
+	}
+
 	struct hid_report_event *report = new_hid_report_event(size + sizeof(report_id));
 
 	report->source = per;
@@ -414,10 +529,12 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 		__ASSERT_NO_MSG(!is_report_enqueued(&per->enqueued_reports, irep_idx));
 
 		EVENT_SUBMIT(report);
+		latency_stats_report(timestamp);
 		per->enqueued_reports.last_idx = irep_idx;
 		sub->busy = true;
 	} else {
-		enqueue_hid_report(&per->enqueued_reports, irep_idx, report);
+		enqueue_hid_report(&per->enqueued_reports, irep_idx, report,
+				   timestamp);
 	}
 }
 
@@ -1195,6 +1312,7 @@ static void send_enqueued_report(struct subscriber *sub)
 
 	if (item) {
 		EVENT_SUBMIT(item->report);
+		latency_stats_report(item->timestamp);
 
 		k_free(item);
 
@@ -1358,6 +1476,56 @@ static bool handle_hid_report_event(const struct hid_report_event *event)
 	return false;
 }
 
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+static void update_config(const uint8_t opt_id, const uint8_t *data,
+			  const size_t size)
+{
+	switch (opt_id) {
+	case HID_FORWARD_OPT_LAT_RESET:
+		memset(&lat_stats, 0, sizeof(lat_stats));
+		LOG_INF("Latency statistics reset");
+		break;
+
+	default:
+		LOG_WRN("Unsupported set opt: %" PRIu8, opt_id);
+		break;
+	}
+}
+
+static void fetch_config(const uint8_t opt_id, uint8_t *data, size_t *size)
+{
+	switch (opt_id) {
+	case HID_FORWARD_OPT_LAT_STATS:
+	{
+		uint32_t latency_avg = 0;
+
+		if (lat_stats.report_cnt > 0) {
+			latency_avg = lat_stats.latency_sum / lat_stats.report_cnt;
+		}
+
+		size_t pos = 0;
+
+		sys_put_le32(lat_stats.report_cnt, &data[pos]);
+		pos += sizeof(lat_stats.report_cnt);
+		sys_put_le32(lat_stats.merged_cnt, &data[pos]);
+		pos += sizeof(lat_stats.merged_cnt);
+		sys_put_le32(latency_avg, &data[pos]);
+		pos += sizeof(latency_avg);
+		sys_put_le32(lat_stats.latency_max, &data[pos]);
+		pos += sizeof(lat_stats.latency_max);
+
+		__ASSERT_NO_MSG(pos <= CONFIG_CHANNEL_FETCHED_DATA_MAX_SIZE);
+		*size = pos;
+		break;
+	}
+
+	default:
+		LOG_WRN("Unsupported fetch opt: %" PRIu8, opt_id);
+		break;
+	}
+}
+#endif
+
 static bool event_handler(const struct event_header *eh)
 {
 	if (is_hid_report_sent_event(eh)) {
@@ -1495,10 +1663,19 @@ static bool event_handler(const struct event_header *eh)
 
 	if (IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE)) {
 		if (is_config_event(eh)) {
-			return handle_config_event(cast_config_event(eh));
+			bool consumed = handle_config_event(cast_config_event(eh));
+
+			if (consumed || !IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS)) {
+				return consumed;
+			}
 		}
 	}
 
+#if CONFIG_DESKTOP_HID_FORWARD_LATENCY_STATS
+	GEN_CONFIG_EVENT_HANDLERS(STRINGIFY(MODULE), opt_descr, update_config,
+				  fetch_config);
+#endif
+
 	/* If event is unhandled, unsubscribe. */
 	__ASSERT_NO_MSG(false);
 
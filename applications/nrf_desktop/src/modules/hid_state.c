@@ -14,7 +14,6 @@
 #include <sys/types.h>
 
 #include <zephyr/types.h>
-#include <sys/slist.h>
 #include <sys/util.h>
 #include <sys/byteorder.h>
 
@@ -85,25 +84,31 @@ struct item {
 struct items {
 	uint8_t item_count_max; /**< Maximal numer of items in this set. */
 	uint8_t item_count; /**< Current number of items in this set. */
+	uint16_t usage_bm_base; /**< First usage ID tracked by the bitmask (0 if unused). */
+	uint8_t usage_bm; /**< Bitmask of active items with usage ID within the tracked range. */
 	struct item item[ITEM_COUNT]; /**< Items set. Browse from the end. */
 };
 
 /**@brief Enqueued HID state item. */
 struct item_event {
-	sys_snode_t node; /**< Event queue linked list node. */
 	struct item item; /**< HID state item which has been enqueued. */
 	uint32_t timestamp; /**< HID event timestamp. */
 };
 
-/**@brief Event queue. */
+/**@brief Event queue.
+ *
+ * Statically allocated ring buffer. The queue is accessed only from
+ * the event handler context and does not require locking.
+ */
 struct eventq {
-	sys_slist_t root;
-	size_t len;
+	struct item_event event[CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE];
+	uint8_t head; /**< Index of the oldest event. */
+	uint8_t len; /**< Number of enqueued events. */
 };
 
 /**@brief Axis data. */
 struct axis_data {
-	int16_t axis[AXIS_COUNT]; /**< Array of axes. */
+	int32_t axis[AXIS_COUNT]; /**< Array of axis accumulators. */
 	uint8_t axis_count; /**< Number of axes in this array. */
 };
 
@@ -143,8 +148,7 @@ struct hid_state {
 };
 
 
-static const struct report_data empty_rd = {
-			.eventq.root = SYS_SLIST_STATIC_INIT(&empty_rd.eventq.root)};
+static const struct report_data empty_rd;
 
 static uint8_t report_data_index[REPORT_ID_COUNT];
 static uint8_t report_state_index[REPORT_ID_COUNT];
@@ -230,16 +234,7 @@ static int usage_id_compare(const void *a, const void *b)
 
 static void eventq_reset(struct eventq *eventq)
 {
-	struct item_event *event;
-	struct item_event *tmp;
-
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&eventq->root, event, tmp, node) {
-		sys_slist_remove(&eventq->root, NULL, &event->node);
-
-		k_free(event);
-	}
-
-	sys_slist_init(&eventq->root);
+	eventq->head = 0;
 	eventq->len = 0;
 }
 
@@ -251,65 +246,55 @@ static bool eventq_is_full(const struct eventq *eventq)
 
 static bool eventq_is_empty(struct eventq *eventq)
 {
-	bool empty = sys_slist_is_empty(&eventq->root);
+	return (eventq->len == 0);
+}
 
-	__ASSERT_NO_MSG(!empty == (eventq->len != 0));
+static struct item_event *eventq_peek(struct eventq *eventq, size_t pos)
+{
+	__ASSERT_NO_MSG(pos < eventq->len);
 
-	return empty;
+	return &eventq->event[(eventq->head + pos) % ARRAY_SIZE(eventq->event)];
 }
 
-static struct item_event *eventq_get(struct eventq *eventq)
+static bool eventq_get(struct eventq *eventq, struct item_event *event)
 {
-	sys_snode_t *node = sys_slist_get(&eventq->root);
-
-	if (!node) {
-		return NULL;
+	if (eventq_is_empty(eventq)) {
+		return false;
 	}
 
+	*event = *eventq_peek(eventq, 0);
+
+	eventq->head = (eventq->head + 1) % ARRAY_SIZE(eventq->event);
 	eventq->len--;
 
-	return CONTAINER_OF(node, struct item_event, node);
+	return true;
 }
 
 static void eventq_append(struct eventq *eventq, uint16_t usage_id, int16_t value)
 {
-	struct item_event *hid_event = k_malloc(sizeof(*hid_event));
-
-	if (!hid_event) {
-		LOG_ERR("Failed to allocate HID event");
+	if (eventq_is_full(eventq)) {
+		LOG_ERR("No space for HID event");
 		/* Should never happen. */
 		__ASSERT_NO_MSG(false);
 		return;
 	}
 
+	size_t idx = (eventq->head + eventq->len) % ARRAY_SIZE(eventq->event);
+	struct item_event *hid_event = &eventq->event[idx];
+
 	hid_event->item.usage_id = usage_id;
 	hid_event->item.value = value;
 	hid_event->timestamp = k_uptime_get_32();
 
-	/* Add a new event to the queue. */
-	sys_slist_append(&eventq->root, &hid_event->node);
-
 	eventq->len++;
 }
 
-static void eventq_region_purge(struct eventq *eventq,
-				sys_snode_t *last_to_purge)
+static void eventq_region_purge(struct eventq *eventq, size_t cnt)
 {
-	sys_snode_t *tmp;
-	sys_snode_t *tmp_safe;
-	size_t cnt = 0;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, tmp, tmp_safe) {
-		sys_slist_remove(&eventq->root, NULL, tmp);
-
-		k_free(CONTAINER_OF(tmp, struct item_event, node));
-		cnt++;
-
-		if (tmp == last_to_purge) {
-			break;
-		}
-	}
+	__ASSERT_NO_MSG(cnt <= eventq->len);
 
+	/* Events are always removed from the beginning of the queue. */
+	eventq->head = (eventq->head + cnt) % ARRAY_SIZE(eventq->event);
 	eventq->len -= cnt;
 
 	LOG_WRN("%u stale events removed from the queue!", cnt);
@@ -320,11 +305,10 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 {
 	/* Find timed out events. */
 
-	sys_snode_t *first_valid;
+	size_t first_valid;
 
-	SYS_SLIST_FOR_EACH_NODE(&eventq->root, first_valid) {
-		uint32_t diff = timestamp - CONTAINER_OF(
-			first_valid, struct item_event, node)->timestamp;
+	for (first_valid = 0; first_valid < eventq->len; first_valid++) {
+		uint32_t diff = timestamp - eventq_peek(eventq, first_valid)->timestamp;
 
 		if (diff < CONFIG_DESKTOP_HID_REPORT_EXPIRATION) {
 			break;
@@ -335,17 +319,11 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 	 * key down.
 	 */
 
-	sys_snode_t *maxfound = sys_slist_peek_head(&eventq->root);
-	size_t maxfound_pos = 0;
-
-	sys_snode_t *cur;
-	size_t cur_pos = 0;
+	size_t maxfound = 0;
+	size_t purge_cnt = 0;
 
-	sys_snode_t *tmp_safe;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, cur, tmp_safe) {
-		const struct item cur_item =
-			CONTAINER_OF(cur, struct item_event, node)->item;
+	for (size_t cur = 0; cur < eventq->len; cur++) {
+		const struct item cur_item = eventq_peek(eventq, cur)->item;
 
 		if (cur_item.value > 0) {
 			/* Every key down must be paired with key up.
@@ -354,19 +332,10 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 			 */
 
 			unsigned int hit_count = cur_item.value;
-			sys_snode_t *j = cur;
-			size_t j_pos = cur_pos;
-
-			SYS_SLIST_ITERATE_FROM_NODE(&eventq->root, j) {
-				j_pos++;
-				if (j == first_valid) {
-					break;
-				}
+			size_t j;
 
-				const struct item item =
-					CONTAINER_OF(j,
-						     struct item_event,
-						     node)->item;
+			for (j = cur + 1; j < first_valid; j++) {
+				const struct item item = eventq_peek(eventq, j)->item;
 
 				if (cur_item.usage_id == item.usage_id) {
 					hit_count += item.value;
@@ -380,14 +349,13 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 				}
 			}
 
-			if (j == first_valid) {
+			if (j >= first_valid) {
 				/* Pair not found. */
 				break;
 			}
 
-			if (j_pos > maxfound_pos) {
+			if (j > maxfound) {
 				maxfound = j;
-				maxfound_pos = j_pos;
 			}
 		}
 
@@ -400,29 +368,12 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 			/* All events up to this point have pairs and can
 			 * be deleted.
 			 */
-			eventq_region_purge(eventq, maxfound);
+			purge_cnt = maxfound + 1;
 		}
-
-		cur_pos++;
 	}
-}
-
-static void sort_by_usage_id(struct item items[], size_t array_size)
-{
-	for (size_t k = 0; k < array_size; k++) {
-		size_t id = k;
-
-		for (size_t l = k + 1; l < array_size; l++) {
-			if (items[l].usage_id < items[id].usage_id) {
-				id = l;
-			}
-		}
-		if (id != k) {
-			struct item tmp = items[k];
 
-			items[k] = items[id];
-			items[id] = tmp;
-		}
+	if (purge_cnt > 0) {
+		eventq_region_purge(eventq, purge_cnt);
 	}
 }
 
@@ -430,6 +381,7 @@ static void clear_items(struct items *items)
 {
 	memset(items->item, 0, sizeof(items->item));
 	items->item_count = 0;
+	items->usage_bm = 0;
 }
 
 static void clear_axes(struct axis_data *axes)
@@ -437,6 +389,18 @@ static void clear_axes(struct axis_data *axes)
 	memset(axes->axis, 0, sizeof(axes->axis));
 }
 
+/**@brief Add a delta to the axis accumulator.
+ *
+ * The accumulator saturates instead of wrapping around when motion piles up.
+ * The lower bound is -INT32_MAX, so that the value can be safely negated.
+ */
+static void axis_add(struct axis_data *axes, size_t idx, int16_t delta)
+{
+	int64_t sum = (int64_t)axes->axis[idx] + delta;
+
+	axes->axis[idx] = MAX(MIN(sum, INT32_MAX), -INT32_MAX);
+}
+
 static void clear_report_data(struct report_data *rd)
 {
 	LOG_INF("Clear report data (%p)", (void *)rd);
@@ -506,6 +470,64 @@ static struct subscriber *get_linked_subscriber(uint8_t report_id)
 	return rs ? rs->subscriber : NULL;
 }
 
+static void usage_bm_update(struct items *items, uint16_t usage_id, bool active)
+{
+	if ((items->usage_bm_base == 0) ||
+	    (usage_id < items->usage_bm_base) ||
+	    (usage_id - items->usage_bm_base >= CHAR_BIT * sizeof(items->usage_bm))) {
+		return;
+	}
+
+	WRITE_BIT(items->usage_bm, usage_id - items->usage_bm_base, active);
+}
+
+static void item_remove(struct items *items, struct item *p_item)
+{
+	/* After removal, the free slot is moved to the beginning of the array
+	 * by shifting all items with lower usage ID. The order is preserved.
+	 */
+	const size_t first = ARRAY_SIZE(items->item) - items->item_count;
+	const size_t idx = p_item - items->item;
+
+	__ASSERT_NO_MSG((idx >= first) && (idx < ARRAY_SIZE(items->item)));
+
+	usage_bm_update(items, p_item->usage_id, false);
+
+	memmove(&items->item[first + 1], &items->item[first],
+		(idx - first) * sizeof(items->item[0]));
+	items->item[first].usage_id = 0;
+	items->item[first].value = 0;
+	items->item_count -= 1;
+}
+
+static void item_insert(struct items *items, uint16_t usage_id, int16_t value)
+{
+	/* Free slots (zeros) are stored at the beginning of the array and
+	 * items are sorted by usage ID. Use the last free slot and shift
+	 * items with lower usage ID to keep the array sorted.
+	 */
+	const size_t first = ARRAY_SIZE(items->item) - items->item_count;
+	size_t idx = first;
+
+	__ASSERT_NO_MSG(first > 0);
+	__ASSERT_NO_MSG(items->item[first - 1].usage_id == 0);
+
+	while ((idx < ARRAY_SIZE(items->item)) &&
+	       (items->item[idx].usage_id < usage_id)) {
+		idx++;
+	}
+
+	memmove(&items->item[first - 1], &items->item[first],
+		(idx - first) * sizeof(items->item[0]));
+
+	/* Record this value change. */
+	items->item[idx - 1].usage_id = usage_id;
+	items->item[idx - 1].value = value;
+	items->item_count += 1;
+
+	usage_bm_update(items, usage_id, true);
+}
+
 static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 {
 	const uint8_t prev_item_count = items->item_count;
@@ -530,8 +552,7 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		p_item->value += value;
 		if (p_item->value == 0) {
 			__ASSERT_NO_MSG(items->item_count != 0);
-			items->item_count -= 1;
-			p_item->usage_id = 0;
+			item_remove(items, p_item);
 		}
 
 		update_needed = true;
@@ -548,28 +569,11 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		 */
 		LOG_WRN("No place on the list to store HID item!");
 	} else {
-		/* After sort operation, free slots (zeros) are stored
-		 * at the beginning of the array.
-		 */
-		size_t const idx = ARRAY_SIZE(items->item) - prev_item_count - 1;
-
-		__ASSERT_NO_MSG(items->item[idx].usage_id == 0);
-
-		/* Record this value change. */
-		items->item[idx].usage_id = usage_id;
-		items->item[idx].value = value;
-		items->item_count += 1;
+		item_insert(items, usage_id, value);
 
 		update_needed = true;
 	}
 
-	if (prev_item_count != items->item_count) {
-		/* Sort elements on the list. Use simple algorithm
-		 * with small footprint.
-		 */
-		sort_by_usage_id(items->item, ARRAY_SIZE(items->item));
-	}
-
 	return update_needed;
 }
 
@@ -603,7 +607,8 @@ static void send_report_keyboard(struct report_state *rs, struct report_data *rd
 	event->dyndata.data[0] = rs->report_id;
 	event->dyndata.data[2] = 0; /* Reserved byte */
 
-	uint8_t modifier_bm = 0;
+	/* Modifiers are tracked incrementally as the items bitmask. */
+	uint8_t modifier_bm = rd->items.usage_bm;
 	uint8_t *keys = &event->dyndata.data[3];
 
 	const size_t max = ARRAY_SIZE(rd->items.item);
@@ -619,9 +624,7 @@ static void send_report_keyboard(struct report_state *rs, struct report_data *rd
 				cnt++;
 			} else if ((item.usage_id >= KEYBOARD_REPORT_FIRST_MODIFIER) &&
 				   (item.usage_id <= KEYBOARD_REPORT_LAST_MODIFIER)) {
-				/* Make sure any key bitmask will fit into modifiers. */
-				BUILD_ASSERT(KEYBOARD_REPORT_LAST_MODIFIER - KEYBOARD_REPORT_FIRST_MODIFIER < 8);
-				modifier_bm |= BIT(item.usage_id - KEYBOARD_REPORT_FIRST_MODIFIER);
+				/* Already included in the modifier bitmask. */
 			} else {
 				LOG_WRN("Undefined usage 0x%x", item.usage_id);
 			}
@@ -671,20 +674,8 @@ static void send_report_mouse(struct report_state *rs, struct report_data *rd)
 		rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL] -= wheel * 2;
 	}
 
-	/* Traverse pressed keys and build mouse buttons bitmask */
-	uint8_t button_bm = 0;
-	for (size_t i = 0; i < ARRAY_SIZE(rd->items.item); i++) {
-		struct item item = rd->items.item[i];
-
-		if (item.usage_id) {
-			__ASSERT_NO_MSG(item.usage_id <= 8);
-			__ASSERT_NO_MSG(item.value > 0);
-
-			uint8_t mask = 1 << (item.usage_id - 1);
-
-			button_bm |= mask;
-		}
-	}
+	/* Mouse buttons bitmask is tracked incrementally as the items bitmask. */
+	uint8_t button_bm = rd->items.usage_bm;
 
 
 	/* Encode report. */
@@ -736,7 +727,7 @@ static void send_report_boot_mouse(struct report_state *rs, struct report_data *
 	/* X/Y axis */
 	int8_t dx = MAX(MIN(rd->axes.axis[MOUSE_REPORT_AXIS_X], INT8_MAX), INT8_MIN);
 	int8_t dy = MAX(MIN(-rd->axes.axis[MOUSE_REPORT_AXIS_Y], INT8_MAX), INT8_MIN);
-	int16_t wheel = rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL];
+	int32_t wheel = rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL];
 
 	if (dx) {
 		rd->axes.axis[MOUSE_REPORT_AXIS_X] -= dx;
@@ -747,20 +738,8 @@ static void send_report_boot_mouse(struct report_state *rs, struct report_data *
 	if (wheel) {
 		rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL] = 0;
 	}
-	/* Traverse pressed keys and build mouse buttons bitmask */
-	uint8_t button_bm = 0;
-	for (size_t i = 0; i < ARRAY_SIZE(rd->items.item); i++) {
-		struct item item = rd->items.item[i];
-
-		if (item.usage_id) {
-			__ASSERT_NO_MSG(item.usage_id <= 8);
-			__ASSERT_NO_MSG(item.value > 0);
-
-			uint8_t mask = 1 << (item.usage_id - 1);
-
-			button_bm |= mask;
-		}
-	}
+	/* Mouse buttons bitmask is tracked incrementally as the items bitmask. */
+	uint8_t button_bm = rd->items.usage_bm;
 
 
 	size_t report_size = sizeof(rs->report_id) + sizeof(dx) + sizeof(dy) +
@@ -826,21 +805,16 @@ static bool update_report(struct report_data *rd)
 {
 	bool update_needed = false;
 
-	while (!update_needed && !eventq_is_empty(&rd->eventq)) {
-		/* There are enqueued events to handle. */
-		struct item_event *event = eventq_get(&rd->eventq);
-
-		__ASSERT_NO_MSG(event);
+	struct item_event event;
 
+	while (!update_needed && eventq_get(&rd->eventq, &event)) {
+		/* There are enqueued events to handle. */
 		update_needed = key_value_set(&rd->items,
-					      event->item.usage_id,
-					      event->item.value);
+					      event.item.usage_id,
+					      event.item.value);
 
 		rd->linked_rs->update_needed = rd->linked_rs->update_needed || update_needed;
 
-
-		k_free(event);
-
 		/* If no item was changed, try next event. */
 	}
 
@@ -1275,16 +1249,12 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 			 * Try to remove queued items starting from the
 			 * oldest one.
 			 */
-			sys_snode_t *i;
-
-			SYS_SLIST_FOR_EACH_NODE(&rd->eventq.root, i) {
+			for (size_t i = 0; i < rd->eventq.len; i++) {
 				/* Initial cleanup was done above. Queue will
 				 * not contain events with expired timestamp.
 				 */
 				uint32_t timestamp =
-					CONTAINER_OF(i,
-						     struct item_event,
-						     node)->timestamp +
+					eventq_peek(&rd->eventq, i)->timestamp +
 					CONFIG_DESKTOP_HID_REPORT_EXPIRATION;
 
 				eventq_cleanup(&rd->eventq, timestamp);
@@ -1292,7 +1262,7 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 				if (!eventq_is_full(&rd->eventq)) {
 					/* At least one element was removed
 					 * from the queue. Do not continue
-					 * list traverse, content was modified!
+					 * queue traverse, content was modified!
 					 */
 					break;
 				}
@@ -1368,7 +1338,10 @@ static void init(void)
 		report_data_index[REPORT_ID_MOUSE] = data_id;
 		report_state_index[REPORT_ID_MOUSE] = state_id;
 
+		/* Mouse buttons use usage IDs starting from 1. */
+		BUILD_ASSERT(MOUSE_REPORT_BUTTON_COUNT_MAX <= CHAR_BIT);
 		state.report_data[data_id].items.item_count_max = MOUSE_REPORT_BUTTON_COUNT_MAX;
+		state.report_data[data_id].items.usage_bm_base = 1;
 		state.report_data[data_id].axes.axis_count = MOUSE_REPORT_AXIS_COUNT;
 
 		data_id++;
@@ -1378,7 +1351,10 @@ static void init(void)
 		report_data_index[REPORT_ID_KEYBOARD_KEYS] = data_id;
 		report_state_index[REPORT_ID_KEYBOARD_KEYS] = state_id;
 
+		/* Make sure any key bitmask will fit into modifiers. */
+		BUILD_ASSERT(KEYBOARD_REPORT_LAST_MODIFIER - KEYBOARD_REPORT_FIRST_MODIFIER < CHAR_BIT);
 		state.report_data[data_id].items.item_count_max = KEYBOARD_REPORT_KEY_COUNT_MAX;
+		state.report_data[data_id].items.usage_bm_base = KEYBOARD_REPORT_FIRST_MODIFIER;
 
 		data_id++;
 		state_id++;
@@ -1425,8 +1401,8 @@ static bool handle_motion_event(const struct motion_event *event)
 	struct report_data *rd = get_report_data(REPORT_ID_MOUSE);
 	__ASSERT_NO_MSG(rd != NULL);
 
-	rd->axes.axis[MOUSE_REPORT_AXIS_X] += event->dx;
-	rd->axes.axis[MOUSE_REPORT_AXIS_Y] += event->dy;
+	axis_add(&rd->axes, MOUSE_REPORT_AXIS_X, event->dx);
+	axis_add(&rd->axes, MOUSE_REPORT_AXIS_Y, event->dy);
 
 	report_send(NULL, rd, true, true);
 
@@ -1442,7 +1418,7 @@ static bool handle_wheel_event(const struct wheel_event *event)
 	struct report_data *rd = get_report_data(REPORT_ID_MOUSE);
 	__ASSERT_NO_MSG(rd != NULL);
 
-	rd->axes.axis[MOUSE_REPORT_AXIS_WHEEL] += event->wheel;
+	axis_add(&rd->axes, MOUSE_REPORT_AXIS_WHEEL, event->wheel);
 
 	report_send(NULL, rd, true, true);
 
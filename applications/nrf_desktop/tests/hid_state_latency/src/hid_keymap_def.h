@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "hid_keymap.h"
+#include <caf/key_id.h>
+
+/* This configuration file is included only once from hid_state module and holds
+ * information about mapping between buttons and generated reports.
+ */
+
+/* This structure enforces the header file is included only once in the build.
+ * Violating this requirement triggers a multiple definition error at link time.
+ */
+const struct {} hid_keymap_def_include_once;
+
+static const struct hid_keymap hid_keymap[] = {
+	{ KEY_ID(0, 0), 0x01, REPORT_ID_MOUSE }, /* Left Mouse Button */
+	{ KEY_ID(0, 1), 0x02, REPORT_ID_MOUSE }, /* Right Mouse Button */
+};
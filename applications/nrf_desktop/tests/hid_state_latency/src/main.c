@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <inttypes.h>
+#include <ztest.h>
+#include <event_manager.h>
+#include <caf/events/button_event.h>
+#include <caf/key_id.h>
+
+#include "motion_event.h"
+#include "hid_event.h"
+#include "usb_event.h"
+
+#define MODULE main
+#include <caf/events/module_state_event.h>
+
+#define SAMPLE_CNT		1000
+#define BURST_CNT		8
+#define REPORT_TIMEOUT		K_MSEC(100)
+#define SETUP_TIME		K_MSEC(50)
+
+struct mouse_report {
+	size_t size;
+	uint8_t buttons;
+	int16_t dx;
+	int16_t dy;
+	uint32_t cycles;
+};
+
+struct latency {
+	uint32_t max;
+	uint64_t sum;
+	size_t cnt;
+};
+
+/* Address is used as an ID of the emulated USB HID subscriber. */
+static const uint8_t usb_hid_dev;
+
+static K_SEM_DEFINE(report_sem, 0, SAMPLE_CNT);
+static struct mouse_report last_report;
+
+static int16_t decode_12bit(uint16_t val)
+{
+	return (val & BIT(11)) ? (int16_t)(val | 0xf000) : (int16_t)val;
+}
+
+static bool handle_hid_report_event(const struct hid_report_event *event)
+{
+	const uint8_t *data = event->dyndata.data;
+
+	if ((event->subscriber != &usb_hid_dev) || (data[0] != REPORT_ID_MOUSE)) {
+		return false;
+	}
+
+	last_report.cycles = k_cycle_get_32();
+	last_report.size = event->dyndata.size;
+	last_report.buttons = data[1];
+	last_report.dx = decode_12bit(data[3] | ((data[4] & 0x0f) << 8));
+	last_report.dy = decode_12bit((data[4] >> 4) | (data[5] << 4));
+
+	k_sem_give(&report_sem);
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_hid_report_event(eh)) {
+		return handle_hid_report_event(cast_hid_report_event(eh));
+	}
+
+	/* If event is unhandled, unsubscribe. */
+	__ASSERT_NO_MSG(false);
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, hid_report_event);
+
+static void report_wait(struct mouse_report *report)
+{
+	zassert_ok(k_sem_take(&report_sem, REPORT_TIMEOUT), "No HID report");
+	*report = last_report;
+	zassert_equal(report->size, REPORT_SIZE_MOUSE + 1, "Invalid report size");
+}
+
+/* Emulate the transport confirming that the report was sent to the host. */
+static void report_ack(void)
+{
+	struct hid_report_sent_event *event = new_hid_report_sent_event();
+
+	event->subscriber = &usb_hid_dev;
+	event->report_id = REPORT_ID_MOUSE;
+	event->error = false;
+	EVENT_SUBMIT(event);
+}
+
+static void motion_submit(int16_t dx, int16_t dy)
+{
+	struct motion_event *event = new_motion_event();
+
+	event->dx = dx;
+	event->dy = dy;
+	EVENT_SUBMIT(event);
+}
+
+static void button_submit(uint16_t key_id, bool pressed)
+{
+	struct button_event *event = new_button_event();
+
+	event->key_id = key_id;
+	event->pressed = pressed;
+	EVENT_SUBMIT(event);
+}
+
+static void latency_add(struct latency *l, uint32_t start, const struct mouse_report *report)
+{
+	uint32_t cycles = report->cycles - start;
+
+	l->max = MAX(l->max, cycles);
+	l->sum += cycles;
+	l->cnt++;
+}
+
+/* On native_posix the kernel clock does not advance while code runs, so the
+ * printed latency is meaningful only on hardware. The checks of the report
+ * content apply on all platforms.
+ */
+static void latency_print(const char *name, const struct latency *l)
+{
+	zassert_true(l->cnt > 0, "No samples");
+
+	uint32_t avg = l->sum / l->cnt;
+
+	printk("%s: %zu reports, latency avg %" PRIu32 " us, max %" PRIu32 " us\n", name,
+	       l->cnt, k_cyc_to_us_floor32(avg), k_cyc_to_us_floor32(l->max));
+}
+
+static void test_init(void)
+{
+	zassert_false(event_manager_init(), "Error when initializing");
+
+	/* HID state initializes when the main module is ready. */
+	module_set_state(MODULE_STATE_READY);
+
+	struct usb_hid_event *usb_event = new_usb_hid_event();
+
+	usb_event->id = &usb_hid_dev;
+	usb_event->enabled = true;
+	EVENT_SUBMIT(usb_event);
+
+	struct hid_report_subscription_event *sub_event = new_hid_report_subscription_event();
+
+	sub_event->subscriber = &usb_hid_dev;
+	sub_event->report_id = REPORT_ID_MOUSE;
+	sub_event->enabled = true;
+	EVENT_SUBMIT(sub_event);
+
+	k_sleep(SETUP_TIME);
+
+	/* Acknowledge reports sent on subscription, if any. */
+	while (!k_sem_take(&report_sem, K_NO_WAIT)) {
+		report_ack();
+		k_sleep(SETUP_TIME);
+	}
+}
+
+/* Motion event to HID report, one report in flight. */
+static void test_motion_latency(void)
+{
+	struct latency l = {0};
+	struct mouse_report report;
+
+	for (size_t i = 0; i < SAMPLE_CNT; i++) {
+		int16_t d = (i % 2) ? 3 : -5;
+		uint32_t start = k_cycle_get_32();
+
+		motion_submit(d, d);
+		report_wait(&report);
+		latency_add(&l, start, &report);
+
+		zassert_equal(report.dx, d, "Invalid dx");
+		zassert_equal(report.dy, -d, "Invalid dy");
+
+		report_ack();
+	}
+
+	latency_print("motion", &l);
+}
+
+/* Button event to HID report, each press and release forms a report. */
+static void test_button_latency(void)
+{
+	struct latency l = {0};
+	struct mouse_report report;
+
+	for (size_t i = 0; i < SAMPLE_CNT; i++) {
+		bool pressed = ((i % 2) == 0);
+		uint32_t start = k_cycle_get_32();
+
+		button_submit(KEY_ID(0, 0), pressed);
+		report_wait(&report);
+		latency_add(&l, start, &report);
+
+		zassert_equal(report.buttons, pressed ? BIT(0) : 0, "Invalid buttons");
+		zassert_equal(report.dx, 0, "Unexpected motion");
+
+		report_ack();
+	}
+
+	latency_print("button", &l);
+}
+
+/* Motion that arrives while a report is in flight is accumulated and sent in the
+ * next report. Latency is measured from the first event of the burst.
+ */
+static void test_motion_burst(void)
+{
+	struct latency l = {0};
+	struct mouse_report report;
+
+	for (size_t i = 0; i < SAMPLE_CNT / BURST_CNT; i++) {
+		uint32_t start = k_cycle_get_32();
+
+		motion_submit(1, 1);
+		report_wait(&report);
+		zassert_equal(report.dx, 1, "Invalid dx");
+
+		for (size_t j = 1; j < BURST_CNT; j++) {
+			motion_submit(1, 1);
+		}
+		report_ack();
+		report_wait(&report);
+		latency_add(&l, start, &report);
+
+		zassert_equal(report.dx, BURST_CNT - 1, "Motion lost");
+		zassert_equal(report.dy, -(BURST_CNT - 1), "Motion lost");
+
+		report_ack();
+	}
+
+	zassert_not_equal(k_sem_take(&report_sem, SETUP_TIME), 0, "Unexpected report");
+
+	latency_print("motion burst", &l);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hid_state_latency,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_motion_latency),
+			 ztest_unit_test(test_button_latency),
+			 ztest_unit_test(test_motion_burst)
+			 );
+
+	ztest_run_test_suite(hid_state_latency);
+}
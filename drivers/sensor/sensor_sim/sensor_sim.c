@@ -24,6 +24,10 @@ LOG_MODULE_REGISTER(sensor_sim, CONFIG_SENSOR_SIM_LOG_LEVEL);
 static struct wave_gen_param accel_param[ACCEL_CHAN_COUNT];
 struct k_mutex accel_param_mutex;
 
+#if defined(CONFIG_SENSOR_SIM_ACCEL_FIFO)
+static struct wave_gen_block accel_block[ACCEL_CHAN_COUNT];
+#endif
+
 static double accel_samples[ACCEL_CHAN_COUNT];
 
 static double temp_sample;
@@ -101,11 +105,38 @@ int sensor_sim_set_wave_param(enum sensor_channel chan, const struct wave_gen_pa
 		memcpy(get_wave_params(SENSOR_CHAN_ACCEL_Z), set_params, sizeof(*dest));
 	}
 
+#if defined(CONFIG_SENSOR_SIM_ACCEL_FIFO)
+	for (size_t i = 0; i < ARRAY_SIZE(accel_block); i++) {
+		int err = wave_gen_block_set_param(&accel_block[i], &accel_param[i]);
+
+		/* Parameters are validated before. */
+		__ASSERT_NO_MSG(!err);
+		ARG_UNUSED(err);
+	}
+#endif
+
 	k_mutex_unlock(&accel_param_mutex);
 
 	return 0;
 }
 
+int sensor_sim_accel_fifo_read(float *buf, size_t sample_cnt)
+{
+#if defined(CONFIG_SENSOR_SIM_ACCEL_FIFO)
+	k_mutex_lock(&accel_param_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(accel_block); i++) {
+		wave_gen_generate_block(&accel_block[i], &buf[i], sample_cnt, ACCEL_CHAN_COUNT);
+	}
+
+	k_mutex_unlock(&accel_param_mutex);
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
 /**
  * @brief Helper function to convert from double to sensor_value struct
  *
@@ -268,7 +299,13 @@ static int sensor_sim_init(const struct device *dev)
 		return -EIO;
 	}
 #endif
-	srand(k_cycle_get_32());
+	uint32_t seed = CONFIG_SENSOR_SIM_NOISE_SEED;
+
+	if (seed == 0) {
+		seed = k_cycle_get_32();
+	}
+
+	srand(seed);
 
 	k_mutex_init(&accel_param_mutex);
 
@@ -280,6 +317,20 @@ static int sensor_sim_init(const struct device *dev)
 		}
 	}
 
+#if defined(CONFIG_SENSOR_SIM_ACCEL_FIFO)
+	for (size_t i = 0; i < ARRAY_SIZE(accel_block); i++) {
+		/* Every axis uses a separate noise sequence. */
+		int err = wave_gen_block_init(&accel_block[i], &accel_param[i],
+					      CONFIG_SENSOR_SIM_ACCEL_FIFO_SAMPLE_PERIOD_US,
+					      seed + i);
+
+		if (err) {
+			LOG_ERR("Cannot initialize wave block (err %d)", err);
+			return err;
+		}
+	}
+#endif
+
 	return 0;
 }
 
@@ -313,6 +313,20 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context);
  */
 int bt_gatt_dm_data_release(struct bt_gatt_dm *dm);
 
+/** @brief Remove cached discovery data of the given peer.
+ *
+ * Use this function when the bond with the peer is removed to release
+ * the settings storage used by the discovery cache.
+ *
+ * @note Available only if @kconfig{CONFIG_BT_GATT_DM_CACHE} is enabled.
+ *
+ * @param[in] addr Identity address of the peer.
+ *
+ * @retval 0 If the operation was successful.
+ *         Otherwise, a (negative) error code is returned.
+ */
+int bt_gatt_dm_cache_clear(const bt_addr_le_t *addr);
+
 /** @brief Print service discovery data.
  *
  * This function prints GATT attributes that belong to the discovered service.
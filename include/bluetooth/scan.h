@@ -543,6 +543,15 @@ int bt_scan_blocklist_device_add(const bt_addr_le_t *addr);
  */
 void bt_scan_blocklist_clear(void);
 
+/**@brief Clear the advertising report deduplication cache.
+ *
+ * @details Use this function to remove all entries from the
+ *          deduplication cache. The next report of every device
+ *          is delivered to the application. The cache is also
+ *          cleared each time @ref bt_scan_start is called.
+ */
+void bt_scan_dedup_cache_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
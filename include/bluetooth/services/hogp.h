@@ -202,12 +202,26 @@ struct bt_hogp {
 
 	struct {
 		/**
-		 * During the initialization process, all reports reference
-		 * information is read. This structure helps tracking the
-		 * current state of this process.
+		 * During the initialization process, HID information,
+		 * all reports reference information and protocol mode are
+		 * read. This structure helps tracking the current state
+		 * of this process.
 		 */
-		uint8_t rep_idx;
-	} init_repref;
+		/** Index of the first value read by the current request. */
+		uint8_t item;
+		/** Number of values read by the current request. */
+		uint8_t cnt;
+		/** Values are read one by one. */
+		bool single;
+		/** Values of the current request were received. */
+		bool received;
+		/** Handles of the values read by the current request. */
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+		uint16_t handles[CONFIG_BT_HOGP_REPORTS_MAX + 2];
+#else
+		uint16_t handles[1];
+#endif
+	} init_read;
 
 	struct {
 		/** Keyboard input boot report. Input and Output keyboard
@@ -79,6 +79,13 @@ struct bt_nus_cb {
 	 */
 	void (*send_enabled)(enum bt_nus_send_status status);
 
+	/** @brief Stream space available callback.
+	 *
+	 * Space became available in the stream buffer after
+	 * @ref bt_nus_stream_write accepted only a part of the data.
+	 * Used only if @kconfig{CONFIG_BT_NUS_STREAM} is enabled.
+	 */
+	void (*stream_space_available)(void);
 };
 
 /**@brief Initialize the service.
@@ -126,6 +133,42 @@ static inline uint32_t bt_nus_get_mtu(struct bt_conn *conn)
 	return bt_gatt_get_mtu(conn) - 3;
 }
 
+/**@brief Bind the stream to a connection.
+ * @details The stream buffer is cleared. Data written with
+ *          @ref bt_nus_stream_write is sent to the given peer.
+ *          Call @ref bt_nus_stream_disable when the connection is lost.
+ * @note Available only if @kconfig{CONFIG_BT_NUS_STREAM} is enabled.
+ * @param[in] conn Pointer to connection object.
+ * @retval 0 If the stream is enabled.
+ *           Otherwise, a negative value is returned.
+ */
+int bt_nus_stream_enable(struct bt_conn *conn);
+
+/**@brief Unbind the stream and drop the buffered data.
+ * @note Available only if @kconfig{CONFIG_BT_NUS_STREAM} is enabled.
+ */
+void bt_nus_stream_disable(void);
+
+/**@brief Write data to the stream.
+ * @details The data is copied to the stream buffer and sent in the
+ *          background. It is fragmented to the ATT MTU and several
+ *          notifications are queued in the stack at the same time.
+ *          If the buffer cannot hold all the data, only a part of it
+ *          is accepted and the @ref bt_nus_cb.stream_space_available
+ *          callback is called when space is available again.
+ * @note Available only if @kconfig{CONFIG_BT_NUS_STREAM} is enabled.
+ * @param[in] data Pointer to a data buffer.
+ * @param[in] len  Length of the data in the buffer.
+ * @return Number of bytes accepted, or a negative value on error.
+ */
+int bt_nus_stream_write(const uint8_t *data, size_t len);
+
+/**@brief Get free space in the stream buffer.
+ * @note Available only if @kconfig{CONFIG_BT_NUS_STREAM} is enabled.
+ * @return Number of bytes that can be written to the stream.
+ */
+size_t bt_nus_stream_space_get(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -74,6 +74,10 @@ EVENT_TYPE_DECLARE(sensor_state_event);
  * in X, Y and Z axis as three floating-point values. @ref sensor_event_get_data_cnt and @ref
  * sensor_event_get_data_ptr can be used to access the sensor data provided by a given sensor event.
  *
+ * A single event may contain multiple samples of the sensor. The samples are stored one after
+ * another and the number of samples is provided in the sample_cnt field. Use @ref
+ * sensor_event_get_sample_data_cnt to get the number of floating-point values in a single sample.
+ *
  * @warning The sensor event related to the given sensor must use the same description as
  *          #sensor_state_event related to the sensor.
  */
@@ -81,6 +85,7 @@ struct sensor_event {
 	struct event_header header; /**< Event header. */
 
 	const char *descr; /**< Description of the sensor. */
+	uint8_t sample_cnt; /**< Number of samples in the sensor data. */
 	struct event_dyndata dyndata; /**< Sensor data. Provided as floating-point values. */
 };
 
@@ -108,6 +113,20 @@ static inline float *sensor_event_get_data_ptr(const struct sensor_event *event)
 	return (float *)event->dyndata.data;
 }
 
+/** @brief Get size of a single sample of sensor data.
+ *
+ * @param[in] event       Pointer to the sensor_event.
+ *
+ * @return Size of a single sample, expressed as a number of floating-point values.
+ */
+static inline size_t sensor_event_get_sample_data_cnt(const struct sensor_event *event)
+{
+	__ASSERT_NO_MSG(event->sample_cnt > 0);
+	__ASSERT_NO_MSG((sensor_event_get_data_cnt(event) % event->sample_cnt) == 0);
+
+	return (sensor_event_get_data_cnt(event) / event->sample_cnt);
+}
+
 #ifdef __cplusplus
 }
 #endif
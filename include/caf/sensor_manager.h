@@ -86,6 +86,29 @@ struct sm_sensor_config {
 	 * @brief Sampling period
 	 */
 	unsigned int sampling_period_ms;
+	/**
+	 * @brief Number of samples in a single sensor event
+	 *
+	 * Samples are collected and submitted together in one sensor_event
+	 * as a contiguous array of floating-point values. Value of 0 or 1
+	 * means that every sample is submitted in a separate event.
+	 *
+	 * The event is submitted when the batch is full. There is no timeout,
+	 * so the first sample of a batch is delayed by up to
+	 * (event_sample_cnt - 1) * sampling_period_ms. For a sensor with long
+	 * sampling period, keep the value low.
+	 */
+	uint8_t event_sample_cnt;
+	/**
+	 * @brief Index of the sampling thread
+	 *
+	 * Sensors assigned to the same thread are sampled in the earliest
+	 * deadline first order. Assign sensors that are slow to sample
+	 * (for example connected over a slow bus) to a separate thread, so
+	 * that they do not delay sampling of other sensors. The value must
+	 * be lower than :kconfig:`CONFIG_CAF_SENSOR_MANAGER_THREAD_COUNT`.
+	 */
+	uint8_t thread_id;
 	/**
 	 * @brief Sensor trigger configuration
 	 *
@@ -41,6 +41,24 @@ extern "C" {
  */
 int sensor_sim_set_wave_param(enum sensor_channel chan, const struct wave_gen_param *set_params);
 
+/** @brief Read a block of simulated acceleration samples.
+ *
+ * Subsequent samples are generated with the time step defined by
+ * CONFIG_SENSOR_SIM_ACCEL_FIFO_SAMPLE_PERIOD_US. Every call continues the signal returned by
+ * the previous call. Values for the X, Y, and Z axes are interleaved in the buffer.
+ *
+ * @note	This function can be used only if CONFIG_SENSOR_SIM_ACCEL_FIFO is enabled.
+ *		Moreover, although it is thread-safe, it cannot be used in interrupts.
+ *
+ * @param[out] buf		Buffer used to store the samples. The buffer must be able to
+ *				store 3 * sample_cnt values.
+ * @param[in]  sample_cnt	Number of read samples.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int sensor_sim_accel_fifo_read(float *buf, size_t sample_cnt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef JSON_WRITER_H__
+#define JSON_WRITER_H__
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @defgroup json_writer JSON writer
+ * @{
+ * @brief Streaming JSON writer that encodes messages without building a cJSON tree.
+ *
+ * The writer appends unformatted JSON to a bounded buffer. The output is identical to
+ * cJSON_PrintUnformatted() for the same sequence of items. If the buffer is NULL, the writer
+ * only calculates the length of the output, still bounded by the passed in size.
+ *
+ * Errors are latched and reported by @ref json_writer_finish.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Structure containing the state of a writer. */
+struct json_writer {
+	char *buf;
+	size_t size;
+	size_t len;
+	/* Bit per nesting level, set if the level has no items yet. */
+	uint32_t first;
+	uint8_t depth;
+	int err;
+};
+
+/** @brief Position in the output that the writer can be rewound to. */
+struct json_writer_mark {
+	size_t len;
+	uint32_t first;
+	uint8_t depth;
+	int err;
+};
+
+/**
+ * @brief Function that writes a complete message using the writer.
+ *
+ * @param[in] w Writer.
+ * @param[in] ctx Context passed to @ref json_writer_encode_alloc.
+ *
+ * @return 0 on success. -ENODATA if nothing was written. Otherwise a negative error code.
+ */
+typedef int (*json_writer_encode_fn)(struct json_writer *w, void *ctx);
+
+/**
+ * @brief Initialize the writer.
+ *
+ * @param[out] w Writer.
+ * @param[in] buf Output buffer or NULL to only calculate the output length.
+ * @param[in] size Maximum size of the output, including the NULL terminator.
+ */
+void json_writer_init(struct json_writer *w, char *buf, size_t size);
+
+/** @brief Check if the writer only calculates the output length. Entries must not be
+ *	   unqueued while calculating the length.
+ */
+static inline bool json_writer_dry_run(const struct json_writer *w)
+{
+	return w->buf == NULL;
+}
+
+/** @brief Latch an error, unless an earlier error is already latched. */
+static inline void json_writer_error(struct json_writer *w, int err)
+{
+	if (!w->err) {
+		w->err = err;
+	}
+}
+
+/** @brief Start an object. Key must be NULL for array items and root. */
+void json_writer_obj_start(struct json_writer *w, const char *key);
+
+/** @brief End the current object. */
+void json_writer_obj_end(struct json_writer *w);
+
+/** @brief Start an array. Key must be NULL for array items and root. */
+void json_writer_arr_start(struct json_writer *w, const char *key);
+
+/** @brief End the current array. */
+void json_writer_arr_end(struct json_writer *w);
+
+/** @brief Add a string. */
+void json_writer_str(struct json_writer *w, const char *key, const char *val);
+
+/** @brief Add a number. NaN and infinity are written as null. */
+void json_writer_num(struct json_writer *w, const char *key, double val);
+
+/** @brief Add a null value. */
+void json_writer_null(struct json_writer *w, const char *key);
+
+/** @brief Add a boolean value. */
+void json_writer_bool(struct json_writer *w, const char *key, bool val);
+
+/**
+ * @brief Append data to the output as is, without separators or escaping.
+ *
+ * Used by encoders that share the bounded output buffer of the writer, such as CBOR.
+ */
+void json_writer_raw(struct json_writer *w, const char *data, size_t len);
+
+/** @brief Save the current position of the writer. */
+void json_writer_mark(const struct json_writer *w, struct json_writer_mark *mark);
+
+/** @brief Rewind the writer to a saved position, discarding everything written after it. */
+void json_writer_rewind(struct json_writer *w, const struct json_writer_mark *mark);
+
+/**
+ * @brief Check if the output written so far, and the bytes needed to close all open objects
+ *	  and arrays, fits in the buffer. Used to find out if the last entry should be rewound.
+ *
+ * @return true if the output fits.
+ */
+bool json_writer_fits(const struct json_writer *w);
+
+/**
+ * @brief Finish writing and NULL-terminate the output.
+ *
+ * @return Length of the output, without the NULL terminator, or a negative error code.
+ */
+int json_writer_finish(struct json_writer *w);
+
+/**
+ * @brief Encode a message into a buffer allocated with the exact size.
+ *
+ * The encode function is called twice, first to calculate the length of the output, bounded
+ * by max_size, and then to write it. The output must be freed with k_free().
+ *
+ * @param[in] fn Function that writes the message.
+ * @param[in] ctx Context passed to the function.
+ * @param[in] max_size Maximum size of the output, including the NULL terminator.
+ * @param[out] out Pointer to the allocated NULL-terminated output.
+ * @param[out] out_len Length of the output.
+ *
+ * @return 0 on success. -ENODATA if the encode function did not write anything. Otherwise
+ *         a negative error code is returned.
+ */
+int json_writer_encode_alloc(json_writer_encode_fn fn, void *ctx, size_t max_size,
+			     char **out, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* JSON_WRITER_H__ */
@@ -44,7 +44,21 @@ enum aws_iot_topic_type {
 	 *  $aws/things/<thing-name>/shadow/delete, publishing an empty message
 	 *  to this topic deletes the device Shadow document.
 	 */
-	AWS_IOT_SHADOW_TOPIC_DELETE
+	AWS_IOT_SHADOW_TOPIC_DELETE,
+	/** Data received on $aws/things/<thing-name>/shadow/get/accepted. */
+	AWS_IOT_SHADOW_TOPIC_GET_ACCEPTED,
+	/** Data received on $aws/things/<thing-name>/shadow/get/rejected. */
+	AWS_IOT_SHADOW_TOPIC_GET_REJECTED,
+	/** Data received on $aws/things/<thing-name>/shadow/update/accepted. */
+	AWS_IOT_SHADOW_TOPIC_UPDATE_ACCEPTED,
+	/** Data received on $aws/things/<thing-name>/shadow/update/rejected. */
+	AWS_IOT_SHADOW_TOPIC_UPDATE_REJECTED,
+	/** Data received on $aws/things/<thing-name>/shadow/update/delta. */
+	AWS_IOT_SHADOW_TOPIC_UPDATE_DELTA,
+	/** Data received on $aws/things/<thing-name>/shadow/delete/accepted. */
+	AWS_IOT_SHADOW_TOPIC_DELETE_ACCEPTED,
+	/** Data received on $aws/things/<thing-name>/shadow/delete/rejected. */
+	AWS_IOT_SHADOW_TOPIC_DELETE_REJECTED
 };
 
 /**@ AWS broker disconnect results. */
@@ -109,7 +123,11 @@ enum aws_iot_evt_type {
 
 /** @brief AWS IoT topic data. */
 struct aws_iot_topic_data {
-	/** Type of shadow topic that will be published to. */
+	/** Type of shadow topic that will be published to. For received data,
+	 *  the type of the shadow topic the data was received on, or the type
+	 *  given to the application topic in
+	 *  @ref aws_iot_subscription_topics_add.
+	 */
 	enum aws_iot_topic_type type;
 	/** Pointer to string of application specific topic. */
 	const char *str;
@@ -162,10 +162,111 @@ typedef void (*cloud_evt_handler_t)(const struct cloud_backend *const backend,
 				    const struct cloud_event *const evt,
 				    void *user_data);
 
+/**@brief Priority class of a message sent with @ref cloud_send_async.
+ *	  Queued messages are sent in order of priority, and in the order
+ *	  they were queued within the same priority.
+ */
+enum cloud_send_prio {
+	/** Messages that must be sent as soon as possible, such as alarms. */
+	CLOUD_SEND_PRIO_HIGH,
+	/** Regular messages. */
+	CLOUD_SEND_PRIO_NORMAL,
+	/** Messages that are sent when no other messages are queued, such as
+	 *  batched data.
+	 */
+	CLOUD_SEND_PRIO_LOW,
+
+	CLOUD_SEND_PRIO_COUNT
+};
+
+/**@brief Status of a message sent with @ref cloud_send_async. */
+enum cloud_send_status {
+	/** The message has been passed to the transport. The message buffer
+	 *  is no longer used. This is the final status, unless the message is
+	 *  waiting for an acknowledgment, see @ref cloud_send_ack_supported.
+	 */
+	CLOUD_SEND_STATUS_SENT,
+	/** The message has been acknowledged by the cloud. */
+	CLOUD_SEND_STATUS_ACKED,
+	/** The message could not be sent or was not acknowledged. */
+	CLOUD_SEND_STATUS_FAILED,
+};
+
+struct cloud_send_req;
+
+/**
+ * @brief Callback reporting the status of a message sent with
+ *	  @ref cloud_send_async. Called from the cloud send work queue.
+ *
+ * @param backend Pointer to cloud backend.
+ * @param req     Pointer to the send request. The request can be reused
+ *		  or freed when a final status is reported.
+ * @param status  Status of the message.
+ * @param err     0, or a negative error code if status is
+ *		  CLOUD_SEND_STATUS_FAILED. -ENOTCONN if the backend was
+ *		  disconnected before the message was acknowledged and
+ *		  -ETIMEDOUT if the acknowledgment timed out.
+ */
+typedef void (*cloud_send_cb_t)(const struct cloud_backend *const backend,
+				struct cloud_send_req *req,
+				enum cloud_send_status status, int err);
+
+/**@brief Request to send a message asynchronously. The request is owned by
+ *	  the cloud API from when it is queued until a final status is
+ *	  reported.
+ */
+struct cloud_send_req {
+	/** Message to send. */
+	struct cloud_msg msg;
+	/** Priority class of the message. */
+	enum cloud_send_prio prio;
+	/** Callback reporting the status of the message, can be NULL. */
+	cloud_send_cb_t cb;
+	/** User defined data. */
+	void *user_data;
+
+	/* Private, used by the cloud API. */
+	sys_snode_t node;
+	int64_t deadline;
+	uint16_t message_id;
+	enum cloud_send_status status;
+	int err;
+};
+
+/**@brief Asynchronous send state of a backend. Private, used by the cloud
+ *	  API.
+ */
+struct cloud_send_queue {
+	const struct cloud_backend *backend;
+	struct k_spinlock lock;
+	sys_slist_t queued[CLOUD_SEND_PRIO_COUNT];
+	sys_slist_t in_flight;
+	sys_slist_t done;
+	size_t queued_count;
+	size_t in_flight_count;
+	uint16_t next_message_id;
+	bool ready;
+	struct k_work work;
+	struct k_work_delayable timeout_work;
+};
+
+/**@brief Range of message IDs used for messages sent with
+ *	  @ref cloud_send_async that are waiting for an acknowledgment. The
+ *	  range is within the nRF Cloud user tag range, messages sent with
+ *	  other APIs should not use IDs in this range.
+ */
+#define CLOUD_SEND_MSG_ID_FIRST 0xF000
+#define CLOUD_SEND_MSG_ID_LAST	0xFFFF
+
 /**
  * @brief Cloud backend API.
  *
- * ping() and user_data_set() can be omitted, the other functions are mandatory.
+ * ping(), user_data_set() and send_with_id() can be omitted, the other
+ * functions are mandatory.
+ *
+ * send_with_id() sends a message with the given message ID. A backend that
+ * implements it must call @ref cloud_send_ack_notify when a message sent
+ * with it is acknowledged by the cloud.
  */
 struct cloud_api {
 	int (*init)(const struct cloud_backend *const backend,
@@ -189,6 +290,9 @@ struct cloud_api {
 			     void *user_data);
 	int (*id_get)(const struct cloud_backend *const backend,
 		      char *id, size_t id_len);
+	int (*send_with_id)(const struct cloud_backend *const backend,
+			    const struct cloud_msg *const msg,
+			    uint16_t message_id);
 };
 
 /**@brief Structure for cloud backend configuration. */
@@ -199,6 +303,9 @@ struct cloud_backend_config {
 	void *user_data;
 	char *id;
 	size_t id_len;
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+	struct cloud_send_queue send_queue;
+#endif
 };
 
 /**@brief Structure for cloud backend. */
@@ -299,6 +406,72 @@ static inline int cloud_send(const struct cloud_backend *const backend,
 	return backend->api->send(backend, msg);
 }
 
+/**@brief Queue a message to be sent asynchronously.
+ *
+ * @details Messages are sent from the cloud send work queue when the
+ *	    backend is ready, in order of priority. The status of the
+ *	    message is reported in the request callback. Messages that are
+ *	    queued when the backend is disconnected are kept until the
+ *	    backend is ready again. Messages waiting for an acknowledgment
+ *	    fail with -ENOTCONN on disconnect.
+ *
+ * @note Requires CONFIG_CLOUD_API_ASYNC_SEND.
+ *
+ * @param backend Pointer to a cloud backend structure.
+ * @param req     Pointer to the send request. The request and the message
+ *		  buffer must be valid until the message is sent.
+ *
+ * @retval 0 If the message was queued.
+ * @retval -ENOBUFS If the send queue of the backend is full. The caller
+ *		    should retry when a queued message has been sent.
+ * @return Otherwise a negative error code.
+ */
+int cloud_send_async(const struct cloud_backend *const backend,
+		     struct cloud_send_req *req);
+
+/**@brief Remove a queued message from the send queue. The request
+ *	  callback is not called.
+ *
+ * @param backend Pointer to a cloud backend structure.
+ * @param req     Pointer to the send request.
+ *
+ * @retval 0 If the message was removed.
+ * @retval -EBUSY If the message has already been sent or is being sent.
+ */
+int cloud_send_async_cancel(const struct cloud_backend *const backend,
+			    struct cloud_send_req *req);
+
+/**@brief Report the acknowledgment of a message sent with the send_with_id()
+ *	  API of a backend. Called by the backend.
+ *
+ * @param backend    Pointer to cloud backend.
+ * @param message_id ID of the acknowledged message. IDs of messages not
+ *		     sent with @ref cloud_send_async are ignored.
+ * @param result     0 if the message was acknowledged, otherwise a negative
+ *		     error code.
+ */
+void cloud_send_ack_notify(const struct cloud_backend *const backend,
+			   uint16_t message_id, int result);
+
+/**@brief Process a backend event in the asynchronous send queue.
+ *	  Called by @ref cloud_notify_event.
+ */
+void cloud_send_async_evt_handle(const struct cloud_backend *const backend,
+				 const struct cloud_event *const evt);
+
+/**@brief Check if the backend reports acknowledgments of messages sent with
+ *	  @ref cloud_send_async. If so, messages with a QoS other than
+ *	  CLOUD_QOS_AT_MOST_ONCE get CLOUD_SEND_STATUS_ACKED or
+ *	  CLOUD_SEND_STATUS_FAILED as final status.
+ *
+ * @param backend Pointer to a cloud backend structure.
+ */
+static inline bool cloud_send_ack_supported(const struct cloud_backend *const backend)
+{
+	return (backend != NULL) && (backend->api != NULL) &&
+	       (backend->api->send_with_id != NULL);
+}
+
 /**
  * @brief Optional API to ping the cloud's remote endpoint periodically.
  *
@@ -451,6 +624,10 @@ static inline void cloud_notify_event(struct cloud_backend *backend,
 				      struct cloud_event *evt,
 				      void *user_data)
 {
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+	cloud_send_async_evt_handle(backend, evt);
+#endif
+
 	if (backend->config->handler) {
 		backend->config->handler(backend, evt, user_data);
 	}
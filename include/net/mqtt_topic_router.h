@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MQTT_TOPIC_ROUTER_H__
+#define MQTT_TOPIC_ROUTER_H__
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file mqtt_topic_router.h
+ * @defgroup mqtt_topic_router MQTT topic router
+ * @{
+ * @brief Library that matches incoming MQTT topics against a set of topic
+ *	  filters.
+ *
+ * The topic filters are registered when the topics are known, typically
+ * before subscribing, and are stored in a tree with one node per topic
+ * level. Matching a topic walks the tree one level at a time, so the cost
+ * depends on the number of levels in the topic and not on the number of
+ * registered filters. The single-level (+) and multi-level (#) wildcards
+ * are supported.
+ *
+ * The router does not copy the filters. The filter strings must be valid
+ * for as long as the router is used.
+ */
+
+/** @brief Node of the topic tree. Private, used by the library. */
+struct mqtt_topic_router_node {
+	const char *level;
+	uint16_t level_len;
+	/* Index of the first child and of the next sibling, plus one.
+	 * Zero if there is none.
+	 */
+	uint16_t child;
+	uint16_t sibling;
+	/* Route of the filter that ends at this node, or -1. */
+	int16_t route;
+};
+
+/** @brief Topic router. */
+struct mqtt_topic_router {
+	struct mqtt_topic_router_node *nodes;
+	uint16_t node_max;
+	uint16_t node_count;
+	/* Index of the first top level node, plus one. */
+	uint16_t root;
+};
+
+/**
+ * @brief Define a topic router.
+ *
+ * @param _name Name of the router.
+ * @param _node_max Maximum number of nodes. A filter uses one node per
+ *		    topic level that it does not share with a previously
+ *		    added filter.
+ */
+#define MQTT_TOPIC_ROUTER_DEFINE(_name, _node_max)				\
+	static struct mqtt_topic_router_node _name##_nodes[_node_max];		\
+	static struct mqtt_topic_router _name = {				\
+		.nodes = _name##_nodes,						\
+		.node_max = _node_max,						\
+	}
+
+/**
+ * @brief Remove all filters from the router.
+ *
+ * @param[in] router Router.
+ */
+void mqtt_topic_router_reset(struct mqtt_topic_router *router);
+
+/**
+ * @brief Add a topic filter to the router.
+ *
+ * @param[in] router Router.
+ * @param[in] filter Topic filter. Not copied, must be kept valid.
+ * @param[in] filter_len Length of the topic filter.
+ * @param[in] route Value returned by @ref mqtt_topic_router_match for
+ *		    topics that match the filter, 0 to INT16_MAX.
+ *
+ * @retval 0 If the filter was added.
+ * @retval -EINVAL If the filter or route is invalid.
+ * @retval -EEXIST If the filter has already been added.
+ * @retval -ENOMEM If the router has no free nodes.
+ */
+int mqtt_topic_router_add(struct mqtt_topic_router *router, const char *filter,
+			  size_t filter_len, int route);
+
+/**
+ * @brief Find the route of a topic.
+ *
+ * If several filters match the topic, a filter with an exact topic level
+ * is preferred over the single-level wildcard, which is preferred over the
+ * multi-level wildcard, level by level from the start of the topic.
+ * As required by MQTT, topics starting with '$' do not match filters
+ * starting with a wildcard.
+ *
+ * @param[in] router Router.
+ * @param[in] topic Topic, does not need to be NULL-terminated.
+ * @param[in] topic_len Length of the topic.
+ *
+ * @return Route of the matching filter.
+ * @retval -ENOENT If no filter matches the topic.
+ * @retval -EINVAL If the router or topic is NULL.
+ */
+int mqtt_topic_router_match(const struct mqtt_topic_router *router, const char *topic,
+			    size_t topic_len);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_TOPIC_ROUTER_H__ */
@@ -171,6 +171,16 @@ enum nrf_cloud_topic_type {
 	NRF_CLOUD_TOPIC_BULK
 };
 
+/** @brief Encoding of device-to-cloud sensor data messages. */
+enum nrf_cloud_encoding {
+	/** JSON text, as expected by nRF Cloud. */
+	NRF_CLOUD_ENCODING_JSON,
+	/** CBOR, with the same keys and structure as the JSON encoding.
+	 *  Requires @kconfig{CONFIG_NRF_CLOUD_CBOR}.
+	 */
+	NRF_CLOUD_ENCODING_CBOR,
+};
+
 /**@brief FOTA status reported to nRF Cloud. */
 enum nrf_cloud_fota_status {
 	NRF_CLOUD_FOTA_QUEUED = 0,
@@ -485,6 +495,28 @@ int nrf_cloud_shadow_device_status_update(const struct nrf_cloud_device_status *
  */
 int nrf_cloud_sensor_data_stream(const struct nrf_cloud_sensor_data *param);
 
+/**
+ * @brief Set the encoding of sensor data messages.
+ *
+ * The encoding applies to messages sent with @ref nrf_cloud_sensor_data_send
+ * and @ref nrf_cloud_sensor_data_stream. Shadow updates and location
+ * requests are always encoded as JSON.
+ *
+ * @param[in] encoding Encoding to be used.
+ *
+ * @retval 0        If successful.
+ * @retval -ENOTSUP The encoding is not enabled.
+ * @retval -EINVAL  The encoding is unknown.
+ */
+int nrf_cloud_encoding_set(enum nrf_cloud_encoding encoding);
+
+/**
+ * @brief Get the encoding of sensor data messages.
+ *
+ * @return Encoding in use.
+ */
+enum nrf_cloud_encoding nrf_cloud_encoding_get(void);
+
 /**
  * @brief Send data to nRF Cloud.
  *
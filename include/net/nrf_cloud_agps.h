@@ -57,6 +57,26 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len);
  */
 void nrf_cloud_agps_processed(struct nrf_modem_gnss_agps_data_frame *received_elements);
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+/**@brief Injects cached A-GPS data requested by the modem.
+ *
+ * Requested elements that are cached and not older than their configured
+ * maximum age are injected to the modem and removed from the request.
+ * Ephemerides and almanacs are injected only if all requested satellites
+ * are cached, because nRF Cloud sends them as a whole.
+ *
+ * @ref nrf_cloud_agps_request does this before sending the request. Call
+ * this function directly when the remaining data is requested in another
+ * way, for example with nrf_cloud_rest_agps_data_get().
+ *
+ * @param request Elements requested by the modem. Updated to the elements
+ *                that still need to be requested.
+ *
+ * @return 0 if successful, otherwise a (negative) error code.
+ */
+int nrf_cloud_agps_cache_inject(struct nrf_modem_gnss_agps_data_frame *request);
+#endif /* CONFIG_NRF_CLOUD_AGPS_CACHE */
+
 /**@brief Query whether A-GPS data has been requested from cloud
  *
  * @return True if request is outstanding.
@@ -66,6 +66,75 @@ struct wave_gen_param {
  */
 int wave_gen_generate_value(uint32_t time, const struct wave_gen_param *params, double *out_val);
 
+/** @brief State of the wave signal generated in blocks.
+ *
+ * The structure is used to generate a continuous wave signal sampled with a fixed step.
+ * The members must not be modified directly.
+ */
+struct wave_gen_block {
+	/** Parameters of the wave signal. */
+	struct wave_gen_param params;
+
+	/** Time between subsequent values [us]. */
+	uint32_t sample_period_us;
+
+	/** Phase of the next value. Full range of the variable represents one period. */
+	uint32_t phase;
+
+	/** Phase increment between subsequent values. */
+	uint32_t phase_step;
+
+	/** State of the noise generator. */
+	uint32_t noise_state;
+};
+
+/**
+ * @brief Initialize generating wave signal in blocks.
+ *
+ * The generated signal starts at the beginning of the wave period. Noise is generated using
+ * a pseudo-random number generator initialized with the provided seed. The same seed results
+ * in the same sequence of values.
+ *
+ * @param[out]	block			Pointer to the initialized wave block state.
+ * @param[in]	params			Parameters describing generated wave signal.
+ * @param[in]	sample_period_us	Time between subsequent values [us].
+ * @param[in]	seed			Seed of the noise generator.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int wave_gen_block_init(struct wave_gen_block *block, const struct wave_gen_param *params,
+			uint32_t sample_period_us, uint32_t seed);
+
+/**
+ * @brief Update parameters of wave signal generated in blocks.
+ *
+ * The phase of the signal is preserved.
+ *
+ * @param[in,out] block		Pointer to the wave block state.
+ * @param[in]	  params	Parameters describing generated wave signal.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int wave_gen_block_set_param(struct wave_gen_block *block, const struct wave_gen_param *params);
+
+/**
+ * @brief Generate a block of wave values.
+ *
+ * The values are generated with a fixed time step and continue the signal generated by the
+ * previous call. The values are stored with the given stride, so that the values of multiple
+ * signals can be interleaved in a single buffer.
+ *
+ * @param[in,out] block		Pointer to the wave block state.
+ * @param[out]	  out		Pointer to the buffer that is used to store generated values.
+ * @param[in]	  cnt		Number of generated values.
+ * @param[in]	  stride	Distance between subsequent values in the buffer (1 for
+ *				contiguous values).
+ */
+void wave_gen_generate_block(struct wave_gen_block *block, float *out, size_t cnt,
+			     size_t stride);
+
 #ifdef __cplusplus
 }
 #endif
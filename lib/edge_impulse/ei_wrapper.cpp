@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <math.h>
+
 #include <ei_run_classifier.h>
 #include <ei_wrapper.h>
 
@@ -25,6 +26,20 @@ BUILD_ASSERT(CONFIG_EI_WRAPPER_THREAD_STACK_SIZE > 0);
 #define THREAD_PRIORITY 	CONFIG_EI_WRAPPER_THREAD_PRIORITY
 #define DEBUG_MODE		IS_ENABLED(CONFIG_EI_WRAPPER_DEBUG_MODE)
 
+#ifdef CONFIG_EI_WRAPPER_CONTINUOUS
+#define CONTINUOUS_MODE		true
+#define INPUT_SLICE_SIZE	(EI_CLASSIFIER_SLICE_SIZE * INPUT_FRAME_SIZE)
+#define PROCESS_SIZE		INPUT_SLICE_SIZE
+
+/* EI_CLASSIFIER_SLICE_SIZE is given in samples, each made of INPUT_FRAME_SIZE values.
+ * The slices must cover the whole window.
+ */
+BUILD_ASSERT(INPUT_SLICE_SIZE * CONFIG_EI_WRAPPER_CONTINUOUS_SLICES == INPUT_WINDOW_SIZE);
+#else
+#define CONTINUOUS_MODE		false
+#define PROCESS_SIZE		INPUT_WINDOW_SIZE
+#endif
+
 enum state {
 	STATE_DISABLED,
 	STATE_WAITING_FOR_DATA,
@@ -51,6 +66,7 @@ static struct data_buffer ei_input;
 static ei_impulse_result_t ei_result;
 static int cur_res_idx;
 static ei_wrapper_result_ready_cb user_cb;
+static atomic_t classifier_reset = ATOMIC_INIT(true);
 
 
 BUILD_ASSERT(DATA_BUFFER_SIZE > INPUT_WINDOW_SIZE);
@@ -70,7 +86,7 @@ static size_t buf_calc_free_space(const struct data_buffer *b)
 {
 	if (b->wait_data_size > 0) {
 		return b->wait_data_size + ARRAY_SIZE(b->buf) -
-		       INPUT_WINDOW_SIZE - 1;
+		       PROCESS_SIZE - 1;
 	}
 
 	return ARRAY_SIZE(b->buf) - buf_get_collected_data_count(b) - 1;
@@ -83,6 +99,14 @@ static void buf_processing_end(struct data_buffer *b)
 	__ASSERT_NO_MSG(b->state == STATE_PROCESSING);
 	b->state = STATE_READY;
 
+	if (CONTINUOUS_MODE) {
+		/* Each slice is passed to the classifier only once. */
+		b->process_idx += PROCESS_SIZE;
+		if (b->process_idx >= ARRAY_SIZE(b->buf)) {
+			b->process_idx -= ARRAY_SIZE(b->buf);
+		}
+	}
+
 	k_spin_unlock(&b->lock, key);
 }
 
@@ -162,7 +186,7 @@ static int buf_append(struct data_buffer *b, const float *data, size_t len,
 static void buf_get(const struct data_buffer *b, float *b_res, size_t offset,
 		    size_t len)
 {
-	__ASSERT_NO_MSG((offset + len) <= INPUT_WINDOW_SIZE);
+	__ASSERT_NO_MSG((offset + len) <= PROCESS_SIZE);
 
 	/* Processing index cannot change while processing is done. */
 	__ASSERT_NO_MSG(b->state == STATE_PROCESSING);
@@ -207,7 +231,7 @@ static int buf_processing_move(struct data_buffer *b, size_t move,
 		b->process_idx -= ARRAY_SIZE(b->buf);
 	}
 
-	size_t processing_end_move = move + INPUT_WINDOW_SIZE;
+	size_t processing_end_move = move + PROCESS_SIZE;
 
 	if (processing_end_move > max_move) {
 		b->wait_data_size = processing_end_move - max_move;
@@ -275,7 +299,14 @@ int ei_wrapper_add_data(const float *data, size_t data_size)
 
 int ei_wrapper_clear_data(bool *cancelled)
 {
-	return buf_cleanup(&ei_input, cancelled);
+	int err = buf_cleanup(&ei_input, cancelled);
+
+	if (!err && CONTINUOUS_MODE) {
+		/* Features cached for the dropped data can no longer be used. */
+		atomic_set(&classifier_reset, true);
+	}
+
+	return err;
 }
 
 int ei_wrapper_start_prediction(size_t window_shift, size_t frame_shift)
@@ -283,6 +314,11 @@ int ei_wrapper_start_prediction(size_t window_shift, size_t frame_shift)
 	size_t sample_shift = window_shift * ei_wrapper_get_window_size() +
 			      frame_shift * ei_wrapper_get_frame_size();
 
+	if (CONTINUOUS_MODE && (sample_shift > 0)) {
+		/* Skipping data would break the cached feature history. */
+		return -EINVAL;
+	}
+
 	bool process_buf;
 	int err = buf_processing_move(&ei_input, sample_shift, &process_buf);
 
@@ -293,6 +329,10 @@ int ei_wrapper_start_prediction(size_t window_shift, size_t frame_shift)
 	return err;
 }
 
+/* The classifier pulls the input window through the signal callback into its own buffers.
+ * Offsets are mapped directly into the circular buffer (including the wrap), so the wrapper
+ * does not use any intermediate copy of the window.
+ */
 static int raw_feature_get_data(size_t offset, size_t length, float *out_ptr)
 {
 	buf_get(&ei_input, out_ptr, offset, length);
@@ -317,11 +357,24 @@ static void edge_impulse_thread_fn(void)
 		k_sem_take(&ei_sem, K_FOREVER);
 
 		features_signal.get_data = &raw_feature_get_data;
-		features_signal.total_length = INPUT_WINDOW_SIZE;
+		features_signal.total_length = PROCESS_SIZE;
+
+		EI_IMPULSE_ERROR err;
+
+#ifdef CONFIG_EI_WRAPPER_CONTINUOUS
+		if (atomic_cas(&classifier_reset, true, false)) {
+			run_classifier_init();
+		}
 
+		/* Only the newest slice is processed by DSP. Features of the
+		 * previous slices of the window are reused by the library.
+		 */
+		err = run_classifier_continuous(&features_signal, &ei_result,
+						DEBUG_MODE);
+#else
 		/* Invoke the impulse. */
-		EI_IMPULSE_ERROR err = run_classifier(&features_signal,
-						      &ei_result, DEBUG_MODE);
+		err = run_classifier(&features_signal, &ei_result, DEBUG_MODE);
+#endif
 
 		if (err) {
 			LOG_ERR("run_classifier err=%d", err);
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <json_writer.h>
+
+#define MAX_DEPTH	32
+#define NUM_BUF_SIZE	26
+
+static void put(struct json_writer *w, const char *data, size_t len)
+{
+	/* One byte is always left for the NULL terminator. */
+	if (w->len + len >= w->size) {
+		json_writer_error(w, -ENOBUFS);
+	} else if (w->buf && !w->err) {
+		memcpy(&w->buf[w->len], data, len);
+	}
+
+	w->len += len;
+}
+
+static void put_c(struct json_writer *w, char c)
+{
+	put(w, &c, 1);
+}
+
+/* Strings are escaped in the same way as done by cJSON. */
+static void put_str(struct json_writer *w, const char *str)
+{
+	const char *start = str;
+
+	put_c(w, '"');
+
+	for (; *str; str++) {
+		unsigned char c = *str;
+		char esc = 0;
+
+		switch (c) {
+		case '"':
+		case '\\':
+			esc = c;
+			break;
+		case '\b':
+			esc = 'b';
+			break;
+		case '\f':
+			esc = 'f';
+			break;
+		case '\n':
+			esc = 'n';
+			break;
+		case '\r':
+			esc = 'r';
+			break;
+		case '\t':
+			esc = 't';
+			break;
+		default:
+			if (c >= 32) {
+				continue;
+			}
+			break;
+		}
+
+		put(w, start, str - start);
+		start = str + 1;
+
+		if (esc) {
+			char seq[2] = {'\\', esc};
+
+			put(w, seq, sizeof(seq));
+		} else {
+			char seq[7];
+
+			snprintf(seq, sizeof(seq), "\\u%04x", c);
+			put(w, seq, 6);
+		}
+	}
+
+	put(w, start, str - start);
+	put_c(w, '"');
+}
+
+static void item_start(struct json_writer *w, const char *key)
+{
+	if (w->depth > 0) {
+		if (w->first & BIT(w->depth - 1)) {
+			w->first &= ~BIT(w->depth - 1);
+		} else {
+			put_c(w, ',');
+		}
+	}
+
+	if (key) {
+		put_str(w, key);
+		put_c(w, ':');
+	}
+}
+
+static void level_push(struct json_writer *w, const char *key, char c)
+{
+	item_start(w, key);
+	put_c(w, c);
+
+	if (w->depth == MAX_DEPTH) {
+		json_writer_error(w, -E2BIG);
+		return;
+	}
+
+	w->first |= BIT(w->depth);
+	w->depth++;
+}
+
+static void level_pop(struct json_writer *w, char c)
+{
+	if (w->depth == 0) {
+		json_writer_error(w, -EINVAL);
+		return;
+	}
+
+	w->depth--;
+	put_c(w, c);
+}
+
+void json_writer_init(struct json_writer *w, char *buf, size_t size)
+{
+	memset(w, 0, sizeof(*w));
+	w->buf = buf;
+	w->size = size;
+}
+
+void json_writer_obj_start(struct json_writer *w, const char *key)
+{
+	level_push(w, key, '{');
+}
+
+void json_writer_obj_end(struct json_writer *w)
+{
+	level_pop(w, '}');
+}
+
+void json_writer_arr_start(struct json_writer *w, const char *key)
+{
+	level_push(w, key, '[');
+}
+
+void json_writer_arr_end(struct json_writer *w)
+{
+	level_pop(w, ']');
+}
+
+void json_writer_str(struct json_writer *w, const char *key, const char *val)
+{
+	if (val == NULL) {
+		json_writer_error(w, -EINVAL);
+		return;
+	}
+
+	item_start(w, key);
+	put_str(w, val);
+}
+
+static bool compare_double(double a, double b)
+{
+	double max_val = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+
+	return (fabs(a - b) <= max_val * DBL_EPSILON);
+}
+
+/* Numbers are formatted in the same way as done by cJSON. */
+void json_writer_num(struct json_writer *w, const char *key, double val)
+{
+	char num[NUM_BUF_SIZE];
+	int len;
+
+	item_start(w, key);
+
+	if (isnan(val) || isinf(val)) {
+		len = snprintf(num, sizeof(num), "null");
+	} else {
+		int val_int;
+
+		if (val >= INT_MAX) {
+			val_int = INT_MAX;
+		} else if (val <= (double)INT_MIN) {
+			val_int = INT_MIN;
+		} else {
+			val_int = (int)val;
+		}
+
+		if (val == (double)val_int) {
+			len = snprintf(num, sizeof(num), "%d", val_int);
+		} else {
+			len = snprintf(num, sizeof(num), "%1.15g", val);
+
+			if (!compare_double(strtod(num, NULL), val)) {
+				len = snprintf(num, sizeof(num), "%1.17g", val);
+			}
+		}
+	}
+
+	if ((len < 0) || ((size_t)len >= sizeof(num))) {
+		json_writer_error(w, -EINVAL);
+		return;
+	}
+
+	put(w, num, len);
+}
+
+void json_writer_null(struct json_writer *w, const char *key)
+{
+	item_start(w, key);
+	put(w, "null", 4);
+}
+
+void json_writer_bool(struct json_writer *w, const char *key, bool val)
+{
+	item_start(w, key);
+	if (val) {
+		put(w, "true", 4);
+	} else {
+		put(w, "false", 5);
+	}
+}
+
+void json_writer_raw(struct json_writer *w, const char *data, size_t len)
+{
+	put(w, data, len);
+}
+
+void json_writer_mark(const struct json_writer *w, struct json_writer_mark *mark)
+{
+	mark->len = w->len;
+	mark->first = w->first;
+	mark->depth = w->depth;
+	mark->err = w->err;
+}
+
+void json_writer_rewind(struct json_writer *w, const struct json_writer_mark *mark)
+{
+	w->len = mark->len;
+	w->first = mark->first;
+	w->depth = mark->depth;
+	w->err = mark->err;
+}
+
+bool json_writer_fits(const struct json_writer *w)
+{
+	/* Each open object or array needs one byte to be closed. */
+	return !w->err && (w->len + w->depth < w->size);
+}
+
+int json_writer_finish(struct json_writer *w)
+{
+	if (w->depth != 0) {
+		json_writer_error(w, -EINVAL);
+	}
+
+	if (w->buf && (w->size > 0)) {
+		w->buf[MIN(w->len, w->size - 1)] = '\0';
+	}
+
+	if (w->err) {
+		return w->err;
+	}
+
+	return w->len;
+}
+
+int json_writer_encode_alloc(json_writer_encode_fn fn, void *ctx, size_t max_size,
+			     char **out, size_t *out_len)
+{
+	int err;
+	int len;
+	char *buf;
+	struct json_writer w;
+
+	/* Calculate the length of the output. The entries that are written are decided by
+	 * the maximum size. When writing the output to a buffer of the calculated length the
+	 * same entries fit, so both passes produce the same output.
+	 */
+	json_writer_init(&w, NULL, max_size);
+
+	err = fn(&w, ctx);
+	if (err) {
+		return err;
+	}
+
+	len = json_writer_finish(&w);
+	if (len < 0) {
+		return len;
+	}
+
+	buf = k_malloc(len + 1);
+	if (buf == NULL) {
+		return -ENOMEM;
+	}
+
+	json_writer_init(&w, buf, len + 1);
+
+	err = fn(&w, ctx);
+	if (err) {
+		k_free(buf);
+		return err;
+	}
+
+	err = json_writer_finish(&w);
+	if (err < 0) {
+		k_free(buf);
+		return err;
+	}
+
+	__ASSERT_NO_MSG(err == len);
+
+	*out = buf;
+	*out_len = len;
+
+	return 0;
+}
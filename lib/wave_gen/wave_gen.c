@@ -125,3 +125,180 @@ int wave_gen_generate_value(uint32_t time, const struct wave_gen_param *params,
 
 	return 0;
 }
+
+/* Sine values generated in a block are resynchronized with the phase after this number of
+ * values to avoid accumulating error of the recurrence.
+ */
+#define BLOCK_SINE_RESYNC_CNT	64
+
+/* Phase is a fraction of the wave period, where 2^32 represents the full period. */
+#define PHASE_TO_RAD(phase)	((float)(phase) * (float)(2 * M_PI / 4294967296.0))
+#define PHASE_HALF		BIT(31)
+
+#define NOISE_DEFAULT_SEED	0x12345678
+
+/**
+ * @brief Generates a pseudo-random number between -1 and 1 using xorshift32.
+ *
+ * @param[in,out] state	State of the generator.
+ *
+ * @return Pseudo-random number.
+ */
+static float block_noise(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return (int32_t)x * (1.0f / 2147483648.0f);
+}
+
+static int block_phase_step_calc(const struct wave_gen_param *params, uint32_t sample_period_us,
+				 uint32_t *phase_step)
+{
+	if (params->type >= WAVE_GEN_TYPE_COUNT) {
+		return -EINVAL;
+	}
+
+	if (params->period_ms == 0) {
+		if (params->type != WAVE_GEN_TYPE_NONE) {
+			return -EINVAL;
+		}
+
+		*phase_step = 0;
+		return 0;
+	}
+
+	uint64_t period_us = (uint64_t)params->period_ms * USEC_PER_MSEC;
+
+	*phase_step = ((((uint64_t)sample_period_us % period_us) << 32) + period_us / 2) /
+		      period_us;
+
+	return 0;
+}
+
+int wave_gen_block_init(struct wave_gen_block *block, const struct wave_gen_param *params,
+			uint32_t sample_period_us, uint32_t seed)
+{
+	uint32_t phase_step;
+	int err = block_phase_step_calc(params, sample_period_us, &phase_step);
+
+	if (err) {
+		return err;
+	}
+
+	block->params = *params;
+	block->sample_period_us = sample_period_us;
+	block->phase = 0;
+	block->phase_step = phase_step;
+	/* Zero is a fixed point of the xorshift generator. */
+	block->noise_state = (seed != 0) ? (seed) : (NOISE_DEFAULT_SEED);
+
+	return 0;
+}
+
+int wave_gen_block_set_param(struct wave_gen_block *block, const struct wave_gen_param *params)
+{
+	uint32_t phase_step;
+	int err = block_phase_step_calc(params, block->sample_period_us, &phase_step);
+
+	if (err) {
+		return err;
+	}
+
+	block->params = *params;
+	block->phase_step = phase_step;
+
+	return 0;
+}
+
+static void block_sine(struct wave_gen_block *block, float *out, size_t cnt, size_t stride)
+{
+	const float step_sin = sinf(PHASE_TO_RAD(block->phase_step));
+	const float step_cos = cosf(PHASE_TO_RAD(block->phase_step));
+
+	while (cnt > 0) {
+		size_t chunk = MIN(cnt, BLOCK_SINE_RESYNC_CNT);
+		float s = sinf(PHASE_TO_RAD(block->phase));
+		float c = cosf(PHASE_TO_RAD(block->phase));
+
+		for (size_t i = 0; i < chunk; i++) {
+			float s_next = s * step_cos + c * step_sin;
+
+			*out = s;
+			out += stride;
+
+			c = c * step_cos - s * step_sin;
+			s = s_next;
+		}
+
+		block->phase += chunk * block->phase_step;
+		cnt -= chunk;
+	}
+}
+
+static void block_triangle(struct wave_gen_block *block, float *out, size_t cnt, size_t stride)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		float p = block->phase * (1.0f / 4294967296.0f);
+
+		*out = (block->phase < PHASE_HALF) ? (4.0f * p - 1.0f) : (3.0f - 4.0f * p);
+		out += stride;
+
+		block->phase += block->phase_step;
+	}
+}
+
+static void block_square(struct wave_gen_block *block, float *out, size_t cnt, size_t stride)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		*out = (block->phase < PHASE_HALF) ? (-1.0f) : (1.0f);
+		out += stride;
+
+		block->phase += block->phase_step;
+	}
+}
+
+void wave_gen_generate_block(struct wave_gen_block *block, float *out, size_t cnt,
+			     size_t stride)
+{
+	__ASSERT_NO_MSG(stride > 0);
+
+	const float amplitude = block->params.amplitude;
+	const float offset = block->params.offset;
+	const float noise = block->params.noise;
+
+	switch (block->params.type) {
+	case WAVE_GEN_TYPE_SINE:
+		block_sine(block, out, cnt, stride);
+		break;
+
+	case WAVE_GEN_TYPE_TRIANGLE:
+		block_triangle(block, out, cnt, stride);
+		break;
+
+	case WAVE_GEN_TYPE_SQUARE:
+		block_square(block, out, cnt, stride);
+		break;
+
+	case WAVE_GEN_TYPE_NONE:
+	default:
+		for (size_t i = 0; i < cnt; i++) {
+			out[i * stride] = 0.0f;
+		}
+		break;
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		float *val = &out[i * stride];
+
+		*val = *val * amplitude + offset;
+
+		if (noise != 0.0f) {
+			*val += noise * block_noise(&block->noise_state);
+		}
+	}
+}
@@ -53,6 +53,18 @@ BLE_BOND_OPTIONS = {
     'peer_search':            ConfigOption(None, 'peer_search', 'Trigger peer search', None),
 }
 
+HID_FORWARD_OPTIONS = {
+    'report_count':   ConfigOption((0, 0xFFFFFFFF), 'lat_stats', 'Number of forwarded HID input reports', int),
+    'merged_count':   ConfigOption((0, 0xFFFFFFFF), 'lat_stats', 'Number of mouse reports merged into enqueued reports', int),
+    'latency_avg':    ConfigOption((0, 0xFFFFFFFF), 'lat_stats', 'Average forwarding latency [us]', int),
+    'latency_max':    ConfigOption((0, 0xFFFFFFFF), 'lat_stats', 'Maximum forwarding latency [us]', int),
+    'latency_reset':  ConfigOption(None, 'lat_reset', 'Reset forwarding latency statistics', None),
+}
+
+HID_FORWARD_OPTIONS_FORMAT = {
+    'lat_stats': ('<IIII', ['report_count', 'merged_count', 'latency_avg', 'latency_max'], None, None),
+}
+
 MODULE_CONFIG = {
     'motion/paw3212' : {
         'options' : MOTION_PAW3212_OPTIONS
@@ -69,5 +81,10 @@ MODULE_CONFIG = {
 
     'ble_bond' : {
         'options' : BLE_BOND_OPTIONS
+    },
+
+    'hid_forward' : {
+        'options' : HID_FORWARD_OPTIONS,
+        'format' : HID_FORWARD_OPTIONS_FORMAT
     }
 }
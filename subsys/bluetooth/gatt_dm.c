@@ -5,7 +5,10 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 #include <zephyr.h>
+#include <sys/byteorder.h>
+#include <settings/settings.h>
 #include <logging/log.h>
 
 #include <bluetooth/gatt_dm.h>
@@ -18,10 +21,48 @@ LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
 #define DATA_ALIGN 4U
 
+/* Every characteristic takes at least two attributes, so the table is
+ * never more than half full.
+ */
+#define CHRC_UUID_TABLE_SIZE CONFIG_BT_GATT_DM_MAX_ATTRS
+
+/* Attribute indexes are stored as uint8_t */
+BUILD_ASSERT(CONFIG_BT_GATT_DM_MAX_ATTRS < UINT8_MAX);
+
 /* They are placed in data_chunk without padding, so they must be aligned */
 BUILD_ASSERT(sizeof(struct bt_gatt_service_val) % DATA_ALIGN == 0);
 BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
 
+#if CONFIG_BT_GATT_DM_CACHE
+#define CACHE_SETTINGS_KEY "bt_dm"
+#define CACHE_KEY_LEN (sizeof(CACHE_SETTINGS_KEY "/") + 13 + sizeof("/") + \
+		       8 + sizeof("/") + 4)
+#define CACHE_HASH_LEN 16
+#define CACHE_HEADER_SIZE (CACHE_HASH_LEN + 1)
+/* Handle, permissions, type, value handle, properties and two UUIDs */
+#define CACHE_ATTR_MAX_SIZE (6 + 2 * sizeof(struct bt_uuid_128))
+#define CACHE_DATA_MAX_SIZE (CACHE_HEADER_SIZE + \
+			     CONFIG_BT_GATT_DM_MAX_ATTRS * CACHE_ATTR_MAX_SIZE)
+
+/* Type of the attribute stored in the cache */
+enum {
+	CACHE_ATTR_PLAIN,
+	CACHE_ATTR_SERVICE,
+	CACHE_ATTR_CHRC
+};
+
+/* Any type of the UUID, aligned for the UUID structure access */
+union cache_uuid {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 uuid_16;
+	struct bt_uuid_32 uuid_32;
+	struct bt_uuid_128 uuid_128;
+};
+
+/* Serialized attributes of the currently stored or loaded service */
+static uint8_t cache_data[CACHE_DATA_MAX_SIZE];
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 /* Flags for parsed attribute array state */
 enum {
 	STATE_ATTRS_LOCKED,
@@ -50,6 +91,17 @@ struct bt_gatt_dm {
 	struct bt_gatt_dm_attr attrs[CONFIG_BT_GATT_DM_MAX_ATTRS];
 	/* Currently accessed attribute */
 	size_t cur_attr_id;
+	/* Hashes of the attribute UUIDs, built when discovery completes */
+	uint32_t attr_uuid_hash[CONFIG_BT_GATT_DM_MAX_ATTRS];
+	/* Indexes of the characteristic attributes in handle order */
+	uint8_t chrc_idx[CONFIG_BT_GATT_DM_MAX_ATTRS];
+	/* Number of the characteristic attributes */
+	size_t chrc_cnt;
+	/* Open addressing table of the characteristic value UUIDs.
+	 * Each entry holds the attribute index incremented by one,
+	 * 0 marks an empty entry.
+	 */
+	uint8_t chrc_uuid_table[CHRC_UUID_TABLE_SIZE];
 	/* Flags with the status of the attributes */
 	ATOMIC_DEFINE(state_flags, STATE_NUM);
 
@@ -60,6 +112,21 @@ struct bt_gatt_dm {
 
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
+
+#if CONFIG_BT_GATT_DM_CACHE
+	/* The Database Hash read parameters */
+	struct bt_gatt_read_params hash_read_params;
+	/* Work used to serve the discovery from the cache */
+	struct k_work cache_work;
+	/* The Database Hash of the peer */
+	uint8_t db_hash[CACHE_HASH_LEN];
+	/* Settings key of the currently discovered service */
+	char cache_key[CACHE_KEY_LEN];
+	/* The Database Hash is known and results can be cached */
+	bool cache_active;
+	/* Current results were loaded from the cache */
+	bool cache_hit;
+#endif /* CONFIG_BT_GATT_DM_CACHE */
 };
 
 /* Currently only one instance is supported */
@@ -113,6 +180,8 @@ static void svc_attr_memory_release(struct bt_gatt_dm *dm)
 
 	/* Clear attributes */
 	dm->cur_attr_id = 0;
+	dm->chrc_cnt = 0;
+	memset(dm->chrc_uuid_table, 0, sizeof(dm->chrc_uuid_table));
 
 	/* Release dynamic memory data chunks */
 	while (!sys_slist_is_empty(&dm->chunk_list)) {
@@ -236,9 +305,375 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+/* Must be called before the discovery parameters are modified. */
+static void cache_key_get(const struct bt_gatt_dm *dm, char *key, size_t len)
+{
+	const bt_addr_le_t *addr = bt_conn_get_dst(dm->conn);
+	const struct bt_uuid *uuid = dm->discover_params.uuid;
+	uint32_t uuid_hash = 0;
+
+	if (uuid) {
+		const uint8_t *uuid_data = (const uint8_t *)uuid;
+
+		/* 32-bit FNV-1a hash of the requested service UUID. */
+		uuid_hash = 2166136261U;
+		for (size_t i = 0; i < get_uuid_size(uuid); i++) {
+			uuid_hash ^= uuid_data[i];
+			uuid_hash *= 16777619U;
+		}
+	}
+
+	snprintk(key, len,
+		 CACHE_SETTINGS_KEY "/%02x%02x%02x%02x%02x%02x%u/%08x/%04x",
+		 addr->a.val[5], addr->a.val[4], addr->a.val[3],
+		 addr->a.val[2], addr->a.val[1], addr->a.val[0], addr->type,
+		 uuid_hash, dm->discover_params.start_handle);
+}
+
+static size_t cache_uuid_put(uint8_t *buf, const struct bt_uuid *uuid)
+{
+	size_t size = get_uuid_size(uuid);
+
+	memcpy(buf, uuid, size);
+
+	return size;
+}
+
+/* Returns number of bytes read or 0 if the buffer holds no valid UUID. */
+static size_t cache_uuid_get(const uint8_t *buf, size_t len,
+			     union cache_uuid *uuid)
+{
+	size_t size;
+
+	if (len < sizeof(struct bt_uuid)) {
+		return 0;
+	}
+
+	switch (buf[0]) {
+	case BT_UUID_TYPE_16:
+		size = sizeof(struct bt_uuid_16);
+		break;
+	case BT_UUID_TYPE_32:
+		size = sizeof(struct bt_uuid_32);
+		break;
+	case BT_UUID_TYPE_128:
+		size = sizeof(struct bt_uuid_128);
+		break;
+	default:
+		return 0;
+	}
+
+	if (len < size) {
+		return 0;
+	}
+
+	memcpy(uuid, buf, size);
+
+	return size;
+}
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+	uint8_t *pos = cache_data;
+	int err;
+
+	memcpy(pos, dm->db_hash, sizeof(dm->db_hash));
+	pos += sizeof(dm->db_hash);
+	*pos++ = dm->cur_attr_id;
+
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[i];
+		const struct bt_gatt_service_val *service_val =
+			bt_gatt_dm_attr_service_val(attr);
+		const struct bt_gatt_chrc *chrc = bt_gatt_dm_attr_chrc_val(attr);
+
+		sys_put_le16(attr->handle, pos);
+		pos += sizeof(uint16_t);
+		*pos++ = attr->perm;
+
+		if (service_val) {
+			*pos++ = CACHE_ATTR_SERVICE;
+			pos += cache_uuid_put(pos, attr->uuid);
+			sys_put_le16(service_val->end_handle, pos);
+			pos += sizeof(uint16_t);
+			pos += cache_uuid_put(pos, service_val->uuid);
+		} else if (chrc) {
+			*pos++ = CACHE_ATTR_CHRC;
+			pos += cache_uuid_put(pos, attr->uuid);
+			sys_put_le16(chrc->value_handle, pos);
+			pos += sizeof(uint16_t);
+			*pos++ = chrc->properties;
+			pos += cache_uuid_put(pos, chrc->uuid);
+		} else {
+			*pos++ = CACHE_ATTR_PLAIN;
+			pos += cache_uuid_put(pos, attr->uuid);
+		}
+	}
+
+	err = settings_save_one(dm->cache_key, cache_data, pos - cache_data);
+	if (err) {
+		LOG_WRN("Cannot store discovery cache, error: %d", err);
+	} else {
+		LOG_DBG("Discovery cache stored, %zu bytes", pos - cache_data);
+	}
+}
+
+static int cache_load_cb(const char *key, size_t len,
+			 settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	ssize_t *data_len = param;
+
+	/* Only the exact key match is expected. */
+	if (key) {
+		return 0;
+	}
+
+	if (len > sizeof(cache_data)) {
+		return -ENOMEM;
+	}
+
+	*data_len = read_cb(cb_arg, cache_data, len);
+
+	return 0;
+}
+
+/* Rebuilds the attribute array from the cache data. */
+static int cache_attrs_restore(struct bt_gatt_dm *dm, const uint8_t *pos,
+			       const uint8_t *end, size_t attr_cnt)
+{
+	for (size_t i = 0; i < attr_cnt; i++) {
+		union cache_uuid uuid;
+		union cache_uuid val_uuid;
+		struct bt_gatt_attr attr = {
+			.uuid = &uuid.uuid,
+		};
+		struct bt_gatt_dm_attr *cur_attr;
+		size_t size;
+		uint8_t type;
+
+		if (end - pos < sizeof(uint16_t) + 2) {
+			return -EINVAL;
+		}
+
+		attr.handle = sys_get_le16(pos);
+		pos += sizeof(uint16_t);
+		attr.perm = *pos++;
+		type = *pos++;
+
+		size = cache_uuid_get(pos, end - pos, &uuid);
+		if (!size) {
+			return -EINVAL;
+		}
+		pos += size;
+
+		switch (type) {
+		case CACHE_ATTR_SERVICE: {
+			struct bt_gatt_service_val *service_val;
+
+			if ((i != 0) || (end - pos < sizeof(uint16_t))) {
+				return -EINVAL;
+			}
+
+			cur_attr = attr_store(dm, &attr, sizeof(*service_val));
+			service_val = cur_attr ?
+				bt_gatt_dm_attr_service_val(cur_attr) : NULL;
+			if (!service_val) {
+				return -ENOMEM;
+			}
+
+			service_val->end_handle = sys_get_le16(pos);
+			pos += sizeof(uint16_t);
+
+			size = cache_uuid_get(pos, end - pos, &val_uuid);
+			if (!size) {
+				return -EINVAL;
+			}
+			pos += size;
+
+			service_val->uuid = uuid_store(dm, &val_uuid.uuid);
+			if (!service_val->uuid) {
+				return -ENOMEM;
+			}
+			break;
+		}
+		case CACHE_ATTR_CHRC: {
+			struct bt_gatt_chrc *chrc;
+
+			if (end - pos < sizeof(uint16_t) + 1) {
+				return -EINVAL;
+			}
+
+			cur_attr = attr_store(dm, &attr, sizeof(*chrc));
+			chrc = cur_attr ?
+				bt_gatt_dm_attr_chrc_val(cur_attr) : NULL;
+			if (!chrc) {
+				return -ENOMEM;
+			}
+
+			chrc->value_handle = sys_get_le16(pos);
+			pos += sizeof(uint16_t);
+			chrc->properties = *pos++;
+
+			size = cache_uuid_get(pos, end - pos, &val_uuid);
+			if (!size) {
+				return -EINVAL;
+			}
+			pos += size;
+
+			chrc->uuid = uuid_store(dm, &val_uuid.uuid);
+			if (!chrc->uuid) {
+				return -ENOMEM;
+			}
+			break;
+		}
+		case CACHE_ATTR_PLAIN:
+			if (i == 0) {
+				return -EINVAL;
+			}
+
+			cur_attr = attr_store(dm, &attr, 0);
+			if (!cur_attr) {
+				return -ENOMEM;
+			}
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	return (pos == end) ? 0 : -EINVAL;
+}
+
+/* Returns 0 if the attributes were loaded, -ENOENT if there is no valid
+ * cache entry or other (negative) error code on memory failure.
+ */
+static int cache_load(struct bt_gatt_dm *dm)
+{
+	ssize_t data_len = 0;
+	struct bt_gatt_service_val *service_val;
+	int err;
+
+	err = settings_load_subtree_direct(dm->cache_key, cache_load_cb, &data_len);
+	if (err || (data_len < CACHE_HEADER_SIZE)) {
+		return -ENOENT;
+	}
+
+	if (memcmp(cache_data, dm->db_hash, sizeof(dm->db_hash))) {
+		LOG_DBG("Database Hash changed");
+		return -ENOENT;
+	}
+
+	err = cache_attrs_restore(dm, &cache_data[CACHE_HEADER_SIZE],
+				  &cache_data[data_len],
+				  cache_data[CACHE_HASH_LEN]);
+	if (err == -EINVAL) {
+		LOG_WRN("Invalid discovery cache entry");
+		return -ENOENT;
+	} else if (err) {
+		return err;
+	}
+
+	service_val = bt_gatt_dm_attr_service_val(&dm->attrs[0]);
+	if (dm->discover_params.uuid &&
+	    bt_uuid_cmp(dm->discover_params.uuid, service_val->uuid)) {
+		return -ENOENT;
+	}
+
+	/* Let bt_gatt_dm_continue proceed from the end of this service. */
+	dm->discover_params.end_handle = service_val->end_handle;
+
+	return 0;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
+/* Returns the same hash for the 16, 32 and 128-bit representations
+ * of the same UUID, so that it is consistent with bt_uuid_cmp.
+ */
+static uint32_t uuid_hash(const struct bt_uuid *uuid)
+{
+	/* Bluetooth Base UUID without the 32-bit value, little-endian */
+	static const uint8_t base_uuid[] = {
+		0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+		0x00, 0x10, 0x00, 0x00
+	};
+	const uint8_t *val;
+	uint32_t hash;
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		return BT_UUID_16(uuid)->val;
+	case BT_UUID_TYPE_32:
+		return BT_UUID_32(uuid)->val;
+	case BT_UUID_TYPE_128:
+		val = BT_UUID_128(uuid)->val;
+		if (!memcmp(val, base_uuid, sizeof(base_uuid))) {
+			return sys_get_le32(&val[sizeof(base_uuid)]);
+		}
+
+		/* 32-bit FNV-1a hash. */
+		hash = 2166136261U;
+		for (size_t i = 0; i < BT_UUID_SIZE_128; i++) {
+			hash ^= val[i];
+			hash *= 16777619U;
+		}
+		return hash;
+	default:
+		return 0;
+	}
+}
+
+static struct bt_gatt_chrc *chrc_val_get(const struct bt_gatt_dm_attr *attr)
+{
+	return &((struct bt_gatt_chrc *)attr->uuid)[-1];
+}
+
+static bool attr_is_chrc(const struct bt_gatt_dm *dm,
+			 const struct bt_gatt_dm_attr *attr)
+{
+	return (dm->attr_uuid_hash[attr - dm->attrs] == BT_UUID_GATT_CHRC_VAL) &&
+	       !bt_uuid_cmp(BT_UUID_GATT_CHRC, attr->uuid);
+}
+
+static void attr_index_build(struct bt_gatt_dm *dm)
+{
+	dm->chrc_cnt = 0;
+	memset(dm->chrc_uuid_table, 0, sizeof(dm->chrc_uuid_table));
+
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[i];
+
+		dm->attr_uuid_hash[i] = uuid_hash(attr->uuid);
+
+		if ((i == 0) || !attr_is_chrc(dm, attr)) {
+			continue;
+		}
+
+		dm->chrc_idx[dm->chrc_cnt++] = i;
+
+		/* Characteristics are inserted in handle order, so the first
+		 * match in the probe sequence has the lowest handle.
+		 */
+		uint32_t pos = uuid_hash(chrc_val_get(attr)->uuid) %
+			       CHRC_UUID_TABLE_SIZE;
+
+		while (dm->chrc_uuid_table[pos]) {
+			pos = (pos + 1) % CHRC_UUID_TABLE_SIZE;
+		}
+
+		dm->chrc_uuid_table[pos] = i + 1;
+	}
+}
+
 static void discovery_complete(struct bt_gatt_dm *dm)
 {
 	LOG_DBG("Discovery complete.");
+	attr_index_build(dm);
+#if CONFIG_BT_GATT_DM_CACHE
+	if (dm->cache_active && !dm->cache_hit) {
+		cache_store(dm);
+	}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
@@ -496,16 +931,29 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_char_next(
 		prev = dm->attrs;
 	}
 
-	if (dm->attrs <= prev) {
-		const struct bt_gatt_dm_attr *const end =
-			&(dm->attrs[dm->cur_attr_id]);
-		while (++prev < end) {
-			if (!bt_uuid_cmp(BT_UUID_GATT_CHRC, prev->uuid)) {
-				return prev;
-			}
+	if ((prev < dm->attrs) || (prev >= &dm->attrs[dm->cur_attr_id])) {
+		return NULL;
+	}
+
+	size_t prev_idx = prev - dm->attrs;
+	size_t lower = 0;
+	size_t upper = dm->chrc_cnt;
+
+	/* Find the first characteristic after the given attribute. */
+	while (lower < upper) {
+		size_t m = (lower + upper) / 2;
+
+		if (dm->chrc_idx[m] <= prev_idx) {
+			lower = m + 1;
+		} else {
+			upper = m;
 		}
 	}
 
+	if (lower < dm->chrc_cnt) {
+		return &dm->attrs[dm->chrc_idx[lower]];
+	}
+
 	return NULL;
 }
 
@@ -513,15 +961,22 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_char_by_uuid(
 	const struct bt_gatt_dm *dm,
 	const struct bt_uuid *uuid)
 {
-	const struct bt_gatt_dm_attr *curr = NULL;
+	uint32_t pos = uuid_hash(uuid) % CHRC_UUID_TABLE_SIZE;
 
-	while ((curr = bt_gatt_dm_char_next(dm, curr)) != NULL) {
-		struct bt_gatt_chrc *chrc = bt_gatt_dm_attr_chrc_val(curr);
+	for (size_t i = 0; i < CHRC_UUID_TABLE_SIZE; i++) {
+		uint8_t entry = dm->chrc_uuid_table[pos];
 
-		__ASSERT_NO_MSG(chrc != NULL);
-		if (!bt_uuid_cmp(uuid, chrc->uuid)) {
-			return curr;
+		if (!entry) {
+			break;
 		}
+
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[entry - 1];
+
+		if (!bt_uuid_cmp(uuid, chrc_val_get(attr)->uuid)) {
+			return attr;
+		}
+
+		pos = (pos + 1) % CHRC_UUID_TABLE_SIZE;
 	}
 
 	return NULL;
@@ -559,9 +1014,11 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_by_uuid(
 	const struct bt_uuid *uuid)
 {
 	const struct bt_gatt_dm_attr *curr = attr_chrc;
+	uint32_t hash = uuid_hash(uuid);
 
 	while ((curr = bt_gatt_dm_desc_next(dm, curr)) != NULL) {
-		if (!bt_uuid_cmp(uuid, curr->uuid)) {
+		if ((dm->attr_uuid_hash[curr - dm->attrs] == hash) &&
+		    !bt_uuid_cmp(uuid, curr->uuid)) {
 			break;
 		}
 	}
@@ -575,13 +1032,104 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
 {
 	const struct bt_gatt_dm_attr *curr = bt_gatt_dm_attr_next(dm, prev);
 
-	if (curr && !bt_uuid_cmp(BT_UUID_GATT_CHRC, curr->uuid)) {
+	if (curr && attr_is_chrc(dm, curr)) {
 		curr = NULL;
 	}
 
 	return curr;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+static void cache_work_handler(struct k_work *work)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(work, struct bt_gatt_dm,
+					     cache_work);
+	const struct bt_uuid *svc_uuid = dm->discover_params.uuid;
+	union cache_uuid uuid;
+	int err;
+
+	if (dm->cache_active) {
+		if (svc_uuid) {
+			memcpy(&uuid, svc_uuid, get_uuid_size(svc_uuid));
+		}
+
+		cache_key_get(dm, dm->cache_key, sizeof(dm->cache_key));
+
+		err = cache_load(dm);
+		if (!err) {
+			LOG_DBG("Discovery served from the cache");
+			dm->cache_hit = true;
+			discovery_complete(dm);
+			return;
+		}
+
+		/* Drop partially restored data, but keep the service UUID. */
+		svc_attr_memory_release(dm);
+		dm->discover_params.uuid = svc_uuid ?
+					   uuid_store(dm, &uuid.uuid) : NULL;
+
+		if ((err != -ENOENT) || (svc_uuid && !dm->discover_params.uuid)) {
+			discovery_complete_error(dm, -ENOMEM);
+			return;
+		}
+	}
+
+	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+		discovery_complete_error(dm, err);
+	}
+}
+
+static uint8_t db_hash_read_cb(struct bt_conn *conn, uint8_t err,
+			       struct bt_gatt_read_params *params,
+			       const void *data, uint16_t length)
+{
+	struct bt_gatt_dm *dm = &bt_gatt_dm_inst;
+
+	if (!err && data && (length == sizeof(dm->db_hash))) {
+		memcpy(dm->db_hash, data, sizeof(dm->db_hash));
+		dm->cache_active = true;
+	} else {
+		LOG_DBG("Database Hash not available, error: %u", err);
+		dm->cache_active = false;
+	}
+
+	k_work_submit(&dm->cache_work);
+
+	return BT_GATT_ITER_STOP;
+}
+
+static int db_hash_read(struct bt_gatt_dm *dm)
+{
+	struct bt_conn_info info;
+	int err;
+
+	dm->cache_active = false;
+	dm->cache_hit = false;
+
+	err = bt_conn_get_info(dm->conn, &info);
+	if (err || !bt_addr_le_is_bonded(info.id, info.le.dst)) {
+		/* Only bonded peers are identified across connections. */
+		return bt_gatt_discover(dm->conn, &dm->discover_params);
+	}
+
+	dm->hash_read_params.func = db_hash_read_cb;
+	dm->hash_read_params.handle_count = 0;
+	dm->hash_read_params.by_uuid.start_handle = 0x0001;
+	dm->hash_read_params.by_uuid.end_handle = 0xffff;
+	dm->hash_read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+
+	err = bt_gatt_read(dm->conn, &dm->hash_read_params);
+	if (err) {
+		LOG_WRN("Cannot read Database Hash, error: %d", err);
+		return bt_gatt_discover(dm->conn, &dm->discover_params);
+	}
+
+	return 0;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
 		     const struct bt_gatt_dm_cb *cb,
@@ -619,7 +1167,12 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
+#if CONFIG_BT_GATT_DM_CACHE
+	k_work_init(&dm->cache_work, cache_work_handler);
+	err = db_hash_read(dm);
+#else
 	err = bt_gatt_discover(conn, &dm->discover_params);
+#endif /* CONFIG_BT_GATT_DM_CACHE */
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
 		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
@@ -660,6 +1213,15 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
+#if CONFIG_BT_GATT_DM_CACHE
+	if (dm->cache_active) {
+		/* The Database Hash is already known for this connection. */
+		dm->cache_hit = false;
+		k_work_submit(&dm->cache_work);
+		return 0;
+	}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 	err = bt_gatt_discover(dm->conn, &dm->discover_params);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
@@ -683,6 +1245,71 @@ int bt_gatt_dm_data_release(struct bt_gatt_dm *dm)
 	return 0;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+/* Names of the cache entries found for the peer */
+struct cache_clear_ctx {
+	char names[4][CACHE_KEY_LEN];
+	size_t cnt;
+};
+
+static int cache_clear_cb(const char *key, size_t len,
+			  settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	struct cache_clear_ctx *ctx = param;
+
+	/* Deleted entries are reported with zero length by some backends,
+	 * collecting them again would never finish the clearing.
+	 */
+	if (!key || !len || (ctx->cnt >= ARRAY_SIZE(ctx->names))) {
+		return 0;
+	}
+
+	strncpy(ctx->names[ctx->cnt], key, sizeof(ctx->names[0]) - 1);
+	ctx->names[ctx->cnt][sizeof(ctx->names[0]) - 1] = '\0';
+	ctx->cnt++;
+
+	return 0;
+}
+
+int bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+	char prefix[CACHE_KEY_LEN];
+	char key[2 * CACHE_KEY_LEN];
+	struct cache_clear_ctx ctx;
+	int err;
+
+	if (!addr) {
+		return -EINVAL;
+	}
+
+	snprintk(prefix, sizeof(prefix),
+		 CACHE_SETTINGS_KEY "/%02x%02x%02x%02x%02x%02x%u",
+		 addr->a.val[5], addr->a.val[4], addr->a.val[3],
+		 addr->a.val[2], addr->a.val[1], addr->a.val[0], addr->type);
+
+	/* Entries cannot be deleted while the subtree is being loaded. */
+	do {
+		ctx.cnt = 0;
+
+		err = settings_load_subtree_direct(prefix, cache_clear_cb, &ctx);
+		if (err) {
+			return err;
+		}
+
+		for (size_t i = 0; i < ctx.cnt; i++) {
+			snprintk(key, sizeof(key), "%s/%s", prefix,
+				 ctx.names[i]);
+			err = settings_delete(key);
+			if (err) {
+				return err;
+			}
+		}
+	} while (ctx.cnt == ARRAY_SIZE(ctx.names));
+
+	return 0;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 #if CONFIG_BT_GATT_DM_DATA_PRINT
 
 #define UUID_STR_LEN 37
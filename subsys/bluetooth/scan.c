@@ -7,6 +7,7 @@
 #include <zephyr.h>
 #include <sys/byteorder.h>
 #include <string.h>
+#include <stdlib.h>
 #include <bluetooth/scan.h>
 
 #include <logging/log.h>
@@ -230,6 +231,38 @@ struct conn_blocklist {
 };
 #endif /* CONFIG_BT_SCAN_BLOCKLIST */
 
+#if CONFIG_BT_SCAN_DEDUP
+/* Deduplication cache entry. */
+struct dedup_entry {
+	/* Advertiser address. */
+	bt_addr_le_t addr;
+
+	/* Advertising report type. */
+	uint8_t adv_type;
+
+	/* RSSI of the last delivered report. */
+	int8_t rssi;
+
+	/* Hash of the last delivered advertising payload. */
+	uint32_t ad_hash;
+
+	/* Uptime of the last delivered report. */
+	int64_t report_time;
+
+	/* Uptime of the last received report. Used for the LRU replacement. */
+	int64_t seen_time;
+};
+
+/* Advertising report deduplication cache. */
+struct dedup_cache {
+	/* Array of the tracked advertisers. */
+	struct dedup_entry entry[CONFIG_BT_SCAN_DEDUP_CACHE_LEN];
+
+	/* Count of the tracked advertisers. */
+	size_t count;
+};
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 /* Scanning module instance. Options for the different scanning modes.
  * This structure stores all module settings. It is used to enable
  * or disable scanning modes and to configure filters.
@@ -264,6 +297,11 @@ static struct bt_scan {
 	struct conn_blocklist blocklist;
 #endif /* CONFIG_BT_SCAN_BLOCKLIST */
 
+#if CONFIG_BT_SCAN_DEDUP
+	/* Advertising report deduplication cache. */
+	struct dedup_cache dedup;
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 } bt_scan;
 
 static sys_slist_t callback_list;
@@ -451,6 +489,85 @@ static bool conn_attempts_exceeded(const bt_addr_le_t *addr)
 
 #endif /* CONFIG_BT_SCAN_CONN_ATTEMPTS_FILTER */
 
+#if CONFIG_BT_SCAN_DEDUP
+static uint32_t ad_hash_get(const struct net_buf_simple *ad)
+{
+	/* 32-bit FNV-1a hash. */
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < ad->len; i++) {
+		hash ^= ad->data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static struct dedup_entry *dedup_entry_get(struct dedup_cache *cache,
+					   const bt_addr_le_t *addr,
+					   uint8_t adv_type)
+{
+	struct dedup_entry *lru = &cache->entry[0];
+
+	for (size_t i = 0; i < cache->count; i++) {
+		struct dedup_entry *entry = &cache->entry[i];
+
+		if ((entry->adv_type == adv_type) &&
+		    (bt_addr_le_cmp(&entry->addr, addr) == 0)) {
+			return entry;
+		}
+
+		if (entry->seen_time < lru->seen_time) {
+			lru = entry;
+		}
+	}
+
+	if (cache->count < ARRAY_SIZE(cache->entry)) {
+		lru = &cache->entry[cache->count];
+		cache->count++;
+	}
+
+	/* Replace the least recently seen device. */
+	bt_addr_le_copy(&lru->addr, addr);
+	lru->adv_type = adv_type;
+	lru->report_time = INT64_MIN;
+
+	return lru;
+}
+
+static bool dedup_report_check(const struct bt_le_scan_recv_info *info,
+			       const struct net_buf_simple *ad)
+{
+	struct dedup_entry *entry;
+	uint32_t hash = ad_hash_get(ad);
+	int64_t now = k_uptime_get();
+	bool deliver = true;
+
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+
+	entry = dedup_entry_get(&bt_scan.dedup, info->addr, info->adv_type);
+	entry->seen_time = now;
+
+	if ((entry->report_time != INT64_MIN) &&
+	    (entry->ad_hash == hash) &&
+	    ((now - entry->report_time) < CONFIG_BT_SCAN_DEDUP_WINDOW_MS)) {
+		deliver = (CONFIG_BT_SCAN_DEDUP_RSSI_DELTA > 0) &&
+			  (abs(info->rssi - entry->rssi) >=
+			   CONFIG_BT_SCAN_DEDUP_RSSI_DELTA);
+	}
+
+	if (deliver) {
+		entry->ad_hash = hash;
+		entry->rssi = info->rssi;
+		entry->report_time = now;
+	}
+
+	k_mutex_unlock(&scan_mutex);
+
+	return deliver;
+}
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 static bool scan_device_filter_check(const bt_addr_le_t *addr)
 {
 #if CONFIG_BT_SCAN_BLOCKLIST
@@ -1483,6 +1600,13 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	struct bt_scan_control scan_control;
 	struct net_buf_simple_state state;
 
+#if CONFIG_BT_SCAN_DEDUP
+	/* Drop the report if the same data was recently delivered. */
+	if (!dedup_report_check(info, ad)) {
+		return;
+	}
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 	memset(&scan_control, 0, sizeof(scan_control));
 
 	scan_control.all_mode = bt_scan.scan_filters.all_mode;
@@ -1533,6 +1657,11 @@ int bt_scan_start(enum bt_scan_type scan_type)
 		return -EINVAL;
 	}
 
+#if CONFIG_BT_SCAN_DEDUP
+	/* Deliver the first report of every device in a new scan session. */
+	bt_scan_dedup_cache_clear();
+#endif /* CONFIG_BT_SCAN_DEDUP */
+
 	/* Start the scanning. */
 	int err = bt_le_scan_start(&bt_scan.scan_param, NULL);
 
@@ -1617,3 +1746,12 @@ void bt_scan_conn_attempts_filter_clear(void)
 	k_mutex_unlock(&scan_mutex);
 }
 #endif /* CONFIG_BT_SCAN_CONN_ATTEMPTS_FILTER */
+
+#if CONFIG_BT_SCAN_DEDUP
+void bt_scan_dedup_cache_clear(void)
+{
+	k_mutex_lock(&scan_mutex, K_FOREVER);
+	memset(&bt_scan.dedup, 0, sizeof(bt_scan.dedup));
+	k_mutex_unlock(&scan_mutex);
+}
+#endif /* CONFIG_BT_SCAN_DEDUP */
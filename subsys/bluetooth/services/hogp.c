@@ -7,6 +7,7 @@
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
+#include <bluetooth/att.h>
 
 #include <bluetooth/services/hogp.h>
 
@@ -15,6 +16,11 @@
 
 LOG_MODULE_REGISTER(hogp, CONFIG_BT_HOGP_LOG_LEVEL);
 
+/* Sizes of the values read when the HIDS client is prepared */
+#define HID_INFO_LEN 4
+#define REPREF_LEN   2
+#define PM_LEN       1
+
 /* Real report structure definition */
 struct bt_hogp_rep_info {
 	/** HOGP object
@@ -274,196 +280,117 @@ static void hids_prep_error(struct bt_hogp *hogp, int err)
 }
 
 /**
- * @brief Process protocol mode read
+ * @brief Get the number of values read after the discovery
  *
- * This function processed protocol mode read that is started when
- * HID server is connected.
+ * The values are read in the following order: HID Information,
+ * Report Reference of every report and Protocol Mode (if present).
  *
- * @param conn   Connection handler.
- * @param err    Read ATT error code.
- * @param params Notification parameters structure - the pointer
- *               to the structure provided to read function.
- * @param data   Pointer to the data buffer.
- * @param length The size of the received data.
+ * @param hogp HOGP object.
  *
- * @retval BT_GATT_ITER_STOP     Stop notification
- * @retval BT_GATT_ITER_CONTINUE Continue notification
+ * @return The number of values.
  */
-static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
-			    struct bt_gatt_read_params *params,
-			    const void *data, uint16_t length);
+static size_t init_read_item_cnt(const struct bt_hogp *hogp)
+{
+	return 1 + hogp->rep_count + ((hogp->handlers.pm != 0) ? 1 : 0);
+}
 
 /**
- * @brief Start protocol mode read
+ * @brief Get the handle and the size of the value read after the discovery
  *
- * Function that starts protocol mode read at the HID connection.
- * @note
- * Read semaphore should be already taken in @ref repref_read_start.
- *
- * @param hogp  See @ref bt_hogp_handles_assign.
- *
- * @return 0 or negative error value.
+ * @param[in]  hogp   HOGP object.
+ * @param[in]  item   Value index, see @ref init_read_item_cnt.
+ * @param[out] handle Value handle.
+ * @param[out] len    Value size.
  */
-static int pm_read_start(struct bt_hogp *hogp)
+static void init_read_item_get(const struct bt_hogp *hogp, size_t item,
+			       uint16_t *handle, size_t *len)
 {
-	int err;
-
-	__ASSERT_NO_MSG(hogp);
-	if (hogp->handlers.pm == 0) {
-		LOG_DBG("Device ready without boot protocol");
-		hids_mark_ready(hogp);
-		return 0;
-	}
-	LOG_DBG("PM read start");
-	hogp->read_params.func = pm_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = hogp->handlers.pm;
-	hogp->read_params.single.offset = 0;
-	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
-	if (err) {
-		LOG_ERR("PM read error (err: %d)", err);
-		return err;
+	if (item == 0) {
+		*handle = hogp->handlers.info;
+		*len = HID_INFO_LEN;
+	} else if (item <= hogp->rep_count) {
+		*handle = hogp->rep_info[item - 1]->handlers.ref;
+		*len = REPREF_LEN;
+	} else {
+		*handle = hogp->handlers.pm;
+		*len = PM_LEN;
 	}
-	return 0;
 }
 
-static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
-			    struct bt_gatt_read_params *params,
-			    const void *data, uint16_t length)
+static int hid_info_decode(struct bt_hogp *hogp, const uint8_t *bdata,
+			   uint16_t length)
 {
-	struct bt_hogp *hogp;
-
-	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
-
-	if (err) {
-		LOG_ERR("PM read error");
-		hids_prep_error(hogp, err);
-		return BT_GATT_ITER_STOP;
-	}
-	if (length != 1 || !data) {
-		LOG_ERR("Unexpected PM size");
-		hids_prep_error(hogp, -ENOTSUP);
-		return BT_GATT_ITER_STOP;
+	if (length != HID_INFO_LEN) {
+		LOG_ERR("Unexpected HID information size: %u", length);
+		return -ENOTSUP;
 	}
 
-	hogp->pm = (enum bt_hids_pm)((uint8_t *)data)[0];
-	LOG_DBG("Read PM success: %d", (int)hogp->pm);
-	hids_mark_ready(hogp);
-	return BT_GATT_ITER_STOP;
-}
-
-/**
- * @brief Process report reference read
- *
- * Report reference read is started after connection to HID server.
- *
- * @param conn   Connection handler.
- * @param err    Read ATT error code.
- * @param params Notification parameters structure - the pointer
- *               to the structure provided to read function.
- * @param data   Pointer to the data buffer.
- * @param length The size of the received data.
- *
- * @retval BT_GATT_ITER_STOP     Stop notification
- * @retval BT_GATT_ITER_CONTINUE Continue notification
- */
-static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
-				struct bt_gatt_read_params *params,
-				const void *data, uint16_t length);
+	hogp->info_val.bcd_hid = sys_get_le16(&bdata[0]);
+	hogp->info_val.b_country_code = bdata[2];
+	hogp->info_val.flags = bdata[3];
 
-/**
- * @brief Start Report Reference read
- *
- * Internal function that initializes report reference value read.
- *
- * @param hogp  See @ref bt_hogp_handles_assign.
- * @param rep_idx Index in the report array
- *
- * @return 0 or negative error value.
- */
-static int repref_read_start(struct bt_hogp *hogp, size_t rep_idx)
-{
-	int err;
-	struct bt_hogp_rep_info *rep;
+	LOG_DBG("HID information success:");
+	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
+	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
+	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
 
-	__ASSERT_NO_MSG(hogp);
-	if (rep_idx >= hogp->rep_count) {
-		err = pm_read_start(hogp);
-		if (err) {
-			LOG_ERR("Cannot start boot protocol read (err: %d)",
-				err);
-		}
-		return err;
-	}
-	LOG_DBG("Report (id: %u) reference read start", rep_idx);
-	rep = hogp->rep_info[rep_idx];
-	hogp->init_repref.rep_idx = rep_idx;
-	hogp->read_params.func = repref_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = rep->handlers.ref;
-	hogp->read_params.single.offset = 0;
-	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
-	if (err) {
-		LOG_ERR("Report reference read error (err: %d)", err);
-		return err;
-	}
 	return 0;
 }
 
-static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
-				struct bt_gatt_read_params *params,
-				const void *data, uint16_t length)
+static int repref_decode(struct bt_hogp *hogp, size_t rep_idx,
+			 const uint8_t *bdata, uint16_t length)
 {
-	int ret;
-	struct bt_hogp *hogp;
 	struct bt_hogp_rep_info *rep;
-	size_t rep_idx;
-	const uint8_t *bdata = data;
-
-	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
-	rep_idx = hogp->init_repref.rep_idx;
 	__ASSERT_NO_MSG(rep_idx < hogp->rep_count);
 
-	if (err) {
-		LOG_ERR("Report (idx: %u) reference read error (err: %d)",
-			rep_idx, err);
-		hids_prep_error(hogp, err);
-		return BT_GATT_ITER_STOP;
-	}
-	if (length != 2 || !data) {
+	if (length != REPREF_LEN) {
 		LOG_ERR("Report (idx: %u) reference unexpected size (%u)",
 			rep_idx, length);
-		hids_prep_error(hogp, -ENOTSUP);
-		return BT_GATT_ITER_STOP;
+		return -ENOTSUP;
 	}
 
 	rep = hogp->rep_info[rep_idx];
 	if ((uint8_t)rep->ref.type != bdata[1]) {
 		LOG_ERR("Unexpected report type (%u while expecting %u)",
 			bdata[1], rep->ref.type);
-		hids_prep_error(hogp, -EINVAL);
-		return BT_GATT_ITER_STOP;
+		return -EINVAL;
 	}
 	rep->ref.id = bdata[0];
 	LOG_DBG("Report reference read (idx: %u, id: %u)",
 		rep_idx, rep->ref.id);
 
+	return 0;
+}
 
-	/* Next */
-	ret = repref_read_start(hogp, rep_idx + 1);
-	if (ret) {
-		hids_prep_error(hogp, ret);
-		return BT_GATT_ITER_STOP;
+static int pm_decode(struct bt_hogp *hogp, const uint8_t *bdata,
+		     uint16_t length)
+{
+	if (length != PM_LEN) {
+		LOG_ERR("Unexpected PM size");
+		return -ENOTSUP;
 	}
 
-	return BT_GATT_ITER_STOP;
+	hogp->pm = (enum bt_hids_pm)bdata[0];
+	LOG_DBG("Read PM success: %d", (int)hogp->pm);
+
+	return 0;
+}
+
+static int init_read_item_decode(struct bt_hogp *hogp, size_t item,
+				 const uint8_t *bdata, uint16_t length)
+{
+	if (item == 0) {
+		return hid_info_decode(hogp, bdata, length);
+	} else if (item <= hogp->rep_count) {
+		return repref_decode(hogp, item - 1, bdata, length);
+	} else {
+		return pm_decode(hogp, bdata, length);
+	}
 }
 
 /**
- * @brief HIDS information read
- *
- * HIDS information read is started after connection to HID server.
+ * @brief Process the read of the values required after the discovery
  *
  * @param conn   Connection handler.
  * @param err    Read ATT error code.
@@ -475,67 +402,164 @@ static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
  * @retval BT_GATT_ITER_STOP     Stop notification
  * @retval BT_GATT_ITER_CONTINUE Continue notification
  */
-static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
-				   struct bt_gatt_read_params *params,
-				   const void *data, uint16_t length);
+static uint8_t init_read_process(struct bt_conn *conn, uint8_t err,
+				 struct bt_gatt_read_params *params,
+				 const void *data, uint16_t length);
 
-static int hid_info_read_start(struct bt_hogp *hogp)
+/**
+ * @brief Start the read of the values required after the discovery
+ *
+ * Function reads as many values as fit into a single ATT response using
+ * the Read Multiple request. If the peer does not support it or
+ * @kconfig{CONFIG_BT_HOGP_READ_MULTIPLE} is disabled, values are read
+ * one by one.
+ * @note
+ * Read semaphore should be already taken in @ref post_discovery_start.
+ *
+ * @param hogp See @ref bt_hogp_handles_assign.
+ * @param item Index of the first value to read.
+ *
+ * @return 0 or negative error value.
+ */
+static int init_read_start(struct bt_hogp *hogp, size_t item)
 {
+	size_t item_cnt = init_read_item_cnt(hogp);
+	size_t max_len = bt_gatt_get_mtu(hogp->conn) - 1;
+	size_t max_cnt = hogp->init_read.single ?
+			 1 : ARRAY_SIZE(hogp->init_read.handles);
+	size_t total_len = 0;
+	size_t cnt = 0;
 	int err;
 
-	__ASSERT_NO_MSG(hogp);
-	if (hogp->handlers.info == 0) {
-		LOG_ERR("Device ready without HID information characteristic");
-		return -EINVAL;
+	if (item >= item_cnt) {
+		if (hogp->handlers.pm == 0) {
+			LOG_DBG("Device ready without boot protocol");
+		}
+		hids_mark_ready(hogp);
+		return 0;
 	}
-	LOG_DBG("HID information read start");
-	hogp->read_params.func = hid_info_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = hogp->handlers.info;
-	hogp->read_params.single.offset = 0;
+
+	do {
+		uint16_t handle;
+		size_t len;
+
+		init_read_item_get(hogp, item + cnt, &handle, &len);
+		if ((cnt > 0) && (total_len + len > max_len)) {
+			break;
+		}
+
+		hogp->init_read.handles[cnt++] = handle;
+		total_len += len;
+	} while ((item + cnt < item_cnt) && (cnt < max_cnt));
+
+	LOG_DBG("Read start (first: %u, count: %u)", item, cnt);
+	hogp->init_read.item = item;
+	hogp->init_read.cnt = cnt;
+	hogp->init_read.received = false;
+	hogp->read_params.func = init_read_process;
+	hogp->read_params.handle_count = cnt;
+	if (cnt == 1) {
+		hogp->read_params.single.handle = hogp->init_read.handles[0];
+		hogp->read_params.single.offset = 0;
+	} else {
+		hogp->read_params.multiple.handles = hogp->init_read.handles;
+		hogp->read_params.multiple.variable = false;
+	}
+
 	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
 	if (err) {
-		LOG_ERR("HID information read error (err: %d)", err);
+		LOG_ERR("Read error (err: %d)", err);
+		hogp->init_read.cnt = 0;
 		return err;
 	}
 	return 0;
 }
 
-static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
-				   struct bt_gatt_read_params *params,
-				   const void *data, uint16_t length)
+static uint8_t init_read_process(struct bt_conn *conn, uint8_t err,
+				 struct bt_gatt_read_params *params,
+				 const void *data, uint16_t length)
 {
 	struct bt_hogp *hogp;
 	const uint8_t *bdata = data;
+	size_t item;
+	int ret;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
+	if (!hogp->init_read.cnt) {
+		/* Read was already aborted. */
+		return BT_GATT_ITER_STOP;
+	}
+
 	if (err) {
-		LOG_ERR("HID information read error");
-		hids_prep_error(hogp, err);
+		if ((err == BT_ATT_ERR_NOT_SUPPORTED) &&
+		    (hogp->init_read.cnt > 1)) {
+			LOG_DBG("Read Multiple not supported by the peer");
+			hogp->init_read.single = true;
+			ret = init_read_start(hogp, hogp->init_read.item);
+		} else {
+			LOG_ERR("Read error (err: %u)", err);
+			ret = err;
+		}
+
+		if (ret) {
+			hogp->init_read.cnt = 0;
+			hids_prep_error(hogp, ret);
+		}
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 4 || !data) {
-		LOG_ERR("Unexpected HID information size: %u", length);
-		hids_prep_error(hogp, -ENOTSUP);
+
+	if (!data) {
+		if (!hogp->init_read.received) {
+			LOG_ERR("Unexpected empty value");
+			hogp->init_read.cnt = 0;
+			hids_prep_error(hogp, -ENOTSUP);
+			return BT_GATT_ITER_STOP;
+		}
+
+		/* Read procedure completed - continue with the next values. */
+		ret = init_read_start(hogp,
+				      hogp->init_read.item + hogp->init_read.cnt);
+		if (ret) {
+			hids_prep_error(hogp, ret);
+		}
 		return BT_GATT_ITER_STOP;
 	}
 
-	hogp->info_val.bcd_hid = sys_get_le16(&bdata[0]);
-	hogp->info_val.b_country_code = bdata[2];
-	hogp->info_val.flags = bdata[3];
+	item = hogp->init_read.item;
+	for (size_t i = 0; i < hogp->init_read.cnt; i++, item++) {
+		uint16_t handle;
+		size_t len;
 
-	LOG_DBG("HID information success:");
-	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
-	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
-	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
+		init_read_item_get(hogp, item, &handle, &len);
+		if (hogp->init_read.cnt == 1) {
+			/* Single read - let the decoder validate the size. */
+			len = length;
+		} else if (len > length) {
+			len = length;
+		}
 
-	err = repref_read_start(hogp, 0);
-	if (err) {
-		hids_prep_error(hogp, err);
+		ret = init_read_item_decode(hogp, item, bdata, len);
+		if (ret) {
+			hogp->init_read.cnt = 0;
+			hids_prep_error(hogp, ret);
+			return BT_GATT_ITER_STOP;
+		}
+
+		bdata += len;
+		length -= len;
 	}
 
-	return BT_GATT_ITER_STOP;
+	if (length) {
+		LOG_ERR("Unexpected data size");
+		hogp->init_read.cnt = 0;
+		hids_prep_error(hogp, -ENOTSUP);
+		return BT_GATT_ITER_STOP;
+	}
+
+	/* Wait for the read procedure to complete. */
+	hogp->init_read.received = true;
+	return BT_GATT_ITER_CONTINUE;
 }
 
 /**
@@ -554,12 +578,18 @@ static int post_discovery_start(struct bt_hogp *hogp)
 	int err;
 
 	__ASSERT_NO_MSG(hogp);
+	if (hogp->handlers.info == 0) {
+		LOG_ERR("Device ready without HID information characteristic");
+		return -EINVAL;
+	}
+
 	err = k_sem_take(&hogp->read_params_sem, K_NO_WAIT);
 	if (err) {
 		return err;
 	}
 
-	err = hid_info_read_start(hogp);
+	hogp->init_read.single = !IS_ENABLED(CONFIG_BT_HOGP_READ_MULTIPLE);
+	err = init_read_start(hogp, 0);
 	if (err) {
 		k_sem_give(&hogp->read_params_sem);
 		return err;
@@ -7,6 +7,7 @@
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
+#include <sys/ring_buffer.h>
 
 #include <bluetooth/services/nus.h>
 #include <logging/log.h>
@@ -15,6 +16,36 @@ LOG_MODULE_REGISTER(bt_nus, CONFIG_BT_NUS_LOG_LEVEL);
 
 static struct bt_nus_cb nus_cb;
 
+#if CONFIG_BT_NUS_STREAM
+RING_BUF_DECLARE(stream_buf, CONFIG_BT_NUS_STREAM_BUF_SIZE);
+
+/* Protects the stream buffer and the stream state. */
+static struct k_spinlock stream_lock;
+
+static struct {
+	/* Connection the stream is bound to. */
+	struct bt_conn *conn;
+	/* Number of the notifications queued in the stack. */
+	atomic_t in_flight;
+	/* Write was truncated, notify when space is available. */
+	bool space_wait;
+	/* Data is claimed from the buffer by the TX work. */
+	bool claimed;
+	/* Buffer is reset once the claimed data is released. */
+	bool reset_pending;
+} stream;
+
+/* Delay of the retry if the stack could not queue a notification and
+ * no notification completes to trigger it.
+ */
+#define STREAM_RETRY_DELAY K_MSEC(10)
+
+static void stream_tx_work_handler(struct k_work *work);
+
+/* Work used to pass the buffered data to the stack. */
+static K_WORK_DELAYABLE_DEFINE(stream_tx_work, stream_tx_work_handler);
+#endif /* CONFIG_BT_NUS_STREAM */
+
 static void nus_ccc_cfg_changed(const struct bt_gatt_attr *attr,
 				  uint16_t value)
 {
@@ -74,6 +105,8 @@ int bt_nus_init(struct bt_nus_cb *callbacks)
 		nus_cb.received = callbacks->received;
 		nus_cb.sent = callbacks->sent;
 		nus_cb.send_enabled = callbacks->send_enabled;
+		nus_cb.stream_space_available =
+			callbacks->stream_space_available;
 	}
 
 	return 0;
@@ -98,3 +131,270 @@ int bt_nus_send(struct bt_conn *conn, const uint8_t *data, uint16_t len)
 		return -EINVAL;
 	}
 }
+
+#if CONFIG_BT_NUS_STREAM
+/* Release a queued notification, unless the stream was rebound and the
+ * counter reset meanwhile. Called with the stream lock held.
+ */
+static bool stream_in_flight_release(struct bt_conn *conn)
+{
+	if ((conn != stream.conn) || (atomic_get(&stream.in_flight) == 0)) {
+		return false;
+	}
+
+	atomic_dec(&stream.in_flight);
+
+	return true;
+}
+
+static void stream_sent(struct bt_conn *conn, void *user_data)
+{
+	k_spinlock_key_t key;
+	bool released;
+
+	ARG_UNUSED(user_data);
+
+	key = k_spin_lock(&stream_lock);
+	released = stream_in_flight_release(conn);
+	k_spin_unlock(&stream_lock, key);
+
+	if (released) {
+		k_work_reschedule(&stream_tx_work, K_NO_WAIT);
+	}
+}
+
+static void stream_tx_work_handler(struct k_work *work)
+{
+	const struct bt_gatt_attr *attr = &nus_svc.attrs[2];
+	struct bt_gatt_notify_params params = {
+		.attr = attr,
+		.func = stream_sent,
+	};
+	struct bt_conn *conn;
+	bool space_notify = false;
+	bool retry = false;
+	k_spinlock_key_t key;
+	uint32_t mtu;
+	uint8_t *data;
+	uint32_t len;
+	int err;
+
+	key = k_spin_lock(&stream_lock);
+	conn = stream.conn ? bt_conn_ref(stream.conn) : NULL;
+	k_spin_unlock(&stream_lock, key);
+
+	if (!conn) {
+		return;
+	}
+
+	mtu = bt_nus_get_mtu(conn);
+
+	while (atomic_get(&stream.in_flight) <
+	       CONFIG_BT_NUS_STREAM_MAX_IN_FLIGHT) {
+		key = k_spin_lock(&stream_lock);
+
+		/* The stream was disabled or rebound meanwhile. */
+		if (stream.conn != conn) {
+			k_spin_unlock(&stream_lock, key);
+			break;
+		}
+
+		/* Batch the data: send a notification shorter than the MTU
+		 * only if nothing is queued in the stack.
+		 */
+		if ((ring_buf_size_get(&stream_buf) < mtu) &&
+		    (atomic_get(&stream.in_flight) > 0)) {
+			k_spin_unlock(&stream_lock, key);
+			break;
+		}
+
+		len = ring_buf_get_claim(&stream_buf, &data, mtu);
+		stream.claimed = (len > 0);
+		k_spin_unlock(&stream_lock, key);
+
+		if (!len) {
+			break;
+		}
+
+		params.data = data;
+		params.len = len;
+
+		/* The stack copies the data, so the buffer can be released
+		 * right after the notification is queued.
+		 */
+		atomic_inc(&stream.in_flight);
+		err = bt_gatt_notify_cb(conn, &params);
+
+		key = k_spin_lock(&stream_lock);
+		if (err) {
+			stream_in_flight_release(conn);
+			/* Keep the data, unless the peer is gone. Running out of
+			 * the TX buffers is expected under load.
+			 */
+			if (err == -ENOTCONN) {
+				LOG_WRN("Stream notification failed (err %d), "
+					"dropping %u bytes", err, len);
+			} else {
+				LOG_DBG("Stream notification failed (err %d), "
+					"retrying", err);
+				len = 0;
+				/* A completed notification triggers the retry. */
+				retry = (atomic_get(&stream.in_flight) == 0);
+			}
+		}
+		stream.claimed = false;
+		if (stream.reset_pending) {
+			stream.reset_pending = false;
+			ring_buf_reset(&stream_buf);
+		} else {
+			ring_buf_get_finish(&stream_buf, len);
+		}
+		if (stream.space_wait) {
+			stream.space_wait = false;
+			space_notify = true;
+		}
+		k_spin_unlock(&stream_lock, key);
+
+		if (err) {
+			break;
+		}
+	}
+
+	bt_conn_unref(conn);
+
+	if (retry) {
+		k_work_schedule(&stream_tx_work, STREAM_RETRY_DELAY);
+	}
+
+	if (space_notify && nus_cb.stream_space_available) {
+		nus_cb.stream_space_available();
+	}
+}
+
+/* Drop the buffered data. The TX work may still use the data it claimed,
+ * so the reset is deferred until it releases the claim. Called with the
+ * stream lock held.
+ */
+static void stream_buf_reset(void)
+{
+	if (stream.claimed) {
+		stream.reset_pending = true;
+	} else {
+		ring_buf_reset(&stream_buf);
+	}
+}
+
+int bt_nus_stream_enable(struct bt_conn *conn)
+{
+	k_spinlock_key_t key;
+
+	if (!conn) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&stream_lock);
+
+	if (stream.conn) {
+		k_spin_unlock(&stream_lock, key);
+		return -EALREADY;
+	}
+
+	stream.conn = bt_conn_ref(conn);
+	stream.space_wait = false;
+	/* Notifications queued for the previous connection may never
+	 * complete, their completions are ignored.
+	 */
+	atomic_set(&stream.in_flight, 0);
+	stream_buf_reset();
+
+	k_spin_unlock(&stream_lock, key);
+
+	return 0;
+}
+
+void bt_nus_stream_disable(void)
+{
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&stream_lock);
+	conn = stream.conn;
+	stream.conn = NULL;
+	atomic_set(&stream.in_flight, 0);
+	stream_buf_reset();
+	k_spin_unlock(&stream_lock, key);
+
+	if (conn) {
+		bt_conn_unref(conn);
+	}
+}
+
+int bt_nus_stream_write(const uint8_t *data, size_t len)
+{
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+	uint32_t written;
+	bool subscribed;
+
+	if (!data) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&stream_lock);
+	conn = stream.conn ? bt_conn_ref(stream.conn) : NULL;
+	k_spin_unlock(&stream_lock, key);
+
+	if (!conn) {
+		return -ENOTCONN;
+	}
+
+	/* The GATT database must not be accessed with the spinlock held. */
+	subscribed = bt_gatt_is_subscribed(conn, &nus_svc.attrs[2],
+					   BT_GATT_CCC_NOTIFY);
+	if (!subscribed) {
+		bt_conn_unref(conn);
+		return -EACCES;
+	}
+
+	key = k_spin_lock(&stream_lock);
+
+	if (stream.conn != conn) {
+		k_spin_unlock(&stream_lock, key);
+		bt_conn_unref(conn);
+		return -ENOTCONN;
+	}
+
+	/* Until the deferred reset is done, the buffer holds stale data;
+	 * report it as full, the TX work notifies when it is emptied.
+	 */
+	if (stream.reset_pending) {
+		written = 0;
+	} else {
+		written = ring_buf_put(&stream_buf, data, len);
+	}
+	if (written < len) {
+		stream.space_wait = true;
+	}
+
+	k_spin_unlock(&stream_lock, key);
+	bt_conn_unref(conn);
+
+	if (written) {
+		k_work_reschedule(&stream_tx_work, K_NO_WAIT);
+	}
+
+	return written;
+}
+
+size_t bt_nus_stream_space_get(void)
+{
+	k_spinlock_key_t key;
+	size_t space;
+
+	key = k_spin_lock(&stream_lock);
+	space = ring_buf_space_get(&stream_buf);
+	k_spin_unlock(&stream_lock, key);
+
+	return space;
+}
+#endif /* CONFIG_BT_NUS_STREAM */
@@ -39,7 +39,15 @@ enum state {
 	STATE_SUSPENDING
 };
 
+enum col_state {
+	COL_STATE_INPUT,
+	COL_STATE_OUTPUT_LOW,
+	COL_STATE_OUTPUT_HIGH,
+};
+
 static const struct device *gpio_devs[ARRAY_SIZE(port_map)];
+static uint32_t row_port_mask[ARRAY_SIZE(port_map)];
+static enum col_state col_states[MAX(ARRAY_SIZE(col), 1)];
 static struct gpio_callback gpio_cb[ARRAY_SIZE(port_map)];
 static struct k_work_delayable matrix_scan;
 static struct k_work_delayable button_pressed;
@@ -49,29 +57,48 @@ static enum state state;
 static void scan_fn(struct k_work *work);
 
 
+static int set_col(size_t idx, enum col_state new_state)
+{
+	static const gpio_flags_t col_flags[] = {
+		[COL_STATE_INPUT] = GPIO_INPUT,
+		[COL_STATE_OUTPUT_LOW] = GPIO_OUTPUT_LOW,
+		[COL_STATE_OUTPUT_HIGH] = GPIO_OUTPUT_HIGH,
+	};
+
+	/* Pin configuration is changed only if needed to reduce the number of
+	 * GPIO driver calls done during a single scan.
+	 */
+	if (col_states[idx] == new_state) {
+		return 0;
+	}
+
+	int err = gpio_pin_configure(gpio_devs[col[idx].port], col[idx].pin,
+				     col_flags[new_state]);
+
+	if (!err) {
+		col_states[idx] = new_state;
+	}
+
+	return err;
+}
+
 static int set_cols(uint32_t mask)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(col); i++) {
-		uint32_t val = (mask & BIT(i)) ? (1) : (0);
-		int err;
+		bool val = (mask & BIT(i));
+		enum col_state new_state;
 
 		if (val || !mask) {
 			if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
 				val = !val;
 			}
 
-			err = gpio_pin_configure(gpio_devs[col[i].port],
-						 col[i].pin, GPIO_OUTPUT);
-			if (!err) {
-				err = gpio_pin_set_raw(gpio_devs[col[i].port],
-						       col[i].pin, val);
-			}
+			new_state = (val) ? (COL_STATE_OUTPUT_HIGH) : (COL_STATE_OUTPUT_LOW);
 		} else {
-			err = gpio_pin_configure(gpio_devs[col[i].port],
-						 col[i].pin, GPIO_INPUT);
+			new_state = COL_STATE_INPUT;
 		}
 
-		if (err) {
+		if (set_col(i, new_state)) {
 			LOG_ERR("Cannot set pin");
 			return -EFAULT;
 		}
@@ -82,19 +109,30 @@ static int set_cols(uint32_t mask)
 
 static int get_rows(uint32_t *mask)
 {
-	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
-		int val = gpio_pin_get_raw(gpio_devs[row[i].port], row[i].pin);
+	gpio_port_value_t port_val[ARRAY_SIZE(port_map)] = {0};
 
-		if (val < 0) {
-			LOG_ERR("Cannot get pin");
+	/* Read each used port once instead of reading pins one by one. */
+	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
+		if (!row_port_mask[i]) {
+			continue;
+		}
+
+		int err = gpio_port_get_raw(gpio_devs[i], &port_val[i]);
+
+		if (err) {
+			LOG_ERR("Cannot get port");
 			return -EFAULT;
 		}
 
 		if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
-			val = !val;
+			port_val[i] = ~port_val[i];
 		}
+	}
 
-		*mask |= (val << i);
+	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
+		if (port_val[row[i].port] & BIT(row[i].pin)) {
+			*mask |= BIT(i);
+		}
 	}
 
 	return 0;
@@ -273,29 +311,30 @@ static void scan_fn(struct k_work *work)
 		}
 	}
 
-	/* Emit event for any key state change */
+	/* Emit event for any key state change. The whole matrix is scanned on every
+	 * call, only the event generation is limited to the keys that changed state.
+	 */
 	bool any_pressed = false;
 	size_t evt_limit = 0;
 
 	for (size_t i = 0; i < COLUMNS; i++) {
-		for (size_t j = 0; j < ARRAY_SIZE(row); j++) {
-			bool is_raw_pressed = raw_state[i] & BIT(j);
-			bool is_pressed = cur_state[i] & BIT(j);
-			bool was_pressed = settled_state[i] & BIT(j);
+		/* Keys that changed state and are not masked by ghosting. */
+		uint32_t change_mask = (cur_state[i] ^ settled_state[i]) &
+				       ~(cur_state[i] ^ raw_state[i]);
 
-			if ((is_pressed != was_pressed) &&
-			    (is_pressed == is_raw_pressed) &&
-			    (evt_limit < CONFIG_CAF_BUTTONS_EVENT_LIMIT)) {
-				struct button_event *event = new_button_event();
+		while (change_mask && (evt_limit < CONFIG_CAF_BUTTONS_EVENT_LIMIT)) {
+			size_t j = find_lsb_set(change_mask) - 1;
+			bool is_pressed = cur_state[i] & BIT(j);
+			struct button_event *event = new_button_event();
 
-				event->key_id = KEY_ID(i, j);
-				event->pressed = is_pressed;
-				EVENT_SUBMIT(event);
+			event->key_id = KEY_ID(i, j);
+			event->pressed = is_pressed;
+			EVENT_SUBMIT(event);
 
-				evt_limit++;
+			evt_limit++;
 
-				WRITE_BIT(settled_state[i], j, is_pressed);
-			}
+			WRITE_BIT(settled_state[i], j, is_pressed);
+			change_mask &= change_mask - 1;
 		}
 
 		any_pressed = any_pressed ||
@@ -457,7 +496,6 @@ static void init_fn(void)
 		goto error;
 	}
 
-	uint32_t pin_mask[ARRAY_SIZE(port_map)] = {0};
 	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
 		/* Module starts in scanning mode and will switch to
 		 * callback mode if no button is pressed.
@@ -470,7 +508,7 @@ static void init_fn(void)
 			goto error;
 		}
 
-		pin_mask[row[i].port] |= BIT(row[i].pin);
+		row_port_mask[row[i].port] |= BIT(row[i].pin);
 	}
 
 	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
@@ -478,7 +516,7 @@ static void init_fn(void)
 			/* Skip non-existing ports */
 			continue;
 		}
-		gpio_init_callback(&gpio_cb[i], button_pressed_isr, pin_mask[i]);
+		gpio_init_callback(&gpio_cb[i], button_pressed_isr, row_port_mask[i]);
 		err = gpio_add_callback(gpio_devs[i], &gpio_cb[i]);
 		if (err) {
 			LOG_ERR("Cannot add callback");
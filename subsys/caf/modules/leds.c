@@ -28,7 +28,11 @@ struct led {
 	uint16_t effect_step;
 	uint16_t effect_substep;
 
-	struct k_work_delayable work;
+	int64_t next_update;
+	bool active;
+
+	struct led_color hw_color;
+	bool hw_color_valid;
 };
 
 #ifdef CONFIG_CAF_LEDS_PWM
@@ -59,6 +63,9 @@ static struct led leds[] = {
 	DT_INST_FOREACH_STATUS_OKAY(_LED_INSTANCE_DEF)
 };
 
+/* A single work updates all of the LEDs that reached their update time. */
+static struct k_work_delayable leds_work;
+
 
 static int set_color_one_channel(struct led *led, struct led_color *color)
 {
@@ -78,6 +85,11 @@ static int set_color_all_channels(struct led *led, struct led_color *color)
 	int err = 0;
 
 	for (size_t i = 0; (i < ARRAY_SIZE(color->c)) && !err; i++) {
+		/* Only the channels that changed are written to the driver. */
+		if (led->hw_color_valid && (led->hw_color.c[i] == color->c[i])) {
+			continue;
+		}
+
 		err = led_set_brightness(led->dev, i, color->c[i]);
 	}
 
@@ -88,6 +100,10 @@ static void set_color(struct led *led, struct led_color *color)
 {
 	int err;
 
+	if (led->hw_color_valid && !memcmp(&led->hw_color, color, sizeof(led->hw_color))) {
+		return;
+	}
+
 	if (led->color_count == ARRAY_SIZE(color->c)) {
 		err = set_color_all_channels(led, color);
 	} else {
@@ -96,6 +112,10 @@ static void set_color(struct led *led, struct led_color *color)
 
 	if (err) {
 		LOG_ERR("Cannot set LED brightness (err: %d)", err);
+		led->hw_color_valid = false;
+	} else {
+		led->hw_color = *color;
+		led->hw_color_valid = true;
 	}
 }
 
@@ -106,10 +126,8 @@ static void set_off(struct led *led)
 	set_color(led, &nocolor);
 }
 
-static void work_handler(struct k_work *work)
+static void led_substep(struct led *led, int64_t now)
 {
-	struct led *led = CONTAINER_OF(work, struct led, work);
-
 	const struct led_effect_step *effect_step =
 		&led->effect->steps[led->effect_step];
 
@@ -143,35 +161,66 @@ static void work_handler(struct k_work *work)
 	}
 
 	if (led->effect_step < led->effect->step_count) {
-		int32_t next_delay =
+		led->next_update = now +
 			led->effect->steps[led->effect_step].substep_time;
+	} else {
+		led->active = false;
+	}
+}
+
+static void leds_schedule(int64_t now)
+{
+	int64_t next_update = INT64_MAX;
+
+	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
+		if (leds[i].active) {
+			next_update = MIN(next_update, leds[i].next_update);
+		}
+	}
 
-		k_work_reschedule(&led->work, K_MSEC(next_delay));
+	if (next_update == INT64_MAX) {
+		k_work_cancel_delayable(&leds_work);
+	} else {
+		k_work_reschedule(&leds_work, K_MSEC(MAX(next_update - now, 0)));
 	}
 }
 
+static void work_handler(struct k_work *work)
+{
+	int64_t now = k_uptime_get();
+
+	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
+		struct led *led = &leds[i];
+
+		if (led->active && (led->next_update <= now)) {
+			led_substep(led, now);
+		}
+	}
+
+	leds_schedule(now);
+}
+
 static void led_update(struct led *led)
 {
-	k_work_cancel_delayable(&led->work);
+	int64_t now = k_uptime_get();
 
+	led->active = false;
 	led->effect_step = 0;
 	led->effect_substep = 0;
 
 	if (!led->effect) {
 		LOG_DBG("No effect set");
-		return;
-	}
-
-	__ASSERT_NO_MSG(led->effect->steps);
+	} else if (led->effect->step_count > 0) {
+		__ASSERT_NO_MSG(led->effect->steps);
 
-	if (led->effect->step_count > 0) {
-		int32_t next_delay =
+		led->next_update = now +
 			led->effect->steps[led->effect_step].substep_time;
-
-		k_work_reschedule(&led->work, K_MSEC(next_delay));
+		led->active = true;
 	} else {
 		LOG_WRN("LED effect with no effect");
 	}
+
+	leds_schedule(now);
 }
 
 static int leds_init(void)
@@ -180,6 +229,8 @@ static int leds_init(void)
 
 	BUILD_ASSERT(DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT) > 0, "No LEDs defined");
 
+	k_work_init_delayable(&leds_work, work_handler);
+
 	for (size_t i = 0; (i < ARRAY_SIZE(leds)) && !err; i++) {
 		struct led *led = &leds[i];
 
@@ -189,7 +240,6 @@ static int leds_init(void)
 			LOG_ERR("Device %s is not ready", led->dev->name);
 			err = -ENODEV;
 		} else {
-			k_work_init_delayable(&led->work, work_handler);
 			led_update(led);
 		}
 	}
@@ -216,8 +266,10 @@ static void leds_start(void)
 
 static void leds_stop(void)
 {
+	k_work_cancel_delayable(&leds_work);
+
 	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
-		k_work_cancel_delayable(&leds[i].work);
+		leds[i].active = false;
 
 		set_off(&leds[i]);
 
@@ -23,25 +23,46 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_CAF_SENSOR_MANAGER_LOG_LEVEL);
 
 #define SAMPLE_THREAD_STACK_SIZE	CONFIG_CAF_SENSOR_MANAGER_THREAD_STACK_SIZE
 #define SAMPLE_THREAD_PRIORITY		CONFIG_CAF_SENSOR_MANAGER_THREAD_PRIORITY
+#define SAMPLE_THREAD_COUNT		CONFIG_CAF_SENSOR_MANAGER_THREAD_COUNT
 
 /* PM_DEVICE_STATE_ACTIVE should equal zero. */
 BUILD_ASSERT(PM_DEVICE_STATE_ACTIVE == 0, "PM_DEVICE_STATE_ACTIVE is expected equal 0");
 
+struct sensor_stats {
+	uint32_t sample_cnt;
+	uint32_t drop_cnt;
+	uint64_t delay_sum;
+	uint32_t delay_min;
+	uint32_t delay_max;
+};
+
 struct sensor_data {
 	const struct device *dev;
 	int sampling_period;
 	int64_t sample_timeout;
 	float *prev;
+	float *batch;
+	uint8_t batch_cnt;
 	atomic_t state;
 	unsigned int sleep_cntd;
 	atomic_t event_cnt;
+#if CONFIG_CAF_SENSOR_MANAGER_STATS
+	struct sensor_stats stats;
+#endif
+};
+
+struct sample_thread {
+	struct k_thread thread;
+	struct k_sem can_sample;
+	int64_t stats_print_time;
 };
 
 static struct sensor_data sensor_data[ARRAY_SIZE(sensor_configs)];
 
-static K_THREAD_STACK_DEFINE(sample_thread_stack, SAMPLE_THREAD_STACK_SIZE);
-static struct k_thread sample_thread;
-static struct k_sem can_sample;
+static K_THREAD_STACK_ARRAY_DEFINE(sample_thread_stacks, SAMPLE_THREAD_COUNT,
+				   SAMPLE_THREAD_STACK_SIZE);
+static struct sample_thread sample_threads[SAMPLE_THREAD_COUNT];
+static atomic_t running_threads;
 
 
 static void update_sensor_state(const struct sm_sensor_config *sc, struct sensor_data *sd,
@@ -57,12 +78,13 @@ static void update_sensor_state(const struct sm_sensor_config *sc, struct sensor
 }
 
 static void send_sensor_event(const char *descr, const float *data, const size_t data_cnt,
-			      atomic_t *event_cnt)
+			      uint8_t sample_cnt, atomic_t *event_cnt)
 {
 	struct sensor_event *event = new_sensor_event(sizeof(float) * data_cnt);
 	float *data_ptr = sensor_event_get_data_ptr(event);
 
 	event->descr = descr;
+	event->sample_cnt = sample_cnt;
 
 	__ASSERT_NO_MSG(sensor_event_get_data_cnt(event) == data_cnt);
 	memcpy(data_ptr, data, sizeof(float) * data_cnt);
@@ -114,6 +136,29 @@ static size_t get_sensor_data_cnt(const struct sm_sensor_config *sc)
 	return data_cnt;
 }
 
+static bool is_batch_used(const struct sm_sensor_config *sc)
+{
+	return sc->event_sample_cnt > 1;
+}
+
+static void batch_flush(const struct sm_sensor_config *sc, struct sensor_data *sd)
+{
+	if (sd->batch_cnt == 0) {
+		return;
+	}
+
+	if (atomic_get(&sd->event_cnt) < sc->active_events_limit) {
+		send_sensor_event(sc->event_descr, sd->batch,
+				  sd->batch_cnt * get_sensor_data_cnt(sc),
+				  sd->batch_cnt, &sd->event_cnt);
+	} else {
+		LOG_WRN("Did not send event due to too many active events on sensor: %s",
+			sc->dev_name);
+	}
+
+	sd->batch_cnt = 0;
+}
+
 static void reset_sensor_sleep_cnt(const struct sm_sensor_config *sc,
 				   struct sensor_data *sd)
 {
@@ -205,7 +250,7 @@ static void trigger_handler(const struct device *dev, const struct sensor_trigge
 		EVENT_SUBMIT(new_wake_up_event());
 	}
 
-	k_sem_give(&can_sample);
+	k_sem_give(&sample_threads[sc->thread_id].can_sample);
 }
 
 static void enter_sleep(const struct sm_sensor_config *sc,
@@ -228,7 +273,14 @@ static void sample_sensor(struct sensor_data *sd, const struct sm_sensor_config
 	size_t data_idx = 0;
 	size_t data_cnt = get_sensor_data_cnt(sc);
 	struct sensor_value data[data_cnt];
-	float curr[data_cnt];
+	float single[is_batch_used(sc) ? 1 : data_cnt];
+	float *curr = single;
+
+	if (is_batch_used(sc)) {
+		/* Store converted values directly in the batch buffer. */
+		__ASSERT_NO_MSG(sd->batch_cnt < sc->event_sample_cnt);
+		curr = &sd->batch[sd->batch_cnt * data_cnt];
+	}
 
 	int err = sensor_sample_fetch(sd->dev);
 
@@ -239,57 +291,155 @@ static void sample_sensor(struct sensor_data *sd, const struct sm_sensor_config
 		data_idx += sampled_chan->data_cnt;
 	}
 
-	for (size_t i = 0; i < ARRAY_SIZE(curr); i++) {
-		curr[i] = sensor_value_to_double(&data[i]);
-	}
-
 	if (err) {
 		LOG_ERR("Sensor sampling error (err %d)", err);
+		/* Submit samples collected before the error. */
+		batch_flush(sc, sd);
 		update_sensor_state(sc, sd, SENSOR_STATE_ERROR);
+		return;
+	}
+
+	for (size_t i = 0; i < data_cnt; i++) {
+		curr[i] = sensor_value_to_double(&data[i]);
+	}
+
+	if (is_batch_used(sc)) {
+		sd->batch_cnt++;
+		if (sd->batch_cnt == sc->event_sample_cnt) {
+			batch_flush(sc, sd);
+		}
+	} else if (atomic_get(&sd->event_cnt) < sc->active_events_limit) {
+		send_sensor_event(sc->event_descr, curr, data_cnt, 1, &sd->event_cnt);
 	} else {
-		if (atomic_get(&sd->event_cnt) < sc->active_events_limit) {
-			send_sensor_event(sc->event_descr, curr, ARRAY_SIZE(curr),
-					  &sd->event_cnt);
-		} else {
-			LOG_WRN("Did not send event due to too many active events on sensor: %s",
-				sc->dev_name);
+		LOG_WRN("Did not send event due to too many active events on sensor: %s",
+			sc->dev_name);
+	}
+
+	if (sc->trigger) {
+		process_sensor_activity(sc, sd, curr);
+		if (!is_sensor_active(sd)) {
+			/* Do not keep collected samples until the sensor wakes up. */
+			batch_flush(sc, sd);
+			enter_sleep(sc, sd);
 		}
 
-		if (sc->trigger) {
-			process_sensor_activity(sc, sd, curr);
-			if (!is_sensor_active(sd)) {
-				enter_sleep(sc, sd);
-			}
+	}
+}
+
+static void stats_sample_update(struct sensor_data *sd, uint32_t delay, int drops)
+{
+#if CONFIG_CAF_SENSOR_MANAGER_STATS
+	struct sensor_stats *stats = &sd->stats;
+
+	if (stats->sample_cnt == 0) {
+		stats->delay_min = delay;
+		stats->delay_max = delay;
+	} else {
+		stats->delay_min = MIN(stats->delay_min, delay);
+		stats->delay_max = MAX(stats->delay_max, delay);
+	}
+
+	stats->sample_cnt++;
+	stats->delay_sum += delay;
+	stats->drop_cnt += drops;
+#endif
+}
+
+static void stats_print(uint8_t thread_id, int64_t cur_uptime)
+{
+#if CONFIG_CAF_SENSOR_MANAGER_STATS
+	struct sample_thread *st = &sample_threads[thread_id];
+
+	if (cur_uptime < st->stats_print_time) {
+		return;
+	}
+
+	st->stats_print_time = cur_uptime + CONFIG_CAF_SENSOR_MANAGER_STATS_INTERVAL_MS;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_data); i++) {
+		struct sensor_stats *stats = &sensor_data[i].stats;
+		const struct sm_sensor_config *sc = &sensor_configs[i];
 
+		if ((sc->thread_id != thread_id) || (stats->sample_cnt == 0)) {
+			continue;
 		}
+
+		/* Delay is measured from the sample deadline to the start of sampling.
+		 * Jitter is the difference between the longest and the shortest delay.
+		 */
+		LOG_INF("%s: samples: %" PRIu32 ", dropped: %" PRIu32 ", delay avg: %" PRIu32
+			" us, max: %" PRIu32 " us, jitter: %" PRIu32 " us",
+			sc->dev_name, stats->sample_cnt, stats->drop_cnt,
+			(uint32_t)(stats->delay_sum / stats->sample_cnt), stats->delay_max,
+			stats->delay_max - stats->delay_min);
+
+		memset(stats, 0, sizeof(*stats));
 	}
+#endif
+}
+
+static struct sensor_data *get_next_sensor(uint8_t thread_id, int64_t cur_uptime)
+{
+	struct sensor_data *next_sd = NULL;
+
+	/* Earliest deadline first: pick the sensor with the oldest sample timeout. */
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_data); i++) {
+		struct sensor_data *sd = &sensor_data[i];
+
+		if ((sensor_configs[i].thread_id != thread_id) ||
+		    (atomic_get(&sd->state) != SENSOR_STATE_ACTIVE) ||
+		    (sd->sample_timeout > cur_uptime)) {
+			continue;
+		}
+
+		if (!next_sd || (sd->sample_timeout < next_sd->sample_timeout)) {
+			next_sd = sd;
+		}
+	}
+
+	return next_sd;
 }
 
-static size_t sample_sensors(int64_t *next_timeout)
+static size_t sample_sensors(uint8_t thread_id, int64_t *next_timeout)
 {
 	size_t alive_sensors = 0;
-	int64_t cur_uptime = k_uptime_get();
+	struct sensor_data *sd;
+
+	while ((sd = get_next_sensor(thread_id, k_uptime_get())) != NULL) {
+		const struct sm_sensor_config *sc = &sensor_configs[sd - sensor_data];
+		int64_t cur_ticks = k_uptime_ticks();
+		int64_t cur_uptime = k_ticks_to_ms_floor64(cur_ticks);
+		uint32_t delay = k_ticks_to_us_floor64(cur_ticks) -
+				 (sd->sample_timeout * USEC_PER_MSEC);
+
+		sample_sensor(sd, sc);
+
+		int drops = -1;
+		while (sd->sample_timeout <= cur_uptime) {
+			sd->sample_timeout += sd->sampling_period;
+			drops++;
+		}
+
+		if (drops > 0) {
+			LOG_WRN("%d sample dropped", drops);
+		}
+
+		stats_sample_update(sd, delay, MAX(drops, 0));
+	}
 
 	*next_timeout = INT64_MAX;
 
 	for (size_t i = 0; i < ARRAY_SIZE(sensor_data); i++) {
-		struct sensor_data *sd = &sensor_data[i];
+		sd = &sensor_data[i];
 		const struct sm_sensor_config *sc = &sensor_configs[i];
 
-		if (atomic_get(&sd->state) == SENSOR_STATE_ACTIVE) {
-			if (sd->sample_timeout <= cur_uptime) {
-				sample_sensor(sd, sc);
-			}
-
-			int drops = -1;
-			while (sd->sample_timeout <= cur_uptime) {
-				sd->sample_timeout += sd->sampling_period;
-				drops++;
-			}
+		if (sc->thread_id != thread_id) {
+			continue;
+		}
 
-			if (drops > 0) {
-				LOG_WRN("%d sample dropped", drops);
-			}
+		if (atomic_get(&sd->state) != SENSOR_STATE_ACTIVE) {
+			/* Sampling stopped, submit incomplete batch. */
+			batch_flush(sc, sd);
 		}
 
 		if (atomic_get(&sd->state) != SENSOR_STATE_ERROR) {
@@ -302,6 +452,8 @@ static size_t sample_sensors(int64_t *next_timeout)
 		}
 	}
 
+	stats_print(thread_id, k_uptime_get());
+
 	return alive_sensors;
 }
 
@@ -344,6 +496,9 @@ static void configure_max_power_state(void)
 		bool active = false;
 		bool trigger_present = false;
 
+		/* Function can be called from multiple sampling threads. */
+		k_sched_lock();
+
 		/* Travel through all the sensors and check their state
 		 * and configuration.
 		 * Depending on the "most active" sensor the overall allowed
@@ -382,6 +537,8 @@ static void configure_max_power_state(void)
 			power_manager_restrict(MODULE_IDX(MODULE), power_state);
 			last_power_state = power_state;
 		}
+
+		k_sched_unlock();
 	}
 }
 
@@ -394,6 +551,14 @@ static size_t sensor_init(void)
 		struct sensor_data *sd = &sensor_data[i];
 		const struct sm_sensor_config *sc = &sensor_configs[i];
 
+		if (sc->thread_id >= SAMPLE_THREAD_COUNT) {
+			update_sensor_state(sc, sd, SENSOR_STATE_ERROR);
+			LOG_ERR("%s sensor uses invalid thread (%" PRIu8 ")", sc->dev_name,
+				sc->thread_id);
+			__ASSERT_NO_MSG(false);
+			continue;
+		}
+
 		sd->dev = device_get_binding(sc->dev_name);
 		if (!sd->dev) {
 			update_sensor_state(sc, sd, SENSOR_STATE_ERROR);
@@ -403,6 +568,17 @@ static size_t sensor_init(void)
 		sd->sampling_period = sc->sampling_period_ms;
 		sd->sample_timeout = cur_uptime + sc->sampling_period_ms;
 
+		if (is_batch_used(sc)) {
+			size_t batch_size = sc->event_sample_cnt * get_sensor_data_cnt(sc);
+
+			sd->batch = k_malloc(batch_size * sizeof(float));
+			if (!sd->batch) {
+				update_sensor_state(sc, sd, SENSOR_STATE_ERROR);
+				LOG_ERR("%s sensor cannot allocate sample batch", sc->dev_name);
+				continue;
+			}
+		}
+
 		if (sc->trigger) {
 			int err = sensor_trigger_init(sc, sd);
 
@@ -420,35 +596,110 @@ static size_t sensor_init(void)
 	return alive_sensors;
 }
 
-static void sample_thread_fn(void)
+static size_t get_thread_sensor_cnt(uint8_t thread_id)
 {
-	size_t alive_sensors = 0;
-	int64_t next_timeout = 0;
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_data); i++) {
+		if ((sensor_configs[i].thread_id == thread_id) &&
+		    (atomic_get(&sensor_data[i].state) != SENSOR_STATE_ERROR)) {
+			cnt++;
+		}
+	}
 
-	k_sem_init(&can_sample, 0, 1);
+	return cnt;
+}
 
-	alive_sensors = sensor_init();
+static void sample_thread_fn(void *arg0, void *arg1, void *arg2);
 
-	if (alive_sensors) {
-		module_set_state(MODULE_STATE_READY);
+static void sample_thread_start(uint8_t thread_id)
+{
+	struct sample_thread *st = &sample_threads[thread_id];
+	char name[sizeof("caf_sensor_manager_") + 1];
+
+	/* Threads with higher index run with lower priority. Use them for sensors
+	 * that are slow to sample.
+	 */
+	k_thread_create(&st->thread, sample_thread_stacks[thread_id], SAMPLE_THREAD_STACK_SIZE,
+			sample_thread_fn, (void *)(uintptr_t)thread_id, NULL, NULL,
+			SAMPLE_THREAD_PRIORITY + thread_id, 0, K_NO_WAIT);
+	snprintk(name, sizeof(name), "caf_sensor_manager_%" PRIu8, thread_id);
+	k_thread_name_set(&st->thread, name);
+}
 
-		while (alive_sensors > 0) {
-			k_sem_take(&can_sample, K_TIMEOUT_ABS_MS(next_timeout));
+static bool sensors_start(void)
+{
+	/* Called from the first sampling thread, so that slow sensor drivers do not
+	 * block the event manager during initialization.
+	 */
+	if (!sensor_init()) {
+		return false;
+	}
 
-			alive_sensors = sample_sensors(&next_timeout);
-			configure_max_power_state();
+	/* The first thread is counted even without sensors. It leaves the sampling
+	 * loop after the first pass in that case.
+	 */
+	bool used[SAMPLE_THREAD_COUNT] = {true};
+
+	for (uint8_t i = 1; i < SAMPLE_THREAD_COUNT; i++) {
+		used[i] = (get_thread_sensor_cnt(i) > 0);
+	}
+
+	/* All threads must be counted before any of them can stop. */
+	for (uint8_t i = 0; i < SAMPLE_THREAD_COUNT; i++) {
+		if (used[i]) {
+			atomic_inc(&running_threads);
+		}
+	}
+
+	for (uint8_t i = 1; i < SAMPLE_THREAD_COUNT; i++) {
+		if (used[i]) {
+			sample_thread_start(i);
 		}
 	}
 
-	module_set_state(MODULE_STATE_ERROR);
+	module_set_state(MODULE_STATE_READY);
+
+	return true;
+}
+
+static void sample_thread_fn(void *arg0, void *arg1, void *arg2)
+{
+	uint8_t thread_id = (uintptr_t)arg0;
+	struct sample_thread *st = &sample_threads[thread_id];
+	size_t alive_sensors = 0;
+	int64_t next_timeout = 0;
+
+	ARG_UNUSED(arg1);
+	ARG_UNUSED(arg2);
+
+	if ((thread_id == 0) && !sensors_start()) {
+		module_set_state(MODULE_STATE_ERROR);
+		return;
+	}
+
+	do {
+		k_sem_take(&st->can_sample, K_TIMEOUT_ABS_MS(next_timeout));
+
+		alive_sensors = sample_sensors(thread_id, &next_timeout);
+		configure_max_power_state();
+	} while (alive_sensors > 0);
+
+	if (atomic_dec(&running_threads) == 1) {
+		/* No sensor can be sampled anymore. */
+		module_set_state(MODULE_STATE_ERROR);
+	}
 }
 
 static void init(void)
 {
-	k_thread_create(&sample_thread, sample_thread_stack, SAMPLE_THREAD_STACK_SIZE,
-			(k_thread_entry_t)sample_thread_fn, NULL, NULL, NULL,
-			SAMPLE_THREAD_PRIORITY, 0, K_NO_WAIT);
-	k_thread_name_set(&sample_thread, "caf_sensor_manager");
+	/* Semaphores are given on wake up also if no sensor could be initialized. */
+	for (size_t i = 0; i < ARRAY_SIZE(sample_threads); i++) {
+		k_sem_init(&sample_threads[i].can_sample, 0, 1);
+	}
+
+	/* Sensors are initialized by the first thread. It starts the other threads. */
+	sample_thread_start(0);
 }
 
 static bool handle_power_down_event(const struct event_header *eh)
@@ -513,7 +764,11 @@ static bool handle_wake_up_event(const struct event_header *eh)
 		}
 		k_sched_unlock();
 	}
-	k_sem_give(&can_sample);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sample_threads); i++) {
+		k_sem_give(&sample_threads[i].can_sample);
+	}
+
 	return false;
 }
 
@@ -8,6 +8,7 @@
 #include <net/mqtt.h>
 #include <net/socket.h>
 #include <net/cloud.h>
+#include <net/mqtt_topic_router.h>
 #include <stdio.h>
 
 #if defined(CONFIG_AWS_FOTA)
@@ -109,6 +110,18 @@ static struct cloud_backend *aws_iot_backend;
 #define AWS_IOT_SHADOW_REQUEST_STRING ""
 
 static struct aws_iot_app_topic_data app_topic_data;
+static enum aws_iot_topic_type
+	app_topic_types[CONFIG_AWS_IOT_APP_SUBSCRIPTION_LIST_COUNT];
+
+/* Routes incoming topics to their topic type. Shadow topics are routed to
+ * their type, application topics to APP_TOPIC_ROUTE_FIRST plus their index
+ * in the application topic list.
+ */
+#define APP_TOPIC_ROUTE_FIRST 0x100
+#define TOPIC_ROUTER_NODE_CNT \
+	(16 + CONFIG_AWS_IOT_APP_SUBSCRIPTION_LIST_COUNT * 8)
+MQTT_TOPIC_ROUTER_DEFINE(topic_router, TOPIC_ROUTER_NODE_CNT);
+
 static struct mqtt_client client;
 static struct sockaddr_storage broker;
 
@@ -126,6 +139,13 @@ static atomic_t connection_poll_active;
  */
 static atomic_t aws_iot_disconnected = ATOMIC_INIT(1);
 
+/* Message IDs are incremented from 1, wrapping around before the range that
+ * is reserved for messages sent with cloud_send_async(). 0 is not a valid
+ * MQTT message ID.
+ */
+#define MSG_ID_INCREMENT_COUNT (CLOUD_SEND_MSG_ID_FIRST - 1)
+static atomic_t message_id_counter;
+
 /* Structure used to confirm successful subscriptions. */
 static struct aws_iot_suback_confirmation {
 	/* Subscription ID for application specific topics. */
@@ -138,6 +158,13 @@ static struct aws_iot_suback_confirmation {
 
 static K_SEM_DEFINE(connection_poll_sem, 0, 1);
 
+/* Get the next message ID, never in the reserved range. */
+static uint16_t get_next_message_id(void)
+{
+	return ((uint32_t)atomic_inc(&message_id_counter) %
+		MSG_ID_INCREMENT_COUNT) + 1;
+}
+
 static int connect_error_translate(const int err)
 {
 	switch (err) {
@@ -516,7 +543,7 @@ static int topic_subscribe(void)
 
 	if (app_topic_data.list_count > 0) {
 
-		suback_conf.app_subs_message_id = k_cycle_get_32();
+		suback_conf.app_subs_message_id = get_next_message_id();
 
 		const struct mqtt_subscription_list app_sub_list = {
 			.list = app_topic_data.list,
@@ -540,7 +567,7 @@ static int topic_subscribe(void)
 
 	if (ARRAY_SIZE(aws_iot_rx_list) > 0) {
 
-		suback_conf.aws_subs_message_id = k_cycle_get_32();
+		suback_conf.aws_subs_message_id = get_next_message_id();
 
 		const struct mqtt_subscription_list aws_sub_list = {
 			.list = (struct mqtt_topic *)&aws_iot_rx_list,
@@ -568,6 +595,76 @@ static int topic_subscribe(void)
 	return app_topic_data.list_count + ARRAY_SIZE(aws_iot_rx_list);
 }
 
+static void topic_router_populate(void)
+{
+	int err;
+	const struct {
+		const char *topic;
+		enum aws_iot_topic_type type;
+	} shadow_topics[] = {
+#if defined(CONFIG_AWS_IOT_TOPIC_GET_ACCEPTED_SUBSCRIBE)
+		{ get_accepted_topic, AWS_IOT_SHADOW_TOPIC_GET_ACCEPTED },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_GET_REJECTED_SUBSCRIBE)
+		{ get_rejected_topic, AWS_IOT_SHADOW_TOPIC_GET_REJECTED },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_ACCEPTED_SUBSCRIBE)
+		{ update_accepted_topic, AWS_IOT_SHADOW_TOPIC_UPDATE_ACCEPTED },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_REJECTED_SUBSCRIBE)
+		{ update_rejected_topic, AWS_IOT_SHADOW_TOPIC_UPDATE_REJECTED },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_UPDATE_DELTA_SUBSCRIBE)
+		{ update_delta_topic, AWS_IOT_SHADOW_TOPIC_UPDATE_DELTA },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_ACCEPTED_SUBSCRIBE)
+		{ delete_accepted_topic, AWS_IOT_SHADOW_TOPIC_DELETE_ACCEPTED },
+#endif
+#if defined(CONFIG_AWS_IOT_TOPIC_DELETE_REJECTED_SUBSCRIBE)
+		{ delete_rejected_topic, AWS_IOT_SHADOW_TOPIC_DELETE_REJECTED },
+#endif
+	};
+
+	mqtt_topic_router_reset(&topic_router);
+
+	/* Topics that cannot be routed are still received, with the
+	 * AWS_IOT_SHADOW_TOPIC_UNKNOWN type.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(shadow_topics); i++) {
+		err = mqtt_topic_router_add(&topic_router,
+					    shadow_topics[i].topic,
+					    strlen(shadow_topics[i].topic),
+					    shadow_topics[i].type);
+		if (err) {
+			LOG_WRN("Shadow topic not routed, error: %d", err);
+		}
+	}
+
+	for (size_t i = 0; i < app_topic_data.list_count; i++) {
+		err = mqtt_topic_router_add(&topic_router,
+					    app_topic_data.list[i].topic.utf8,
+					    app_topic_data.list[i].topic.size,
+					    APP_TOPIC_ROUTE_FIRST + i);
+		if (err) {
+			LOG_WRN("Application topic not routed, error: %d", err);
+		}
+	}
+}
+
+static enum aws_iot_topic_type topic_type_get(const struct mqtt_topic *topic)
+{
+	int route = mqtt_topic_router_match(&topic_router, topic->topic.utf8,
+					    topic->topic.size);
+
+	if (route < 0) {
+		return AWS_IOT_SHADOW_TOPIC_UNKNOWN;
+	} else if (route >= APP_TOPIC_ROUTE_FIRST) {
+		return app_topic_types[route - APP_TOPIC_ROUTE_FIRST];
+	}
+
+	return route;
+}
+
 static void device_shadow_document_request(void)
 {
 	int err;
@@ -751,7 +848,7 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 		aws_iot_evt.type = AWS_IOT_EVT_DATA_RECEIVED;
 		aws_iot_evt.data.msg.ptr = payload_buf;
 		aws_iot_evt.data.msg.len = p->message.payload.len;
-		aws_iot_evt.data.msg.topic.type = AWS_IOT_SHADOW_TOPIC_UNKNOWN;
+		aws_iot_evt.data.msg.topic.type = topic_type_get(&p->message.topic);
 		aws_iot_evt.data.msg.topic.str = p->message.topic.topic.utf8;
 		aws_iot_evt.data.msg.topic.len = p->message.topic.topic.size;
 
@@ -761,6 +858,12 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 		LOG_DBG("MQTT_EVT_PUBACK: id = %d result = %d",
 			mqtt_evt->param.puback.message_id,
 			mqtt_evt->result);
+
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+		cloud_send_ack_notify(aws_iot_backend,
+				      mqtt_evt->param.puback.message_id,
+				      mqtt_evt->result);
+#endif
 		break;
 	case MQTT_EVT_SUBACK:
 		LOG_DBG("MQTT_EVT_SUBACK: id = %d result = %d",
@@ -1063,7 +1166,7 @@ int aws_iot_input(void)
 	return mqtt_input(&client);
 }
 
-int aws_iot_send(const struct aws_iot_data *const tx_data)
+static int publish(const struct aws_iot_data *const tx_data, uint16_t message_id)
 {
 	struct aws_iot_data tx_data_pub = {
 		.ptr	    = tx_data->ptr,
@@ -1118,7 +1221,7 @@ int aws_iot_send(const struct aws_iot_data *const tx_data)
 	param.message.topic.topic.size	= tx_data_pub.topic.len;
 	param.message.payload.data	= tx_data_pub.ptr;
 	param.message.payload.len	= tx_data_pub.len;
-	param.message_id		= k_cycle_get_32();
+	param.message_id		= message_id;
 	param.dup_flag			= 0;
 	param.retain_flag		= 0;
 
@@ -1128,6 +1231,11 @@ int aws_iot_send(const struct aws_iot_data *const tx_data)
 	return mqtt_publish(&client, &param);
 }
 
+int aws_iot_send(const struct aws_iot_data *const tx_data)
+{
+	return publish(tx_data, get_next_message_id());
+}
+
 int aws_iot_disconnect(void)
 {
 	atomic_set(&disconnect_requested, 1);
@@ -1138,6 +1246,12 @@ int aws_iot_connect(struct aws_iot_config *const config)
 {
 	int err;
 
+	/* The router is populated before connecting, as messages can be
+	 * received on the subscriptions of a persistent session before any
+	 * topic is subscribed to.
+	 */
+	topic_router_populate();
+
 	if (IS_ENABLED(CONFIG_AWS_IOT_CONNECTION_POLL_THREAD)) {
 		err = connection_poll_start();
 		if (err) {
@@ -1177,6 +1291,7 @@ int aws_iot_subscription_topics_add(
 		app_topic_data.list[i].topic.utf8 = topic_list[i].str;
 		app_topic_data.list[i].topic.size = topic_list[i].len;
 		app_topic_data.list[i].qos = MQTT_QOS_1_AT_LEAST_ONCE;
+		app_topic_types[i] = topic_list[i].type;
 	}
 
 	app_topic_data.list_count = list_count;
@@ -1410,6 +1525,24 @@ static int api_send(const struct cloud_backend *const backend,
 	return aws_iot_send(&tx_data);
 }
 
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+static int api_send_with_id(const struct cloud_backend *const backend,
+			    const struct cloud_msg *const msg,
+			    uint16_t message_id)
+{
+	struct aws_iot_data tx_data = {
+		.ptr = msg->buf,
+		.len = msg->len,
+		.qos = msg->qos,
+		.topic.str = msg->endpoint.str,
+		.topic.len = msg->endpoint.len,
+		.topic.type = msg->endpoint.type
+	};
+
+	return publish(&tx_data, message_id);
+}
+#endif
+
 static int api_input(const struct cloud_backend *const backend)
 {
 	return aws_iot_input();
@@ -1433,7 +1566,10 @@ static const struct cloud_api aws_iot_api = {
 	.send			= api_send,
 	.input			= api_input,
 	.ping			= api_ping,
-	.keepalive_time_left	= api_keepalive_time_left
+	.keepalive_time_left	= api_keepalive_time_left,
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+	.send_with_id		= api_send_with_id,
+#endif
 };
 
 CLOUD_BACKEND_DEFINE(AWS_IOT, aws_iot_api);
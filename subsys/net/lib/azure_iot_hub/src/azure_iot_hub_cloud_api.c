@@ -100,6 +100,12 @@ static void api_event_handler(struct azure_iot_hub_evt *evt)
 		cloud_notify_event(azure_iot_hub_backend, &cloud_evt,
 				   config->user_data);
 		break;
+	case AZURE_IOT_HUB_EVT_PUBACK:
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+		cloud_send_ack_notify(azure_iot_hub_backend,
+				      evt->data.message_id, 0);
+#endif
+		break;
 	case AZURE_IOT_HUB_EVT_ERROR:
 		cloud_evt.type = CLOUD_EVT_ERROR;
 		cloud_evt.data.err = evt->data.err;
@@ -169,13 +175,13 @@ static int api_disconnect(const struct cloud_backend *const backend)
 	return azure_iot_hub_disconnect();
 }
 
-static int api_send(const struct cloud_backend *const backend,
-		  const struct cloud_msg *const msg)
+static int send_with_id(const struct cloud_msg *const msg, uint16_t message_id)
 {
 	struct azure_iot_hub_data tx_data = {
 		.ptr = msg->buf,
 		.len = msg->len,
 		.qos = msg->qos,
+		.message_id = message_id,
 		.topic.str = msg->endpoint.str,
 		.topic.len = msg->endpoint.len,
 	};
@@ -202,6 +208,21 @@ static int api_send(const struct cloud_backend *const backend,
 	return azure_iot_hub_send(&tx_data);
 }
 
+static int api_send(const struct cloud_backend *const backend,
+		  const struct cloud_msg *const msg)
+{
+	return send_with_id(msg, 0);
+}
+
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+static int api_send_with_id(const struct cloud_backend *const backend,
+			    const struct cloud_msg *const msg,
+			    uint16_t message_id)
+{
+	return send_with_id(msg, message_id);
+}
+#endif
+
 static int api_input(const struct cloud_backend *const backend)
 {
 	return azure_iot_hub_input();
@@ -225,6 +246,9 @@ static const struct cloud_api azure_iot_hub_api = {
 	.ping			= api_ping,
 	.keepalive_time_left	= api_keepalive_time_left,
 	.input			= api_input,
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+	.send_with_id		= api_send_with_id,
+#endif
 };
 
 CLOUD_BACKEND_DEFINE(AZURE_IOT_HUB, azure_iot_hub_api);
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <init.h>
+#include <net/cloud.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_REGISTER(cloud_send, CONFIG_CLOUD_API_ASYNC_SEND_LOG_LEVEL);
+
+extern struct cloud_backend __cloud_backends_start[0];
+extern struct cloud_backend __cloud_backends_end[0];
+
+K_THREAD_STACK_DEFINE(cloud_send_stack_area, CONFIG_CLOUD_API_ASYNC_SEND_STACK_SIZE);
+static struct k_work_q cloud_send_work_q;
+
+static struct cloud_send_queue *queue_get(const struct cloud_backend *const backend)
+{
+	return &backend->config->send_queue;
+}
+
+static bool ack_expected(const struct cloud_backend *const backend,
+			 const struct cloud_send_req *req)
+{
+	return (req->msg.qos != CLOUD_QOS_AT_MOST_ONCE) &&
+	       (backend->api->send_with_id != NULL);
+}
+
+static void status_report(const struct cloud_backend *const backend,
+			  struct cloud_send_req *req,
+			  enum cloud_send_status status, int err)
+{
+	if (req->cb) {
+		req->cb(backend, req, status, err);
+	}
+}
+
+/* Must be called with the queue locked. The status is reported from the work queue. */
+static void req_done(struct cloud_send_queue *q, struct cloud_send_req *req,
+		     enum cloud_send_status status, int err)
+{
+	req->status = status;
+	req->err = err;
+	sys_slist_append(&q->done, &req->node);
+}
+
+/* Must be called with the queue locked. */
+static struct cloud_send_req *in_flight_remove(struct cloud_send_queue *q, uint16_t message_id)
+{
+	sys_snode_t *node;
+	sys_snode_t *prev = NULL;
+
+	SYS_SLIST_FOR_EACH_NODE(&q->in_flight, node) {
+		struct cloud_send_req *req = CONTAINER_OF(node, struct cloud_send_req, node);
+
+		if (req->message_id == message_id) {
+			sys_slist_remove(&q->in_flight, prev, node);
+			q->in_flight_count--;
+			return req;
+		}
+
+		prev = node;
+	}
+
+	return NULL;
+}
+
+/* Must be called with the queue locked. */
+static struct cloud_send_req *next_req_get(struct cloud_send_queue *q)
+{
+	for (size_t i = 0; i < CLOUD_SEND_PRIO_COUNT; i++) {
+		sys_snode_t *node = sys_slist_get(&q->queued[i]);
+
+		if (node) {
+			q->queued_count--;
+			return CONTAINER_OF(node, struct cloud_send_req, node);
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with the queue locked. */
+static uint16_t message_id_get(struct cloud_send_queue *q)
+{
+	uint16_t message_id = q->next_message_id;
+
+	q->next_message_id = (message_id == CLOUD_SEND_MSG_ID_LAST) ?
+			     CLOUD_SEND_MSG_ID_FIRST : message_id + 1;
+
+	return message_id;
+}
+
+static void done_report(struct cloud_send_queue *q)
+{
+	struct cloud_send_req *req, *next;
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	sys_slist_t done = q->done;
+
+	sys_slist_init(&q->done);
+	k_spin_unlock(&q->lock, key);
+
+	/* The callback can reuse the request, so the next node is read before it is called. */
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&done, req, next, node) {
+		status_report(q->backend, req, req->status, req->err);
+	}
+}
+
+static void req_send(struct cloud_send_queue *q, struct cloud_send_req *req, bool ack)
+{
+	const struct cloud_backend *const backend = q->backend;
+	k_spinlock_key_t key;
+	int err;
+
+	if (ack) {
+		err = backend->api->send_with_id(backend, &req->msg, req->message_id);
+	} else {
+		err = backend->api->send(backend, &req->msg);
+	}
+
+	if (err == 0) {
+		status_report(backend, req, CLOUD_SEND_STATUS_SENT, 0);
+		return;
+	}
+
+	LOG_WRN("Sending message failed, error: %d", err);
+
+	if (ack) {
+		key = k_spin_lock(&q->lock);
+
+		/* The message has already been failed if the backend was disconnected while
+		 * sending it. In that case the status is reported from the done list.
+		 */
+		if (in_flight_remove(q, req->message_id) == NULL) {
+			k_spin_unlock(&q->lock, key);
+			return;
+		}
+
+		k_spin_unlock(&q->lock, key);
+	}
+
+	status_report(backend, req, CLOUD_SEND_STATUS_FAILED, err);
+}
+
+static void timeout_schedule(struct cloud_send_queue *q)
+{
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	sys_snode_t *node = sys_slist_peek_head(&q->in_flight);
+	int64_t delay = 0;
+
+	/* Messages are added to the in-flight list in the order they are sent, with the
+	 * same timeout, so the first message times out first.
+	 */
+	if (node) {
+		struct cloud_send_req *req = CONTAINER_OF(node, struct cloud_send_req, node);
+
+		delay = MAX(req->deadline - k_uptime_get(), 0);
+	}
+
+	k_spin_unlock(&q->lock, key);
+
+	if (node) {
+		k_work_schedule_for_queue(&cloud_send_work_q, &q->timeout_work, K_MSEC(delay));
+	}
+}
+
+static void send_work_fn(struct k_work *work)
+{
+	struct cloud_send_queue *q = CONTAINER_OF(work, struct cloud_send_queue, work);
+
+	done_report(q);
+
+	while (true) {
+		struct cloud_send_req *req = NULL;
+		bool ack = false;
+		k_spinlock_key_t key = k_spin_lock(&q->lock);
+
+		if (q->ready && (q->in_flight_count < CONFIG_CLOUD_API_ASYNC_SEND_IN_FLIGHT_MAX)) {
+			req = next_req_get(q);
+		}
+
+		if (req == NULL) {
+			k_spin_unlock(&q->lock, key);
+			break;
+		}
+
+		ack = ack_expected(q->backend, req);
+		if (ack) {
+			/* Added to the in-flight list before the message is sent, as the
+			 * acknowledgment can be received before the send function returns.
+			 */
+			req->message_id = message_id_get(q);
+			req->deadline = k_uptime_get() +
+					CONFIG_CLOUD_API_ASYNC_SEND_ACK_TIMEOUT * MSEC_PER_SEC;
+			sys_slist_append(&q->in_flight, &req->node);
+			q->in_flight_count++;
+		}
+
+		k_spin_unlock(&q->lock, key);
+
+		req_send(q, req, ack);
+	}
+
+	timeout_schedule(q);
+}
+
+static void timeout_work_fn(struct k_work *work)
+{
+	struct k_work_delayable *timeout_work = k_work_delayable_from_work(work);
+	struct cloud_send_queue *q = CONTAINER_OF(timeout_work, struct cloud_send_queue,
+						  timeout_work);
+	int64_t now = k_uptime_get();
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	sys_snode_t *node;
+	int count = 0;
+
+	while ((node = sys_slist_peek_head(&q->in_flight)) != NULL) {
+		struct cloud_send_req *req = CONTAINER_OF(node, struct cloud_send_req, node);
+
+		if (req->deadline > now) {
+			break;
+		}
+
+		(void)sys_slist_get(&q->in_flight);
+		q->in_flight_count--;
+		req_done(q, req, CLOUD_SEND_STATUS_FAILED, -ETIMEDOUT);
+		count++;
+	}
+
+	k_spin_unlock(&q->lock, key);
+
+	if (count > 0) {
+		LOG_WRN("%d message(s) not acknowledged in time", count);
+	}
+
+	/* Reports the status and reschedules the timeout for the remaining messages. */
+	k_work_submit_to_queue(&cloud_send_work_q, &q->work);
+}
+
+int cloud_send_async(const struct cloud_backend *const backend,
+		     struct cloud_send_req *req)
+{
+	struct cloud_send_queue *q;
+	k_spinlock_key_t key;
+
+	if (backend == NULL || backend->api == NULL ||
+	    backend->api->send == NULL) {
+		return -ENOTSUP;
+	}
+
+	if (req == NULL || req->prio >= CLOUD_SEND_PRIO_COUNT) {
+		return -EINVAL;
+	}
+
+	q = queue_get(backend);
+	key = k_spin_lock(&q->lock);
+
+	if (q->queued_count >= CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE) {
+		k_spin_unlock(&q->lock, key);
+		return -ENOBUFS;
+	}
+
+	req->message_id = 0;
+	sys_slist_append(&q->queued[req->prio], &req->node);
+	q->queued_count++;
+
+	k_spin_unlock(&q->lock, key);
+
+	k_work_submit_to_queue(&cloud_send_work_q, &q->work);
+
+	return 0;
+}
+
+int cloud_send_async_cancel(const struct cloud_backend *const backend,
+			    struct cloud_send_req *req)
+{
+	struct cloud_send_queue *q;
+	k_spinlock_key_t key;
+	int err = -EBUSY;
+
+	if (backend == NULL || req == NULL || req->prio >= CLOUD_SEND_PRIO_COUNT) {
+		return -EINVAL;
+	}
+
+	q = queue_get(backend);
+	key = k_spin_lock(&q->lock);
+
+	if (sys_slist_find_and_remove(&q->queued[req->prio], &req->node)) {
+		q->queued_count--;
+		err = 0;
+	}
+
+	k_spin_unlock(&q->lock, key);
+
+	return err;
+}
+
+void cloud_send_ack_notify(const struct cloud_backend *const backend,
+			   uint16_t message_id, int result)
+{
+	struct cloud_send_queue *q = queue_get(backend);
+	struct cloud_send_req *req;
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+
+	req = in_flight_remove(q, message_id);
+	if (req) {
+		req_done(q, req, result ? CLOUD_SEND_STATUS_FAILED : CLOUD_SEND_STATUS_ACKED,
+			 result);
+	}
+
+	k_spin_unlock(&q->lock, key);
+
+	if (req) {
+		k_work_submit_to_queue(&cloud_send_work_q, &q->work);
+	}
+}
+
+void cloud_send_async_evt_handle(const struct cloud_backend *const backend,
+				 const struct cloud_event *const evt)
+{
+	struct cloud_send_queue *q = queue_get(backend);
+	k_spinlock_key_t key;
+	sys_snode_t *node;
+
+	switch (evt->type) {
+	case CLOUD_EVT_READY:
+		key = k_spin_lock(&q->lock);
+		q->ready = true;
+		k_spin_unlock(&q->lock, key);
+		break;
+	case CLOUD_EVT_DISCONNECTED:
+		key = k_spin_lock(&q->lock);
+		q->ready = false;
+
+		/* Acknowledgments are not received after the connection is lost. Queued
+		 * messages are kept until the backend is ready again.
+		 */
+		while ((node = sys_slist_get(&q->in_flight)) != NULL) {
+			req_done(q, CONTAINER_OF(node, struct cloud_send_req, node),
+				 CLOUD_SEND_STATUS_FAILED, -ENOTCONN);
+		}
+
+		q->in_flight_count = 0;
+		k_spin_unlock(&q->lock, key);
+		break;
+	default:
+		return;
+	}
+
+	k_work_submit_to_queue(&cloud_send_work_q, &q->work);
+}
+
+static int cloud_send_init(const struct device *unused)
+{
+	ARG_UNUSED(unused);
+
+	k_work_queue_start(&cloud_send_work_q, cloud_send_stack_area,
+			   K_THREAD_STACK_SIZEOF(cloud_send_stack_area),
+			   CONFIG_CLOUD_API_ASYNC_SEND_PRIORITY, NULL);
+	k_thread_name_set(&cloud_send_work_q.thread, "cloud_send");
+
+	for (struct cloud_backend *backend = __cloud_backends_start;
+	     backend != __cloud_backends_end; backend++) {
+		struct cloud_send_queue *q = queue_get(backend);
+
+		q->backend = backend;
+		q->next_message_id = CLOUD_SEND_MSG_ID_FIRST;
+
+		for (size_t i = 0; i < CLOUD_SEND_PRIO_COUNT; i++) {
+			sys_slist_init(&q->queued[i]);
+		}
+
+		sys_slist_init(&q->in_flight);
+		sys_slist_init(&q->done);
+		k_work_init(&q->work, send_work_fn);
+		k_work_init_delayable(&q->timeout_work, timeout_work_fn);
+	}
+
+	return 0;
+}
+
+SYS_INIT(cloud_send_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <string.h>
+#include <net/mqtt_topic_router.h>
+
+#define ROUTE_NONE -1
+
+static struct mqtt_topic_router_node *node_get(const struct mqtt_topic_router *router,
+					       uint16_t index)
+{
+	return &router->nodes[index - 1];
+}
+
+static bool node_is(const struct mqtt_topic_router_node *node, char wildcard)
+{
+	return (node->level_len == 1) && (node->level[0] == wildcard);
+}
+
+/* Length of the first level of a topic or filter. */
+static size_t level_len_get(const char *topic, size_t topic_len)
+{
+	const char *end = memchr(topic, '/', topic_len);
+
+	return end ? (size_t)(end - topic) : topic_len;
+}
+
+static int filter_validate(const char *filter, size_t filter_len)
+{
+	size_t pos = 0;
+
+	while (true) {
+		const char *level = &filter[pos];
+		size_t len = level_len_get(level, filter_len - pos);
+		bool last = (pos + len == filter_len);
+
+		/* Wildcards must occupy an entire level, and '#' must be the last level. */
+		if (memchr(level, '+', len) || memchr(level, '#', len)) {
+			if ((len != 1) || ((level[0] == '#') && !last)) {
+				return -EINVAL;
+			}
+		}
+
+		if (last) {
+			return 0;
+		}
+
+		pos += len + 1;
+	}
+}
+
+void mqtt_topic_router_reset(struct mqtt_topic_router *router)
+{
+	router->node_count = 0;
+	router->root = 0;
+}
+
+int mqtt_topic_router_add(struct mqtt_topic_router *router, const char *filter,
+			  size_t filter_len, int route)
+{
+	uint16_t *first = NULL;
+	size_t pos = 0;
+	int err;
+
+	if ((router == NULL) || (filter == NULL) || (filter_len == 0) ||
+	    (route < 0) || (route > INT16_MAX) || (filter_len > UINT16_MAX)) {
+		return -EINVAL;
+	}
+
+	err = filter_validate(filter, filter_len);
+	if (err) {
+		return err;
+	}
+
+	first = &router->root;
+
+	while (true) {
+		const char *level = &filter[pos];
+		size_t len = level_len_get(level, filter_len - pos);
+		struct mqtt_topic_router_node *node = NULL;
+		uint16_t *link = first;
+
+		for (uint16_t i = *first; i != 0; i = node_get(router, i)->sibling) {
+			struct mqtt_topic_router_node *sibling = node_get(router, i);
+
+			if ((sibling->level_len == len) && (memcmp(sibling->level, level, len) == 0)) {
+				node = sibling;
+				break;
+			}
+
+			link = &sibling->sibling;
+		}
+
+		if (node == NULL) {
+			if (router->node_count == router->node_max) {
+				return -ENOMEM;
+			}
+
+			node = &router->nodes[router->node_count++];
+			*node = (struct mqtt_topic_router_node) {
+				.level = level,
+				.level_len = len,
+				.route = ROUTE_NONE
+			};
+			*link = router->node_count;
+		}
+
+		if (pos + len == filter_len) {
+			if (node->route != ROUTE_NONE) {
+				return -EEXIST;
+			}
+
+			node->route = route;
+			return 0;
+		}
+
+		first = &node->child;
+		pos += len + 1;
+	}
+}
+
+/* Route of a '#' child, as "a/#" also matches "a". */
+static int multi_level_child_route(const struct mqtt_topic_router *router,
+				   const struct mqtt_topic_router_node *node)
+{
+	for (uint16_t i = node->child; i != 0; i = node_get(router, i)->sibling) {
+		const struct mqtt_topic_router_node *child = node_get(router, i);
+
+		if (node_is(child, '#')) {
+			return child->route;
+		}
+	}
+
+	return ROUTE_NONE;
+}
+
+static int level_match(const struct mqtt_topic_router *router, uint16_t first,
+		       const char *topic, size_t topic_len, bool top_level)
+{
+	size_t len = level_len_get(topic, topic_len);
+	bool last = (len == topic_len);
+	const struct mqtt_topic_router_node *candidates[2] = { NULL };
+	const struct mqtt_topic_router_node *multi_level = NULL;
+
+	for (uint16_t i = first; i != 0; i = node_get(router, i)->sibling) {
+		const struct mqtt_topic_router_node *node = node_get(router, i);
+
+		if (node_is(node, '+')) {
+			candidates[1] = node;
+		} else if (node_is(node, '#')) {
+			multi_level = node;
+		} else if ((node->level_len == len) && (memcmp(node->level, topic, len) == 0)) {
+			candidates[0] = node;
+		}
+	}
+
+	if (top_level && (topic_len > 0) && (topic[0] == '$')) {
+		candidates[1] = NULL;
+		multi_level = NULL;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(candidates); i++) {
+		const struct mqtt_topic_router_node *node = candidates[i];
+		int route = ROUTE_NONE;
+
+		if (node == NULL) {
+			continue;
+		}
+
+		if (last) {
+			route = (node->route != ROUTE_NONE) ? node->route :
+				multi_level_child_route(router, node);
+		} else if (node->child != 0) {
+			route = level_match(router, node->child, &topic[len + 1],
+					    topic_len - len - 1, false);
+		}
+
+		if (route != ROUTE_NONE) {
+			return route;
+		}
+	}
+
+	return multi_level ? multi_level->route : ROUTE_NONE;
+}
+
+int mqtt_topic_router_match(const struct mqtt_topic_router *router, const char *topic,
+			    size_t topic_len)
+{
+	int route;
+
+	if ((router == NULL) || (topic == NULL)) {
+		return -EINVAL;
+	}
+
+	route = level_match(router, router->root, topic, topic_len, true);
+
+	return (route == ROUTE_NONE) ? -ENOENT : route;
+}
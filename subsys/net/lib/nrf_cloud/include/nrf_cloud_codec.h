@@ -77,7 +77,9 @@ extern "C" {
 /**@brief Initialize the codec used encoding the data to the cloud. */
 int nrf_cloud_codec_init(void);
 
-/**@brief Encode the sensor data based on the indicated type. */
+/**@brief Encode the sensor data based on the indicated type.
+ * The output must be freed using @ref nrf_cloud_free.
+ */
 int nrf_cloud_encode_sensor_data(const struct nrf_cloud_sensor_data *input,
 				 struct nrf_cloud_data *output);
 
@@ -96,7 +98,9 @@ int nrf_cloud_decode_data_endpoint(const struct nrf_cloud_data *input,
 				   struct nrf_cloud_data *bulk_endpoint,
 				   struct nrf_cloud_data *m_endpoint);
 
-/** @brief Encodes state information. */
+/** @brief Encodes state information.
+ * The output must be freed using @ref nrf_cloud_free.
+ */
 int nrf_cloud_encode_state(uint32_t reported_state, struct nrf_cloud_data *output);
 
 /** @brief Search input for config and encode response if necessary. */
@@ -136,7 +140,7 @@ int nrf_cloud_json_add_modem_info(cJSON * const data_obj);
 
 /** @brief Builds a cellular positioning request string using the provided cell info.
  * If successful, memory will be allocated for the output string and the user is
- * responsible for freeing it using @ref cJSON_free.
+ * responsible for freeing it using @ref nrf_cloud_free.
  */
 int nrf_cloud_format_cell_pos_req(struct lte_lc_cells_info const *const inf,
 				  size_t inf_cnt, char **string_out);
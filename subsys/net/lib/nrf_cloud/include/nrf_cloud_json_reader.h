@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef NRF_CLOUD_JSON_READER_H_
+#define NRF_CLOUD_JSON_READER_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum nesting depth accepted by the reader. */
+#define NRF_CLOUD_JSON_READER_MAX_DEPTH 16
+
+/** @brief Type of a JSON value. */
+enum nrf_cloud_json_type {
+	NRF_CLOUD_JSON_NONE,
+	NRF_CLOUD_JSON_OBJ,
+	NRF_CLOUD_JSON_ARR,
+	NRF_CLOUD_JSON_STR,
+	NRF_CLOUD_JSON_NUM,
+	NRF_CLOUD_JSON_TRUE,
+	NRF_CLOUD_JSON_FALSE,
+	NRF_CLOUD_JSON_NULL,
+};
+
+/** @brief JSON value located in the input buffer.
+ *
+ * For strings, the value points to the escaped content without quotes.
+ * For objects and arrays, the value spans the whole raw subtree.
+ */
+struct nrf_cloud_json_value {
+	enum nrf_cloud_json_type type;
+	const char *ptr;
+	size_t len;
+};
+
+struct nrf_cloud_json_reader_frame {
+	/* Key of the current member, NULL for array frames. */
+	const char *key;
+	size_t key_len;
+	const char *start;
+	bool is_arr;
+};
+
+/** @brief Streaming JSON reader.
+ *
+ * The reader validates the input in a single pass and reports each value,
+ * together with the key path leading to it, straight from the input buffer.
+ * No tree is built and no memory is allocated.
+ */
+struct nrf_cloud_json_reader {
+	struct nrf_cloud_json_reader_frame frame[NRF_CLOUD_JSON_READER_MAX_DEPTH];
+	uint8_t depth;
+};
+
+/** @brief Callback for each completed value.
+ *
+ * Values are reported in the order in which they end, so members of an
+ * object are reported before the object itself. Returning a non-zero value
+ * stops the parsing.
+ */
+typedef int (*nrf_cloud_json_value_cb)(const struct nrf_cloud_json_reader *r,
+				       const struct nrf_cloud_json_value *val,
+				       void *ctx);
+
+/** @brief Field to be extracted by @ref nrf_cloud_json_extract. */
+struct nrf_cloud_json_field {
+	/** Dot separated key path, for example "state.pairing.state". */
+	const char *path;
+	/** Value of the first match, type is NRF_CLOUD_JSON_NONE if not found. */
+	struct nrf_cloud_json_value val;
+};
+
+/** @brief Parse a JSON document and call the callback for each value.
+ *
+ * Parsing stops at the first NULL character or after len bytes.
+ *
+ * @param[in] buf Input buffer.
+ * @param[in] len Length of the input.
+ * @param[in] cb Callback called for each value.
+ * @param[in] ctx Context passed to the callback.
+ *
+ * @retval 0 If successful.
+ * @retval -EBADMSG If the input is not valid JSON.
+ * @retval -E2BIG If the input is nested too deeply.
+ *           Otherwise, the value returned by the callback.
+ */
+int nrf_cloud_json_parse(const char *buf, size_t len, nrf_cloud_json_value_cb cb,
+			 void *ctx);
+
+/** @brief Check if the key path of the current value matches.
+ *
+ * Values inside arrays never match.
+ *
+ * @param[in] r Reader passed to the callback.
+ * @param[in] path Dot separated key path.
+ */
+bool nrf_cloud_json_path_match(const struct nrf_cloud_json_reader *r,
+			       const char *path);
+
+/** @brief Extract values at the given key paths from a JSON document.
+ *
+ * @param[in] buf Input buffer.
+ * @param[in] len Length of the input.
+ * @param[in,out] fields Fields to be extracted.
+ * @param[in] field_cnt Number of fields.
+ *
+ * @retval 0 If successful. Fields not found have type NRF_CLOUD_JSON_NONE.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int nrf_cloud_json_extract(const char *buf, size_t len,
+			   struct nrf_cloud_json_field *fields, size_t field_cnt);
+
+/** @brief Check if a string value is equal to a string. */
+bool nrf_cloud_json_str_eq(const struct nrf_cloud_json_value *val,
+			   const char *str);
+
+/** @brief Check if a string value starts with a string. */
+bool nrf_cloud_json_str_prefix(const struct nrf_cloud_json_value *val,
+			       const char *str);
+
+/** @brief Copy and unescape a string value.
+ *
+ * @param[in] val String value.
+ * @param[out] out Pointer to the NULL-terminated copy, must be freed with
+ *                 nrf_cloud_free.
+ * @param[out] out_len Length of the copy. Can be NULL.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the value is not a string.
+ * @retval -ENOMEM If the allocation failed.
+ */
+int nrf_cloud_json_strdup(const struct nrf_cloud_json_value *val, char **out,
+			  size_t *out_len);
+
+/** @brief Convert a number value to an integer, clamped as done by cJSON.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the value is not a number.
+ */
+int nrf_cloud_json_to_int(const struct nrf_cloud_json_value *val, int *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_CLOUD_JSON_READER_H_ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef NRF_CLOUD_JSON_WRITER_H_
+#define NRF_CLOUD_JSON_WRITER_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <json_writer.h>
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+#include <tinycbor/cbor.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum nesting depth of CBOR output. */
+#define NRF_CLOUD_CBOR_MAX_DEPTH 8
+
+/** @brief Streaming JSON writer.
+ *
+ * JSON output is written by the JSON writer library, see @ref json_writer.
+ * If the buffer is NULL, the writer only calculates the length of the output.
+ *
+ * The same sequence of items can be written as CBOR instead, using
+ * indefinite-length maps and arrays, see @ref nrf_cloud_json_writer_init_cbor.
+ *
+ * Errors are latched and reported by @ref nrf_cloud_json_writer_finish.
+ */
+struct nrf_cloud_json_writer {
+	/* Output buffer and JSON state, also used for the CBOR output. */
+	struct json_writer json;
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+	bool cbor;
+	uint8_t cbor_depth;
+	/* Output of the CBOR encoders, writes to the buffer above. */
+	struct cbor_encoder_writer cbor_out;
+	/* Encoder per nesting level, index 0 is the root. */
+	CborEncoder enc[NRF_CLOUD_CBOR_MAX_DEPTH + 1];
+#endif
+};
+
+/** @brief Callback that writes a complete JSON message using the writer. */
+typedef void (*nrf_cloud_json_encode_fn)(struct nrf_cloud_json_writer *w,
+					 const void *ctx);
+
+/** @brief Initialize the writer.
+ *
+ * @param[out] w Writer.
+ * @param[in] buf Output buffer or NULL to only calculate the output length.
+ * @param[in] size Size of the output buffer.
+ */
+void nrf_cloud_json_writer_init(struct nrf_cloud_json_writer *w, char *buf,
+				size_t size);
+
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+/** @brief Initialize the writer for CBOR output.
+ *
+ * @param[out] w Writer.
+ * @param[in] buf Output buffer or NULL to only calculate the output length.
+ * @param[in] size Size of the output buffer.
+ */
+void nrf_cloud_json_writer_init_cbor(struct nrf_cloud_json_writer *w, char *buf,
+				     size_t size);
+#endif
+
+/** @brief Start an object. Key must be NULL for array items and root. */
+void nrf_cloud_json_writer_obj_start(struct nrf_cloud_json_writer *w,
+				     const char *key);
+
+/** @brief End the current object. */
+void nrf_cloud_json_writer_obj_end(struct nrf_cloud_json_writer *w);
+
+/** @brief Start an array. Key must be NULL for array items and root. */
+void nrf_cloud_json_writer_arr_start(struct nrf_cloud_json_writer *w,
+				     const char *key);
+
+/** @brief End the current array. */
+void nrf_cloud_json_writer_arr_end(struct nrf_cloud_json_writer *w);
+
+/** @brief Add a string. */
+void nrf_cloud_json_writer_str(struct nrf_cloud_json_writer *w,
+			       const char *key, const char *val);
+
+/** @brief Add a number. */
+void nrf_cloud_json_writer_num(struct nrf_cloud_json_writer *w,
+			       const char *key, double val);
+
+/** @brief Add a null value. */
+void nrf_cloud_json_writer_null(struct nrf_cloud_json_writer *w,
+				const char *key);
+
+/** @brief Add a boolean value. */
+void nrf_cloud_json_writer_bool(struct nrf_cloud_json_writer *w,
+				const char *key, bool val);
+
+/** @brief Finish writing and NULL-terminate the output.
+ *
+ * The terminator is not counted in the length, also for CBOR output.
+ *
+ * @return Length of the output (without the NULL terminator) or
+ *         a negative error code.
+ */
+int nrf_cloud_json_writer_finish(struct nrf_cloud_json_writer *w);
+
+/** @brief Encode a message into a buffer allocated with the exact size.
+ *
+ * The encode function is called twice, first to calculate the length of the
+ * output and then to write it. The output must be freed with nrf_cloud_free.
+ *
+ * @param[in] fn Function that writes the message.
+ * @param[in] ctx Context passed to the function.
+ * @param[in] cbor Write CBOR instead of JSON.
+ * @param[out] out Pointer to the allocated NULL-terminated output.
+ * @param[out] out_len Length of the output. Can be NULL.
+ *
+ * @retval 0 If successful.
+ * @retval -ENOTSUP If CBOR is requested but not enabled.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int nrf_cloud_json_encode_alloc(nrf_cloud_json_encode_fn fn, const void *ctx,
+				bool cbor, char **out, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_CLOUD_JSON_WRITER_H_ */
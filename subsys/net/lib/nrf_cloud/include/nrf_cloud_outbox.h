@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef NRF_CLOUD_OUTBOX_H__
+#define NRF_CLOUD_OUTBOX_H__
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <settings/settings.h>
+#include <net/nrf_cloud.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Settings subkey used for messages stored by the outbox. */
+#define NCT_OUTBOX_SETTINGS_KEY "ob"
+
+/** @brief Data channel topic of an outbox message. */
+enum nct_outbox_topic {
+	NCT_OUTBOX_TOPIC_DC,
+	NCT_OUTBOX_TOPIC_BULK,
+};
+
+/** @brief Add a QoS 1 message to the outbox.
+ *
+ * The message is copied. It is published right away if the data channel is
+ * connected and the in-flight window has room, otherwise it is queued.
+ *
+ * @param[in] topic Data channel topic.
+ * @param[in] data Message payload.
+ * @param[in] message_id Requested message ID or NCT_MSG_ID_USE_NEXT_INCREMENT.
+ *
+ * @retval 0 If the message was published or queued.
+ * @retval -ENOBUFS If the outbox is full.
+ * @retval -ENOMEM If the message could not be allocated.
+ */
+int nct_outbox_add(enum nct_outbox_topic topic, const struct nrf_cloud_data *data,
+		   uint16_t message_id);
+
+/** @brief Release an in-flight message acknowledged by the broker.
+ *
+ * @retval true If the message was sent from the outbox.
+ */
+bool nct_outbox_ack(uint16_t message_id);
+
+/** @brief Start publishing queued messages after the data channel is connected. */
+void nct_outbox_connected(void);
+
+/** @brief Move in-flight messages back to the queue after a disconnect. */
+void nct_outbox_disconnected(void);
+
+/** @brief Load a message stored by the outbox, called from the settings handler.
+ *
+ * @param[in] key Settings key below NCT_OUTBOX_SETTINGS_KEY.
+ */
+int nct_outbox_settings_set(const char *key, size_t len_rd,
+			    settings_read_cb read_cb, void *cb_arg);
+
+/** @brief Publish an outbox message, implemented by the transport.
+ *
+ * @param[in] topic Data channel topic.
+ * @param[in,out] message_id Message ID, assigned if NCT_MSG_ID_USE_NEXT_INCREMENT.
+ * @param[in] dup Set if the message has been published before.
+ * @param[in] data Message payload.
+ * @param[in] len Length of the payload.
+ */
+int nct_outbox_publish(enum nct_outbox_topic topic, uint16_t *message_id, bool dup,
+		       const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_CLOUD_OUTBOX_H__ */
@@ -35,6 +35,7 @@ extern "C" {
 #define NUM_BLOCKS			NUM_PREDICTIONS
 #define BLOCK_SIZE			PGPS_PREDICTION_STORAGE_SIZE
 #define NO_BLOCK			-1
+#define INDEX_NO_BLOCK			0xFFU
 
 struct gps_location {
 	int32_t latitude;
@@ -42,6 +43,16 @@ struct gps_location {
 	int64_t gps_sec;
 };
 
+/* storage block of each prediction, for the set starting at gps_day and
+ * gps_time_of_day; INDEX_NO_BLOCK if not stored
+ */
+struct npgps_index {
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
+	uint16_t prediction_count;
+	uint8_t block[NUM_PREDICTIONS];
+};
+
 struct nrf_cloud_pgps_header;
 
 typedef int (*npgps_buffer_handler_t)(uint8_t *buf, size_t len);
@@ -49,6 +60,8 @@ typedef int (*npgps_buffer_handler_t)(uint8_t *buf, size_t len);
 /* settings functions */
 int npgps_save_header(struct nrf_cloud_pgps_header *header);
 const struct nrf_cloud_pgps_header *npgps_get_saved_header(void);
+int npgps_save_index(const struct npgps_index *idx);
+const struct npgps_index *npgps_get_saved_index(void);
 const struct gps_location *npgps_get_saved_location(void);
 int npgps_settings_init(void);
 
@@ -346,11 +346,21 @@ int nrf_cloud_sensor_data_stream(const struct nrf_cloud_sensor_data *param)
 	return err;
 }
 
-int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
+/* With the outbox, QoS 1 data channel messages are queued while offline. */
+static bool send_offline_allowed(const struct nrf_cloud_tx_data *msg)
+{
+	return IS_ENABLED(CONFIG_NRF_CLOUD_OUTBOX) &&
+	       (current_state >= STATE_INITIALIZED) &&
+	       (msg->qos == MQTT_QOS_1_AT_LEAST_ONCE) &&
+	       ((msg->topic_type == NRF_CLOUD_TOPIC_MESSAGE) ||
+		(msg->topic_type == NRF_CLOUD_TOPIC_BULK));
+}
+
+static int send_with_id(const struct nrf_cloud_tx_data *msg, uint16_t message_id)
 {
 	int err;
 
-	if (current_state != STATE_DC_CONNECTED) {
+	if ((current_state != STATE_DC_CONNECTED) && !send_offline_allowed(msg)) {
 		return -EACCES;
 	}
 
@@ -360,7 +370,7 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 			.opcode = NCT_CC_OPCODE_UPDATE_REQ,
 			.data.ptr = msg->data.ptr,
 			.data.len = msg->data.len,
-			.message_id = NCT_MSG_ID_USE_NEXT_INCREMENT
+			.message_id = message_id
 		};
 
 		err = nct_cc_send(&shadow_data);
@@ -375,7 +385,7 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 		const struct nct_dc_data buf = {
 			.data.ptr = msg->data.ptr,
 			.data.len = msg->data.len,
-			.message_id = NCT_MSG_ID_USE_NEXT_INCREMENT
+			.message_id = message_id
 		};
 
 		if (msg->qos == MQTT_QOS_0_AT_MOST_ONCE) {
@@ -394,7 +404,7 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 		const struct nct_dc_data buf = {
 			.data.ptr = msg->data.ptr,
 			.data.len = msg->data.len,
-			.message_id = NCT_MSG_ID_USE_NEXT_INCREMENT
+			.message_id = message_id
 		};
 
 		err = nct_dc_bulk_send(&buf, msg->qos);
@@ -413,6 +423,11 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 	return 0;
 }
 
+int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
+{
+	return send_with_id(msg, NCT_MSG_ID_USE_NEXT_INCREMENT);
+}
+
 int nrf_cloud_tenant_id_get(char *id_buf, size_t id_len)
 {
 	return nct_tenant_id_get(id_buf, id_len);
@@ -651,9 +666,12 @@ static void api_event_handler(const struct nrf_cloud_evt *nrf_cloud_evt)
 		cloud_notify_event(nrf_cloud_backend, &evt, config->user_data);
 		break;
 	case NRF_CLOUD_EVT_SENSOR_DATA_ACK:
-		/* Not implemented; the cloud API does not support a
-		 * tag/message ID when sending data.
-		 */
+		LOG_DBG("NRF_CLOUD_EVT_SENSOR_DATA_ACK");
+
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+		cloud_send_ack_notify(nrf_cloud_backend,
+				      *(uint16_t *)nrf_cloud_evt->data.ptr, 0);
+#endif
 		break;
 	case NRF_CLOUD_EVT_TRANSPORT_DISCONNECTED:
 		LOG_DBG("NRF_CLOUD_EVT_TRANSPORT_DISCONNECTED");
@@ -750,8 +768,9 @@ static int api_disconnect(const struct cloud_backend *const backend)
 	return nrf_cloud_disconnect();
 }
 
-static int api_send(const struct cloud_backend *const backend,
-		const struct cloud_msg *const msg)
+static int api_send_with_id(const struct cloud_backend *const backend,
+			    const struct cloud_msg *const msg,
+			    uint16_t message_id)
 {
 	int err = 0;
 
@@ -778,7 +797,7 @@ static int api_send(const struct cloud_backend *const backend,
 			return err;
 		}
 
-		err = nrf_cloud_send(&buf);
+		err = send_with_id(&buf, message_id);
 		if (err) {
 			LOG_ERR("nrf_cloud_send failed, error: %d", err);
 			return err;
@@ -793,7 +812,7 @@ static int api_send(const struct cloud_backend *const backend,
 			.topic_type = NRF_CLOUD_TOPIC_STATE,
 		};
 
-		err = nrf_cloud_send(&shadow_data);
+		err = send_with_id(&shadow_data, message_id);
 		if (err) {
 			LOG_ERR("nrf_cloud_send failed, error: %d", err);
 			return err;
@@ -813,6 +832,12 @@ static int api_send(const struct cloud_backend *const backend,
 	return 0;
 }
 
+static int api_send(const struct cloud_backend *const backend,
+		const struct cloud_msg *const msg)
+{
+	return api_send_with_id(backend, msg, NCT_MSG_ID_USE_NEXT_INCREMENT);
+}
+
 static int api_ping(const struct cloud_backend *const backend)
 {
 	/* TODO: Do only ping, nrf_cloud_process() also checks for input. */
@@ -856,7 +881,10 @@ static const struct cloud_api nrf_cloud_api = {
 	.keepalive_time_left = api_keepalive_time_left,
 	.input = api_input,
 	.user_data_set = api_user_data_set,
-	.id_get = api_id_get
+	.id_get = api_id_get,
+#if defined(CONFIG_CLOUD_API_ASYNC_SEND)
+	.send_with_id = api_send_with_id,
+#endif
 };
 
 CLOUD_BACKEND_DEFINE(NRF_CLOUD, nrf_cloud_api);
@@ -33,6 +33,36 @@ static bool agps_print_enabled;
 static struct nrf_modem_gnss_agps_data_frame processed;
 static atomic_t request_in_progress;
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+#define CACHE_NUM_SV		32
+#define CACHE_MSEC_PER_MIN	(60LL * MSEC_PER_SEC)
+#define CACHE_MSEC_PER_HOUR	(60LL * CACHE_MSEC_PER_MIN)
+#define CACHE_EPHE_MAX_AGE	(CONFIG_NRF_CLOUD_AGPS_CACHE_EPHE_MAX_AGE * CACHE_MSEC_PER_MIN)
+#define CACHE_ALM_MAX_AGE	(CONFIG_NRF_CLOUD_AGPS_CACHE_ALM_MAX_AGE * CACHE_MSEC_PER_HOUR)
+#define CACHE_UTC_IONO_MAX_AGE	(CONFIG_NRF_CLOUD_AGPS_CACHE_UTC_IONO_MAX_AGE * CACHE_MSEC_PER_HOUR)
+#define CACHE_LOCATION_MAX_AGE	(CONFIG_NRF_CLOUD_AGPS_CACHE_LOCATION_MAX_AGE * CACHE_MSEC_PER_MIN)
+
+/* Copies of the A-GPS data injected to the modem, with the uptime at which
+ * each element was received. Protected by agps_injection_active.
+ */
+static struct agps_cache {
+	struct nrf_modem_gnss_agps_data_ephemeris ephe[CACHE_NUM_SV];
+	struct nrf_modem_gnss_agps_data_almanac alm[CACHE_NUM_SV];
+	struct nrf_modem_gnss_agps_data_utc utc;
+	struct nrf_modem_gnss_agps_data_klobuchar klobuchar;
+	struct nrf_modem_gnss_agps_data_location location;
+	int64_t ephe_time[CACHE_NUM_SV];
+	int64_t alm_time[CACHE_NUM_SV];
+	int64_t utc_time;
+	int64_t klobuchar_time;
+	int64_t location_time;
+	uint32_t ephe_mask;
+	uint32_t alm_mask;
+	/* NRF_MODEM_GNSS_AGPS_*_REQUEST flags of the cached elements */
+	uint32_t flags;
+} cache;
+#endif /* CONFIG_NRF_CLOUD_AGPS_CACHE */
+
 void agps_print_enable(bool enable)
 {
 	agps_print_enabled = enable;
@@ -77,19 +107,36 @@ static int json_add_types_array(cJSON * const obj, enum nrf_cloud_agps_type *typ
 int nrf_cloud_agps_request(const struct nrf_modem_gnss_agps_data_frame *request)
 {
 #if IS_ENABLED(CONFIG_NRF_CLOUD_MQTT)
-	if (nfsm_get_current_state() != STATE_DC_CONNECTED) {
-		return -EACCES;
-	}
-
 	int err;
 	enum nrf_cloud_agps_type types[9];
 	size_t type_count = 0;
 	cJSON *data_obj;
 	cJSON *agps_req_obj;
 
-	atomic_set(&request_in_progress, 0);
 	memset(&processed, 0, sizeof(processed));
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	struct nrf_modem_gnss_agps_data_frame missing = *request;
+
+	err = nrf_cloud_agps_cache_inject(&missing);
+	if (err) {
+		LOG_WRN("Failed to inject cached A-GPS data: %d", err);
+		missing = *request;
+	}
+	request = &missing;
+
+	if (!missing.sv_mask_ephe && !missing.sv_mask_alm && !missing.data_flags) {
+		LOG_INF("A-GPS request answered from cache");
+		return 0;
+	}
+#endif
+
+	if (nfsm_get_current_state() != STATE_DC_CONNECTED) {
+		return -EACCES;
+	}
+
+	atomic_set(&request_in_progress, 0);
+
 	if (request->data_flags & NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST) {
 		types[type_count++] = NRF_CLOUD_AGPS_UTC_PARAMETERS;
 	}
@@ -183,7 +230,7 @@ int nrf_cloud_agps_request_all(void)
 	return nrf_cloud_agps_request(&request);
 }
 
-static int send_to_modem(void *data, size_t data_len, uint16_t type)
+static int agps_write(void *data, size_t data_len, uint16_t type)
 {
 	if (agps_print_enabled) {
 		agps_print(type, data);
@@ -192,6 +239,184 @@ static int send_to_modem(void *data, size_t data_len, uint16_t type)
 	return nrf_modem_gnss_agps_write(data, data_len, type);
 }
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+static bool cache_fresh(int64_t time, int64_t max_age)
+{
+	return (max_age > 0) && ((k_uptime_get() - time) < max_age);
+}
+
+static void cache_store(const void *data, uint16_t type)
+{
+	int64_t now = k_uptime_get();
+
+	switch (type) {
+	case NRF_MODEM_GNSS_AGPS_EPHEMERIDES: {
+		const struct nrf_modem_gnss_agps_data_ephemeris *ephe = data;
+		int i = ephe->sv_id - 1;
+
+		if ((i >= 0) && (i < CACHE_NUM_SV)) {
+			cache.ephe[i] = *ephe;
+			cache.ephe_time[i] = now;
+			cache.ephe_mask |= BIT(i);
+		}
+		break;
+	}
+	case NRF_MODEM_GNSS_AGPS_ALMANAC: {
+		const struct nrf_modem_gnss_agps_data_almanac *alm = data;
+		int i = alm->sv_id - 1;
+
+		if ((i >= 0) && (i < CACHE_NUM_SV)) {
+			cache.alm[i] = *alm;
+			cache.alm_time[i] = now;
+			cache.alm_mask |= BIT(i);
+		}
+		break;
+	}
+	case NRF_MODEM_GNSS_AGPS_UTC_PARAMETERS:
+		cache.utc = *(const struct nrf_modem_gnss_agps_data_utc *)data;
+		cache.utc_time = now;
+		cache.flags |= NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION:
+		cache.klobuchar = *(const struct nrf_modem_gnss_agps_data_klobuchar *)data;
+		cache.klobuchar_time = now;
+		cache.flags |= NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_LOCATION:
+		cache.location = *(const struct nrf_modem_gnss_agps_data_location *)data;
+		cache.location_time = now;
+		cache.flags |= NRF_MODEM_GNSS_AGPS_POSITION_REQUEST;
+		break;
+	default:
+		/* time and integrity are only valid for a short while */
+		break;
+	}
+}
+
+/* Injects the satellites in mask if all of them are cached and fresh, as
+ * nRF Cloud sends the whole type if any of them is requested.
+ */
+static int cache_inject_sv(uint32_t *mask, void *items, size_t item_size,
+			   const int64_t *times, int64_t max_age, uint16_t type)
+{
+	uint32_t pending = *mask;
+	int err;
+	int i;
+
+	for (i = 0; i < CACHE_NUM_SV; i++) {
+		if ((pending & BIT(i)) && !cache_fresh(times[i], max_age)) {
+			return 0;
+		}
+	}
+
+	for (i = 0; i < CACHE_NUM_SV; i++) {
+		if (pending & BIT(i)) {
+			err = agps_write((uint8_t *)items + i * item_size, item_size, type);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	*mask = 0;
+	return 0;
+}
+
+static int cache_inject_item(struct nrf_modem_gnss_agps_data_frame *request,
+			     uint32_t flag, void *item, size_t item_size,
+			     int64_t time, int64_t max_age, uint16_t type)
+{
+	int err;
+
+	if (!(request->data_flags & flag) || !(cache.flags & flag) ||
+	    !cache_fresh(time, max_age)) {
+		return 0;
+	}
+
+	err = agps_write(item, item_size, type);
+	if (!err) {
+		request->data_flags &= ~flag;
+		processed.data_flags |= flag;
+	}
+	return err;
+}
+
+int nrf_cloud_agps_cache_inject(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	uint32_t ephe;
+	uint32_t alm;
+	int err;
+
+	err = k_sem_take(&agps_injection_active, K_FOREVER);
+	if (err) {
+		return err;
+	}
+
+	ephe = request->sv_mask_ephe & cache.ephe_mask;
+	alm = request->sv_mask_alm & cache.alm_mask;
+
+	if (ephe == request->sv_mask_ephe) {
+		err = cache_inject_sv(&ephe, cache.ephe, sizeof(cache.ephe[0]),
+				      cache.ephe_time, CACHE_EPHE_MAX_AGE,
+				      NRF_MODEM_GNSS_AGPS_EPHEMERIDES);
+		if (!err && !ephe) {
+			processed.sv_mask_ephe |= request->sv_mask_ephe;
+			request->sv_mask_ephe = 0;
+		}
+	}
+
+	if (!err && (alm == request->sv_mask_alm)) {
+		err = cache_inject_sv(&alm, cache.alm, sizeof(cache.alm[0]),
+				      cache.alm_time, CACHE_ALM_MAX_AGE,
+				      NRF_MODEM_GNSS_AGPS_ALMANAC);
+		if (!err && !alm) {
+			processed.sv_mask_alm |= request->sv_mask_alm;
+			request->sv_mask_alm = 0;
+		}
+	}
+
+	if (!err) {
+		err = cache_inject_item(request, NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST,
+					&cache.utc, sizeof(cache.utc), cache.utc_time,
+					CACHE_UTC_IONO_MAX_AGE,
+					NRF_MODEM_GNSS_AGPS_UTC_PARAMETERS);
+	}
+
+	if (!err) {
+		err = cache_inject_item(request, NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST,
+					&cache.klobuchar, sizeof(cache.klobuchar),
+					cache.klobuchar_time, CACHE_UTC_IONO_MAX_AGE,
+					NRF_MODEM_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION);
+	}
+
+	if (!err) {
+		err = cache_inject_item(request, NRF_MODEM_GNSS_AGPS_POSITION_REQUEST,
+					&cache.location, sizeof(cache.location),
+					cache.location_time, CACHE_LOCATION_MAX_AGE,
+					NRF_MODEM_GNSS_AGPS_LOCATION);
+	}
+
+	k_sem_give(&agps_injection_active);
+
+	LOG_DBG("A-GPS still needed from cloud: emask:0x%08X amask:0x%08X flags:0x%08X",
+		request->sv_mask_ephe, request->sv_mask_alm, request->data_flags);
+
+	return err;
+}
+#endif /* CONFIG_NRF_CLOUD_AGPS_CACHE */
+
+static int send_to_modem(void *data, size_t data_len, uint16_t type)
+{
+	int err = agps_write(data, data_len, type);
+
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	if (!err) {
+		cache_store(data, type);
+	}
+#endif
+	return err;
+}
+
 static int copy_utc(struct nrf_modem_gnss_agps_data_utc *dst,
 		    struct nrf_cloud_apgs_element *src)
 {
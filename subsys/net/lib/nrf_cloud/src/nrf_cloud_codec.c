@@ -5,6 +5,8 @@
  */
 
 #include "nrf_cloud_codec.h"
+#include "nrf_cloud_json_reader.h"
+#include "nrf_cloud_json_writer.h"
 #include "nrf_cloud_mem.h"
 #include "nrf_cloud_fsm.h"
 #include <stdbool.h>
@@ -131,23 +133,6 @@ cJSON *json_create_req_obj(const char *const app_id, const char *const msg_type)
 	return req_obj;
 }
 
-static char *json_strdup(cJSON *const string_obj)
-{
-	char *dest;
-	char *src = cJSON_GetStringValue(string_obj);
-
-	if (!src) {
-		return NULL;
-	}
-
-	dest = nrf_cloud_calloc(strlen(src) + 1, 1);
-	if (dest) {
-		strcpy(dest, src);
-	}
-
-	return dest;
-}
-
 static int get_modem_info(struct modem_param_info *const modem_info)
 {
 	__ASSERT_NO_MSG(modem_info != NULL);
@@ -232,58 +217,88 @@ static int json_add_null_cs(cJSON *parent, const char *const str)
 }
 
 #if defined(CONFIG_NRF_CLOUD_MQTT)
-static int json_add_str_cs(cJSON *parent, const char *str, const char *item)
-{
-	if (!parent || !str || !item) {
-		return -EINVAL;
-	}
+/* Shadow fields used during pairing. On initial pairing, a shadow delta event
+ * is sent which does not include the "desired" JSON key, "state" is used
+ * instead. Both variants are extracted in a single pass.
+ */
+enum shadow_field {
+	SHADOW_ROOT,
+	SHADOW_TOPIC_PRFX,
+	SHADOW_PAIRING_STATE,
+	SHADOW_TOPICS,
+	SHADOW_TOPIC_TX,
+	SHADOW_TOPIC_RX,
+	SHADOW_CFG,
+	SHADOW_FIELD_COUNT
+};
 
-	return cJSON_AddStringToObjectCS(parent, str, item) ? 0 : -ENOMEM;
-}
+/* Fields in the same order as enum shadow_field */
+#define SHADOW_PAIRING(obj)	obj "." JSON_KEY_PAIRING
+#define SHADOW_FIELDS(obj)						\
+	{ .path = obj },						\
+	{ .path = obj "." JSON_KEY_TOPIC_PRFX },			\
+	{ .path = SHADOW_PAIRING(obj) "." JSON_KEY_STATE },		\
+	{ .path = SHADOW_PAIRING(obj) "." JSON_KEY_TOPICS },		\
+	{ .path = SHADOW_PAIRING(obj) "." JSON_KEY_TOPICS		\
+		  "." JSON_KEY_DEVICE_TO_CLOUD },			\
+	{ .path = SHADOW_PAIRING(obj) "." JSON_KEY_TOPICS		\
+		  "." JSON_KEY_CLOUD_TO_DEVICE },			\
+	{ .path = obj "." JSON_KEY_CFG }
+
+static const struct nrf_cloud_json_field shadow_fields[] = {
+	SHADOW_FIELDS(JSON_KEY_STATE),
+	SHADOW_FIELDS(JSON_KEY_DES),
+};
 
-static cJSON *json_object_decode(cJSON *obj, const char *str)
-{
-	return obj ? cJSON_GetObjectItem(obj, str) : NULL;
-}
+BUILD_ASSERT(ARRAY_SIZE(shadow_fields) == (2 * SHADOW_FIELD_COUNT));
 
-static int json_decode_and_alloc(cJSON *obj, struct nrf_cloud_data *data)
+/* Extract the shadow fields straight from the receive buffer, without
+ * building a cJSON tree. On success, desired points to the fields of the
+ * "state" or "desired" object.
+ */
+static int shadow_fields_decode(const struct nrf_cloud_data *input,
+				struct nrf_cloud_json_field fields[ARRAY_SIZE(shadow_fields)],
+				struct nrf_cloud_json_field **desired)
 {
-	if (!data || !cJSON_IsString(obj)) {
-		return -EINVAL;
-	}
+	int err;
 
-	data->ptr = json_strdup(obj);
+	memcpy(fields, shadow_fields, sizeof(shadow_fields));
 
-	if (data->ptr == NULL) {
-		return -ENOMEM;
+	err = nrf_cloud_json_extract(input->ptr, input->len, fields,
+				     ARRAY_SIZE(shadow_fields));
+	if (err) {
+		return err;
 	}
 
-	data->len = strlen(data->ptr);
+	if (fields[SHADOW_ROOT].val.type != NRF_CLOUD_JSON_NONE) {
+		*desired = &fields[0];
+	} else {
+		*desired = &fields[SHADOW_FIELD_COUNT];
+	}
 
 	return 0;
 }
 
-static bool compare(const char *s1, const char *s2)
+static int json_decode_and_alloc(const struct nrf_cloud_json_value *val,
+				 struct nrf_cloud_data *data)
 {
-	return !strncmp(s1, s2, strlen(s2));
-}
+	char *ptr;
+	size_t len;
+	int err;
 
-static void nrf_cloud_decode_desired_obj(cJSON *const root_obj,
-					 cJSON **desired_obj)
-{
-	cJSON *state_obj;
-
-	if ((root_obj != NULL) && (desired_obj != NULL)) {
-		/* On initial pairing, a shadow delta event is sent */
-		/* which does not include the "desired" JSON key, */
-		/* "state" is used instead */
-		state_obj = json_object_decode(root_obj, JSON_KEY_STATE);
-		if (state_obj == NULL) {
-			*desired_obj = json_object_decode(root_obj, JSON_KEY_DES);
-		} else {
-			*desired_obj = state_obj;
-		}
+	if (!data) {
+		return -EINVAL;
+	}
+
+	err = nrf_cloud_json_strdup(val, &ptr, &len);
+	if (err) {
+		return err;
 	}
+
+	data->ptr = ptr;
+	data->len = len;
+
+	return 0;
 }
 
 int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
@@ -322,39 +337,64 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 	return ret;
 }
 
+static enum nrf_cloud_encoding sensor_encoding = NRF_CLOUD_ENCODING_JSON;
+
+int nrf_cloud_encoding_set(enum nrf_cloud_encoding encoding)
+{
+	switch (encoding) {
+	case NRF_CLOUD_ENCODING_JSON:
+		break;
+	case NRF_CLOUD_ENCODING_CBOR:
+		if (!IS_ENABLED(CONFIG_NRF_CLOUD_CBOR)) {
+			return -ENOTSUP;
+		}
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	sensor_encoding = encoding;
+
+	return 0;
+}
+
+enum nrf_cloud_encoding nrf_cloud_encoding_get(void)
+{
+	return sensor_encoding;
+}
+
+static void sensor_data_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	const struct nrf_cloud_sensor_data *sensor = ctx;
+
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_str(w, JSON_KEY_APPID, sensor_type_str[sensor->type]);
+	nrf_cloud_json_writer_str(w, JSON_KEY_DATA, sensor->data.ptr);
+	nrf_cloud_json_writer_str(w, JSON_KEY_MSGTYPE, MSGTYPE_VAL_DATA);
+	nrf_cloud_json_writer_obj_end(w);
+}
+
 int nrf_cloud_encode_sensor_data(const struct nrf_cloud_sensor_data *sensor,
 				 struct nrf_cloud_data *output)
 {
-	int ret;
-
 	__ASSERT_NO_MSG(sensor != NULL);
 	__ASSERT_NO_MSG(sensor->data.ptr != NULL);
 	__ASSERT_NO_MSG(sensor->data.len != 0);
 	__ASSERT_NO_MSG(output != NULL);
 	__ASSERT_NO_MSG(sensor->type < SENSOR_TYPE_ARRAY_SIZE);
 
-	cJSON *root_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL) {
-		return -ENOMEM;
-	}
-
-	ret = json_add_str_cs(root_obj, JSON_KEY_APPID, sensor_type_str[sensor->type]);
-	ret += json_add_str_cs(root_obj, JSON_KEY_DATA, sensor->data.ptr);
-	ret += json_add_str_cs(root_obj, JSON_KEY_MSGTYPE, MSGTYPE_VAL_DATA);
-
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
-
 	char *buffer;
+	size_t len;
+	int ret = nrf_cloud_json_encode_alloc(sensor_data_write, sensor,
+					      sensor_encoding == NRF_CLOUD_ENCODING_CBOR,
+					      &buffer, &len);
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
+	if (ret) {
+		return ret;
+	}
 
 	output->ptr = buffer;
-	output->len = strlen(buffer);
+	output->len = len;
 
 	return 0;
 }
@@ -374,74 +414,79 @@ int nrf_cloud_decode_requested_state(const struct nrf_cloud_data *input,
 	__ASSERT_NO_MSG(input->ptr != NULL);
 	__ASSERT_NO_MSG(input->len != 0);
 
-	cJSON *root_obj;
-	cJSON *desired_obj;
-	cJSON *pairing_obj;
-	cJSON *pairing_state_obj;
-	cJSON *topic_prefix_obj;
+	int err;
+	struct nrf_cloud_json_field fields[ARRAY_SIZE(shadow_fields)];
+	struct nrf_cloud_json_field *desired;
+
+#ifdef CONFIG_NRF_CLOUD_GATEWAY
+	/* The gateway state handler operates on the parsed document. */
+	cJSON *root_obj = cJSON_Parse(input->ptr);
 
-	root_obj = cJSON_Parse(input->ptr);
 	if (root_obj == NULL) {
 		LOG_ERR("cJSON_Parse failed: %s",
 			log_strdup((char *)input->ptr));
 		return -ENOENT;
 	}
 
-#ifdef CONFIG_NRF_CLOUD_GATEWAY
-	int ret;
-
 	if (gateway_state_handler) {
-		ret = gateway_state_handler(root_obj);
-		if (ret != 0) {
-			LOG_ERR("Error from gateway_state_handler: %d", ret);
-			cJSON_Delete(root_obj);
-			return ret;
+		err = gateway_state_handler(root_obj);
+		if (err != 0) {
+			LOG_ERR("Error from gateway_state_handler: %d", err);
 		}
 	} else {
 		LOG_ERR("No gateway state handler registered");
-		cJSON_Delete(root_obj);
-		return -EINVAL;
+		err = -EINVAL;
+	}
+
+	cJSON_Delete(root_obj);
+
+	if (err) {
+		return err;
 	}
 #endif /* CONFIG_NRF_CLOUD_GATEWAY */
 
-	nrf_cloud_decode_desired_obj(root_obj, &desired_obj);
+	err = shadow_fields_decode(input, fields, &desired);
+	if (err) {
+		LOG_ERR("JSON parsing failed: %d, %s", err,
+			log_strdup((char *)input->ptr));
+		return -ENOENT;
+	}
+
+	if (desired[SHADOW_TOPIC_PRFX].val.type == NRF_CLOUD_JSON_STR) {
+		char *topic_prefix;
 
-	topic_prefix_obj =
-		json_object_decode(desired_obj, JSON_KEY_TOPIC_PRFX);
-	if (topic_prefix_obj != NULL) {
-		nct_set_topic_prefix(topic_prefix_obj->valuestring);
+		err = nrf_cloud_json_strdup(&desired[SHADOW_TOPIC_PRFX].val,
+					    &topic_prefix, NULL);
+		if (err) {
+			return err;
+		}
+
+		nct_set_topic_prefix(topic_prefix);
+		nrf_cloud_free(topic_prefix);
 		(*requested_state) = STATE_UA_PIN_COMPLETE;
-		cJSON_Delete(root_obj);
 		return 0;
 	}
 
-	pairing_obj = json_object_decode(desired_obj, JSON_KEY_PAIRING);
-	pairing_state_obj = json_object_decode(pairing_obj, JSON_KEY_STATE);
+	const struct nrf_cloud_json_value *pairing_state = &desired[SHADOW_PAIRING_STATE].val;
 
-	if (!pairing_state_obj || pairing_state_obj->type != cJSON_String) {
+	if (pairing_state->type != NRF_CLOUD_JSON_STR) {
 #ifndef CONFIG_NRF_CLOUD_GATEWAY
-		if (cJSON_HasObjectItem(desired_obj, JSON_KEY_CFG) == false) {
+		if (desired[SHADOW_CFG].val.type == NRF_CLOUD_JSON_NONE) {
 			LOG_WRN("Unhandled data received from nRF Cloud.");
 			LOG_INF("Ensure device firmware is up to date.");
 			LOG_INF("Delete and re-add device to nRF Cloud if problem persists.");
 		}
 #endif
-		cJSON_Delete(root_obj);
 		return -ENOENT;
 	}
 
-	const char *state_str = pairing_state_obj->valuestring;
-
-	if (compare(state_str, DUA_PIN_STR)) {
+	if (nrf_cloud_json_str_prefix(pairing_state, DUA_PIN_STR)) {
 		(*requested_state) = STATE_UA_PIN_WAIT;
 	} else {
 		LOG_ERR("Deprecated state. Delete device from nRF Cloud and update device with JITP certificates.");
-		cJSON_Delete(root_obj);
 		return -ENOTSUP;
 	}
 
-	cJSON_Delete(root_obj);
-
 	return 0;
 }
 
@@ -518,78 +563,99 @@ int nrf_cloud_encode_config_response(struct nrf_cloud_data const *const input,
 	return 0;
 }
 
-int nrf_cloud_encode_state(uint32_t reported_state, struct nrf_cloud_data *output)
+static void state_pin_wait_write(struct nrf_cloud_json_writer *w, const void *ctx)
 {
-	__ASSERT_NO_MSG(output != NULL);
+	ARG_UNUSED(ctx);
 
-	char *buffer;
-	int ret = 0;
-	cJSON *root_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_AddObjectToObjectCS(root_obj, JSON_KEY_STATE);
-	cJSON *reported_obj = cJSON_AddObjectToObjectCS(state_obj, JSON_KEY_REP);
-	cJSON *pairing_obj = cJSON_AddObjectToObjectCS(reported_obj, JSON_KEY_PAIRING);
-	cJSON *connection_obj = cJSON_AddObjectToObjectCS(reported_obj, JSON_KEY_CONN);
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_STATE);
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_REP);
 
-	if (!pairing_obj || !connection_obj) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_PAIRING);
+	nrf_cloud_json_writer_str(w, JSON_KEY_STATE, DUA_PIN_STR);
+	nrf_cloud_json_writer_null(w, JSON_KEY_TOPICS);
+	nrf_cloud_json_writer_null(w, JSON_KEY_CFG);
+	nrf_cloud_json_writer_obj_end(w);
 
-	switch (reported_state) {
-	case STATE_UA_PIN_WAIT: {
-		ret += json_add_str_cs(pairing_obj, JSON_KEY_STATE, DUA_PIN_STR);
-		ret += json_add_null_cs(pairing_obj, JSON_KEY_TOPICS);
-		ret += json_add_null_cs(pairing_obj, JSON_KEY_CFG);
-		ret += json_add_null_cs(reported_obj, JSON_KEY_STAGE);
-		ret += json_add_null_cs(reported_obj, JSON_KEY_TOPIC_PRFX);
-		ret += json_add_null_cs(connection_obj, JSON_KEY_KEEPALIVE);
-		break;
-	}
-	case STATE_UA_PIN_COMPLETE: {
-		struct nrf_cloud_data rx_endp;
-		struct nrf_cloud_data tx_endp;
-		struct nrf_cloud_data m_endp;
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_CONN);
+	nrf_cloud_json_writer_null(w, JSON_KEY_KEEPALIVE);
+	nrf_cloud_json_writer_obj_end(w);
 
-		/* Get the endpoint information. */
-		nct_dc_endpoint_get(&tx_endp, &rx_endp, NULL, &m_endp);
-		ret += json_add_str_cs(reported_obj, JSON_KEY_TOPIC_PRFX, m_endp.ptr);
+	nrf_cloud_json_writer_null(w, JSON_KEY_STAGE);
+	nrf_cloud_json_writer_null(w, JSON_KEY_TOPIC_PRFX);
 
-		/* Clear pairing config and pairingStatus fields. */
-		ret += json_add_str_cs(pairing_obj, JSON_KEY_STATE, PAIRED_STR);
-		ret += json_add_null_cs(pairing_obj, JSON_KEY_CFG);
-		ret += json_add_null_cs(reported_obj, JSON_KEY_PAIR_STAT);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
 
-		/* Report keepalive value. */
-		ret += json_add_num_cs(connection_obj, JSON_KEY_KEEPALIVE,
-				       CONFIG_NRF_CLOUD_MQTT_KEEPALIVE);
+static void state_pin_complete_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	ARG_UNUSED(ctx);
+
+	struct nrf_cloud_data rx_endp;
+	struct nrf_cloud_data tx_endp;
+	struct nrf_cloud_data m_endp;
+
+	/* Get the endpoint information. */
+	nct_dc_endpoint_get(&tx_endp, &rx_endp, NULL, &m_endp);
+
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_STATE);
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_REP);
+
+	/* Clear pairing config and report pairing topics. */
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_PAIRING);
+	nrf_cloud_json_writer_str(w, JSON_KEY_STATE, PAIRED_STR);
+	nrf_cloud_json_writer_null(w, JSON_KEY_CFG);
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_TOPICS);
+	nrf_cloud_json_writer_str(w, JSON_KEY_DEVICE_TO_CLOUD, tx_endp.ptr);
+	nrf_cloud_json_writer_str(w, JSON_KEY_CLOUD_TO_DEVICE, rx_endp.ptr);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+
+	/* Report keepalive value. */
+	nrf_cloud_json_writer_obj_start(w, JSON_KEY_CONN);
+	nrf_cloud_json_writer_num(w, JSON_KEY_KEEPALIVE, CONFIG_NRF_CLOUD_MQTT_KEEPALIVE);
+	nrf_cloud_json_writer_obj_end(w);
+
+	nrf_cloud_json_writer_str(w, JSON_KEY_TOPIC_PRFX, m_endp.ptr);
+
+	/* Clear pairingStatus field. */
+	nrf_cloud_json_writer_null(w, JSON_KEY_PAIR_STAT);
+
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
 
-		/* Report pairing topics. */
-		cJSON *topics_obj = cJSON_AddObjectToObjectCS(pairing_obj, JSON_KEY_TOPICS);
+int nrf_cloud_encode_state(uint32_t reported_state, struct nrf_cloud_data *output)
+{
+	__ASSERT_NO_MSG(output != NULL);
 
-		ret += json_add_str_cs(topics_obj, JSON_KEY_DEVICE_TO_CLOUD, tx_endp.ptr);
-		ret += json_add_str_cs(topics_obj, JSON_KEY_CLOUD_TO_DEVICE, rx_endp.ptr);
+	nrf_cloud_json_encode_fn write_fn;
 
-		if (ret != 0) {
-			cJSON_Delete(root_obj);
-			return -ENOMEM;
-		}
+	switch (reported_state) {
+	case STATE_UA_PIN_WAIT:
+		write_fn = state_pin_wait_write;
 		break;
-	}
-	default: {
-		cJSON_Delete(root_obj);
+	case STATE_UA_PIN_COMPLETE:
+		write_fn = state_pin_complete_write;
+		break;
+	default:
 		return -ENOTSUP;
 	}
-	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
+	char *buffer;
+	size_t len;
+	int ret = nrf_cloud_json_encode_alloc(write_fn, NULL, false, &buffer, &len);
 
-	if (buffer == NULL) {
-		return -ENOMEM;
+	if (ret) {
+		return ret;
 	}
 
 	output->ptr = buffer;
-	output->len = strlen(buffer);
+	output->len = len;
 
 	return 0;
 }
@@ -615,52 +681,29 @@ int nrf_cloud_decode_data_endpoint(const struct nrf_cloud_data *input,
 	__ASSERT_NO_MSG(bulk_endpoint != NULL);
 
 	int err;
-	cJSON *root_obj;
-	cJSON *m_endpoint_obj = NULL;
-	cJSON *desired_obj = NULL;
+	struct nrf_cloud_json_field fields[ARRAY_SIZE(shadow_fields)];
+	struct nrf_cloud_json_field *desired;
 
-	root_obj = cJSON_Parse(input->ptr);
-	if (root_obj == NULL) {
-		return -ENOENT;
-	}
-
-	nrf_cloud_decode_desired_obj(root_obj, &desired_obj);
-
-	if (m_endpoint != NULL) {
-		m_endpoint_obj = json_object_decode(
-			desired_obj, "nrfcloud_mqtt_topic_prefix");
-	}
-
-	cJSON *pairing_obj = json_object_decode(desired_obj, JSON_KEY_PAIRING);
-	cJSON *pairing_state_obj = json_object_decode(pairing_obj, JSON_KEY_STATE);
-	cJSON *topic_obj = json_object_decode(pairing_obj, JSON_KEY_TOPICS);
-
-	if ((pairing_state_obj == NULL) || (topic_obj == NULL) ||
-	    (pairing_state_obj->type != cJSON_String)) {
-		cJSON_Delete(root_obj);
+	err = shadow_fields_decode(input, fields, &desired);
+	if (err) {
 		return -ENOENT;
 	}
 
-	const char *state_str = pairing_state_obj->valuestring;
-
-	if (!compare(state_str, PAIRED_STR)) {
-		cJSON_Delete(root_obj);
+	if ((desired[SHADOW_TOPICS].val.type == NRF_CLOUD_JSON_NONE) ||
+	    !nrf_cloud_json_str_prefix(&desired[SHADOW_PAIRING_STATE].val, PAIRED_STR)) {
 		return -ENOENT;
 	}
 
-	if (m_endpoint_obj != NULL) {
-		err = json_decode_and_alloc(m_endpoint_obj, m_endpoint);
+	if ((m_endpoint != NULL) &&
+	    (desired[SHADOW_TOPIC_PRFX].val.type != NRF_CLOUD_JSON_NONE)) {
+		err = json_decode_and_alloc(&desired[SHADOW_TOPIC_PRFX].val, m_endpoint);
 		if (err) {
-			cJSON_Delete(root_obj);
 			return err;
 		}
 	}
 
-	cJSON *tx_obj = json_object_decode(topic_obj, JSON_KEY_DEVICE_TO_CLOUD);
-
-	err = json_decode_and_alloc(tx_obj, tx_endpoint);
+	err = json_decode_and_alloc(&desired[SHADOW_TOPIC_TX].val, tx_endpoint);
 	if (err) {
-		cJSON_Delete(root_obj);
 		LOG_ERR("could not decode topic for %s", JSON_KEY_DEVICE_TO_CLOUD);
 		return err;
 	}
@@ -672,7 +715,6 @@ int nrf_cloud_decode_data_endpoint(const struct nrf_cloud_data *input,
 
 	bulk_endpoint->ptr = nrf_cloud_calloc(bulk_ep_len_temp, 1);
 	if (bulk_endpoint->ptr == NULL) {
-		cJSON_Delete(root_obj);
 		LOG_ERR("Could not allocate memory for bulk topic");
 		return -ENOMEM;
 	}
@@ -681,17 +723,12 @@ int nrf_cloud_decode_data_endpoint(const struct nrf_cloud_data *input,
 				       (char *)tx_endpoint->ptr,
 				       JSON_KEY_TOPIC_BULK);
 
-	cJSON *rx_obj = json_object_decode(topic_obj, JSON_KEY_CLOUD_TO_DEVICE);
-
-	err = json_decode_and_alloc(rx_obj, rx_endpoint);
+	err = json_decode_and_alloc(&desired[SHADOW_TOPIC_RX].val, rx_endpoint);
 	if (err) {
-		cJSON_Delete(root_obj);
 		LOG_ERR("could not decode topic for %s", JSON_KEY_CLOUD_TO_DEVICE);
 		return err;
 	}
 
-	cJSON_Delete(root_obj);
-
 	return err;
 }
 
@@ -1073,75 +1110,80 @@ int nrf_cloud_rest_fota_execution_parse(const char *const response,
 		return -EINVAL;
 	}
 
-	int ret = 0;
-	char *type;
-	cJSON *path_obj;
-	cJSON *host_obj;
-	cJSON *type_obj;
-	cJSON *size_obj;
-
-	cJSON *resp_obj = cJSON_Parse(response);
-	cJSON *job_doc  = cJSON_GetObjectItem(resp_obj, NRF_CLOUD_FOTA_REST_KEY_JOB_DOC);
-	cJSON *id_obj   = cJSON_GetObjectItem(resp_obj, NRF_CLOUD_FOTA_REST_KEY_JOB_ID);
+	enum {
+		FOTA_JOB_ID,
+		FOTA_JOB_DOC,
+		FOTA_PATH,
+		FOTA_HOST,
+		FOTA_TYPE,
+		FOTA_SIZE,
+		FOTA_FIELD_COUNT
+	};
+	struct nrf_cloud_json_field fields[FOTA_FIELD_COUNT] = {
+		[FOTA_JOB_ID]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_ID },
+		[FOTA_JOB_DOC]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_DOC },
+		[FOTA_PATH]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_DOC "."
+					    NRF_CLOUD_FOTA_REST_KEY_PATH },
+		[FOTA_HOST]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_DOC "."
+					    NRF_CLOUD_FOTA_REST_KEY_HOST },
+		[FOTA_TYPE]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_DOC "."
+					    NRF_CLOUD_FOTA_REST_KEY_TYPE },
+		[FOTA_SIZE]	= { .path = NRF_CLOUD_FOTA_REST_KEY_JOB_DOC "."
+					    NRF_CLOUD_FOTA_REST_KEY_SIZE },
+	};
+	const struct nrf_cloud_json_value *type;
+	int ret;
 
 	memset(job, 0, sizeof(*job));
 
-	if (!job_doc || !id_obj) {
+	/* A malformed response is reported as missing fields. */
+	(void)nrf_cloud_json_extract(response, strlen(response), fields, ARRAY_SIZE(fields));
+
+	if ((fields[FOTA_JOB_DOC].val.type == NRF_CLOUD_JSON_NONE) ||
+	    (fields[FOTA_JOB_ID].val.type == NRF_CLOUD_JSON_NONE)) {
 		ret = -EBADMSG;
 		goto err_cleanup;
 	}
 
-	path_obj = cJSON_GetObjectItem(job_doc, NRF_CLOUD_FOTA_REST_KEY_PATH);
-	host_obj = cJSON_GetObjectItem(job_doc, NRF_CLOUD_FOTA_REST_KEY_HOST);
-	type_obj = cJSON_GetObjectItem(job_doc, NRF_CLOUD_FOTA_REST_KEY_TYPE);
-	size_obj = cJSON_GetObjectItem(job_doc, NRF_CLOUD_FOTA_REST_KEY_SIZE);
-
-	if (!id_obj || !path_obj || !host_obj || !type_obj || !size_obj) {
-		ret = -EFTYPE;
-		goto err_cleanup;
+	for (size_t i = FOTA_PATH; i < FOTA_FIELD_COUNT; i++) {
+		if (fields[i].val.type == NRF_CLOUD_JSON_NONE) {
+			ret = -EFTYPE;
+			goto err_cleanup;
+		}
 	}
 
-	if (!cJSON_IsNumber(size_obj)) {
+	if (nrf_cloud_json_to_int(&fields[FOTA_SIZE].val, &job->file_size)) {
 		ret = -ENOMSG;
 		goto err_cleanup;
 	}
-	job->file_size	= size_obj->valueint;
-
-	job->id		= json_strdup(id_obj);
-	job->path	= json_strdup(path_obj);
-	job->host	= json_strdup(host_obj);
 
-	if (!job->id || !job->path || !job->host) {
+	if (nrf_cloud_json_strdup(&fields[FOTA_JOB_ID].val, &job->id, NULL) ||
+	    nrf_cloud_json_strdup(&fields[FOTA_PATH].val, &job->path, NULL) ||
+	    nrf_cloud_json_strdup(&fields[FOTA_HOST].val, &job->host, NULL)) {
 		ret = -ENOSTR;
 		goto err_cleanup;
 	}
 
-	type = cJSON_GetStringValue(type_obj);
-	if (!type) {
+	type = &fields[FOTA_TYPE].val;
+	if (type->type != NRF_CLOUD_JSON_STR) {
 		ret = -ENODATA;
 		goto err_cleanup;
 	}
 
-	if (!strcmp(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_MODEM)) {
+	if (nrf_cloud_json_str_eq(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_MODEM)) {
 		job->type = NRF_CLOUD_FOTA_MODEM;
-	} else if (!strcmp(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_BOOT)) {
+	} else if (nrf_cloud_json_str_eq(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_BOOT)) {
 		job->type = NRF_CLOUD_FOTA_BOOTLOADER;
-	} else if (!strcmp(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_APP)) {
+	} else if (nrf_cloud_json_str_eq(type, NRF_CLOUD_FOTA_REST_VAL_TYPE_APP)) {
 		job->type = NRF_CLOUD_FOTA_APPLICATION;
 	} else {
-		LOG_WRN("Unhandled FOTA type: %s", log_strdup(type));
+		LOG_WRN("Unhandled FOTA type: %.*s", (int)type->len, log_strdup(type->ptr));
 		job->type = NRF_CLOUD_FOTA_TYPE__INVALID;
 	}
 
-	cJSON_Delete(resp_obj);
-
 	return 0;
 
 err_cleanup:
-	if (resp_obj) {
-		cJSON_Delete(resp_obj);
-	}
-
 	nrf_cloud_fota_job_free(job);
 	memset(job, 0, sizeof(*job));
 	job->type = NRF_CLOUD_FOTA_TYPE__INVALID;
@@ -1386,6 +1428,93 @@ cleanup:
 	return -ENOMEM;
 }
 
+struct cell_pos_req_ctx {
+	struct lte_lc_cells_info const *inf;
+	size_t inf_cnt;
+};
+
+static void cell_pos_req_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	const struct cell_pos_req_ctx *req = ctx;
+
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_arr_start(w, NRF_CLOUD_CELL_POS_JSON_KEY_LTE);
+
+	for (size_t i = 0; i < req->inf_cnt; ++i) {
+		struct lte_lc_cells_info const *const lte = (req->inf + i);
+		struct lte_lc_cell const *const cur = &lte->current_cell;
+
+		nrf_cloud_json_writer_obj_start(w, NULL);
+
+		/* required items */
+		nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_ECI, cur->id);
+		nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_MCC, cur->mcc);
+		nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_MNC, cur->mnc);
+		nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_TAC, cur->tac);
+
+		/* optional */
+		if (cur->earfcn != NRF_CLOUD_CELL_POS_OMIT_EARFCN) {
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_EARFCN,
+						  cur->earfcn);
+		}
+
+		if (cur->rsrp != NRF_CLOUD_CELL_POS_OMIT_RSRP) {
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_RSRP,
+						  RSRP_ADJ(cur->rsrp));
+		}
+
+		if (cur->rsrq != NRF_CLOUD_CELL_POS_OMIT_RSRQ) {
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_RSRQ,
+						  RSRQ_ADJ(cur->rsrq));
+		}
+
+		if (cur->timing_advance != NRF_CLOUD_CELL_POS_OMIT_TIME_ADV) {
+			uint16_t t_adv = MIN(cur->timing_advance,
+					     NRF_CLOUD_CELL_POS_TIME_ADV_MAX);
+
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_T_ADV, t_adv);
+		}
+
+		/* Add an array for neighbor cell data if there are any */
+		if (lte->ncells_count) {
+			nrf_cloud_json_writer_arr_start(w, NRF_CLOUD_CELL_POS_JSON_KEY_NBORS);
+		}
+
+		for (uint8_t j = 0; j < lte->ncells_count; ++j) {
+			struct lte_lc_ncell *ncell = lte->neighbor_cells + j;
+
+			nrf_cloud_json_writer_obj_start(w, NULL);
+
+			/* required items */
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_EARFCN,
+						  ncell->earfcn);
+			nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_PCI,
+						  ncell->phys_cell_id);
+
+			/* optional */
+			if (ncell->rsrp != NRF_CLOUD_CELL_POS_OMIT_RSRP) {
+				nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_RSRP,
+							  RSRP_ADJ(ncell->rsrp));
+			}
+			if (ncell->rsrq != NRF_CLOUD_CELL_POS_OMIT_RSRQ) {
+				nrf_cloud_json_writer_num(w, NRF_CLOUD_CELL_POS_JSON_KEY_RSRQ,
+							  RSRQ_ADJ(ncell->rsrq));
+			}
+
+			nrf_cloud_json_writer_obj_end(w);
+		}
+
+		if (lte->ncells_count) {
+			nrf_cloud_json_writer_arr_end(w);
+		}
+
+		nrf_cloud_json_writer_obj_end(w);
+	}
+
+	nrf_cloud_json_writer_arr_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
+
 int nrf_cloud_format_cell_pos_req(struct lte_lc_cells_info const *const inf,
 	size_t inf_cnt, char **string_out)
 {
@@ -1393,22 +1522,18 @@ int nrf_cloud_format_cell_pos_req(struct lte_lc_cells_info const *const inf,
 		return -EINVAL;
 	}
 
-	int err = 0;
-	cJSON *req_obj = cJSON_CreateObject();
+	const struct cell_pos_req_ctx ctx = {
+		.inf = inf,
+		.inf_cnt = inf_cnt,
+	};
 
-	err = nrf_cloud_format_cell_pos_req_json(inf, inf_cnt, req_obj);
-	if (err) {
-		goto cleanup;
-	}
+	int err = nrf_cloud_json_encode_alloc(cell_pos_req_write, &ctx, false, string_out,
+					      NULL);
 
-	*string_out = cJSON_PrintUnformatted(req_obj);
-	if (*string_out == NULL) {
-		err = -ENOMEM;
+	if (err) {
+		LOG_ERR("Failed to format location request, error: %d", err);
 	}
 
-cleanup:
-	cJSON_Delete(req_obj);
-
 	return err;
 }
 
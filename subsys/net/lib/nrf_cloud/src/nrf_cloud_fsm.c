@@ -7,6 +7,9 @@
 #include "nrf_cloud_fsm.h"
 #include "nrf_cloud_codec.h"
 #include "nrf_cloud_mem.h"
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+#include "nrf_cloud_outbox.h"
+#endif
 
 #include <zephyr.h>
 #include <logging/log.h>
@@ -488,6 +491,12 @@ static int dc_connection_handler(const struct nct_evt *nct_evt)
 		};
 
 		nfsm_set_current_state_and_notify(STATE_DC_CONNECTED, &evt);
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+		/* Entered both after subscribing to the data channel and when a
+		 * persistent session skips the subscription.
+		 */
+		nct_outbox_connected();
+#endif
 	}
 	return 0;
 }
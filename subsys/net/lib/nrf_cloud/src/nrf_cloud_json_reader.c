@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nrf_cloud_json_reader.h"
+#include "nrf_cloud_mem.h"
+
+#define NUM_BUF_SIZE	64
+
+struct parser {
+	const char *p;
+	const char *end;
+};
+
+static bool is_digit(char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+static int hex_val(char c)
+{
+	if (is_digit(c)) {
+		return c - '0';
+	} else if ((c >= 'a') && (c <= 'f')) {
+		return c - 'a' + 10;
+	} else if ((c >= 'A') && (c <= 'F')) {
+		return c - 'A' + 10;
+	}
+
+	return -1;
+}
+
+static void skip_ws(struct parser *ps)
+{
+	while ((ps->p < ps->end) &&
+	       ((*ps->p == ' ') || (*ps->p == '\t') ||
+		(*ps->p == '\n') || (*ps->p == '\r'))) {
+		ps->p++;
+	}
+}
+
+static bool accept(struct parser *ps, char c)
+{
+	if ((ps->p < ps->end) && (*ps->p == c)) {
+		ps->p++;
+		return true;
+	}
+
+	return false;
+}
+
+static int scan_digits(struct parser *ps)
+{
+	const char *start = ps->p;
+
+	while ((ps->p < ps->end) && is_digit(*ps->p)) {
+		ps->p++;
+	}
+
+	return (ps->p == start) ? -EBADMSG : 0;
+}
+
+static int scan_string(struct parser *ps, struct nrf_cloud_json_value *val)
+{
+	if (!accept(ps, '"')) {
+		return -EBADMSG;
+	}
+
+	val->type = NRF_CLOUD_JSON_STR;
+	val->ptr = ps->p;
+
+	while (ps->p < ps->end) {
+		char c = *ps->p++;
+
+		if (c == '"') {
+			val->len = ps->p - 1 - val->ptr;
+			return 0;
+		}
+
+		if (c != '\\') {
+			continue;
+		}
+
+		if (ps->p == ps->end) {
+			break;
+		}
+
+		switch (*ps->p++) {
+		case '"':
+		case '\\':
+		case '/':
+		case 'b':
+		case 'f':
+		case 'n':
+		case 'r':
+		case 't':
+			break;
+		case 'u':
+			for (int i = 0; i < 4; i++) {
+				if ((ps->p == ps->end) || (hex_val(*ps->p) < 0)) {
+					return -EBADMSG;
+				}
+				ps->p++;
+			}
+			break;
+		default:
+			return -EBADMSG;
+		}
+	}
+
+	return -EBADMSG;
+}
+
+static int scan_number(struct parser *ps, struct nrf_cloud_json_value *val)
+{
+	val->type = NRF_CLOUD_JSON_NUM;
+	val->ptr = ps->p;
+
+	(void)accept(ps, '-');
+
+	if (!accept(ps, '0') && scan_digits(ps)) {
+		return -EBADMSG;
+	}
+
+	if (accept(ps, '.') && scan_digits(ps)) {
+		return -EBADMSG;
+	}
+
+	if (accept(ps, 'e') || accept(ps, 'E')) {
+		if (!accept(ps, '+')) {
+			(void)accept(ps, '-');
+		}
+		if (scan_digits(ps)) {
+			return -EBADMSG;
+		}
+	}
+
+	val->len = ps->p - val->ptr;
+
+	return 0;
+}
+
+static int scan_literal(struct parser *ps, struct nrf_cloud_json_value *val,
+			const char *lit, enum nrf_cloud_json_type type)
+{
+	size_t len = strlen(lit);
+
+	if (((size_t)(ps->end - ps->p) < len) || memcmp(ps->p, lit, len)) {
+		return -EBADMSG;
+	}
+
+	val->type = type;
+	val->ptr = ps->p;
+	val->len = len;
+	ps->p += len;
+
+	return 0;
+}
+
+static int scan_scalar(struct parser *ps, struct nrf_cloud_json_value *val)
+{
+	switch (*ps->p) {
+	case '"':
+		return scan_string(ps, val);
+	case 't':
+		return scan_literal(ps, val, "true", NRF_CLOUD_JSON_TRUE);
+	case 'f':
+		return scan_literal(ps, val, "false", NRF_CLOUD_JSON_FALSE);
+	case 'n':
+		return scan_literal(ps, val, "null", NRF_CLOUD_JSON_NULL);
+	default:
+		return scan_number(ps, val);
+	}
+}
+
+static int scan_key(struct parser *ps, struct nrf_cloud_json_reader_frame *frame)
+{
+	struct nrf_cloud_json_value key;
+	int err;
+
+	skip_ws(ps);
+
+	err = scan_string(ps, &key);
+	if (err) {
+		return err;
+	}
+
+	frame->key = key.ptr;
+	frame->key_len = key.len;
+
+	skip_ws(ps);
+
+	return accept(ps, ':') ? 0 : -EBADMSG;
+}
+
+int nrf_cloud_json_parse(const char *buf, size_t len, nrf_cloud_json_value_cb cb,
+			 void *ctx)
+{
+	if (!buf) {
+		return -EINVAL;
+	}
+
+	struct nrf_cloud_json_reader r = { .depth = 0 };
+	struct nrf_cloud_json_reader_frame *frame;
+	struct nrf_cloud_json_value val;
+	struct parser ps = {
+		.p = buf,
+		.end = buf + strnlen(buf, len),
+	};
+	bool close = false;
+	int err;
+
+	for (;;) {
+		skip_ws(&ps);
+		if (ps.p == ps.end) {
+			return -EBADMSG;
+		}
+
+		if ((*ps.p == '{') || (*ps.p == '[')) {
+			if (r.depth == NRF_CLOUD_JSON_READER_MAX_DEPTH) {
+				return -E2BIG;
+			}
+
+			frame = &r.frame[r.depth++];
+			frame->is_arr = (*ps.p == '[');
+			frame->start = ps.p++;
+			frame->key = NULL;
+			frame->key_len = 0;
+
+			skip_ws(&ps);
+			if ((ps.p < ps.end) && (*ps.p == (frame->is_arr ? ']' : '}'))) {
+				close = true;
+			} else if (frame->is_arr) {
+				continue;
+			} else {
+				err = scan_key(&ps, frame);
+				if (err) {
+					return err;
+				}
+				continue;
+			}
+		} else {
+			err = scan_scalar(&ps, &val);
+			if (err) {
+				return err;
+			}
+
+			err = cb ? cb(&r, &val, ctx) : 0;
+			if (err) {
+				return err;
+			}
+		}
+
+		/* Close finished containers until the next value is expected. */
+		for (;;) {
+			if (close) {
+				close = false;
+				frame = &r.frame[--r.depth];
+				ps.p++;
+
+				val.type = frame->is_arr ? NRF_CLOUD_JSON_ARR : NRF_CLOUD_JSON_OBJ;
+				val.ptr = frame->start;
+				val.len = ps.p - frame->start;
+
+				err = cb ? cb(&r, &val, ctx) : 0;
+				if (err) {
+					return err;
+				}
+			}
+
+			skip_ws(&ps);
+
+			if (r.depth == 0) {
+				return (ps.p == ps.end) ? 0 : -EBADMSG;
+			}
+
+			frame = &r.frame[r.depth - 1];
+
+			if (accept(&ps, ',')) {
+				if (!frame->is_arr) {
+					err = scan_key(&ps, frame);
+					if (err) {
+						return err;
+					}
+				}
+				break;
+			}
+
+			if ((ps.p < ps.end) && (*ps.p == (frame->is_arr ? ']' : '}'))) {
+				close = true;
+				continue;
+			}
+
+			return -EBADMSG;
+		}
+	}
+}
+
+bool nrf_cloud_json_path_match(const struct nrf_cloud_json_reader *r,
+			       const char *path)
+{
+	for (size_t i = 0; i < r->depth; i++) {
+		const struct nrf_cloud_json_reader_frame *frame = &r->frame[i];
+		const char *sep = strchr(path, '.');
+		size_t seg_len = sep ? (size_t)(sep - path) : strlen(path);
+
+		if (!frame->key || (frame->key_len != seg_len) ||
+		    memcmp(frame->key, path, seg_len)) {
+			return false;
+		}
+
+		/* Path must continue as long as there are frames left. */
+		if (!sep) {
+			return (i == (r->depth - 1U));
+		}
+
+		path = sep + 1;
+	}
+
+	return false;
+}
+
+struct extract_ctx {
+	struct nrf_cloud_json_field *fields;
+	size_t field_cnt;
+};
+
+static int extract_cb(const struct nrf_cloud_json_reader *r,
+		      const struct nrf_cloud_json_value *val, void *ctx)
+{
+	struct extract_ctx *ec = ctx;
+
+	for (size_t i = 0; i < ec->field_cnt; i++) {
+		struct nrf_cloud_json_field *field = &ec->fields[i];
+
+		if ((field->val.type == NRF_CLOUD_JSON_NONE) &&
+		    nrf_cloud_json_path_match(r, field->path)) {
+			field->val = *val;
+		}
+	}
+
+	return 0;
+}
+
+int nrf_cloud_json_extract(const char *buf, size_t len,
+			   struct nrf_cloud_json_field *fields, size_t field_cnt)
+{
+	struct extract_ctx ec = {
+		.fields = fields,
+		.field_cnt = field_cnt,
+	};
+
+	for (size_t i = 0; i < field_cnt; i++) {
+		memset(&fields[i].val, 0, sizeof(fields[i].val));
+	}
+
+	return nrf_cloud_json_parse(buf, len, extract_cb, &ec);
+}
+
+bool nrf_cloud_json_str_eq(const struct nrf_cloud_json_value *val,
+			   const char *str)
+{
+	return (val->type == NRF_CLOUD_JSON_STR) && (val->len == strlen(str)) &&
+	       !memcmp(val->ptr, str, val->len);
+}
+
+bool nrf_cloud_json_str_prefix(const struct nrf_cloud_json_value *val,
+			       const char *str)
+{
+	size_t len = strlen(str);
+
+	return (val->type == NRF_CLOUD_JSON_STR) && (val->len >= len) &&
+	       !memcmp(val->ptr, str, len);
+}
+
+static uint32_t parse_hex4(const char *p)
+{
+	uint32_t cp = 0;
+
+	for (int i = 0; i < 4; i++) {
+		cp = (cp << 4) | hex_val(p[i]);
+	}
+
+	return cp;
+}
+
+static size_t put_utf8(char *out, uint32_t cp)
+{
+	if (cp < 0x80) {
+		out[0] = cp;
+		return 1;
+	} else if (cp < 0x800) {
+		out[0] = 0xC0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3F);
+		return 2;
+	} else if (cp < 0x10000) {
+		out[0] = 0xE0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3F);
+		out[2] = 0x80 | (cp & 0x3F);
+		return 3;
+	}
+
+	out[0] = 0xF0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3F);
+	out[2] = 0x80 | ((cp >> 6) & 0x3F);
+	out[3] = 0x80 | (cp & 0x3F);
+	return 4;
+}
+
+int nrf_cloud_json_strdup(const struct nrf_cloud_json_value *val, char **out,
+			  size_t *out_len)
+{
+	if (!val || !out || (val->type != NRF_CLOUD_JSON_STR)) {
+		return -EINVAL;
+	}
+
+	/* Unescaped string is never longer than the escaped one. */
+	char *dest = nrf_cloud_malloc(val->len + 1);
+	const char *src = val->ptr;
+	const char *end = val->ptr + val->len;
+	size_t len = 0;
+
+	if (!dest) {
+		return -ENOMEM;
+	}
+
+	while (src < end) {
+		char c = *src++;
+
+		if (c != '\\') {
+			dest[len++] = c;
+			continue;
+		}
+
+		/* Escapes were validated by the parser. */
+		c = *src++;
+		switch (c) {
+		case 'b':
+			dest[len++] = '\b';
+			break;
+		case 'f':
+			dest[len++] = '\f';
+			break;
+		case 'n':
+			dest[len++] = '\n';
+			break;
+		case 'r':
+			dest[len++] = '\r';
+			break;
+		case 't':
+			dest[len++] = '\t';
+			break;
+		case 'u': {
+			uint32_t cp = parse_hex4(src);
+
+			src += 4;
+
+			/* Combine UTF-16 surrogate pairs. */
+			if ((cp >= 0xD800) && (cp <= 0xDBFF) && ((end - src) >= 6) &&
+			    (src[0] == '\\') && (src[1] == 'u')) {
+				uint32_t low = parse_hex4(&src[2]);
+
+				if ((low >= 0xDC00) && (low <= 0xDFFF)) {
+					cp = 0x10000 + (((cp & 0x3FF) << 10) | (low & 0x3FF));
+					src += 6;
+				}
+			}
+
+			len += put_utf8(&dest[len], cp);
+			break;
+		}
+		default:
+			dest[len++] = c;
+			break;
+		}
+	}
+
+	dest[len] = '\0';
+	*out = dest;
+
+	if (out_len) {
+		*out_len = len;
+	}
+
+	return 0;
+}
+
+int nrf_cloud_json_to_int(const struct nrf_cloud_json_value *val, int *out)
+{
+	char num[NUM_BUF_SIZE];
+	double d;
+
+	if (!val || !out || (val->type != NRF_CLOUD_JSON_NUM) ||
+	    (val->len >= sizeof(num))) {
+		return -EINVAL;
+	}
+
+	memcpy(num, val->ptr, val->len);
+	num[val->len] = '\0';
+	d = strtod(num, NULL);
+
+	if (d >= INT_MAX) {
+		*out = INT_MAX;
+	} else if (d <= (double)INT_MIN) {
+		*out = INT_MIN;
+	} else {
+		*out = (int)d;
+	}
+
+	return 0;
+}
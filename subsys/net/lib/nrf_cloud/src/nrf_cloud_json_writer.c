@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nrf_cloud_json_writer.h"
+#include "nrf_cloud_mem.h"
+
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+#define IS_CBOR(w) ((w)->cbor)
+
+static int cbor_out_write(struct cbor_encoder_writer *out, const char *data, int len)
+{
+	struct nrf_cloud_json_writer *w =
+		CONTAINER_OF(out, struct nrf_cloud_json_writer, cbor_out);
+
+	json_writer_raw(&w->json, data, len);
+	out->bytes_written += len;
+
+	/* Buffer overflow is latched by the JSON writer. */
+	return CborNoError;
+}
+
+static CborEncoder *cbor_enc(struct nrf_cloud_json_writer *w)
+{
+	return &w->enc[w->cbor_depth];
+}
+
+static void cbor_check(struct nrf_cloud_json_writer *w, CborError err)
+{
+	if (err != CborNoError) {
+		json_writer_error(&w->json, -EINVAL);
+	}
+}
+
+static void cbor_key(struct nrf_cloud_json_writer *w, const char *key)
+{
+	if (key) {
+		cbor_check(w, cbor_encode_text_stringz(cbor_enc(w), key));
+	}
+}
+
+static void cbor_level_push(struct nrf_cloud_json_writer *w, const char *key, bool arr)
+{
+	if (w->cbor_depth == NRF_CLOUD_CBOR_MAX_DEPTH) {
+		json_writer_error(&w->json, -E2BIG);
+		return;
+	}
+
+	cbor_key(w, key);
+
+	if (arr) {
+		cbor_check(w, cbor_encoder_create_array(cbor_enc(w), &w->enc[w->cbor_depth + 1],
+							CborIndefiniteLength));
+	} else {
+		cbor_check(w, cbor_encoder_create_map(cbor_enc(w), &w->enc[w->cbor_depth + 1],
+						      CborIndefiniteLength));
+	}
+
+	w->cbor_depth++;
+}
+
+static void cbor_level_pop(struct nrf_cloud_json_writer *w)
+{
+	if (w->cbor_depth == 0) {
+		json_writer_error(&w->json, -EINVAL);
+		return;
+	}
+
+	w->cbor_depth--;
+	cbor_check(w, cbor_encoder_close_container(cbor_enc(w), &w->enc[w->cbor_depth + 1]));
+}
+
+/* Integers are encoded as such, other numbers in the smallest float type
+ * that represents them exactly. Like in JSON, NaN and infinity become null.
+ */
+static void cbor_num(struct nrf_cloud_json_writer *w, const char *key, double val)
+{
+	CborEncoder *enc = cbor_enc(w);
+
+	cbor_key(w, key);
+
+	if (isnan(val) || isinf(val)) {
+		cbor_check(w, cbor_encode_null(enc));
+	} else if ((fabs(val) < 9.2e18) && (val == (double)(int64_t)val)) {
+		cbor_check(w, cbor_encode_int(enc, (int64_t)val));
+	} else if (val == (double)(float)val) {
+		cbor_check(w, cbor_encode_float(enc, (float)val));
+	} else {
+		cbor_check(w, cbor_encode_double(enc, val));
+	}
+}
+
+static void cbor_str(struct nrf_cloud_json_writer *w, const char *key, const char *val)
+{
+	cbor_key(w, key);
+	cbor_check(w, cbor_encode_text_stringz(cbor_enc(w), val));
+}
+
+static void cbor_null(struct nrf_cloud_json_writer *w, const char *key)
+{
+	cbor_key(w, key);
+	cbor_check(w, cbor_encode_null(cbor_enc(w)));
+}
+
+static void cbor_bool(struct nrf_cloud_json_writer *w, const char *key, bool val)
+{
+	cbor_key(w, key);
+	cbor_check(w, cbor_encode_boolean(cbor_enc(w), val));
+}
+#else
+#define IS_CBOR(w) false
+#define cbor_level_push(w, key, arr)
+#define cbor_level_pop(w)
+#define cbor_num(w, key, val)
+#define cbor_str(w, key, val)
+#define cbor_null(w, key)
+#define cbor_bool(w, key, val)
+#endif /* CONFIG_NRF_CLOUD_CBOR */
+
+void nrf_cloud_json_writer_init(struct nrf_cloud_json_writer *w, char *buf,
+				size_t size)
+{
+	memset(w, 0, sizeof(*w));
+	/* Calculating the length is not bounded. */
+	json_writer_init(&w->json, buf, buf ? size : SIZE_MAX);
+}
+
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+void nrf_cloud_json_writer_init_cbor(struct nrf_cloud_json_writer *w, char *buf,
+				     size_t size)
+{
+	nrf_cloud_json_writer_init(w, buf, size);
+	w->cbor = true;
+	w->cbor_out.write = cbor_out_write;
+	cbor_encoder_init(&w->enc[0], &w->cbor_out, 0);
+}
+#endif
+
+void nrf_cloud_json_writer_obj_start(struct nrf_cloud_json_writer *w,
+				     const char *key)
+{
+	if (IS_CBOR(w)) {
+		cbor_level_push(w, key, false);
+		return;
+	}
+
+	json_writer_obj_start(&w->json, key);
+}
+
+void nrf_cloud_json_writer_obj_end(struct nrf_cloud_json_writer *w)
+{
+	if (IS_CBOR(w)) {
+		cbor_level_pop(w);
+		return;
+	}
+
+	json_writer_obj_end(&w->json);
+}
+
+void nrf_cloud_json_writer_arr_start(struct nrf_cloud_json_writer *w,
+				     const char *key)
+{
+	if (IS_CBOR(w)) {
+		cbor_level_push(w, key, true);
+		return;
+	}
+
+	json_writer_arr_start(&w->json, key);
+}
+
+void nrf_cloud_json_writer_arr_end(struct nrf_cloud_json_writer *w)
+{
+	if (IS_CBOR(w)) {
+		cbor_level_pop(w);
+		return;
+	}
+
+	json_writer_arr_end(&w->json);
+}
+
+void nrf_cloud_json_writer_str(struct nrf_cloud_json_writer *w,
+			       const char *key, const char *val)
+{
+	if (!val) {
+		json_writer_error(&w->json, -EINVAL);
+		return;
+	}
+
+	if (IS_CBOR(w)) {
+		cbor_str(w, key, val);
+		return;
+	}
+
+	json_writer_str(&w->json, key, val);
+}
+
+void nrf_cloud_json_writer_num(struct nrf_cloud_json_writer *w,
+			       const char *key, double val)
+{
+	if (IS_CBOR(w)) {
+		cbor_num(w, key, val);
+		return;
+	}
+
+	json_writer_num(&w->json, key, val);
+}
+
+void nrf_cloud_json_writer_null(struct nrf_cloud_json_writer *w,
+				const char *key)
+{
+	if (IS_CBOR(w)) {
+		cbor_null(w, key);
+		return;
+	}
+
+	json_writer_null(&w->json, key);
+}
+
+void nrf_cloud_json_writer_bool(struct nrf_cloud_json_writer *w,
+				const char *key, bool val)
+{
+	if (IS_CBOR(w)) {
+		cbor_bool(w, key, val);
+		return;
+	}
+
+	json_writer_bool(&w->json, key, val);
+}
+
+int nrf_cloud_json_writer_finish(struct nrf_cloud_json_writer *w)
+{
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+	if (w->cbor_depth != 0) {
+		json_writer_error(&w->json, -EINVAL);
+	}
+#endif
+
+	return json_writer_finish(&w->json);
+}
+
+static int writer_init(struct nrf_cloud_json_writer *w, bool cbor, char *buf,
+		       size_t size)
+{
+	if (cbor) {
+#if defined(CONFIG_NRF_CLOUD_CBOR)
+		nrf_cloud_json_writer_init_cbor(w, buf, size);
+		return 0;
+#else
+		return -ENOTSUP;
+#endif
+	}
+
+	nrf_cloud_json_writer_init(w, buf, size);
+
+	return 0;
+}
+
+int nrf_cloud_json_encode_alloc(nrf_cloud_json_encode_fn fn, const void *ctx,
+				bool cbor, char **out, size_t *out_len)
+{
+	struct nrf_cloud_json_writer w;
+	int ret = writer_init(&w, cbor, NULL, 0);
+
+	if (ret) {
+		return ret;
+	}
+
+	fn(&w, ctx);
+
+	int len = nrf_cloud_json_writer_finish(&w);
+
+	if (len < 0) {
+		return len;
+	}
+
+	char *buf = nrf_cloud_malloc(len + 1);
+
+	if (!buf) {
+		return -ENOMEM;
+	}
+
+	(void)writer_init(&w, cbor, buf, len + 1);
+	fn(&w, ctx);
+
+	int err = nrf_cloud_json_writer_finish(&w);
+
+	if (err < 0) {
+		nrf_cloud_free(buf);
+		return err;
+	}
+
+	__ASSERT_NO_MSG(err == len);
+
+	*out = buf;
+	if (out_len) {
+		*out_len = len;
+	}
+
+	return 0;
+}
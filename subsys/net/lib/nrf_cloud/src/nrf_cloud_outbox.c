@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/slist.h>
+#include <logging/log.h>
+#include <settings/settings.h>
+
+#include "nrf_cloud_outbox.h"
+#include "nrf_cloud_mem.h"
+
+LOG_MODULE_REGISTER(nrf_cloud_outbox, CONFIG_NRF_CLOUD_LOG_LEVEL);
+
+#define OUTBOX_SLOTS		CONFIG_NRF_CLOUD_OUTBOX_MAX_MSGS
+#define OUTBOX_WINDOW		CONFIG_NRF_CLOUD_OUTBOX_INFLIGHT_MAX
+#define OUTBOX_COALESCE_MAX	CONFIG_NRF_CLOUD_OUTBOX_COALESCE_MAX_LEN
+
+#define OUTBOX_SETTINGS_PREFIX	"nrf_cloud/" NCT_OUTBOX_SETTINGS_KEY "/"
+/* Prefix and up to two digits of the slot number */
+#define OUTBOX_KEY_LEN		(sizeof(OUTBOX_SETTINGS_PREFIX) + 2)
+
+/* Message has been published before and must be resent with the DUP flag. */
+#define OUTBOX_FLAG_DUP		BIT(0)
+/* Message ID was requested by the application. */
+#define OUTBOX_FLAG_FIXED_ID	BIT(1)
+
+BUILD_ASSERT(OUTBOX_SLOTS <= 32, "Slots are tracked in a 32-bit mask");
+
+/* Record header, stored together with the payload. */
+struct outbox_record {
+	uint32_t seq;
+	uint16_t message_id;
+	uint8_t topic;
+	uint8_t flags;
+} __packed;
+
+struct outbox_msg {
+	sys_snode_t node;
+	/* Slots reserved by the message, more than one if coalesced. */
+	uint32_t slots;
+	/* Slots that hold a stored copy of the message or its parts. */
+	uint32_t stored;
+	size_t len;
+	struct outbox_record rec;
+	/* Payload, must directly follow the record header. */
+	char data[];
+};
+
+static K_MUTEX_DEFINE(outbox_lock);
+static sys_slist_t pending;
+static sys_slist_t inflight;
+static size_t inflight_cnt;
+static uint32_t used_slots;
+static uint32_t next_seq;
+static bool connected;
+
+static int slot_alloc(void)
+{
+	int slot = find_lsb_set(~used_slots) - 1;
+
+	if ((slot < 0) || (slot >= OUTBOX_SLOTS)) {
+		return -ENOBUFS;
+	}
+
+	used_slots |= BIT(slot);
+
+	return slot;
+}
+
+static struct outbox_msg *msg_alloc(size_t len)
+{
+	struct outbox_msg *msg = nrf_cloud_malloc(sizeof(*msg) + len);
+
+	if (msg) {
+		memset(msg, 0, sizeof(*msg));
+		msg->len = len;
+	}
+
+	return msg;
+}
+
+#if defined(CONFIG_NRF_CLOUD_OUTBOX_PERSISTENT)
+static void slot_key(char *key, int slot)
+{
+	snprintk(key, OUTBOX_KEY_LEN, OUTBOX_SETTINGS_PREFIX "%d", slot);
+}
+
+static void msg_unstore(struct outbox_msg *msg, uint32_t slots)
+{
+	char key[OUTBOX_KEY_LEN];
+
+	slots &= msg->stored;
+
+	while (slots) {
+		int slot = find_lsb_set(slots) - 1;
+		int err;
+
+		slot_key(key, slot);
+		err = settings_delete(key);
+		if (err) {
+			LOG_WRN("Failed to delete stored message %d: %d", slot, err);
+		}
+
+		slots &= ~BIT(slot);
+		msg->stored &= ~BIT(slot);
+	}
+}
+
+static void msg_store(struct outbox_msg *msg)
+{
+	int slot = find_lsb_set(msg->slots) - 1;
+	char key[OUTBOX_KEY_LEN];
+	int err;
+
+	if (msg->stored == BIT(slot)) {
+		return;
+	}
+
+	slot_key(key, slot);
+	err = settings_save_one(key, &msg->rec, sizeof(msg->rec) + msg->len);
+	if (err) {
+		LOG_ERR("Failed to store message %d: %d", slot, err);
+		return;
+	}
+
+	/* Parts of a coalesced message are now replaced by a single copy. */
+	msg->stored |= BIT(slot);
+	msg_unstore(msg, ~BIT(slot));
+}
+#else
+static void msg_unstore(struct outbox_msg *msg, uint32_t slots)
+{
+	ARG_UNUSED(msg);
+	ARG_UNUSED(slots);
+}
+
+static void msg_store(struct outbox_msg *msg)
+{
+	ARG_UNUSED(msg);
+}
+#endif /* CONFIG_NRF_CLOUD_OUTBOX_PERSISTENT */
+
+static void msg_release(struct outbox_msg *msg)
+{
+	msg_unstore(msg, msg->slots);
+	used_slots &= ~msg->slots;
+	nrf_cloud_free(msg);
+}
+
+/* Get the part of a message that can be added to a bulk array. */
+static bool msg_element_get(const struct outbox_msg *msg, const char **ptr, size_t *len)
+{
+	if (msg->rec.flags & (OUTBOX_FLAG_DUP | OUTBOX_FLAG_FIXED_ID)) {
+		return false;
+	}
+
+	if (msg->rec.topic == NCT_OUTBOX_TOPIC_DC) {
+		/* Only JSON objects, CBOR encoded messages are sent as such. */
+		if ((msg->len == 0) || (msg->data[0] != '{')) {
+			return false;
+		}
+
+		*ptr = msg->data;
+		*len = msg->len;
+		return true;
+	}
+
+	/* Bulk messages are arrays, their items are added one level up. */
+	if ((msg->len < 2) || (msg->data[0] != '[') || (msg->data[msg->len - 1] != ']')) {
+		return false;
+	}
+
+	*ptr = &msg->data[1];
+	*len = msg->len - 2;
+
+	return true;
+}
+
+/* Take the first queued message. Consecutive messages that were not
+ * published yet are merged into a single bulk message, so that they are sent
+ * in one publish.
+ */
+static struct outbox_msg *pending_take(void)
+{
+	struct outbox_msg *first = SYS_SLIST_PEEK_HEAD_CONTAINER(&pending, first, node);
+	struct outbox_msg *msg;
+	struct outbox_msg *merged;
+	const char *elem;
+	size_t elem_len;
+	size_t len = 1;
+	size_t cnt = 0;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&pending, msg, node) {
+		size_t sep;
+
+		if (!msg_element_get(msg, &elem, &elem_len)) {
+			break;
+		}
+
+		/* Separating comma, and room for the closing bracket. */
+		sep = ((len > 1) && elem_len) ? 1 : 0;
+		if ((len + sep + elem_len + 1) > OUTBOX_COALESCE_MAX) {
+			break;
+		}
+
+		len += sep + elem_len;
+		cnt++;
+	}
+
+	if (cnt < 2) {
+		goto take_first;
+	}
+
+	len++;
+	merged = msg_alloc(len);
+	if (!merged) {
+		goto take_first;
+	}
+
+	merged->rec.seq = first->rec.seq;
+	merged->rec.topic = NCT_OUTBOX_TOPIC_BULK;
+	merged->len = 1;
+	merged->data[0] = '[';
+
+	for (size_t i = 0; i < cnt; i++) {
+		msg = CONTAINER_OF(sys_slist_get_not_empty(&pending), struct outbox_msg, node);
+		(void)msg_element_get(msg, &elem, &elem_len);
+
+		if (elem_len) {
+			if (merged->len > 1) {
+				merged->data[merged->len++] = ',';
+			}
+			memcpy(&merged->data[merged->len], elem, elem_len);
+			merged->len += elem_len;
+		}
+
+		/* Slots and stored copies are kept until the merged message is acked. */
+		merged->slots |= msg->slots;
+		merged->stored |= msg->stored;
+		nrf_cloud_free(msg);
+	}
+
+	merged->data[merged->len++] = ']';
+
+	LOG_DBG("Coalesced %zu messages, %zu bytes", cnt, merged->len);
+
+	return merged;
+
+take_first:
+	return CONTAINER_OF(sys_slist_get_not_empty(&pending), struct outbox_msg, node);
+}
+
+/* Publish queued messages while the in-flight window has room. */
+static void outbox_pump(void)
+{
+	while (connected && (inflight_cnt < OUTBOX_WINDOW) && !sys_slist_is_empty(&pending)) {
+		struct outbox_msg *msg = pending_take();
+		uint16_t message_id = msg->rec.message_id;
+		int err;
+
+		err = nct_outbox_publish(msg->rec.topic, &message_id,
+					 msg->rec.flags & OUTBOX_FLAG_DUP, msg->data, msg->len);
+		msg->rec.message_id = message_id;
+		if (err) {
+			LOG_WRN("Outbox publish failed: %d, message kept", err);
+			sys_slist_prepend(&pending, &msg->node);
+			break;
+		}
+
+		msg->rec.flags |= OUTBOX_FLAG_DUP;
+		sys_slist_append(&inflight, &msg->node);
+		inflight_cnt++;
+	}
+}
+
+int nct_outbox_add(enum nct_outbox_topic topic, const struct nrf_cloud_data *data,
+		   uint16_t message_id)
+{
+	if (!data || (!data->ptr && data->len)) {
+		return -EINVAL;
+	}
+
+	struct outbox_msg *msg;
+	int slot;
+	int err = 0;
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+
+	slot = slot_alloc();
+	if (slot < 0) {
+		LOG_WRN("Outbox full");
+		err = slot;
+		goto unlock;
+	}
+
+	msg = msg_alloc(data->len);
+	if (!msg) {
+		used_slots &= ~BIT(slot);
+		err = -ENOMEM;
+		goto unlock;
+	}
+
+	msg->slots = BIT(slot);
+	msg->rec.seq = next_seq++;
+	msg->rec.topic = topic;
+	msg->rec.message_id = message_id;
+	if (message_id != NCT_MSG_ID_USE_NEXT_INCREMENT) {
+		msg->rec.flags |= OUTBOX_FLAG_FIXED_ID;
+	}
+	memcpy(msg->data, data->ptr, data->len);
+
+	/* Messages queued while offline are stored right away. */
+	if (!connected) {
+		msg_store(msg);
+	}
+
+	sys_slist_append(&pending, &msg->node);
+	outbox_pump();
+
+unlock:
+	k_mutex_unlock(&outbox_lock);
+
+	return err;
+}
+
+bool nct_outbox_ack(uint16_t message_id)
+{
+	struct outbox_msg *msg;
+	sys_snode_t *prev = NULL;
+	bool found = false;
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&inflight, msg, node) {
+		if (msg->rec.message_id == message_id) {
+			sys_slist_remove(&inflight, prev, &msg->node);
+			inflight_cnt--;
+			msg_release(msg);
+			found = true;
+			break;
+		}
+		prev = &msg->node;
+	}
+
+	if (found) {
+		outbox_pump();
+	}
+
+	k_mutex_unlock(&outbox_lock);
+
+	return found;
+}
+
+void nct_outbox_connected(void)
+{
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+
+	connected = true;
+	outbox_pump();
+
+	k_mutex_unlock(&outbox_lock);
+}
+
+void nct_outbox_disconnected(void)
+{
+	struct outbox_msg *msg;
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+
+	if (!connected) {
+		goto unlock;
+	}
+
+	connected = false;
+
+	/* Unacknowledged messages go back to the front of the queue. */
+	sys_slist_merge_slist(&inflight, &pending);
+	pending = inflight;
+	sys_slist_init(&inflight);
+	inflight_cnt = 0;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&pending, msg, node) {
+		msg_store(msg);
+	}
+
+unlock:
+	k_mutex_unlock(&outbox_lock);
+}
+
+int nct_outbox_settings_set(const char *key, size_t len_rd,
+			    settings_read_cb read_cb, void *cb_arg)
+{
+	char *end;
+	long slot = strtol(key, &end, 10);
+	struct outbox_msg *msg;
+	struct outbox_msg *iter;
+	sys_snode_t *prev = NULL;
+
+	if ((end == key) || (*end != '\0') || (slot < 0) || (slot >= OUTBOX_SLOTS) ||
+	    (len_rd < sizeof(struct outbox_record))) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+
+	/* Already loaded. */
+	if (used_slots & BIT(slot)) {
+		k_mutex_unlock(&outbox_lock);
+		return 0;
+	}
+
+	msg = msg_alloc(len_rd - sizeof(struct outbox_record));
+	if (!msg) {
+		k_mutex_unlock(&outbox_lock);
+		return -ENOMEM;
+	}
+
+	if (read_cb(cb_arg, &msg->rec, len_rd) != (ssize_t)len_rd) {
+		nrf_cloud_free(msg);
+		k_mutex_unlock(&outbox_lock);
+		return -EIO;
+	}
+
+	msg->slots = BIT(slot);
+	msg->stored = BIT(slot);
+	used_slots |= BIT(slot);
+	next_seq = MAX(next_seq, msg->rec.seq + 1);
+
+	/* Keep the original order of the messages. */
+	SYS_SLIST_FOR_EACH_CONTAINER(&pending, iter, node) {
+		if (iter->rec.seq > msg->rec.seq) {
+			break;
+		}
+		prev = &iter->node;
+	}
+
+	if (prev) {
+		sys_slist_insert(&pending, prev, &msg->node);
+	} else {
+		sys_slist_prepend(&pending, &msg->node);
+	}
+
+	LOG_DBG("Loaded stored message %ld, %zu bytes", slot, msg->len);
+
+	k_mutex_unlock(&outbox_lock);
+
+	return 0;
+}
@@ -78,6 +78,8 @@ struct pgps_index {
 
 	/* array of pointers to predictions, in sorted time order */
 	struct nrf_cloud_pgps_prediction *predictions[NUM_PREDICTIONS];
+	/* predictions loaded from the saved index are validated on first use */
+	bool validated[NUM_PREDICTIONS];
 };
 
 static struct pgps_index index;
@@ -248,6 +250,7 @@ static int validate_stored_predictions(uint16_t *first_bad_day,
 	/* reset catalog of predictions */
 	for (pnum = 0; pnum < count; pnum++) {
 		index.predictions[pnum] = NULL;
+		index.validated[pnum] = false;
 	}
 
 	npgps_reset_block_pool();
@@ -302,6 +305,7 @@ static int validate_stored_predictions(uint16_t *first_bad_day,
 		LOG_DBG("Prediction num:%u, loc:%p, blk:%d", pnum, pred, i);
 		__ASSERT(i != -1, "unexpected pointer value %p", pred);
 		npgps_mark_block_used(i, true);
+		index.validated[pnum] = true;
 	}
 
 	/* find first free block in flash, if any, after chronologicaly
@@ -335,6 +339,143 @@ static void get_prediction_day_time(int pnum, int64_t *gps_sec, uint16_t *gps_da
 	}
 }
 
+static void save_index(void)
+{
+	struct npgps_index idx = {
+		.gps_day = index.header.gps_day,
+		.gps_time_of_day = index.header.gps_time_of_day,
+		.prediction_count = index.header.prediction_count,
+	};
+	int block;
+	int pnum;
+	int err;
+
+	for (pnum = 0; pnum < NUM_PREDICTIONS; pnum++) {
+		block = NO_BLOCK;
+		if ((pnum < index.header.prediction_count) && index.predictions[pnum]) {
+			block = npgps_pointer_to_block((uint8_t *)index.predictions[pnum]);
+		}
+		idx.block[pnum] = (block == NO_BLOCK) ? INDEX_NO_BLOCK : block;
+	}
+
+	err = npgps_save_index(&idx);
+	if (err) {
+		LOG_ERR("Error saving P-GPS index:%d", err);
+	}
+}
+
+/* Rebuild the catalog of predictions from the index saved with the
+ * current header, without reading the predictions themselves; each one
+ * is validated by nrf_cloud_pgps_find_prediction() when first used.
+ * Returns the number of consecutive predictions available, or -ENOENT
+ * if the saved index is for a different prediction set.
+ */
+static int load_stored_index(void)
+{
+	const struct npgps_index *idx = npgps_get_saved_index();
+	uint16_t count = index.header.prediction_count;
+	int last = NO_BLOCK;
+	int block;
+	int pnum;
+
+	if ((idx->prediction_count != count) ||
+	    (idx->gps_day != index.header.gps_day) ||
+	    (idx->gps_time_of_day != index.header.gps_time_of_day)) {
+		return -ENOENT;
+	}
+
+	memset(index.predictions, 0, sizeof(index.predictions));
+	memset(index.validated, 0, sizeof(index.validated));
+	npgps_reset_block_pool();
+
+	for (pnum = 0; pnum < count; pnum++) {
+		block = idx->block[pnum];
+		if ((block == INDEX_NO_BLOCK) || (block >= NUM_BLOCKS)) {
+			LOG_WRN("Prediction num:%u missing", pnum);
+			break;
+		}
+		index.predictions[pnum] = npgps_block_to_pointer(block);
+		npgps_mark_block_used(block, true);
+		last = block;
+	}
+
+	/* new downloads continue after the last stored prediction */
+	if (last != NO_BLOCK) {
+		(void)npgps_find_first_free(last);
+	}
+
+	npgps_print_blocks();
+	return pnum;
+}
+
+/* Drop prediction 'first' and all later ones from the catalog and free
+ * their blocks; a partial request only fills in predictions at the end
+ * of the set, so this is what lets the bad one be downloaded again.
+ */
+static void drop_indexed_predictions(int first)
+{
+	int block;
+	int pnum;
+
+	for (pnum = first; pnum < index.header.prediction_count; pnum++) {
+		if (index.predictions[pnum]) {
+			block = npgps_pointer_to_block((uint8_t *)index.predictions[pnum]);
+			if (block != NO_BLOCK) {
+				npgps_free_block(block);
+			}
+		}
+		index.predictions[pnum] = NULL;
+		index.validated[pnum] = false;
+	}
+
+	/* new downloads continue after the last prediction kept */
+	if ((first > 0) && index.predictions[first - 1]) {
+		block = npgps_pointer_to_block((uint8_t *)index.predictions[first - 1]);
+		if (block != NO_BLOCK) {
+			(void)npgps_find_first_free(block);
+		}
+	}
+
+	npgps_print_blocks();
+	save_index();
+}
+
+/* Number of consecutive predictions in the catalog, from the first. */
+static uint16_t count_indexed_predictions(void)
+{
+	uint16_t pnum;
+
+	for (pnum = 0; pnum < index.header.prediction_count; pnum++) {
+		if (!index.predictions[pnum]) {
+			break;
+		}
+	}
+	return pnum;
+}
+
+/* Check a prediction loaded from the saved index against its expected
+ * time; drop it, and the rest of the set after it, if it does not match.
+ */
+static int validate_indexed_prediction(int pnum)
+{
+	struct nrf_cloud_pgps_prediction *pred = index.predictions[pnum];
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
+	int err;
+
+	get_prediction_day_time(pnum, NULL, &gps_day, &gps_time_of_day);
+	err = validate_prediction(pred, gps_day, gps_time_of_day,
+				  index.header.prediction_period_min, true, false);
+	if (err) {
+		LOG_ERR("Indexed prediction num:%u is bad:%d; loc:%p", pnum, err, pred);
+		drop_indexed_predictions(pnum);
+		return err;
+	}
+
+	index.validated[pnum] = true;
+	return 0;
+}
+
 static void discard_oldest_predictions(int num)
 {
 	int i;
@@ -359,6 +500,7 @@ static void discard_oldest_predictions(int num)
 	for (i = last; i < index.header.prediction_count; i++) {
 		pnum = i - last;
 		index.predictions[pnum] = index.predictions[i];
+		index.validated[pnum] = index.validated[i];
 	}
 
 	/* set prediction pointers for 'last' in the newly empty
@@ -367,6 +509,7 @@ static void discard_oldest_predictions(int num)
 	for (pnum = index.header.prediction_count - last; pnum <
 	      index.header.prediction_count; pnum++) {
 		index.predictions[pnum] = NULL;
+		index.validated[pnum] = false;
 	}
 	npgps_print_blocks();
 
@@ -446,6 +589,16 @@ static void prediction_work_handler(struct k_work *work)
 			LOG_INF("Next prediction injected successfully.");
 		}
 	}
+
+	if (IS_ENABLED(CONFIG_NRF_CLOUD_PGPS_PREFETCH)) {
+		/* request replacements for expired predictions now, so the
+		 * next set arrives before the current one runs out
+		 */
+		ret = nrf_cloud_pgps_preemptive_updates();
+		if (ret) {
+			LOG_ERR("Error prefetching predictions:%d", ret);
+		}
+	}
 }
 
 static void prediction_timer_handler(struct k_timer *dummy)
@@ -573,6 +726,12 @@ int nrf_cloud_pgps_find_prediction(struct nrf_cloud_pgps_prediction **prediction
 
 	LOG_INF("Selected prediction num:%d", pnum);
 	index.cur_pnum = pnum;
+	if (index.predictions[pnum] && !index.validated[pnum]) {
+		err = validate_indexed_prediction(pnum);
+		if (err) {
+			return err;
+		}
+	}
 	*prediction = index.predictions[pnum];
 	if (*prediction) {
 		err = validate_prediction(*prediction,
@@ -1313,6 +1472,7 @@ static int consume_pgps_data(uint8_t pnum, const char *buf, size_t buf_len)
 			store_prediction(prediction_ptr, buf_len, (uint32_t)gps_sec,
 					 finished || (index.storage_extent == 1));
 			index.predictions[pnum] = npgps_block_to_pointer(index.store_block);
+			index.validated[pnum] = true;
 
 			if (pgps_need_assistance &&
 			    (finished || (index.loading_count > 1))) {
@@ -1329,6 +1489,7 @@ static int consume_pgps_data(uint8_t pnum, const char *buf, size_t buf_len)
 				}
 			} else {
 				LOG_INF("All P-GPS data received. Done.");
+				save_index();
 				state = PGPS_READY;
 				if (evt_handler) {
 					struct nrf_cloud_pgps_event evt = {
@@ -1415,10 +1576,12 @@ int nrf_cloud_pgps_process(const char *buf, size_t buf_len)
 		index.period_sec =
 			index.header.prediction_period_min * SEC_PER_MIN;
 		memset(index.predictions, 0, sizeof(index.predictions));
+		memset(index.validated, 0, sizeof(index.validated));
 	} else {
 		for (pnum = index.pnum_offset;
 		     pnum < index.expected_count + index.pnum_offset; pnum++) {
 			index.predictions[pnum] = NULL;
+			index.validated[pnum] = false;
 		}
 	}
 	index.loading_count = 0;
@@ -1541,7 +1704,16 @@ int nrf_cloud_pgps_init(struct nrf_cloud_pgps_init_param *param)
 		 */
 		LOG_INF("Checking stored P-GPS data; count:%u, period_min:%u",
 			count, period_min);
-		num_valid = validate_stored_predictions(&gps_day, &gps_time_of_day);
+		err = load_stored_index();
+		if (err < 0) {
+			LOG_INF("No index for stored P-GPS data; validating all");
+			err = validate_stored_predictions(&gps_day, &gps_time_of_day);
+			if (err > 0) {
+				save_index();
+			}
+		}
+		num_valid = err;
+		err = 0;
 	}
 
 	struct nrf_cloud_pgps_prediction *test_prediction;
@@ -1559,6 +1731,10 @@ int nrf_cloud_pgps_init(struct nrf_cloud_pgps_init_param *param)
 				test_prediction->time.date_day,
 				test_prediction->time.time_full_s);
 			pnum = err;
+		} else if (count_indexed_predictions() < num_valid) {
+			/* an indexed prediction failed validation and was dropped */
+			num_valid = count_indexed_predictions();
+			LOG_WRN("Stored prediction num:%u is bad", num_valid);
 		}
 	}
 
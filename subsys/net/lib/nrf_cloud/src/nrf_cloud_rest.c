@@ -27,6 +27,7 @@
 #include <logging/log.h>
 
 #include "nrf_cloud_codec.h"
+#include "nrf_cloud_mem.h"
 
 LOG_MODULE_REGISTER(nrf_cloud_rest, CONFIG_NRF_CLOUD_REST_LOG_LEVEL);
 
@@ -792,7 +793,7 @@ clean_up:
 		k_free(auth_hdr);
 	}
 	if (payload) {
-		cJSON_free(payload);
+		nrf_cloud_free(payload);
 	}
 
 	close_connection(rest_ctx);
@@ -10,6 +10,9 @@
 #if defined(CONFIG_NRF_CLOUD_FOTA)
 #include "nrf_cloud_fota.h"
 #endif
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+#include "nrf_cloud_outbox.h"
+#endif
 
 #include <zephyr.h>
 #include <stdio.h>
@@ -17,6 +20,7 @@
 #include <net/mqtt.h>
 #include <net/socket.h>
 #include <net/cloud.h>
+#include <net/mqtt_topic_router.h>
 #include <logging/log.h>
 #include <sys/util.h>
 #include <settings/settings.h>
@@ -95,9 +99,6 @@ static char *shadow_get_topic;
 static bool mqtt_client_initialized;
 static bool persistent_session;
 
-#define NCT_RX_LIST 0
-#define NCT_TX_LIST 1
-
 static int nct_settings_set(const char *key, size_t len_rd,
 			    settings_read_cb read_cb, void *cb_arg);
 
@@ -134,6 +135,10 @@ static struct mqtt_topic nct_cc_rx_list[CC_RX_LIST_CNT];
 #define CC_TX_LIST_CNT 2
 static struct mqtt_topic nct_cc_tx_list[CC_TX_LIST_CNT];
 
+/* Routes incoming control channel topics to their index in nct_cc_rx_list. */
+#define CC_RX_ROUTER_NODE_CNT 16
+MQTT_TOPIC_ROUTER_DEFINE(nct_cc_rx_router, CC_RX_ROUTER_NODE_CNT);
+
 static uint32_t const nct_cc_rx_opcode_map[] = {
 	NCT_CC_OPCODE_UPDATE_REQ,
 	NCT_CC_OPCODE_UPDATE_REJECT_RSP,
@@ -212,6 +217,13 @@ static uint32_t dc_send(const struct nct_dc_data *dc_data, uint8_t qos)
 		return -EINVAL;
 	}
 
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+	if (qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+		return nct_outbox_add(NCT_OUTBOX_TOPIC_DC, &dc_data->data,
+				      dc_data->message_id);
+	}
+#endif
+
 	struct mqtt_publish_param publish = {
 		.message_id = 0,
 		.message.topic.qos = qos,
@@ -244,6 +256,13 @@ static int bulk_send(const struct nct_dc_data *dc_data, enum mqtt_qos qos)
 		return -EINVAL;
 	}
 
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+	if (qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+		return nct_outbox_add(NCT_OUTBOX_TOPIC_BULK, &dc_data->data,
+				      dc_data->message_id);
+	}
+#endif
+
 	struct mqtt_publish_param publish = {
 		.message.topic.qos = qos,
 		.message.topic.topic.size = nct.dc_bulk_endp.size,
@@ -265,39 +284,45 @@ static int bulk_send(const struct nct_dc_data *dc_data, enum mqtt_qos qos)
 	return mqtt_publish(&nct.client, &publish);
 }
 
-static bool strings_compare(const char *s1, const char *s2, uint32_t s1_len,
-			    uint32_t s2_len)
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+int nct_outbox_publish(enum nct_outbox_topic topic, uint16_t *message_id, bool dup,
+		       const void *data, size_t len)
 {
-	return (strncmp(s1, s2, MIN(s1_len, s2_len))) ? false : true;
+	const struct mqtt_utf8 *endp = (topic == NCT_OUTBOX_TOPIC_BULK) ?
+				       &nct.dc_bulk_endp : &nct.dc_tx_endp;
+
+	if (endp->utf8 == NULL) {
+		return -ENOTCONN;
+	}
+
+	*message_id = get_message_id(*message_id);
+
+	struct mqtt_publish_param publish = {
+		.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE,
+		.message.topic.topic = *endp,
+		.message.payload.data = (uint8_t *)data,
+		.message.payload.len = len,
+		.message_id = *message_id,
+		.dup_flag = dup,
+	};
+
+	return mqtt_publish(&nct.client, &publish);
 }
+#endif /* CONFIG_NRF_CLOUD_OUTBOX */
 
 /* Verify if the topic is a control channel topic or not. */
-static bool control_channel_topic_match(uint32_t list_id,
-					const struct mqtt_topic *topic,
+static bool control_channel_topic_match(const struct mqtt_topic *topic,
 					enum nct_cc_opcode *opcode)
 {
-	struct mqtt_topic *topic_list;
-	uint32_t list_size;
-
-	if (list_id == NCT_RX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_rx_list;
-		list_size = ARRAY_SIZE(nct_cc_rx_list);
-	} else if (list_id == NCT_TX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_tx_list;
-		list_size = ARRAY_SIZE(nct_cc_tx_list);
-	} else {
+	int index = mqtt_topic_router_match(&nct_cc_rx_router, topic->topic.utf8,
+					    topic->topic.size);
+
+	if (index < 0) {
 		return false;
 	}
 
-	for (uint32_t index = 0; index < list_size; index++) {
-		if (strings_compare(
-			    topic->topic.utf8, topic_list[index].topic.utf8,
-			    topic->topic.size, topic_list[index].topic.size)) {
-			*opcode = nct_cc_rx_opcode_map[index];
-			return true;
-		}
-	}
-	return false;
+	*opcode = nct_cc_rx_opcode_map[index];
+	return true;
 }
 
 /* Function to set/generate the MQTT client ID */
@@ -470,10 +495,13 @@ static void nct_reset_topics(void)
 
 	memset(nct_cc_rx_list, 0, sizeof(nct_cc_rx_list[0]) * CC_RX_LIST_CNT);
 	memset(nct_cc_tx_list, 0, sizeof(nct_cc_tx_list[0]) * CC_TX_LIST_CNT);
+	mqtt_topic_router_reset(&nct_cc_rx_router);
 }
 
-static void nct_topic_lists_populate(void)
+static int nct_topic_lists_populate(void)
 {
+	int err;
+
 	/* Add RX topics */
 	nct_cc_rx_list[0].qos = MQTT_QOS_1_AT_LEAST_ONCE;
 	nct_cc_rx_list[0].topic.utf8 = accepted_topic;
@@ -495,6 +523,16 @@ static void nct_topic_lists_populate(void)
 	nct_cc_tx_list[1].qos = MQTT_QOS_1_AT_LEAST_ONCE;
 	nct_cc_tx_list[1].topic.utf8 = update_topic;
 	nct_cc_tx_list[1].topic.size = strlen(update_topic);
+
+	for (int i = 0; i < CC_RX_LIST_CNT; i++) {
+		err = mqtt_topic_router_add(&nct_cc_rx_router, nct_cc_rx_list[i].topic.utf8,
+					    nct_cc_rx_list[i].topic.size, i);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
 }
 
 static int nct_topics_populate(void)
@@ -535,7 +573,10 @@ static int nct_topics_populate(void)
 	LOG_DBG("shadow_get_topic: %s", log_strdup(shadow_get_topic));
 
 	/* Populate RX and TX topic lists */
-	nct_topic_lists_populate();
+	ret = nct_topic_lists_populate();
+	if (ret) {
+		goto err_cleanup;
+	}
 
 	return 0;
 
@@ -664,6 +705,14 @@ static int nct_settings_set(const char *key, size_t len_rd,
 			return 0;
 		}
 	}
+
+#if defined(CONFIG_NRF_CLOUD_OUTBOX_PERSISTENT)
+	const char *next;
+
+	if (settings_name_steq(key, NCT_OUTBOX_SETTINGS_KEY, &next) && next) {
+		return nct_outbox_settings_set(next, len_rd, read_cb, cb_arg);
+	}
+#endif
 	return -ENOTSUP;
 }
 
@@ -689,13 +738,14 @@ static int nct_settings_init(void)
 {
 	int ret = 0;
 
-#if !defined(CONFIG_MQTT_CLEAN_SESSION) || defined(CONFIG_NRF_CLOUD_FOTA)
+#if !defined(CONFIG_MQTT_CLEAN_SESSION) || defined(CONFIG_NRF_CLOUD_FOTA) || \
+	defined(CONFIG_NRF_CLOUD_OUTBOX_PERSISTENT)
 	ret = settings_subsys_init();
 	if (ret) {
 		LOG_ERR("Settings init failed: %d", ret);
 		return ret;
 	}
-#if !defined(CONFIG_MQTT_CLEAN_SESSION)
+#if !defined(CONFIG_MQTT_CLEAN_SESSION) || defined(CONFIG_NRF_CLOUD_OUTBOX_PERSISTENT)
 	ret = settings_load_subtree(settings_handler_nrf_cloud.name);
 	if (ret) {
 		LOG_ERR("Cannot load settings: %d", ret);
@@ -905,8 +955,7 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		/* If the data arrives on one of the subscribed control channel
 		 * topic. Then we notify the same.
 		 */
-		if (control_channel_topic_match(NCT_RX_LIST, &p->message.topic,
-						&cc.opcode)) {
+		if (control_channel_topic_match(&p->message.topic, &cc.opcode)) {
 			cc.message_id = p->message_id;
 			cc.data.ptr = nct.payload_buf;
 			cc.data.len = p->message.payload.len;
@@ -979,6 +1028,9 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		LOG_DBG("MQTT_EVT_PUBACK: id = %d result = %d",
 			_mqtt_evt->param.puback.message_id, _mqtt_evt->result);
 
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+		(void)nct_outbox_ack(_mqtt_evt->param.puback.message_id);
+#endif
 		evt.type = NCT_EVT_CC_TX_DATA_ACK;
 		evt.param.message_id = _mqtt_evt->param.puback.message_id;
 		event_notify = true;
@@ -987,6 +1039,10 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 	case MQTT_EVT_DISCONNECT: {
 		LOG_DBG("MQTT_EVT_DISCONNECT: result = %d", _mqtt_evt->result);
 
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+		nct_outbox_disconnected();
+#endif
+
 		evt.type = NCT_EVT_DISCONNECTED;
 		event_notify = true;
 		break;
@@ -1371,6 +1427,9 @@ void nct_process(void)
 
 	struct nct_evt evt = { .status = err };
 
+#if defined(CONFIG_NRF_CLOUD_OUTBOX)
+	nct_outbox_disconnected();
+#endif
 	evt.type = NCT_EVT_DISCONNECTED;
 	err = nct_input(&evt);
 	if (err) {
@@ -76,6 +76,17 @@ static void tx_callback(struct bt_conn *conn)
 				  bt_nus->ctrl_blk->context);
 }
 
+#if CONFIG_SHELL_BT_NUS_STREAM
+static void stream_space_callback(void)
+{
+	const struct shell_bt_nus *bt_nus =
+		(const struct shell_bt_nus *)shell_transport_bt_nus.ctx;
+
+	bt_nus->ctrl_blk->handler(SHELL_TRANSPORT_EVT_TX_RDY,
+				  bt_nus->ctrl_blk->context);
+}
+#endif /* CONFIG_SHELL_BT_NUS_STREAM */
+
 static void send_enabled_callback(enum bt_nus_send_status status)
 {
 	if (status == BT_NUS_SEND_STATUS_ENABLED) {
@@ -143,11 +154,23 @@ static int write(const struct shell_transport *transport,
 		return 0;
 	}
 
-	*cnt = ring_buf_put(bt_nus->tx_ringbuf, data, length);
-	LOG_DBG("Write req:%d accept:%d", length, *cnt);
+	if (IS_ENABLED(CONFIG_SHELL_BT_NUS_STREAM)) {
+		int ret = bt_nus_stream_write(data, length);
+
+		if (ret < 0) {
+			LOG_DBG("Stream write failed (%d error)", ret);
+			/* Drop the data as when there is no connection. */
+			*cnt = length;
+		} else {
+			*cnt = ret;
+		}
+	} else {
+		*cnt = ring_buf_put(bt_nus->tx_ringbuf, data, length);
+		LOG_DBG("Write req:%d accept:%d", length, *cnt);
 
-	if (atomic_set(&bt_nus->ctrl_blk->tx_busy, 1) == 0) {
-		tx_try(bt_nus);
+		if (atomic_set(&bt_nus->ctrl_blk->tx_busy, 1) == 0) {
+			tx_try(bt_nus);
+		}
 	}
 
 	return 0;
@@ -159,6 +182,9 @@ void shell_bt_nus_disable(void)
 			(const struct shell_bt_nus *)shell_transport_bt_nus.ctx;
 
 	bt_nus->ctrl_blk->conn = NULL;
+#if CONFIG_SHELL_BT_NUS_STREAM
+	bt_nus_stream_disable();
+#endif /* CONFIG_SHELL_BT_NUS_STREAM */
 	k_sem_give(&shell_bt_nus_ready);
 }
 
@@ -173,6 +199,10 @@ void shell_bt_nus_enable(struct bt_conn *conn)
 		CONFIG_LOG_MAX_LEVEL : CONFIG_SHELL_BT_NUS_INIT_LOG_LEVEL;
 
 	bt_nus->ctrl_blk->conn = conn;
+#if CONFIG_SHELL_BT_NUS_STREAM
+	err = bt_nus_stream_enable(conn);
+	__ASSERT_NO_MSG(err == 0);
+#endif /* CONFIG_SHELL_BT_NUS_STREAM */
 
 	k_sem_reset(&shell_bt_nus_ready);
 
@@ -196,7 +226,10 @@ int shell_bt_nus_init(void)
 	struct bt_nus_cb callbacks = {
 		.received = rx_callback,
 		.sent = tx_callback,
-		.send_enabled = send_enabled_callback
+		.send_enabled = send_enabled_callback,
+#if CONFIG_SHELL_BT_NUS_STREAM
+		.stream_space_available = stream_space_callback,
+#endif /* CONFIG_SHELL_BT_NUS_STREAM */
 	};
 
 	return bt_nus_init(&callbacks);
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <math.h>
+#include <string.h>
+#include <wave_gen.h>
+
+#define SAMPLE_PERIOD_MS	1
+#define SAMPLE_PERIOD_US	(SAMPLE_PERIOD_MS * USEC_PER_MSEC)
+#define SAMPLE_CNT		1000
+/* Not a divisor of the sine resynchronization interval, so that the blocks end in the
+ * middle of it.
+ */
+#define BLOCK_CNT		7
+#define TOLERANCE		1e-3
+#define SEED			0xdeadbeef
+
+static const struct wave_gen_param sine_params = {
+	.type = WAVE_GEN_TYPE_SINE,
+	.period_ms = 100,
+	.offset = 1.0,
+	.amplitude = 2.0,
+	.noise = 0.0,
+};
+
+static void block_generate(struct wave_gen_block *block, float *out, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i += BLOCK_CNT) {
+		wave_gen_generate_block(block, &out[i], MIN(BLOCK_CNT, cnt - i), 1);
+	}
+}
+
+/* Compare values generated in blocks with the values of the per-sample API. The difference
+ * between them is allowed to be up to the noise amplitude.
+ */
+static void block_check(const struct wave_gen_param *params, double noise)
+{
+	static float out[SAMPLE_CNT];
+	struct wave_gen_block block;
+	struct wave_gen_param ref_params = *params;
+	size_t diff_cnt = 0;
+
+	ref_params.noise = 0.0;
+
+	zassert_ok(wave_gen_block_init(&block, params, SAMPLE_PERIOD_US, SEED),
+		   "Cannot initialize block");
+	block_generate(&block, out, ARRAY_SIZE(out));
+
+	for (size_t i = 0; i < ARRAY_SIZE(out); i++) {
+		double ref;
+
+		zassert_ok(wave_gen_generate_value(i * SAMPLE_PERIOD_MS, &ref_params, &ref),
+			   "Cannot generate value");
+		zassert_true(fabs(out[i] - ref) <= (noise + TOLERANCE),
+			     "Value %zu differs: %f, expected %f", i, out[i], ref);
+
+		if (fabs(out[i] - ref) > TOLERANCE) {
+			diff_cnt++;
+		}
+	}
+
+	if (noise > 0.0) {
+		zassert_true(diff_cnt > 0, "No noise added");
+	}
+}
+
+static void test_sine(void)
+{
+	block_check(&sine_params, 0.0);
+}
+
+static void test_triangle(void)
+{
+	struct wave_gen_param params = sine_params;
+
+	params.type = WAVE_GEN_TYPE_TRIANGLE;
+	block_check(&params, 0.0);
+}
+
+static void test_square(void)
+{
+	struct wave_gen_param params = sine_params;
+
+	params.type = WAVE_GEN_TYPE_SQUARE;
+	block_check(&params, 0.0);
+}
+
+static void test_noise(void)
+{
+	struct wave_gen_param params = sine_params;
+
+	params.noise = 0.5;
+	block_check(&params, params.noise);
+
+	params.type = WAVE_GEN_TYPE_NONE;
+	params.period_ms = 0;
+	block_check(&params, params.noise);
+}
+
+static void test_noise_seed(void)
+{
+	static float out_a[SAMPLE_CNT];
+	static float out_b[SAMPLE_CNT];
+	struct wave_gen_block block;
+	struct wave_gen_param params = sine_params;
+
+	params.noise = 0.5;
+
+	/* The same seed results in the same values. */
+	zassert_ok(wave_gen_block_init(&block, &params, SAMPLE_PERIOD_US, SEED), NULL);
+	block_generate(&block, out_a, ARRAY_SIZE(out_a));
+
+	zassert_ok(wave_gen_block_init(&block, &params, SAMPLE_PERIOD_US, SEED), NULL);
+	block_generate(&block, out_b, ARRAY_SIZE(out_b));
+
+	zassert_mem_equal(out_a, out_b, sizeof(out_a), "Noise differs for the same seed");
+
+	/* A different seed results in different values. */
+	zassert_ok(wave_gen_block_init(&block, &params, SAMPLE_PERIOD_US, SEED + 1), NULL);
+	block_generate(&block, out_b, ARRAY_SIZE(out_b));
+
+	zassert_true(memcmp(out_a, out_b, sizeof(out_a)), "Noise equal for different seeds");
+
+	/* Zero seed is replaced with a default, the generator does not get stuck. */
+	params.type = WAVE_GEN_TYPE_NONE;
+	params.period_ms = 0;
+	zassert_ok(wave_gen_block_init(&block, &params, SAMPLE_PERIOD_US, 0), NULL);
+	wave_gen_generate_block(&block, out_b, 2, 1);
+
+	zassert_not_equal(out_b[0], out_b[1], "Noise generator stuck");
+}
+
+static void test_stride(void)
+{
+	static float out[SAMPLE_CNT];
+	static float interleaved[2 * SAMPLE_CNT];
+	struct wave_gen_block block_a;
+	struct wave_gen_block block_b;
+	struct wave_gen_param params = sine_params;
+
+	params.noise = 0.5;
+	zassert_ok(wave_gen_block_init(&block_a, &params, SAMPLE_PERIOD_US, SEED), NULL);
+	zassert_ok(wave_gen_block_init(&block_b, &params, SAMPLE_PERIOD_US, SEED), NULL);
+
+	wave_gen_generate_block(&block_a, out, ARRAY_SIZE(out), 1);
+	wave_gen_generate_block(&block_b, &interleaved[1], SAMPLE_CNT, 2);
+
+	for (size_t i = 0; i < ARRAY_SIZE(out); i++) {
+		zassert_equal(interleaved[2 * i + 1], out[i], "Value %zu differs", i);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(wave_gen_tests,
+			 ztest_unit_test(test_sine),
+			 ztest_unit_test(test_triangle),
+			 ztest_unit_test(test_square),
+			 ztest_unit_test(test_noise),
+			 ztest_unit_test(test_noise_seed),
+			 ztest_unit_test(test_stride)
+			 );
+
+	ztest_run_test_suite(wave_gen_tests);
+}
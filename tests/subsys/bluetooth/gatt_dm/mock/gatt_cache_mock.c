@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Peer and settings storage used by the discovery cache.
+ *
+ * The connection functions of the Bluetooth host are replaced using the
+ * linker --wrap option, as the tests do not use a real connection.
+ *
+ * The settings backend keeps the entries in RAM. Like the FCB and file
+ * backends, deleted entries are reported with zero length when loaded.
+ */
+#include <string.h>
+#include <kernel.h>
+#include <ztest.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/att.h>
+#include <settings/settings.h>
+
+#include "gatt_cache_mock.h"
+
+#define ENTRY_COUNT		8
+#define ENTRY_NAME_SIZE		48
+#define ENTRY_VALUE_SIZE	512
+
+const bt_addr_le_t bt_gatt_cache_mock_peer = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a.val = { 0x01, 0x02, 0x03, 0x04, 0x05, 0xc6 },
+};
+
+static struct bt_cache_mock {
+	bool bonded;
+	bool hash_valid;
+	uint8_t db_hash[BT_GATT_CACHE_MOCK_HASH_LEN];
+	size_t read_cnt;
+	struct bt_conn *conn;
+	struct bt_gatt_read_params *params;
+	struct k_work work;
+} cache_mock_data;
+
+static struct {
+	char name[ENTRY_NAME_SIZE];
+	uint8_t value[ENTRY_VALUE_SIZE];
+	size_t len;
+} entries[ENTRY_COUNT];
+
+void bt_gatt_cache_mock_setup(bool bonded, const uint8_t *db_hash)
+{
+	cache_mock_data.bonded = bonded;
+	cache_mock_data.hash_valid = (db_hash != NULL);
+	if (db_hash) {
+		memcpy(cache_mock_data.db_hash, db_hash,
+		       sizeof(cache_mock_data.db_hash));
+	}
+	cache_mock_data.read_cnt = 0;
+}
+
+size_t bt_gatt_cache_mock_read_cnt(void)
+{
+	return cache_mock_data.read_cnt;
+}
+
+size_t bt_gatt_cache_mock_entry_cnt(const char *prefix, bool deleted)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < ENTRY_COUNT; i++) {
+		if ((entries[i].name[0] != '\0') &&
+		    !strncmp(entries[i].name, prefix, strlen(prefix)) &&
+		    ((entries[i].len == 0) == deleted)) {
+			cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+void bt_gatt_cache_mock_settings_clear(void)
+{
+	memset(entries, 0, sizeof(entries));
+}
+
+const bt_addr_le_t *__wrap_bt_conn_get_dst(const struct bt_conn *conn)
+{
+	return &bt_gatt_cache_mock_peer;
+}
+
+int __wrap_bt_conn_get_info(const struct bt_conn *conn,
+			    struct bt_conn_info *info)
+{
+	memset(info, 0, sizeof(*info));
+	info->type = BT_CONN_TYPE_LE;
+	info->id = BT_ID_DEFAULT;
+	info->le.dst = &bt_gatt_cache_mock_peer;
+
+	return 0;
+}
+
+bool __wrap_bt_addr_le_is_bonded(uint8_t id, const bt_addr_le_t *addr)
+{
+	return cache_mock_data.bonded &&
+	       !bt_addr_le_cmp(addr, &bt_gatt_cache_mock_peer);
+}
+
+static void bt_gatt_read_work(struct k_work *work)
+{
+	struct bt_gatt_read_params *params = cache_mock_data.params;
+
+	if (cache_mock_data.hash_valid) {
+		(void)params->func(cache_mock_data.conn, 0, params,
+				   cache_mock_data.db_hash,
+				   sizeof(cache_mock_data.db_hash));
+	} else {
+		(void)params->func(cache_mock_data.conn,
+				   BT_ATT_ERR_ATTRIBUTE_NOT_FOUND, params,
+				   NULL, 0);
+	}
+}
+
+/* Mocked version of the bt_gatt_read, only reads the Database Hash */
+int bt_gatt_read(struct bt_conn *conn, struct bt_gatt_read_params *params)
+{
+	zassert_equal(params->handle_count, 0, "Read by UUID expected");
+	zassert_true(!bt_uuid_cmp(params->by_uuid.uuid, BT_UUID_GATT_DB_HASH),
+		     "Unexpected UUID read");
+
+	cache_mock_data.conn = conn;
+	cache_mock_data.params = params;
+	cache_mock_data.read_cnt++;
+
+	k_work_init(&cache_mock_data.work, bt_gatt_read_work);
+	k_work_submit(&cache_mock_data.work);
+
+	return 0;
+}
+
+static ssize_t entry_read(void *cb_arg, void *data, size_t len)
+{
+	size_t index = (size_t)cb_arg;
+
+	len = MIN(len, entries[index].len);
+	memcpy(data, entries[index].value, len);
+
+	return len;
+}
+
+static int mock_load(struct settings_store *cs,
+		     const struct settings_load_arg *arg)
+{
+	for (size_t i = 0; i < ENTRY_COUNT; i++) {
+		if (entries[i].name[0] == '\0') {
+			continue;
+		}
+
+		settings_call_set_handler(entries[i].name, entries[i].len,
+					  entry_read, (void *)i, arg);
+	}
+
+	return 0;
+}
+
+/* Deleted entries are kept with zero length. */
+static int mock_save(struct settings_store *cs, const char *name,
+		     const char *value, size_t val_len)
+{
+	size_t free = ENTRY_COUNT;
+
+	if ((strlen(name) >= ENTRY_NAME_SIZE) || (val_len > ENTRY_VALUE_SIZE)) {
+		return -ENOMEM;
+	}
+
+	for (size_t i = 0; i < ENTRY_COUNT; i++) {
+		if (!strcmp(entries[i].name, name)) {
+			free = i;
+			break;
+		}
+
+		if ((free == ENTRY_COUNT) && (entries[i].name[0] == '\0')) {
+			free = i;
+		}
+	}
+
+	if (free == ENTRY_COUNT) {
+		return -ENOMEM;
+	}
+
+	strcpy(entries[free].name, name);
+	if (value) {
+		memcpy(entries[free].value, value, val_len);
+	}
+	entries[free].len = value ? val_len : 0;
+
+	return 0;
+}
+
+static const struct settings_store_itf mock_itf = {
+	.csi_load = mock_load,
+	.csi_save = mock_save,
+};
+
+static struct settings_store mock_store = {
+	.cs_itf = &mock_itf,
+};
+
+int settings_backend_init(void)
+{
+	settings_dst_register(&mock_store);
+	settings_src_register(&mock_store);
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef BT_GATT_CACHE_MOCK_H_
+#define BT_GATT_CACHE_MOCK_H_
+
+#include <stdbool.h>
+#include <bluetooth/addr.h>
+
+/**
+ * @file
+ * @defgroup bt_gatt_cache_mock API
+ * @{
+ * @brief The API used to setup the peer and the settings storage for the discovery cache
+ */
+
+/** @brief Length of the Database Hash */
+#define BT_GATT_CACHE_MOCK_HASH_LEN 16
+
+/** @brief Address of the mocked peer */
+extern const bt_addr_le_t bt_gatt_cache_mock_peer;
+
+/**
+ * @brief Discovery cache mock setup
+ *
+ * @param bonded  Report the peer as bonded.
+ * @param db_hash The Database Hash of the peer or NULL if the peer does not
+ *                expose the Database Hash characteristic.
+ */
+void bt_gatt_cache_mock_setup(bool bonded, const uint8_t *db_hash);
+
+/**
+ * @brief Get the number of the Database Hash reads
+ *
+ * The counter is reset by @ref bt_gatt_cache_mock_setup.
+ *
+ * @return Number of bt_gatt_read calls since the mock setup.
+ */
+size_t bt_gatt_cache_mock_read_cnt(void);
+
+/**
+ * @brief Get the number of settings entries with the given prefix
+ *
+ * @param prefix  The settings key prefix.
+ * @param deleted Count deleted entries instead of the stored ones.
+ *
+ * @return Number of entries.
+ */
+size_t bt_gatt_cache_mock_entry_cnt(const char *prefix, bool deleted);
+
+/** @brief Remove all entries from the settings storage. */
+void bt_gatt_cache_mock_settings_clear(void);
+
+/** @} */
+#endif /* BT_GATT_CACHE_MOCK_H_ */
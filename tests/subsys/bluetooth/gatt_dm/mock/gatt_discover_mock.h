@@ -90,5 +90,14 @@
  */
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len);
 
+/**
+ * @brief Get the number of bt_gatt_discover calls
+ *
+ * The counter is reset by @ref bt_gatt_discover_mock_setup.
+ *
+ * @return Number of calls since the mock setup.
+ */
+size_t bt_gatt_discover_mock_call_cnt(void);
+
 /** @} */
 #endif /* #define BT_GATT_DISCOVERY_MOCK_H_ */
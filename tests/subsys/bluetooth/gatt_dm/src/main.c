@@ -10,6 +10,10 @@
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
 #include "../mock/gatt_discover_mock.h"
+#if CONFIG_BT_GATT_DM_CACHE
+#include <settings/settings.h>
+#include "../mock/gatt_cache_mock.h"
+#endif
 
 /* Timeout for the discovery in ms */
 #define SERVICE_DISCOVERY_TIMEOUT 2000
@@ -77,6 +81,11 @@ void test_setup(void)
 {
 	k_sem_reset(&discovery_finished);
 	bt_gatt_discover_mock_setup(discover_sim, ARRAY_SIZE(discover_sim));
+#if CONFIG_BT_GATT_DM_CACHE
+	bt_gatt_cache_mock_setup(false, NULL);
+	bt_gatt_cache_mock_settings_clear();
+	zassert_equal(0, settings_subsys_init(), "Settings initialization failed");
+#endif
 }
 
 struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
@@ -342,6 +351,36 @@ void test_gatt_HIDS_chrc_by_uuid(void)
 	/* Clean up */
 	bt_gatt_dm_data_release(dm);
 	zassert_equal(0, bt_gatt_dm_attr_cnt(dm), "Parameter count after clearing: %d", bt_gatt_dm_attr_cnt(dm));
+
+	/* Released characteristics cannot be found anymore */
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_is_null(attr_chrc, "Expected NULL after release");
+}
+
+void test_gatt_HIDS_chrc_by_uuid_128(void)
+{
+	struct bt_gatt_dm *dm;
+	const struct bt_gatt_dm_attr *attr_chrc;
+	const struct bt_gatt_dm_attr *attr_desc;
+	/* HIDS Report and CCC UUIDs in the 128-bit representation */
+	const struct bt_uuid *report_uuid_128 = BT_UUID_DECLARE_128(
+		BT_UUID_128_ENCODE(0x00002a4d, 0x0000, 0x1000, 0x8000, 0x00805f9b34fb));
+	const struct bt_uuid *ccc_uuid_128 = BT_UUID_DECLARE_128(
+		BT_UUID_128_ENCODE(0x00002902, 0x0000, 0x1000, 0x8000, 0x00805f9b34fb));
+
+	dm = run_dm(BT_UUID_HIDS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, report_uuid_128);
+	zassert_not_null(attr_chrc, "Unexpected NULL");
+	zassert_equal(6, attr_chrc->handle, "Unexpected handle: %d", attr_chrc->handle);
+
+	attr_desc = bt_gatt_dm_desc_by_uuid(dm, attr_chrc, ccc_uuid_128);
+	zassert_not_null(attr_desc, "Unexpected NULL");
+	zassert_equal(8, attr_desc->handle, "Unexpected handle: %d", attr_desc->handle);
+
+	bt_gatt_dm_data_release(dm);
+	zassert_equal(0, bt_gatt_dm_attr_cnt(dm), "Parameter count after clearing: %d", bt_gatt_dm_attr_cnt(dm));
 }
 
 void test_gatt_generic_serv(void)
@@ -376,6 +415,196 @@ void test_gatt_generic_serv(void)
 	/* No cleanup here - cleanup is done in run_dm_next */
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+static const uint8_t db_hash_a[BT_GATT_CACHE_MOCK_HASH_LEN] = {
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+};
+
+static const uint8_t db_hash_b[BT_GATT_CACHE_MOCK_HASH_LEN] = {
+	0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+	0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+};
+
+/* Settings key prefixes of the mocked peer and of a peer that is not connected */
+#define CACHE_PEER_PREFIX "bt_dm/c605040302011"
+#define OTHER_PEER_PREFIX "bt_dm/c605040302021"
+
+/* Checks the HIDS results, whether discovered or loaded from the cache */
+static void cache_hids_check(struct bt_gatt_dm *dm)
+{
+	const struct bt_gatt_dm_attr *attr_chrc;
+	const struct bt_gatt_dm_attr *attr_desc;
+	const struct bt_gatt_service_val *serv_val;
+	const struct bt_gatt_chrc *chrc_val;
+
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(11,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+
+	serv_val = bt_gatt_dm_attr_service_val(bt_gatt_dm_service_get(dm));
+	zassert_not_null(serv_val, "Unexpected NULL instead of service value");
+	zassert_true(!bt_uuid_cmp(BT_UUID_HIDS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(11, serv_val->end_handle, "Unexpected service end handle");
+
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr_chrc, "Unexpected NULL");
+	zassert_equal(6, attr_chrc->handle, "Unexpected handle: %d", attr_chrc->handle);
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr_chrc);
+	zassert_not_null(chrc_val, "Unexpected NULL instead HIDS_REPORT value");
+	zassert_equal(BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+		      chrc_val->properties,
+		      "Unexpected HIDS_REPORT properties");
+
+	attr_desc = bt_gatt_dm_desc_by_uuid(dm, attr_chrc, BT_UUID_GATT_CCC);
+	zassert_not_null(attr_desc, "Unexpected NULL");
+	zassert_equal(8, attr_desc->handle, "Unexpected handle: %d", attr_desc->handle);
+
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_CTRL_POINT);
+	zassert_not_null(attr_chrc, "Unexpected NULL");
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr_chrc);
+	zassert_equal(BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+		      chrc_val->properties,
+		      "Unexpected HIDS_CTRL_POINT properties");
+}
+
+/* Runs the HIDS discovery and checks if it was served from the cache */
+static void cache_hids_run(bool cache_hit)
+{
+	size_t discover_cnt = bt_gatt_discover_mock_call_cnt();
+	struct bt_gatt_dm *dm = run_dm(BT_UUID_HIDS);
+
+	cache_hids_check(dm);
+	if (cache_hit) {
+		zassert_equal(discover_cnt, bt_gatt_discover_mock_call_cnt(),
+			      "Service discovered instead of loaded from the cache");
+	} else {
+		zassert_true(discover_cnt < bt_gatt_discover_mock_call_cnt(),
+			     "Service not discovered");
+	}
+
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_cache_round_trip(void)
+{
+	struct bt_gatt_dm *dm;
+	size_t discover_cnt;
+
+	bt_gatt_cache_mock_setup(true, db_hash_a);
+
+	cache_hids_run(false);
+	zassert_equal(1, bt_gatt_cache_mock_entry_cnt(CACHE_PEER_PREFIX, false),
+		      "Discovery results not stored");
+	cache_hids_run(true);
+	zassert_equal(2, bt_gatt_cache_mock_read_cnt(), "Database Hash not read");
+
+	/* The following services are cached separately. */
+	dm = run_dm(NULL);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	dm = run_dm_next(dm);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(5,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	dm = run_dm_next(dm);
+	zassert_is_null(dm, "Unexpected service detected");
+
+	discover_cnt = bt_gatt_discover_mock_call_cnt();
+
+	dm = run_dm(NULL);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	dm = run_dm_next(dm);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(5,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	zassert_equal(discover_cnt, bt_gatt_discover_mock_call_cnt(),
+		      "Service discovered instead of loaded from the cache");
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_cache_hash_mismatch(void)
+{
+	bt_gatt_cache_mock_setup(true, db_hash_a);
+	cache_hids_run(false);
+
+	/* Stale results must not be used after the peer database changed. */
+	bt_gatt_cache_mock_setup(true, db_hash_b);
+	cache_hids_run(false);
+	cache_hids_run(true);
+
+	bt_gatt_cache_mock_setup(true, db_hash_a);
+	cache_hids_run(false);
+}
+
+void test_gatt_cache_inactive(void)
+{
+	/* Peers without the Database Hash are always discovered. */
+	bt_gatt_cache_mock_setup(true, NULL);
+	cache_hids_run(false);
+	cache_hids_run(false);
+	zassert_equal(0, bt_gatt_cache_mock_entry_cnt(CACHE_PEER_PREFIX, false),
+		      "Unexpected cache entry");
+
+	/* Peers that are not bonded cannot be identified. */
+	bt_gatt_cache_mock_setup(false, db_hash_a);
+	cache_hids_run(false);
+	cache_hids_run(false);
+	zassert_equal(0, bt_gatt_cache_mock_read_cnt(), "Unexpected Database Hash read");
+	zassert_equal(0, bt_gatt_cache_mock_entry_cnt(CACHE_PEER_PREFIX, false),
+		      "Unexpected cache entry");
+}
+
+void test_gatt_cache_clear(void)
+{
+	static const uint8_t dummy[4] = { 0 };
+	bt_addr_le_t other = bt_gatt_cache_mock_peer;
+	char key[SETTINGS_MAX_NAME_LEN];
+	int err;
+
+	bt_gatt_cache_mock_setup(true, db_hash_a);
+	cache_hids_run(false);
+
+	/* More entries than cleared in a single pass. */
+	for (int i = 0; i < 5; i++) {
+		snprintk(key, sizeof(key), CACHE_PEER_PREFIX "/0000000%d/0001", i);
+		err = settings_save_one(key, dummy, sizeof(dummy));
+		zassert_equal(0, err, "Cannot store the entry: %d", err);
+	}
+
+	/* Entry of another peer, with the address differing in one byte. */
+	other.a.val[0]++;
+	err = settings_save_one(OTHER_PEER_PREFIX "/00000000/0001", dummy, sizeof(dummy));
+	zassert_equal(0, err, "Cannot store the entry: %d", err);
+
+	err = bt_gatt_dm_cache_clear(&bt_gatt_cache_mock_peer);
+	zassert_equal(0, err, "Cannot clear the cache: %d", err);
+	zassert_equal(0, bt_gatt_cache_mock_entry_cnt(CACHE_PEER_PREFIX, false),
+		      "Cache entries left after clearing");
+	zassert_equal(6, bt_gatt_cache_mock_entry_cnt(CACHE_PEER_PREFIX, true),
+		      "Unexpected number of deleted entries");
+
+	/* Clearing again only finds the deleted entries. */
+	err = bt_gatt_dm_cache_clear(&bt_gatt_cache_mock_peer);
+	zassert_equal(0, err, "Cannot clear the cache: %d", err);
+
+	/* Other peers are not affected. */
+	zassert_equal(1, bt_gatt_cache_mock_entry_cnt(OTHER_PEER_PREFIX, false),
+		      "Cache entry of another peer removed");
+	err = bt_gatt_dm_cache_clear(&other);
+	zassert_equal(0, err, "Cannot clear the cache: %d", err);
+	zassert_equal(0, bt_gatt_cache_mock_entry_cnt(OTHER_PEER_PREFIX, false),
+		      "Cache entries left after clearing");
+
+	cache_hids_run(false);
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 void test_main(void)
 {
 	ztest_test_suite(
@@ -387,8 +616,21 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_attr_by_handle, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_next_chrc_access, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid_128, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop)
 	);
 
 	ztest_run_test_suite(test_gatt);
+
+#if CONFIG_BT_GATT_DM_CACHE
+	ztest_test_suite(
+		test_gatt_cache,
+		ztest_unit_test_setup_teardown(test_gatt_cache_round_trip, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_hash_mismatch, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_inactive, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_clear, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_gatt_cache);
+#endif
 }
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <string.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/services/nus.h>
+
+/* ATT MTU of the mocked connection, notifications carry up to 20 bytes. */
+#define ATT_MTU			23
+#define NOTIFY_MAX_LEN		(ATT_MTU - 3)
+#define IN_FLIGHT_MAX		CONFIG_BT_NUS_STREAM_MAX_IN_FLIGHT
+#define STREAM_BUF_SIZE		CONFIG_BT_NUS_STREAM_BUF_SIZE
+
+/* Time needed to process the TX work, including a retry. */
+#define TX_PROCESS_TIME		K_MSEC(50)
+
+#define NOTIFY_MAX_CNT		32
+#define RX_BUF_SIZE		256
+
+static char dummy_conn_a;
+static char dummy_conn_b;
+
+#define CONN_A ((struct bt_conn *)&dummy_conn_a)
+#define CONN_B ((struct bt_conn *)&dummy_conn_b)
+
+/* Notifications passed to the mocked stack */
+static struct {
+	struct bt_conn *conn;
+	bt_gatt_complete_func_t func;
+	uint16_t len;
+	bool completed;
+} notify[NOTIFY_MAX_CNT];
+
+static size_t notify_cnt;
+static size_t complete_cnt;
+static size_t call_cnt;
+
+static uint8_t rx_buf[RX_BUF_SIZE];
+static size_t rx_len;
+
+/* Error returned for the notify calls, the call index is counted from 1. */
+static size_t fail_call;
+static int fail_err;
+/* Disable the stream from within the notify call with the given index. */
+static size_t disable_call;
+
+static atomic_t conn_ref_cnt;
+static size_t space_available_cnt;
+/* Free space of the empty stream buffer */
+static size_t buf_space;
+
+
+struct bt_conn *__real_bt_conn_ref(struct bt_conn *conn);
+void __real_bt_conn_unref(struct bt_conn *conn);
+
+static bool is_dummy_conn(const struct bt_conn *conn)
+{
+	return (conn == CONN_A) || (conn == CONN_B);
+}
+
+struct bt_conn *__wrap_bt_conn_ref(struct bt_conn *conn)
+{
+	if (!is_dummy_conn(conn)) {
+		return __real_bt_conn_ref(conn);
+	}
+
+	atomic_inc(&conn_ref_cnt);
+
+	return conn;
+}
+
+void __wrap_bt_conn_unref(struct bt_conn *conn)
+{
+	if (!is_dummy_conn(conn)) {
+		__real_bt_conn_unref(conn);
+		return;
+	}
+
+	zassert_true(atomic_dec(&conn_ref_cnt) > 0, "Unbalanced connection unref");
+}
+
+uint16_t __wrap_bt_gatt_get_mtu(struct bt_conn *conn)
+{
+	return ATT_MTU;
+}
+
+bool __wrap_bt_gatt_is_subscribed(struct bt_conn *conn,
+				  const struct bt_gatt_attr *attr, uint16_t ccc_value)
+{
+	return is_dummy_conn(conn) && (ccc_value == BT_GATT_CCC_NOTIFY);
+}
+
+int __wrap_bt_gatt_notify_cb(struct bt_conn *conn,
+			     struct bt_gatt_notify_params *params)
+{
+	call_cnt++;
+
+	if (call_cnt == disable_call) {
+		bt_nus_stream_disable();
+	}
+
+	if (call_cnt == fail_call) {
+		return fail_err;
+	}
+
+	zassert_true(notify_cnt < NOTIFY_MAX_CNT, "Too many notifications");
+	zassert_true(params->len <= NOTIFY_MAX_LEN, "Notification exceeds MTU");
+	zassert_true(rx_len + params->len <= sizeof(rx_buf), "RX buffer overflow");
+
+	notify[notify_cnt].conn = conn;
+	notify[notify_cnt].func = params->func;
+	notify[notify_cnt].len = params->len;
+	notify[notify_cnt].completed = false;
+	notify_cnt++;
+
+	memcpy(&rx_buf[rx_len], params->data, params->len);
+	rx_len += params->len;
+
+	return 0;
+}
+
+static void stream_space_available(void)
+{
+	space_available_cnt++;
+}
+
+static struct bt_nus_cb nus_cb = {
+	.stream_space_available = stream_space_available,
+};
+
+/* Simulates sending of the oldest queued notification by the stack. */
+static void notify_complete(void)
+{
+	zassert_true(complete_cnt < notify_cnt, "No notification to complete");
+
+	notify[complete_cnt].completed = true;
+	notify[complete_cnt].func(notify[complete_cnt].conn, NULL);
+	complete_cnt++;
+
+	k_sleep(TX_PROCESS_TIME);
+}
+
+static size_t in_flight_cnt(void)
+{
+	return notify_cnt - complete_cnt;
+}
+
+static void stream_write(const uint8_t *data, size_t len)
+{
+	int written = bt_nus_stream_write(data, len);
+
+	zassert_equal(len, written, "Unexpected number of written bytes: %d", written);
+	k_sleep(TX_PROCESS_TIME);
+}
+
+static void pattern_fill(uint8_t *data, size_t len, uint8_t start)
+{
+	for (size_t i = 0; i < len; i++) {
+		data[i] = start + i;
+	}
+}
+
+static void test_setup(void)
+{
+	memset(notify, 0, sizeof(notify));
+	notify_cnt = 0;
+	complete_cnt = 0;
+	call_cnt = 0;
+	rx_len = 0;
+	fail_call = 0;
+	fail_err = 0;
+	disable_call = 0;
+	space_available_cnt = 0;
+
+	zassert_ok(bt_nus_init(&nus_cb), "NUS initialization failed");
+	zassert_ok(bt_nus_stream_enable(CONN_A), "Cannot enable the stream");
+	buf_space = bt_nus_stream_space_get();
+}
+
+static void test_teardown(void)
+{
+	bt_nus_stream_disable();
+	k_sleep(TX_PROCESS_TIME);
+
+	zassert_equal(0, atomic_get(&conn_ref_cnt), "Connection reference leaked");
+}
+
+static void test_batching(void)
+{
+	uint8_t data[17 + NOTIFY_MAX_LEN];
+
+	pattern_fill(data, sizeof(data), 0);
+
+	/* Data is sent right away if nothing is in flight. */
+	stream_write(data, 5);
+	zassert_equal(1, notify_cnt, "Data not sent");
+	zassert_equal(5, notify[0].len, "Unexpected notification length");
+
+	/* Short data is held while a notification is in flight. */
+	stream_write(&data[5], 5);
+	stream_write(&data[10], 7);
+	zassert_equal(1, notify_cnt, "Short notification sent while in flight");
+
+	/* The held data is merged into a single notification. */
+	notify_complete();
+	zassert_equal(2, notify_cnt, "Held data not sent");
+	zassert_equal(12, notify[1].len, "Held data not merged");
+
+	/* Data that fills the MTU is sent while a notification is in flight. */
+	stream_write(&data[17], NOTIFY_MAX_LEN);
+	zassert_equal(3, notify_cnt, "Full notification not sent");
+	zassert_equal(NOTIFY_MAX_LEN, notify[2].len, "Unexpected notification length");
+
+	notify_complete();
+	notify_complete();
+	zassert_equal(3, notify_cnt, "Unexpected notification");
+
+	zassert_equal(sizeof(data), rx_len, "Unexpected number of received bytes");
+	zassert_mem_equal(data, rx_buf, sizeof(data), "Data corrupted");
+}
+
+static void test_in_flight_cap(void)
+{
+	uint8_t data[STREAM_BUF_SIZE + NOTIFY_MAX_LEN];
+	int written;
+
+	pattern_fill(data, sizeof(data), 0x40);
+
+	/* The buffer accepts only a part of the data. */
+	written = bt_nus_stream_write(data, sizeof(data));
+	zassert_true((written > 0) && (written <= STREAM_BUF_SIZE),
+		     "Unexpected number of written bytes: %d", written);
+	k_sleep(TX_PROCESS_TIME);
+
+	zassert_equal(IN_FLIGHT_MAX, in_flight_cnt(), "In-flight limit not used");
+	zassert_true(space_available_cnt > 0, "Space availability not reported");
+
+	/* Every completion releases a single notification. */
+	while (in_flight_cnt() > 0) {
+		size_t prev_cnt = notify_cnt;
+
+		notify_complete();
+		zassert_true(notify_cnt <= prev_cnt + 1, "In-flight limit exceeded");
+		zassert_true(in_flight_cnt() <= IN_FLIGHT_MAX, "In-flight limit exceeded");
+	}
+	zassert_equal(written, rx_len, "Unexpected number of received bytes");
+
+	stream_write(&data[written], sizeof(data) - written);
+	while (in_flight_cnt() > 0) {
+		notify_complete();
+	}
+
+	zassert_equal(sizeof(data), rx_len, "Unexpected number of received bytes");
+	zassert_mem_equal(data, rx_buf, sizeof(data), "Data corrupted");
+	zassert_equal(buf_space, bt_nus_stream_space_get(), "Buffer not emptied");
+}
+
+static void test_retry_idle(void)
+{
+	uint8_t data[10];
+
+	pattern_fill(data, sizeof(data), 0x80);
+
+	/* Nothing is in flight, so the retry is scheduled by the stream. */
+	fail_call = 1;
+	fail_err = -ENOMEM;
+	stream_write(data, sizeof(data));
+
+	zassert_true(call_cnt > 1, "Notification not retried");
+	zassert_equal(1, notify_cnt, "Unexpected number of notifications");
+	zassert_equal(sizeof(data), rx_len, "Data lost on failure");
+	zassert_mem_equal(data, rx_buf, sizeof(data), "Data corrupted");
+}
+
+static void test_retry_in_flight(void)
+{
+	uint8_t data[2 * NOTIFY_MAX_LEN];
+
+	pattern_fill(data, sizeof(data), 0xa0);
+
+	/* The second notification fails while the first one is in flight. */
+	fail_call = 2;
+	fail_err = -ENOMEM;
+	stream_write(data, sizeof(data));
+
+	zassert_equal(1, notify_cnt, "Unexpected number of notifications");
+	zassert_equal(2, call_cnt, "Retry not left to the completion");
+
+	/* The completion triggers the retry. */
+	notify_complete();
+	zassert_equal(2, notify_cnt, "Notification not retried");
+	notify_complete();
+
+	zassert_equal(sizeof(data), rx_len, "Data lost on failure");
+	zassert_mem_equal(data, rx_buf, sizeof(data), "Data corrupted");
+}
+
+static void test_drop_not_connected(void)
+{
+	uint8_t data[10];
+
+	pattern_fill(data, sizeof(data), 0);
+
+	fail_call = 1;
+	fail_err = -ENOTCONN;
+	stream_write(data, sizeof(data));
+
+	zassert_equal(1, call_cnt, "Unexpected retry");
+	zassert_equal(0, rx_len, "Unexpected data");
+	zassert_equal(buf_space, bt_nus_stream_space_get(), "Data not dropped");
+}
+
+static void test_reset_while_claimed(void)
+{
+	uint8_t data[2 * NOTIFY_MAX_LEN];
+
+	pattern_fill(data, sizeof(data), 0x10);
+
+	/* The stream is disabled while the TX work holds the claimed data. */
+	disable_call = 1;
+	stream_write(data, sizeof(data));
+
+	zassert_equal(1, call_cnt, "Data sent after the stream was disabled");
+	zassert_equal(buf_space, bt_nus_stream_space_get(),
+		      "Buffer not reset after the claim was released");
+	zassert_equal(-ENOTCONN, bt_nus_stream_write(data, sizeof(data)),
+		      "Write to a disabled stream");
+
+	/* The buffer is consistent once the stream is enabled again. */
+	zassert_ok(bt_nus_stream_enable(CONN_A), "Cannot enable the stream");
+	rx_len = 0;
+	stream_write(data, sizeof(data));
+	while (rx_len < sizeof(data)) {
+		notify_complete();
+	}
+
+	zassert_mem_equal(data, rx_buf, sizeof(data), "Data corrupted");
+}
+
+static void test_rebind(void)
+{
+	uint8_t data[IN_FLIGHT_MAX * NOTIFY_MAX_LEN];
+	size_t prev_cnt;
+
+	pattern_fill(data, sizeof(data), 0x20);
+
+	/* The link is lost while the in-flight limit is reached. */
+	stream_write(data, sizeof(data));
+	zassert_equal(IN_FLIGHT_MAX, in_flight_cnt(), "In-flight limit not used");
+	bt_nus_stream_disable();
+
+	/* The new connection is not blocked by the lost notifications. */
+	zassert_ok(bt_nus_stream_enable(CONN_B), "Cannot enable the stream");
+	prev_cnt = notify_cnt;
+	stream_write(data, sizeof(data));
+	zassert_equal(prev_cnt + IN_FLIGHT_MAX, notify_cnt, "Stream blocked after rebind");
+	zassert_equal(CONN_B, notify[prev_cnt].conn, "Unexpected connection");
+
+	/* Completions of the previous connection are ignored. */
+	stream_write(data, NOTIFY_MAX_LEN);
+	prev_cnt = notify_cnt;
+	notify[0].func(CONN_A, NULL);
+	k_sleep(TX_PROCESS_TIME);
+	zassert_equal(prev_cnt, notify_cnt, "Stale completion released the limit");
+
+	/* Completions of the current connection release the limit. */
+	complete_cnt = notify_cnt - IN_FLIGHT_MAX;
+	notify_complete();
+	zassert_equal(prev_cnt + 1, notify_cnt, "Data not sent after completion");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_nus_stream,
+		ztest_unit_test_setup_teardown(test_batching, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_in_flight_cap, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_retry_idle, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_retry_in_flight, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_drop_not_connected, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_reset_while_claimed, test_setup, test_teardown),
+		ztest_unit_test_setup_teardown(test_rebind, test_setup, test_teardown)
+	);
+
+	ztest_run_test_suite(test_nus_stream);
+}
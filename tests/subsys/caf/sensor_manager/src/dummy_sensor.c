@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <device.h>
+#include <drivers/sensor.h>
+
+#include "dummy_sensor.h"
+
+#define FETCH_CNT_MAX	128
+
+struct dummy_sensor_config {
+	unsigned int fetch_delay_ms;
+	bool delay_once;
+};
+
+struct dummy_sensor_data {
+	bool delayed;
+	unsigned int fetch_cnt;
+};
+
+static struct dummy_sensor_fetch fetches[FETCH_CNT_MAX];
+static size_t fetch_cnt;
+static struct k_spinlock lock;
+
+static void fetch_record(const struct device *dev)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (fetch_cnt < ARRAY_SIZE(fetches)) {
+		struct dummy_sensor_fetch *fetch = &fetches[fetch_cnt];
+
+		fetch->dev_name = dev->name;
+		strncpy(fetch->thread_name, k_thread_name_get(k_current_get()),
+			sizeof(fetch->thread_name) - 1);
+		fetch_cnt++;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+size_t dummy_sensor_fetches_get(struct dummy_sensor_fetch *dst, size_t max_cnt)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t cnt = MIN(fetch_cnt, max_cnt);
+
+	memcpy(dst, fetches, cnt * sizeof(fetches[0]));
+	k_spin_unlock(&lock, key);
+
+	return cnt;
+}
+
+static int dummy_sensor_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+	const struct dummy_sensor_config *config = dev->config;
+	struct dummy_sensor_data *data = dev->data;
+
+	fetch_record(dev);
+	data->fetch_cnt++;
+
+	if ((config->fetch_delay_ms > 0) && !(config->delay_once && data->delayed)) {
+		data->delayed = true;
+		k_msleep(config->fetch_delay_ms);
+	}
+
+	return 0;
+}
+
+static int dummy_sensor_channel_get(const struct device *dev, enum sensor_channel chan,
+				    struct sensor_value *val)
+{
+	const struct dummy_sensor_data *data = dev->data;
+
+	/* Number of the fetched sample, so that lost or repeated samples can be detected. */
+	val->val1 = data->fetch_cnt;
+	val->val2 = 0;
+
+	return 0;
+}
+
+static int dummy_sensor_init(const struct device *dev)
+{
+	return 0;
+}
+
+static const struct sensor_driver_api dummy_sensor_api = {
+	.sample_fetch = dummy_sensor_sample_fetch,
+	.channel_get = dummy_sensor_channel_get,
+};
+
+#define DUMMY_SENSOR_DEFINE(id, name, delay_ms, once)				\
+	static const struct dummy_sensor_config dummy_sensor_config_##id = {	\
+		.fetch_delay_ms = delay_ms,					\
+		.delay_once = once,						\
+	};									\
+	static struct dummy_sensor_data dummy_sensor_data_##id;		\
+	DEVICE_DEFINE(dummy_sensor_##id, name, dummy_sensor_init, NULL,		\
+		      &dummy_sensor_data_##id, &dummy_sensor_config_##id,	\
+		      POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,			\
+		      &dummy_sensor_api)
+
+DUMMY_SENSOR_DEFINE(stall, DUMMY_SENSOR_STALL, DUMMY_SENSOR_STALL_MS, true);
+DUMMY_SENSOR_DEFINE(fast_a, DUMMY_SENSOR_FAST_A, 0, false);
+DUMMY_SENSOR_DEFINE(fast_b, DUMMY_SENSOR_FAST_B, 0, false);
+DUMMY_SENSOR_DEFINE(slow, DUMMY_SENSOR_SLOW, DUMMY_SENSOR_SLOW_MS, false);
+DUMMY_SENSOR_DEFINE(batch, DUMMY_SENSOR_BATCH, 0, false);
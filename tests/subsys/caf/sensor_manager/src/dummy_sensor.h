@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _DUMMY_SENSOR_H_
+#define _DUMMY_SENSOR_H_
+
+#include <zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sensor that blocks its sampling thread on the first fetch. */
+#define DUMMY_SENSOR_STALL	"DUMMY_STALL"
+#define DUMMY_SENSOR_STALL_MS	50
+/* Sensors sampled by the same thread as the stalling sensor. */
+#define DUMMY_SENSOR_FAST_A	"DUMMY_FAST_A"
+#define DUMMY_SENSOR_FAST_B	"DUMMY_FAST_B"
+/* Sensor that is slow to sample on every fetch. */
+#define DUMMY_SENSOR_SLOW	"DUMMY_SLOW"
+#define DUMMY_SENSOR_SLOW_MS	20
+/* Sensor that submits multiple samples in a single event. */
+#define DUMMY_SENSOR_BATCH		"DUMMY_BATCH"
+#define DUMMY_SENSOR_BATCH_SAMPLE_CNT	4
+
+/** @brief Sample fetch recorded by the dummy sensor driver. */
+struct dummy_sensor_fetch {
+	const char *dev_name;
+	char thread_name[CONFIG_THREAD_MAX_NAME_LEN];
+};
+
+/**
+ * @brief Get the sample fetches recorded so far, in order.
+ *
+ * @param[out] fetches Array to copy the fetches to.
+ * @param[in] max_cnt Size of the array.
+ *
+ * @return Number of copied fetches.
+ */
+size_t dummy_sensor_fetches_get(struct dummy_sensor_fetch *fetches, size_t max_cnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DUMMY_SENSOR_H_ */
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <event_manager.h>
+#include <caf/events/sensor_event.h>
+
+#include "dummy_sensor.h"
+
+#define MODULE main
+#include <caf/events/module_state_event.h>
+
+#define SAMPLING_TIME_MS	300
+#define FETCH_CNT_MAX		128
+#define BATCH_EVENT_CNT_MAX	8
+
+/* Thread assignment of the sensors, as in sensor_manager_def.h. */
+static const struct {
+	const char *dev_name;
+	const char *thread_name;
+} sensor_threads[] = {
+	{ DUMMY_SENSOR_STALL, "caf_sensor_manager_0" },
+	{ DUMMY_SENSOR_FAST_B, "caf_sensor_manager_0" },
+	{ DUMMY_SENSOR_FAST_A, "caf_sensor_manager_0" },
+	{ DUMMY_SENSOR_SLOW, "caf_sensor_manager_1" },
+	{ DUMMY_SENSOR_BATCH, "caf_sensor_manager_1" },
+};
+
+struct batch_event {
+	uint8_t sample_cnt;
+	size_t data_cnt;
+	size_t sample_data_cnt;
+	float data[DUMMY_SENSOR_BATCH_SAMPLE_CNT];
+};
+
+static struct dummy_sensor_fetch fetches[FETCH_CNT_MAX];
+static size_t fetch_cnt;
+
+static struct batch_event batch_events[BATCH_EVENT_CNT_MAX];
+static atomic_t batch_event_cnt;
+static atomic_t single_sample_err_cnt;
+
+static bool handle_sensor_event(const struct sensor_event *event)
+{
+	if (strcmp(event->descr, "batch")) {
+		/* Sensors without batching submit one sample per event. */
+		if (event->sample_cnt != 1) {
+			atomic_inc(&single_sample_err_cnt);
+		}
+		return false;
+	}
+
+	size_t idx = atomic_get(&batch_event_cnt);
+
+	if (idx < ARRAY_SIZE(batch_events)) {
+		struct batch_event *be = &batch_events[idx];
+
+		be->sample_cnt = event->sample_cnt;
+		be->data_cnt = sensor_event_get_data_cnt(event);
+		be->sample_data_cnt = sensor_event_get_sample_data_cnt(event);
+		memcpy(be->data, sensor_event_get_data_ptr(event),
+		       MIN(be->data_cnt, ARRAY_SIZE(be->data)) * sizeof(be->data[0]));
+		atomic_inc(&batch_event_cnt);
+	}
+
+	return false;
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_sensor_event(eh)) {
+		return handle_sensor_event(cast_sensor_event(eh));
+	}
+
+	/* If event is unhandled, unsubscribe. */
+	__ASSERT_NO_MSG(false);
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE(MODULE, sensor_event);
+
+static const char *thread_name_get(const char *dev_name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_threads); i++) {
+		if (!strcmp(sensor_threads[i].dev_name, dev_name)) {
+			return sensor_threads[i].thread_name;
+		}
+	}
+
+	zassert_unreachable("Unknown sensor %s", dev_name);
+
+	return NULL;
+}
+
+static size_t fetch_cnt_get(const char *dev_name)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < fetch_cnt; i++) {
+		if (!strcmp(fetches[i].dev_name, dev_name)) {
+			cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+static void test_init(void)
+{
+	zassert_false(event_manager_init(), "Error when initializing");
+
+	/* Sensor manager starts sampling when the main module is ready. */
+	module_set_state(MODULE_STATE_READY);
+	k_msleep(SAMPLING_TIME_MS);
+
+	fetch_cnt = dummy_sensor_fetches_get(fetches, ARRAY_SIZE(fetches));
+	zassert_true(fetch_cnt < ARRAY_SIZE(fetches), "Too many fetches recorded");
+}
+
+static void test_thread_assignment(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(sensor_threads); i++) {
+		zassert_true(fetch_cnt_get(sensor_threads[i].dev_name) > 0,
+			     "Sensor %s not sampled", sensor_threads[i].dev_name);
+	}
+
+	for (size_t i = 0; i < fetch_cnt; i++) {
+		const char *expected = thread_name_get(fetches[i].dev_name);
+
+		zassert_true(!strcmp(fetches[i].thread_name, expected),
+			     "Sensor %s sampled by %s, expected %s", fetches[i].dev_name,
+			     fetches[i].thread_name, expected);
+	}
+
+	/* The slow sensor, sampled by the second thread, does not delay the fast sensor. */
+	zassert_true(fetch_cnt_get(DUMMY_SENSOR_FAST_A) >=
+		     (SAMPLING_TIME_MS - 2 * DUMMY_SENSOR_STALL_MS) / 14,
+		     "Fast sensor sampled too rarely");
+}
+
+static void test_edf_order(void)
+{
+	static const char * const expected[] = {
+		DUMMY_SENSOR_FAST_A,
+		DUMMY_SENSOR_FAST_B,
+		DUMMY_SENSOR_STALL,
+	};
+	size_t i = 0;
+	size_t checked = 0;
+
+	/* Find the fetch that stalls the first thread. */
+	while ((i < fetch_cnt) && strcmp(fetches[i].dev_name, DUMMY_SENSOR_STALL)) {
+		i++;
+	}
+	zassert_true(i < fetch_cnt, "Stalling sensor not sampled");
+
+	/* Overdue sensors are sampled in the order of their deadlines. */
+	for (i++; (i < fetch_cnt) && (checked < ARRAY_SIZE(expected)); i++) {
+		if (!strcmp(fetches[i].dev_name, DUMMY_SENSOR_SLOW) ||
+		    !strcmp(fetches[i].dev_name, DUMMY_SENSOR_BATCH)) {
+			continue;
+		}
+
+		zassert_true(!strcmp(fetches[i].dev_name, expected[checked]),
+			     "Sampled %s, expected %s", fetches[i].dev_name, expected[checked]);
+		checked++;
+	}
+
+	zassert_equal(checked, ARRAY_SIZE(expected), "Not enough fetches recorded");
+}
+
+static void test_batching(void)
+{
+	size_t event_cnt = atomic_get(&batch_event_cnt);
+
+	zassert_equal(atomic_get(&single_sample_err_cnt), 0,
+		      "Sensor without batching submitted multiple samples");
+
+	/* At least two full batches, so that the batch buffer is reused. */
+	zassert_true(event_cnt >= 2, "Not enough batch events submitted");
+
+	for (size_t i = 0; i < event_cnt; i++) {
+		const struct batch_event *be = &batch_events[i];
+
+		zassert_equal(be->sample_cnt, DUMMY_SENSOR_BATCH_SAMPLE_CNT,
+			      "Invalid sample count in event %zu", i);
+		zassert_equal(be->data_cnt, DUMMY_SENSOR_BATCH_SAMPLE_CNT,
+			      "Invalid data count in event %zu", i);
+		zassert_equal(be->sample_data_cnt, 1, "Invalid sample size in event %zu", i);
+
+		/* The dummy sensor returns the number of the fetched sample. Samples of
+		 * the consecutive events follow each other, with no sample lost or
+		 * repeated when the batch buffer is filled again.
+		 */
+		for (size_t j = 0; j < DUMMY_SENSOR_BATCH_SAMPLE_CNT; j++) {
+			float expected = i * DUMMY_SENSOR_BATCH_SAMPLE_CNT + j + 1;
+
+			zassert_equal(be->data[j], expected,
+				      "Invalid sample %zu in event %zu", j, i);
+		}
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(caf_sensor_manager_tests,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_thread_assignment),
+			 ztest_unit_test(test_edf_order),
+			 ztest_unit_test(test_batching)
+			 );
+
+	ztest_run_test_suite(caf_sensor_manager_tests);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <caf/sensor_manager.h>
+
+#include "dummy_sensor.h"
+
+/* This configuration file is included only once from sensor_manager module and holds
+ * information about the sampled sensors.
+ */
+
+/* This structure enforces the header file is included only once in the build.
+ * Violating this requirement triggers a multiple definition error at link time.
+ */
+const struct {} sensor_manager_def_include_once;
+
+static const struct sm_sampled_channel dummy_chan[] = {
+	{
+		.chan = SENSOR_CHAN_AMBIENT_TEMP,
+		.data_cnt = 1,
+	},
+};
+
+/* Periods are chosen so that, when the stalling sensor returns, both fast sensors are
+ * overdue with distinct deadlines (42 and 44 ms) earlier than the next deadline of the
+ * stalling sensor (80 ms). Sensors are listed in the reverse order of their deadlines.
+ */
+static const struct sm_sensor_config sensor_configs[] = {
+	{
+		.dev_name = DUMMY_SENSOR_STALL,
+		.event_descr = "stall",
+		.chans = dummy_chan,
+		.chan_cnt = ARRAY_SIZE(dummy_chan),
+		.sampling_period_ms = 40,
+		.active_events_limit = 3,
+		.thread_id = 0,
+	},
+	{
+		.dev_name = DUMMY_SENSOR_FAST_B,
+		.event_descr = "fast_b",
+		.chans = dummy_chan,
+		.chan_cnt = ARRAY_SIZE(dummy_chan),
+		.sampling_period_ms = 22,
+		.active_events_limit = 3,
+		.thread_id = 0,
+	},
+	{
+		.dev_name = DUMMY_SENSOR_FAST_A,
+		.event_descr = "fast_a",
+		.chans = dummy_chan,
+		.chan_cnt = ARRAY_SIZE(dummy_chan),
+		.sampling_period_ms = 14,
+		.active_events_limit = 3,
+		.thread_id = 0,
+	},
+	{
+		.dev_name = DUMMY_SENSOR_SLOW,
+		.event_descr = "slow",
+		.chans = dummy_chan,
+		.chan_cnt = ARRAY_SIZE(dummy_chan),
+		.sampling_period_ms = 30,
+		.active_events_limit = 3,
+		.thread_id = 1,
+	},
+	{
+		.dev_name = DUMMY_SENSOR_BATCH,
+		.event_descr = "batch",
+		.chans = dummy_chan,
+		.chan_cnt = ARRAY_SIZE(dummy_chan),
+		.sampling_period_ms = 25,
+		.active_events_limit = 3,
+		.event_sample_cnt = DUMMY_SENSOR_BATCH_SAMPLE_CNT,
+		.thread_id = 1,
+	},
+};
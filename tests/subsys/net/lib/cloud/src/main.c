@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <net/cloud.h>
+
+#define PUBLISH_MAX	16
+#define CB_MAX		16
+#define CB_TIMEOUT	K_SECONDS(1)
+
+/* Publish received by the broker stand-in. */
+struct publish {
+	char payload[16];
+	enum cloud_qos qos;
+	uint16_t message_id;
+};
+
+/* Status reported in a send callback. */
+struct cb_status {
+	struct cloud_send_req *req;
+	enum cloud_send_status status;
+	int err;
+};
+
+static struct publish publishes[PUBLISH_MAX];
+static size_t publish_count;
+static int publish_err;
+
+static struct cb_status cb_statuses[CB_MAX];
+static size_t cb_count;
+static size_t cb_read;
+static K_SEM_DEFINE(cb_sem, 0, CB_MAX);
+
+/* Backend acting as an MQTT broker stand-in. Publishes are recorded, and acknowledgments
+ * and connection events are triggered by the test.
+ */
+static int broker_publish(const struct cloud_msg *const msg, uint16_t message_id)
+{
+	struct publish *p;
+
+	if (publish_err) {
+		return publish_err;
+	}
+
+	zassert_true(publish_count < PUBLISH_MAX, "Too many publishes");
+
+	p = &publishes[publish_count++];
+	strncpy(p->payload, msg->buf, MIN(msg->len, sizeof(p->payload) - 1));
+	p->payload[MIN(msg->len, sizeof(p->payload) - 1)] = '\0';
+	p->qos = msg->qos;
+	p->message_id = message_id;
+
+	return 0;
+}
+
+static int broker_send(const struct cloud_backend *const backend,
+		       const struct cloud_msg *const msg)
+{
+	return broker_publish(msg, 0);
+}
+
+static int broker_send_with_id(const struct cloud_backend *const backend,
+			       const struct cloud_msg *const msg,
+			       uint16_t message_id)
+{
+	return broker_publish(msg, message_id);
+}
+
+static const struct cloud_api broker_api = {
+	.send = broker_send,
+	.send_with_id = broker_send_with_id,
+};
+
+CLOUD_BACKEND_DEFINE(TEST_BROKER, broker_api);
+
+static void broker_evt_notify(enum cloud_event_type type)
+{
+	struct cloud_event evt = {
+		.type = type
+	};
+
+	cloud_notify_event((struct cloud_backend *)&TEST_BROKER, &evt, NULL);
+}
+
+static void broker_puback(uint16_t message_id)
+{
+	cloud_send_ack_notify(&TEST_BROKER, message_id, 0);
+}
+
+static void send_cb(const struct cloud_backend *const backend,
+		    struct cloud_send_req *req,
+		    enum cloud_send_status status, int err)
+{
+	zassert_equal_ptr(backend, &TEST_BROKER, "Wrong backend");
+	zassert_true(cb_count < CB_MAX, "Too many callbacks");
+
+	cb_statuses[cb_count++] = (struct cb_status) {
+		.req = req,
+		.status = status,
+		.err = err
+	};
+
+	k_sem_give(&cb_sem);
+}
+
+static void req_init(struct cloud_send_req *req, char *payload, enum cloud_qos qos,
+		     enum cloud_send_prio prio)
+{
+	*req = (struct cloud_send_req) {
+		.msg.buf = payload,
+		.msg.len = strlen(payload),
+		.msg.qos = qos,
+		.msg.endpoint.type = CLOUD_EP_MSG,
+		.prio = prio,
+		.cb = send_cb
+	};
+}
+
+static void status_check(struct cloud_send_req *req, enum cloud_send_status status, int err)
+{
+	struct cb_status *s;
+
+	zassert_equal(k_sem_take(&cb_sem, CB_TIMEOUT), 0, "No callback");
+
+	s = &cb_statuses[cb_read++];
+	zassert_equal_ptr(s->req, req, "Wrong request");
+	zassert_equal(s->status, status, "Wrong status %d", s->status);
+	zassert_equal(s->err, err, "Wrong error %d", s->err);
+}
+
+static void no_status_check(void)
+{
+	zassert_not_equal(k_sem_take(&cb_sem, K_MSEC(100)), 0, "Unexpected callback");
+}
+
+static void setup(void)
+{
+	publish_count = 0;
+	publish_err = 0;
+	cb_count = 0;
+	cb_read = 0;
+	k_sem_reset(&cb_sem);
+
+	broker_evt_notify(CLOUD_EVT_READY);
+}
+
+static void teardown(void)
+{
+	/* Fails messages waiting for acknowledgment. */
+	broker_evt_notify(CLOUD_EVT_DISCONNECTED);
+	k_sleep(K_MSEC(100));
+}
+
+static void test_send_qos0(void)
+{
+	struct cloud_send_req req;
+
+	req_init(&req, "qos0", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req), 0, "Send failed");
+
+	status_check(&req, CLOUD_SEND_STATUS_SENT, 0);
+	no_status_check();
+
+	zassert_equal(publish_count, 1, "Wrong publish count");
+	zassert_equal(publishes[0].qos, CLOUD_QOS_AT_MOST_ONCE, "Wrong QoS");
+	zassert_equal(publishes[0].message_id, 0, "QoS 0 messages have no ID");
+	zassert_equal(strcmp(publishes[0].payload, "qos0"), 0, "Wrong payload");
+}
+
+static void test_send_qos1_ack(void)
+{
+	struct cloud_send_req req;
+
+	req_init(&req, "qos1", CLOUD_QOS_AT_LEAST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	zassert_true(cloud_send_ack_supported(&TEST_BROKER), "Acks should be supported");
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req), 0, "Send failed");
+
+	status_check(&req, CLOUD_SEND_STATUS_SENT, 0);
+	no_status_check();
+
+	zassert_equal(publish_count, 1, "Wrong publish count");
+	zassert_true(publishes[0].message_id >= CLOUD_SEND_MSG_ID_FIRST, "Wrong message ID");
+
+	/* Acknowledgments of other messages are ignored. */
+	broker_puback(publishes[0].message_id - 1);
+	no_status_check();
+
+	broker_puback(publishes[0].message_id);
+	status_check(&req, CLOUD_SEND_STATUS_ACKED, 0);
+}
+
+static void test_priority_order(void)
+{
+	struct cloud_send_req req[4];
+
+	broker_evt_notify(CLOUD_EVT_DISCONNECTED);
+
+	req_init(&req[0], "low", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_LOW);
+	req_init(&req[1], "normal1", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+	req_init(&req[2], "high", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_HIGH);
+	req_init(&req[3], "normal2", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(req); i++) {
+		zassert_equal(cloud_send_async(&TEST_BROKER, &req[i]), 0, "Send failed");
+	}
+
+	/* Nothing is sent until the backend is ready. */
+	no_status_check();
+	zassert_equal(publish_count, 0, "Sent while disconnected");
+
+	broker_evt_notify(CLOUD_EVT_READY);
+
+	status_check(&req[2], CLOUD_SEND_STATUS_SENT, 0);
+	status_check(&req[1], CLOUD_SEND_STATUS_SENT, 0);
+	status_check(&req[3], CLOUD_SEND_STATUS_SENT, 0);
+	status_check(&req[0], CLOUD_SEND_STATUS_SENT, 0);
+
+	zassert_equal(strcmp(publishes[0].payload, "high"), 0, "Wrong order");
+	zassert_equal(strcmp(publishes[1].payload, "normal1"), 0, "Wrong order");
+	zassert_equal(strcmp(publishes[2].payload, "normal2"), 0, "Wrong order");
+	zassert_equal(strcmp(publishes[3].payload, "low"), 0, "Wrong order");
+}
+
+static void test_backpressure(void)
+{
+	struct cloud_send_req req[CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE + 1];
+
+	broker_evt_notify(CLOUD_EVT_DISCONNECTED);
+
+	for (size_t i = 0; i < ARRAY_SIZE(req); i++) {
+		req_init(&req[i], "data", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+	}
+
+	for (size_t i = 0; i < CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE; i++) {
+		zassert_equal(cloud_send_async(&TEST_BROKER, &req[i]), 0, "Send failed");
+	}
+
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req[CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE]),
+		      -ENOBUFS, "Queue should be full");
+
+	/* A cancelled message makes room for a new one. */
+	zassert_equal(cloud_send_async_cancel(&TEST_BROKER, &req[0]), 0, "Cancel failed");
+	zassert_equal(cloud_send_async_cancel(&TEST_BROKER, &req[0]), -EBUSY,
+		      "Message is not queued");
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req[CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE]),
+		      0, "Send failed");
+
+	broker_evt_notify(CLOUD_EVT_READY);
+
+	for (size_t i = 1; i < ARRAY_SIZE(req); i++) {
+		status_check(&req[i], CLOUD_SEND_STATUS_SENT, 0);
+	}
+
+	no_status_check();
+	zassert_equal(publish_count, CONFIG_CLOUD_API_ASYNC_SEND_QUEUE_SIZE,
+		      "Wrong publish count");
+}
+
+static void test_in_flight_max(void)
+{
+	struct cloud_send_req req[CONFIG_CLOUD_API_ASYNC_SEND_IN_FLIGHT_MAX + 1];
+
+	for (size_t i = 0; i < ARRAY_SIZE(req); i++) {
+		req_init(&req[i], "data", CLOUD_QOS_AT_LEAST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+		zassert_equal(cloud_send_async(&TEST_BROKER, &req[i]), 0, "Send failed");
+	}
+
+	for (size_t i = 0; i < CONFIG_CLOUD_API_ASYNC_SEND_IN_FLIGHT_MAX; i++) {
+		status_check(&req[i], CLOUD_SEND_STATUS_SENT, 0);
+	}
+
+	/* The last message is sent when the first one is acknowledged. */
+	no_status_check();
+	zassert_equal(publish_count, CONFIG_CLOUD_API_ASYNC_SEND_IN_FLIGHT_MAX,
+		      "Wrong publish count");
+
+	broker_puback(publishes[0].message_id);
+
+	status_check(&req[0], CLOUD_SEND_STATUS_ACKED, 0);
+	status_check(&req[CONFIG_CLOUD_API_ASYNC_SEND_IN_FLIGHT_MAX], CLOUD_SEND_STATUS_SENT, 0);
+
+	for (size_t i = 1; i < ARRAY_SIZE(req); i++) {
+		broker_puback(publishes[i].message_id);
+		status_check(&req[i], CLOUD_SEND_STATUS_ACKED, 0);
+	}
+}
+
+static void test_disconnect(void)
+{
+	struct cloud_send_req req;
+
+	req_init(&req, "data", CLOUD_QOS_AT_LEAST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req), 0, "Send failed");
+	status_check(&req, CLOUD_SEND_STATUS_SENT, 0);
+
+	broker_evt_notify(CLOUD_EVT_DISCONNECTED);
+	status_check(&req, CLOUD_SEND_STATUS_FAILED, -ENOTCONN);
+
+	/* Late acknowledgments are ignored. */
+	broker_puback(publishes[0].message_id);
+	no_status_check();
+}
+
+static void test_ack_timeout(void)
+{
+	struct cloud_send_req req;
+
+	req_init(&req, "data", CLOUD_QOS_AT_LEAST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req), 0, "Send failed");
+	status_check(&req, CLOUD_SEND_STATUS_SENT, 0);
+	no_status_check();
+
+	k_sleep(K_SECONDS(CONFIG_CLOUD_API_ASYNC_SEND_ACK_TIMEOUT));
+	status_check(&req, CLOUD_SEND_STATUS_FAILED, -ETIMEDOUT);
+}
+
+static void test_send_error(void)
+{
+	struct cloud_send_req req[2];
+
+	publish_err = -EIO;
+
+	req_init(&req[0], "qos0", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+	req_init(&req[1], "qos1", CLOUD_QOS_AT_LEAST_ONCE, CLOUD_SEND_PRIO_NORMAL);
+
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req[0]), 0, "Send failed");
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req[1]), 0, "Send failed");
+
+	status_check(&req[0], CLOUD_SEND_STATUS_FAILED, -EIO);
+	status_check(&req[1], CLOUD_SEND_STATUS_FAILED, -EIO);
+	no_status_check();
+}
+
+static void test_invalid_params(void)
+{
+	struct cloud_send_req req;
+
+	req_init(&req, "data", CLOUD_QOS_AT_MOST_ONCE, CLOUD_SEND_PRIO_COUNT);
+
+	zassert_equal(cloud_send_async(NULL, &req), -ENOTSUP, "Should fail");
+	zassert_equal(cloud_send_async(&TEST_BROKER, NULL), -EINVAL, "Should fail");
+	zassert_equal(cloud_send_async(&TEST_BROKER, &req), -EINVAL, "Should fail");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cloud_send_async_test,
+			 ztest_unit_test_setup_teardown(test_send_qos0, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_send_qos1_ack, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_priority_order, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_backpressure, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_in_flight_max, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_disconnect, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_ack_timeout, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_send_error, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_invalid_params, setup, teardown)
+			 );
+	ztest_run_test_suite(cloud_send_async_test);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <ztest.h>
+#include <net/mqtt_topic_router.h>
+
+MQTT_TOPIC_ROUTER_DEFINE(router, 16);
+
+static int add(const char *filter, int route)
+{
+	return mqtt_topic_router_add(&router, filter, strlen(filter), route);
+}
+
+static int match(const char *topic)
+{
+	return mqtt_topic_router_match(&router, topic, strlen(topic));
+}
+
+static void setup(void)
+{
+	mqtt_topic_router_reset(&router);
+}
+
+static void test_exact(void)
+{
+	zassert_equal(add("$aws/things/dev/shadow/get/accepted", 0), 0, "Add failed");
+	zassert_equal(add("$aws/things/dev/shadow/get/rejected", 1), 0, "Add failed");
+	zassert_equal(add("$aws/things/dev/shadow/update/delta", 2), 0, "Add failed");
+	zassert_equal(add("dev/agps", 3), 0, "Add failed");
+
+	zassert_equal(match("$aws/things/dev/shadow/get/accepted"), 0, "Wrong route");
+	zassert_equal(match("$aws/things/dev/shadow/get/rejected"), 1, "Wrong route");
+	zassert_equal(match("$aws/things/dev/shadow/update/delta"), 2, "Wrong route");
+	zassert_equal(match("dev/agps"), 3, "Wrong route");
+
+	/* Prefixes and extensions of a filter do not match. */
+	zassert_equal(match("$aws/things/dev/shadow/get"), -ENOENT, "Should not match");
+	zassert_equal(match("$aws/things/dev/shadow/get/accepted/x"), -ENOENT,
+		      "Should not match");
+	zassert_equal(match("dev/agp"), -ENOENT, "Should not match");
+	zassert_equal(match("dev/agpsx"), -ENOENT, "Should not match");
+	zassert_equal(match(""), -ENOENT, "Should not match");
+}
+
+static void test_topic_not_terminated(void)
+{
+	const char topic[] = "dev/agps/get";
+
+	zassert_equal(add("dev/agps", 0), 0, "Add failed");
+	zassert_equal(mqtt_topic_router_match(&router, topic, strlen("dev/agps")), 0,
+		      "Wrong route");
+}
+
+static void test_single_level_wildcard(void)
+{
+	zassert_equal(add("$aws/things/dev/jobs/+/update/accepted", 0), 0, "Add failed");
+	zassert_equal(add("+/agps", 1), 0, "Add failed");
+
+	zassert_equal(match("$aws/things/dev/jobs/job-1/update/accepted"), 0, "Wrong route");
+	zassert_equal(match("$aws/things/dev/jobs//update/accepted"), 0, "Wrong route");
+	zassert_equal(match("$aws/things/dev/jobs/update/accepted"), -ENOENT,
+		      "Should not match");
+	zassert_equal(match("dev/agps"), 1, "Wrong route");
+	zassert_equal(match("dev/agps/x"), -ENOENT, "Should not match");
+}
+
+static void test_multi_level_wildcard(void)
+{
+	zassert_equal(add("dev/config/#", 0), 0, "Add failed");
+
+	zassert_equal(match("dev/config/a"), 0, "Wrong route");
+	zassert_equal(match("dev/config/a/b/c"), 0, "Wrong route");
+	/* The multi-level wildcard also matches the parent level. */
+	zassert_equal(match("dev/config"), 0, "Wrong route");
+	zassert_equal(match("dev/configx"), -ENOENT, "Should not match");
+
+	zassert_equal(add("#", 1), 0, "Add failed");
+	zassert_equal(match("other/topic"), 1, "Wrong route");
+}
+
+static void test_precedence(void)
+{
+	zassert_equal(add("dev/#", 0), 0, "Add failed");
+	zassert_equal(add("dev/+/state", 1), 0, "Add failed");
+	zassert_equal(add("dev/shadow/state", 2), 0, "Add failed");
+
+	zassert_equal(match("dev/shadow/state"), 2, "Exact level should be preferred");
+	zassert_equal(match("dev/other/state"), 1, "Single level should be preferred");
+	zassert_equal(match("dev/shadow/other"), 0, "Should fall back to multi level");
+}
+
+static void test_dollar_topics(void)
+{
+	zassert_equal(add("#", 0), 0, "Add failed");
+	zassert_equal(add("+/things/dev", 1), 0, "Add failed");
+	zassert_equal(add("$aws/#", 2), 0, "Add failed");
+
+	zassert_equal(match("$SYS/broker"), -ENOENT, "Should not match");
+	zassert_equal(match("$aws/things/dev"), 2, "Wrong route");
+	zassert_equal(match("aws/things/dev"), 1, "Wrong route");
+}
+
+static void test_invalid_filters(void)
+{
+	zassert_equal(add("dev/#/state", 0), -EINVAL, "'#' must be the last level");
+	zassert_equal(add("dev/a+", 0), -EINVAL, "'+' must be a whole level");
+	zassert_equal(add("dev/a#", 0), -EINVAL, "'#' must be a whole level");
+	zassert_equal(add("", 0), -EINVAL, "Empty filter");
+	zassert_equal(add("dev", -1), -EINVAL, "Negative route");
+	zassert_equal(mqtt_topic_router_match(&router, NULL, 0), -EINVAL, "NULL topic");
+
+	zassert_equal(add("dev/state", 0), 0, "Add failed");
+	zassert_equal(add("dev/state", 1), -EEXIST, "Duplicate filter");
+}
+
+static void test_no_memory(void)
+{
+	/* 16 levels fit, the 17th does not. */
+	zassert_equal(add("a/b/c/d/e/f/g/h", 0), 0, "Add failed");
+	zassert_equal(add("a/b/c/d/1/2/3/4/5/6/7/8", 1), 0, "Add failed");
+	zassert_equal(add("x", 2), -ENOMEM, "Router should be full");
+
+	/* Filters sharing all levels with added filters need no new nodes. */
+	zassert_equal(add("a/b/c/d", 3), 0, "Add failed");
+	zassert_equal(match("a/b/c/d"), 3, "Wrong route");
+	zassert_equal(match("a/b/c/d/1/2/3/4/5/6/7/8"), 1, "Wrong route");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_topic_router_test,
+			 ztest_unit_test_setup_teardown(test_exact, setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_topic_not_terminated, setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_single_level_wildcard, setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_multi_level_wildcard, setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_precedence, setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_dollar_topics, setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_invalid_filters, setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_no_memory, setup, unit_test_noop)
+			 );
+	ztest_run_test_suite(mqtt_topic_router_test);
+}
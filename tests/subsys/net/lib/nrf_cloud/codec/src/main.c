@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <cJSON.h>
+#include <cJSON_os.h>
+#include <nrf_cloud_codec.h>
+#include <nrf_cloud_mem.h>
+#include <nrf_cloud_fsm.h>
+#include <nrf_cloud_transport.h>
+
+#define TOPIC_TX	"prod/1234/m/d/nrf-352656100000000/d2c"
+#define TOPIC_RX	"prod/1234/m/d/nrf-352656100000000/c2d"
+#define TOPIC_PREFIX	"prod/1234/m/"
+#define KEEPALIVE	1200
+
+/* Dependencies of the codec that are not part of this test. */
+void nct_dc_endpoint_get(struct nrf_cloud_data *tx_endpoint,
+			 struct nrf_cloud_data *rx_endpoint,
+			 struct nrf_cloud_data *bulk_endpoint,
+			 struct nrf_cloud_data *m_endpoint)
+{
+	tx_endpoint->ptr = TOPIC_TX;
+	tx_endpoint->len = strlen(TOPIC_TX);
+	rx_endpoint->ptr = TOPIC_RX;
+	rx_endpoint->len = strlen(TOPIC_RX);
+	if (bulk_endpoint) {
+		bulk_endpoint->ptr = NULL;
+		bulk_endpoint->len = 0;
+	}
+	if (m_endpoint) {
+		m_endpoint->ptr = TOPIC_PREFIX;
+		m_endpoint->len = strlen(TOPIC_PREFIX);
+	}
+}
+
+int nct_dc_send(const struct nct_dc_data *dc)
+{
+	return -ENOTSUP;
+}
+
+void nct_set_topic_prefix(const char *topic_prefix)
+{
+}
+
+enum nfsm_state nfsm_get_current_state(void)
+{
+	return STATE_IDLE;
+}
+
+int modem_info_init(void)
+{
+	return -ENOTSUP;
+}
+
+int modem_info_params_init(struct modem_param_info *modem_param)
+{
+	return -ENOTSUP;
+}
+
+int modem_info_params_get(struct modem_param_info *modem_param)
+{
+	return -ENOTSUP;
+}
+
+/* Reference encoders, built with cJSON the way the codec did before it was
+ * converted to the streaming JSON writer. The output of the converted
+ * encoders must match these byte for byte.
+ */
+static char *ref_sensor_data(const char *app_id, const char *data)
+{
+	cJSON *root_obj = cJSON_CreateObject();
+	char *out;
+
+	cJSON_AddStringToObjectCS(root_obj, "appId", app_id);
+	cJSON_AddStringToObjectCS(root_obj, "data", data);
+	cJSON_AddStringToObjectCS(root_obj, "messageType", "DATA");
+
+	out = cJSON_PrintUnformatted(root_obj);
+	cJSON_Delete(root_obj);
+
+	return out;
+}
+
+static char *ref_state(uint32_t reported_state)
+{
+	cJSON *root_obj = cJSON_CreateObject();
+	cJSON *state_obj = cJSON_AddObjectToObjectCS(root_obj, "state");
+	cJSON *reported_obj = cJSON_AddObjectToObjectCS(state_obj, "reported");
+	cJSON *pairing_obj = cJSON_AddObjectToObjectCS(reported_obj, "pairing");
+	cJSON *connection_obj = cJSON_AddObjectToObjectCS(reported_obj, "connection");
+	cJSON *topics_obj;
+	char *out;
+
+	if (reported_state == STATE_UA_PIN_WAIT) {
+		cJSON_AddStringToObjectCS(pairing_obj, "state", "not_associated");
+		cJSON_AddNullToObjectCS(pairing_obj, "topics");
+		cJSON_AddNullToObjectCS(pairing_obj, "config");
+		cJSON_AddNullToObjectCS(reported_obj, "stage");
+		cJSON_AddNullToObjectCS(reported_obj, "nrfcloud_mqtt_topic_prefix");
+		cJSON_AddNullToObjectCS(connection_obj, "keepalive");
+	} else {
+		cJSON_AddStringToObjectCS(reported_obj, "nrfcloud_mqtt_topic_prefix",
+					  TOPIC_PREFIX);
+		cJSON_AddStringToObjectCS(pairing_obj, "state", "paired");
+		cJSON_AddNullToObjectCS(pairing_obj, "config");
+		cJSON_AddNullToObjectCS(reported_obj, "pairingStatus");
+		cJSON_AddNumberToObjectCS(connection_obj, "keepalive", KEEPALIVE);
+		topics_obj = cJSON_AddObjectToObjectCS(pairing_obj, "topics");
+		cJSON_AddStringToObjectCS(topics_obj, "d2c", TOPIC_TX);
+		cJSON_AddStringToObjectCS(topics_obj, "c2d", TOPIC_RX);
+	}
+
+	out = cJSON_PrintUnformatted(root_obj);
+	cJSON_Delete(root_obj);
+
+	return out;
+}
+
+static char *ref_cell_pos_req(struct lte_lc_cells_info const *const inf, size_t inf_cnt)
+{
+	cJSON *req_obj = cJSON_CreateObject();
+	char *out = NULL;
+
+	if (nrf_cloud_format_cell_pos_req_json(inf, inf_cnt, req_obj) == 0) {
+		out = cJSON_PrintUnformatted(req_obj);
+	}
+	cJSON_Delete(req_obj);
+
+	return out;
+}
+
+static void check_output(const char *ref, const char *out, size_t len)
+{
+	zassert_not_null(ref, "Reference output is NULL");
+	zassert_not_null(out, "Encoder output is NULL");
+	zassert_equal(strlen(out), len, "Length %zu does not match output", len);
+	zassert_equal(strcmp(ref, out), 0, "Output differs:\n%s\n%s", ref, out);
+}
+
+static void setup(void)
+{
+	nrf_cloud_codec_init();
+	zassert_ok(nrf_cloud_encoding_set(NRF_CLOUD_ENCODING_JSON), NULL);
+}
+
+static void test_sensor_data(void)
+{
+	static const struct {
+		enum nrf_cloud_sensor type;
+		const char *app_id;
+		const char *data;
+	} sensors[] = {
+		{ NRF_CLOUD_SENSOR_TEMP, "TEMP", "21.5" },
+		{ NRF_CLOUD_SENSOR_GPS, "GPS",
+		  "$GPGGA,181908.00,6325.6414,N,01023.3520,E,1,06,1.5,58.9,M,39.5,M,,*6C" },
+		{ NRF_CLOUD_SENSOR_BUTTON, "BUTTON", "\"quoted\"\\\t\n" },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		struct nrf_cloud_sensor_data sensor = {
+			.type = sensors[i].type,
+			.data.ptr = sensors[i].data,
+			.data.len = strlen(sensors[i].data),
+		};
+		struct nrf_cloud_data output;
+		char *ref = ref_sensor_data(sensors[i].app_id, sensors[i].data);
+
+		zassert_ok(nrf_cloud_encode_sensor_data(&sensor, &output), NULL);
+		check_output(ref, output.ptr, output.len);
+
+		cJSON_free(ref);
+		nrf_cloud_free((void *)output.ptr);
+	}
+}
+
+static void test_state(void)
+{
+	static const uint32_t states[] = {
+		STATE_UA_PIN_WAIT,
+		STATE_UA_PIN_COMPLETE,
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(states); i++) {
+		struct nrf_cloud_data output;
+		char *ref = ref_state(states[i]);
+
+		zassert_ok(nrf_cloud_encode_state(states[i], &output), NULL);
+		check_output(ref, output.ptr, output.len);
+
+		cJSON_free(ref);
+		nrf_cloud_free((void *)output.ptr);
+	}
+
+	zassert_equal(nrf_cloud_encode_state(STATE_IDLE, &(struct nrf_cloud_data){0}),
+		      -ENOTSUP, NULL);
+}
+
+static void test_cell_pos_req(void)
+{
+	struct lte_lc_ncell ncells[] = {
+		{ .earfcn = 6400, .phys_cell_id = 301, .rsrp = 40, .rsrq = 12 },
+		{ .earfcn = 6400, .phys_cell_id = 302,
+		  .rsrp = NRF_CLOUD_CELL_POS_OMIT_RSRP,
+		  .rsrq = NRF_CLOUD_CELL_POS_OMIT_RSRQ },
+	};
+	struct lte_lc_cells_info cells[] = {
+		{
+			.current_cell = {
+				.mcc = 242, .mnc = 1, .id = 84485647, .tac = 2305,
+				.earfcn = 6400, .rsrp = 45, .rsrq = 17,
+				.timing_advance = 24,
+			},
+			.ncells_count = ARRAY_SIZE(ncells),
+			.neighbor_cells = ncells,
+		},
+		{
+			.current_cell = {
+				.mcc = 242, .mnc = 2, .id = 84485648, .tac = 2306,
+				.earfcn = NRF_CLOUD_CELL_POS_OMIT_EARFCN,
+				.rsrp = NRF_CLOUD_CELL_POS_OMIT_RSRP,
+				.rsrq = NRF_CLOUD_CELL_POS_OMIT_RSRQ,
+				.timing_advance = NRF_CLOUD_CELL_POS_OMIT_TIME_ADV,
+			},
+		},
+	};
+
+	for (size_t cnt = 1; cnt <= ARRAY_SIZE(cells); cnt++) {
+		char *out = NULL;
+		char *ref = ref_cell_pos_req(cells, cnt);
+
+		zassert_ok(nrf_cloud_format_cell_pos_req(cells, cnt, &out), NULL);
+		check_output(ref, out, out ? strlen(out) : 0);
+
+		cJSON_free(ref);
+		nrf_cloud_free(out);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_codec_test,
+			 ztest_unit_test_setup_teardown(test_sensor_data,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_state,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_cell_pos_req,
+							setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(nrf_cloud_codec_test);
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <limits.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <nrf_cloud_json_reader.h>
+#include <nrf_cloud_mem.h>
+
+#define VALUES_MAX	16
+
+struct values {
+	struct nrf_cloud_json_value val[VALUES_MAX];
+	size_t cnt;
+	int stop_at;
+};
+
+static int values_cb(const struct nrf_cloud_json_reader *r,
+		     const struct nrf_cloud_json_value *val, void *ctx)
+{
+	struct values *v = ctx;
+
+	zassert_true(v->cnt < VALUES_MAX, "Too many values");
+	v->val[v->cnt++] = *val;
+
+	return (v->stop_at && (v->cnt == v->stop_at)) ? -ECANCELED : 0;
+}
+
+static int parse(const char *str)
+{
+	return nrf_cloud_json_parse(str, strlen(str), NULL, NULL);
+}
+
+static void value_check(const struct nrf_cloud_json_value *val,
+			enum nrf_cloud_json_type type, const char *raw)
+{
+	zassert_equal(val->type, type, "Wrong type %d, expected %d", val->type, type);
+	zassert_equal(val->len, strlen(raw), "Wrong length");
+	zassert_mem_equal(val->ptr, raw, val->len, "Wrong value");
+}
+
+/* Parse a document holding one string member "s" and unescape it. */
+static void unescape_check(const char *doc, const char *expected)
+{
+	struct nrf_cloud_json_field field = { .path = "s" };
+	char *str;
+	size_t len;
+	int err;
+
+	err = nrf_cloud_json_extract(doc, strlen(doc), &field, 1);
+	zassert_equal(err, 0, "Parsing %s failed: %d", doc, err);
+	zassert_equal(field.val.type, NRF_CLOUD_JSON_STR, "String not found");
+
+	err = nrf_cloud_json_strdup(&field.val, &str, &len);
+	zassert_equal(err, 0, "Unescaping failed: %d", err);
+	zassert_equal(len, strlen(expected), "Wrong length of %s", doc);
+	zassert_mem_equal(str, expected, len + 1, "Wrong unescaped %s", doc);
+
+	nrf_cloud_free(str);
+}
+
+static void to_int_check(const char *num, int expected)
+{
+	struct nrf_cloud_json_value val = {
+		.type = NRF_CLOUD_JSON_NUM,
+		.ptr = num,
+		.len = strlen(num),
+	};
+	int out;
+
+	zassert_equal(nrf_cloud_json_to_int(&val, &out), 0, "Conversion failed");
+	zassert_equal(out, expected, "Wrong value %d for %s", out, num);
+}
+
+static void test_values(void)
+{
+	static const char doc[] =
+		" { \"a\" : -1.5e+3, \"b\": [true, false, null, []], \"c\": {\"d\": \"x\"}, "
+		"\"e\": {} } ";
+	struct values v = { 0 };
+
+	zassert_equal(nrf_cloud_json_parse(doc, sizeof(doc), values_cb, &v), 0,
+		      "Parsing failed");
+
+	/* Values are reported in the order in which they end. */
+	zassert_equal(v.cnt, 10, "Wrong number of values");
+	value_check(&v.val[0], NRF_CLOUD_JSON_NUM, "-1.5e+3");
+	value_check(&v.val[1], NRF_CLOUD_JSON_TRUE, "true");
+	value_check(&v.val[2], NRF_CLOUD_JSON_FALSE, "false");
+	value_check(&v.val[3], NRF_CLOUD_JSON_NULL, "null");
+	value_check(&v.val[4], NRF_CLOUD_JSON_ARR, "[]");
+	value_check(&v.val[5], NRF_CLOUD_JSON_ARR, "[true, false, null, []]");
+	value_check(&v.val[6], NRF_CLOUD_JSON_STR, "x");
+	value_check(&v.val[7], NRF_CLOUD_JSON_OBJ, "{\"d\": \"x\"}");
+	value_check(&v.val[8], NRF_CLOUD_JSON_OBJ, "{}");
+	zassert_equal(v.val[9].type, NRF_CLOUD_JSON_OBJ, "Root is not an object");
+	zassert_equal_ptr(v.val[9].ptr, &doc[1], "Wrong start of root");
+
+	/* Scalars are valid documents. */
+	zassert_equal(parse("0"), 0, "Number rejected");
+	zassert_equal(parse("\"\""), 0, "String rejected");
+	zassert_equal(parse(" null "), 0, "Literal rejected");
+}
+
+static void test_callback_stop(void)
+{
+	struct values v = { .stop_at = 2 };
+	const char *doc = "[1, 2, 3]";
+
+	zassert_equal(nrf_cloud_json_parse(doc, strlen(doc), values_cb, &v), -ECANCELED,
+		      "Callback error not returned");
+	zassert_equal(v.cnt, 2, "Parsing did not stop");
+}
+
+static void test_malformed(void)
+{
+	static const char * const docs[] = {
+		"",
+		"   ",
+		"{",
+		"}",
+		"[1 2]",
+		"{\"a\"}",
+		"{\"a\":}",
+		"{\"a\" 1}",
+		"{a:1}",
+		"{'a':1}",
+		"{1:1}",
+		"[1]]",
+		"{}{}",
+		"[1],",
+		"nul",
+		"True",
+		"+1",
+		"01",
+		"-",
+		"1.",
+		".5",
+		"1e",
+		"0x10",
+		"\"abc",
+		"\"\\x\"",
+		"\"\\u12G4\"",
+		"\"\\u12\"",
+		"[\"a\" \"b\"]",
+		"{\"a\":1 \"b\":2}",
+		"[,1]",
+		"{,}",
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(docs); i++) {
+		zassert_equal(parse(docs[i]), -EBADMSG, "Accepted: %s", docs[i]);
+	}
+
+	zassert_equal(nrf_cloud_json_parse(NULL, 0, NULL, NULL), -EINVAL,
+		      "NULL buffer accepted");
+}
+
+static void test_truncated(void)
+{
+	static const char doc[] =
+		"{\"state\":{\"reported\":{\"v\":[1,-2.5e3,\"s\\u00e9\",true,false,null]}}}";
+	int err;
+
+	zassert_equal(parse(doc), 0, "Complete document rejected");
+
+	for (size_t len = 0; len < strlen(doc); len++) {
+		err = nrf_cloud_json_parse(doc, len, NULL, NULL);
+		zassert_equal(err, -EBADMSG, "Accepted truncated to %d bytes", len);
+	}
+
+	/* Parsing stops at the first NULL character. */
+	zassert_equal(nrf_cloud_json_parse("[1]\0garbage", 11, NULL, NULL), 0,
+		      "Parsed past NULL character");
+	zassert_equal(nrf_cloud_json_parse("[1\0]", 4, NULL, NULL), -EBADMSG,
+		      "Parsed past NULL character");
+}
+
+static void test_depth_limit(void)
+{
+	char doc[2 * (NRF_CLOUD_JSON_READER_MAX_DEPTH + 1) + 1];
+	size_t depth;
+
+	for (depth = NRF_CLOUD_JSON_READER_MAX_DEPTH;
+	     depth <= NRF_CLOUD_JSON_READER_MAX_DEPTH + 1; depth++) {
+		memset(doc, '[', depth);
+		memset(&doc[depth], ']', depth);
+		doc[2 * depth] = '\0';
+
+		zassert_equal(parse(doc),
+			      (depth > NRF_CLOUD_JSON_READER_MAX_DEPTH) ? -E2BIG : 0,
+			      "Wrong result at depth %d", depth);
+	}
+
+	/* Objects and arrays count alike. */
+	zassert_equal(parse("{\"a\":[{\"b\":[{\"c\":[{\"d\":[{\"e\":[{\"f\":[{\"g\":[{\"h\":"
+			    "[{\"i\":1}]}]}]}]}]}]}]}]}"),
+		      -E2BIG, "Mixed nesting past the limit accepted");
+}
+
+static void test_escapes(void)
+{
+	unescape_check("{\"s\":\"plain\"}", "plain");
+	unescape_check("{\"s\":\"\"}", "");
+	unescape_check("{\"s\":\"a\\\"b\\\\c\\/d\"}", "a\"b\\c/d");
+	unescape_check("{\"s\":\"\\b\\f\\n\\r\\t\"}", "\b\f\n\r\t");
+	unescape_check("{\"s\":\"\\u0041\\u00e9\\u20AC\"}", "A\xc3\xa9\xe2\x82\xac");
+
+	/* Surrogate pairs are combined into one code point. */
+	unescape_check("{\"s\":\"\\ud83d\\ude00\"}", "\xf0\x9f\x98\x80");
+	unescape_check("{\"s\":\"x\\uD834\\uDD1Ey\"}", "x\xf0\x9d\x84\x9ey");
+
+	/* The escaped key is matched as is. */
+	struct nrf_cloud_json_field field = { .path = "s" };
+
+	zassert_equal(nrf_cloud_json_extract("{\"\\u0073\":1}", 12, &field, 1), 0,
+		      "Parsing failed");
+	zassert_equal(field.val.type, NRF_CLOUD_JSON_NONE, "Escaped key matched");
+}
+
+static void test_trailing_commas(void)
+{
+	static const char * const docs[] = {
+		"[1,]",
+		"[1, ]",
+		"{\"a\":1,}",
+		"{\"a\":1 , }",
+		"[1,,2]",
+		"{\"a\":[1,],\"b\":2}",
+		"{\"a\":{\"b\":1,},\"c\":2}",
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(docs); i++) {
+		zassert_equal(parse(docs[i]), -EBADMSG, "Accepted: %s", docs[i]);
+	}
+}
+
+static void test_path_match(void)
+{
+	static const char doc[] =
+		"{\"state\":{\"pairing\":{\"state\":\"paired\",\"topics\":{\"d2c\":\"t\"}},"
+		"\"config\":{\"x\":1}},\"arr\":[{\"state\":2}],\"statex\":3,\"state2\":4}";
+	struct nrf_cloud_json_field fields[] = {
+		{ .path = "state.pairing.state" },
+		{ .path = "state.pairing.topics.d2c" },
+		{ .path = "state.config" },
+		{ .path = "state" },
+		{ .path = "arr" },
+		{ .path = "arr.state" },
+		{ .path = "statex" },
+		{ .path = "state.pairing.state.more" },
+		{ .path = "stat" },
+		{ .path = "config.x" },
+	};
+	int err;
+
+	err = nrf_cloud_json_extract(doc, sizeof(doc), fields, ARRAY_SIZE(fields));
+	zassert_equal(err, 0, "Parsing failed: %d", err);
+
+	value_check(&fields[0].val, NRF_CLOUD_JSON_STR, "paired");
+	value_check(&fields[1].val, NRF_CLOUD_JSON_STR, "t");
+	value_check(&fields[2].val, NRF_CLOUD_JSON_OBJ, "{\"x\":1}");
+	zassert_equal(fields[3].val.type, NRF_CLOUD_JSON_OBJ, "Object not matched");
+	zassert_mem_equal(fields[3].val.ptr, "{\"pairing\"", 10, "Wrong object matched");
+	value_check(&fields[4].val, NRF_CLOUD_JSON_ARR, "[{\"state\":2}]");
+
+	/* Values inside arrays, longer or shorter paths and partial keys do not match. */
+	zassert_equal(fields[5].val.type, NRF_CLOUD_JSON_NONE, "Matched inside array");
+	value_check(&fields[6].val, NRF_CLOUD_JSON_NUM, "3");
+	zassert_equal(fields[7].val.type, NRF_CLOUD_JSON_NONE, "Longer path matched");
+	zassert_equal(fields[8].val.type, NRF_CLOUD_JSON_NONE, "Partial key matched");
+	zassert_equal(fields[9].val.type, NRF_CLOUD_JSON_NONE, "Path not from root matched");
+
+	/* String helpers */
+	zassert_true(nrf_cloud_json_str_eq(&fields[0].val, "paired"), "Not equal");
+	zassert_false(nrf_cloud_json_str_eq(&fields[0].val, "pair"), "Prefix is equal");
+	zassert_true(nrf_cloud_json_str_prefix(&fields[0].val, "pair"), "Not a prefix");
+	zassert_false(nrf_cloud_json_str_prefix(&fields[0].val, "paired!"),
+		      "Longer string is a prefix");
+	zassert_false(nrf_cloud_json_str_eq(&fields[6].val, "3"), "Number is a string");
+}
+
+static void test_to_int(void)
+{
+	struct nrf_cloud_json_value str = {
+		.type = NRF_CLOUD_JSON_STR,
+		.ptr = "1",
+		.len = 1,
+	};
+	int out;
+
+	to_int_check("42", 42);
+	to_int_check("-7", -7);
+	to_int_check("0", 0);
+	to_int_check("3.9", 3);
+	to_int_check("-3.9", -3);
+	to_int_check("1e3", 1000);
+	to_int_check("2147483647", INT_MAX);
+	to_int_check("-2147483648", INT_MIN);
+
+	/* Out of range values are clamped, as done by cJSON. */
+	to_int_check("2147483648", INT_MAX);
+	to_int_check("1e300", INT_MAX);
+	to_int_check("-2147483649", INT_MIN);
+	to_int_check("-1e300", INT_MIN);
+
+	zassert_equal(nrf_cloud_json_to_int(&str, &out), -EINVAL, "String converted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_json_reader_test,
+			 ztest_unit_test(test_values),
+			 ztest_unit_test(test_callback_stop),
+			 ztest_unit_test(test_malformed),
+			 ztest_unit_test(test_truncated),
+			 ztest_unit_test(test_depth_limit),
+			 ztest_unit_test(test_escapes),
+			 ztest_unit_test(test_trailing_commas),
+			 ztest_unit_test(test_path_match),
+			 ztest_unit_test(test_to_int)
+			 );
+
+	ztest_run_test_suite(nrf_cloud_json_reader_test);
+}
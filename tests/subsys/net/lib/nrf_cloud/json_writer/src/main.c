@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <nrf_cloud_json_writer.h>
+
+struct cell {
+	uint32_t eci;
+	uint16_t mcc;
+	uint16_t mnc;
+	uint16_t tac;
+	int16_t rsrp;
+	double rsrq;
+};
+
+static const struct cell cells[] = {
+	{ 84485647, 242, 1, 2305, -97, -10.5 },
+	{ 84485648, 242, 1, 2305, -105, -13.0 },
+	{ 84485649, 242, 1, 2305, -112, -16.5 },
+};
+
+static void sensor_temp_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_str(w, "appId", "TEMP");
+	nrf_cloud_json_writer_str(w, "data", "21.5");
+	nrf_cloud_json_writer_str(w, "messageType", "DATA");
+	nrf_cloud_json_writer_obj_end(w);
+}
+
+static void sensor_gps_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_str(w, "appId", "GPS");
+	nrf_cloud_json_writer_str(w, "data",
+		"$GPGGA,181908.00,6325.6414,N,01023.3520,E,1,06,1.5,58.9,M,39.5,M,,*6C");
+	nrf_cloud_json_writer_str(w, "messageType", "DATA");
+	nrf_cloud_json_writer_obj_end(w);
+}
+
+static void device_status_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_obj_start(w, "state");
+	nrf_cloud_json_writer_obj_start(w, "reported");
+	nrf_cloud_json_writer_obj_start(w, "device");
+	nrf_cloud_json_writer_obj_start(w, "networkInfo");
+	nrf_cloud_json_writer_str(w, "currentBand", "20");
+	nrf_cloud_json_writer_str(w, "networkMode", "LTE-M");
+	nrf_cloud_json_writer_num(w, "rsrp", -97);
+	nrf_cloud_json_writer_num(w, "areaCode", 2305);
+	nrf_cloud_json_writer_num(w, "mccmnc", 24201);
+	nrf_cloud_json_writer_num(w, "cellID", 84485647);
+	nrf_cloud_json_writer_str(w, "ipAddress", "10.160.33.51");
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_start(w, "simInfo");
+	nrf_cloud_json_writer_str(w, "uiccMode", "1");
+	nrf_cloud_json_writer_str(w, "iccid", "89450421180216216095");
+	nrf_cloud_json_writer_str(w, "imsi", "242016000941158");
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
+
+static void cell_pos_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_arr_start(w, "lte");
+
+	for (size_t i = 0; i < ARRAY_SIZE(cells); i++) {
+		nrf_cloud_json_writer_obj_start(w, NULL);
+		nrf_cloud_json_writer_num(w, "eci", cells[i].eci);
+		nrf_cloud_json_writer_num(w, "mcc", cells[i].mcc);
+		nrf_cloud_json_writer_num(w, "mnc", cells[i].mnc);
+		nrf_cloud_json_writer_num(w, "tac", cells[i].tac);
+		nrf_cloud_json_writer_num(w, "rsrp", cells[i].rsrp);
+		nrf_cloud_json_writer_num(w, "rsrq", cells[i].rsrq);
+		nrf_cloud_json_writer_obj_end(w);
+	}
+
+	nrf_cloud_json_writer_arr_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
+
+static void values_write(struct nrf_cloud_json_writer *w, const void *ctx)
+{
+	nrf_cloud_json_writer_obj_start(w, NULL);
+	nrf_cloud_json_writer_num(w, "i", 500);
+	nrf_cloud_json_writer_num(w, "n", -1);
+	nrf_cloud_json_writer_num(w, "f", -15.5);
+	nrf_cloud_json_writer_num(w, "d", 0.1);
+	nrf_cloud_json_writer_arr_start(w, "a");
+	nrf_cloud_json_writer_bool(w, NULL, true);
+	nrf_cloud_json_writer_bool(w, NULL, false);
+	nrf_cloud_json_writer_null(w, NULL);
+	nrf_cloud_json_writer_arr_end(w);
+	nrf_cloud_json_writer_obj_end(w);
+}
+
+static void test_json_output(void)
+{
+	char *out;
+	size_t len;
+	int ret;
+	const char expected[] =
+		"{\"i\":500,\"n\":-1,\"f\":-15.5,\"d\":0.1,\"a\":[true,false,null]}";
+
+	ret = nrf_cloud_json_encode_alloc(values_write, NULL, false, &out, &len);
+	zassert_equal(ret, 0, NULL);
+	zassert_equal(len, sizeof(expected) - 1, NULL);
+	zassert_true(!strcmp(out, expected), NULL);
+
+	k_free(out);
+}
+
+static void test_cbor_sensor_data(void)
+{
+	char *out;
+	size_t len;
+	int ret;
+	const uint8_t expected[] = {
+		0xbf,
+		0x65, 'a', 'p', 'p', 'I', 'd',
+		0x64, 'T', 'E', 'M', 'P',
+		0x64, 'd', 'a', 't', 'a',
+		0x64, '2', '1', '.', '5',
+		0x6b, 'm', 'e', 's', 's', 'a', 'g', 'e', 'T', 'y', 'p', 'e',
+		0x64, 'D', 'A', 'T', 'A',
+		0xff
+	};
+
+	ret = nrf_cloud_json_encode_alloc(sensor_temp_write, NULL, true, &out, &len);
+	zassert_equal(ret, 0, NULL);
+	zassert_equal(len, sizeof(expected), NULL);
+	zassert_mem_equal(out, expected, sizeof(expected), NULL);
+
+	k_free(out);
+}
+
+static void test_cbor_values(void)
+{
+	char *out;
+	size_t len;
+	int ret;
+	const uint8_t expected[] = {
+		0xbf,
+		0x61, 'i', 0x19, 0x01, 0xf4,
+		0x61, 'n', 0x20,
+		0x61, 'f', 0xfa, 0xc1, 0x78, 0x00, 0x00,
+		0x61, 'd', 0xfb, 0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a,
+		0x61, 'a', 0x9f, 0xf5, 0xf4, 0xf6, 0xff,
+		0xff
+	};
+
+	ret = nrf_cloud_json_encode_alloc(values_write, NULL, true, &out, &len);
+	zassert_equal(ret, 0, NULL);
+	zassert_equal(len, sizeof(expected), NULL);
+	zassert_mem_equal(out, expected, sizeof(expected), NULL);
+
+	k_free(out);
+}
+
+static void test_cbor_errors(void)
+{
+	struct nrf_cloud_json_writer w;
+	char buf[8];
+
+	nrf_cloud_json_writer_init_cbor(&w, NULL, 0);
+	for (int i = 0; i <= NRF_CLOUD_CBOR_MAX_DEPTH; i++) {
+		nrf_cloud_json_writer_arr_start(&w, NULL);
+	}
+	zassert_equal(nrf_cloud_json_writer_finish(&w), -E2BIG, NULL);
+
+	nrf_cloud_json_writer_init_cbor(&w, NULL, 0);
+	nrf_cloud_json_writer_obj_start(&w, NULL);
+	zassert_equal(nrf_cloud_json_writer_finish(&w), -EINVAL, NULL);
+
+	nrf_cloud_json_writer_init_cbor(&w, buf, sizeof(buf));
+	sensor_temp_write(&w, NULL);
+	zassert_equal(nrf_cloud_json_writer_finish(&w), -ENOBUFS, NULL);
+}
+
+/* Compare the size of representative messages in both encodings. */
+static void test_size_comparison(void)
+{
+	static const struct {
+		const char *name;
+		nrf_cloud_json_encode_fn fn;
+	} msgs[] = {
+		{ "sensor TEMP", sensor_temp_write },
+		{ "sensor GPS", sensor_gps_write },
+		{ "device status", device_status_write },
+		{ "cell position", cell_pos_write },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(msgs); i++) {
+		struct nrf_cloud_json_writer w;
+		int json_len;
+		int cbor_len;
+
+		nrf_cloud_json_writer_init(&w, NULL, 0);
+		msgs[i].fn(&w, NULL);
+		json_len = nrf_cloud_json_writer_finish(&w);
+
+		nrf_cloud_json_writer_init_cbor(&w, NULL, 0);
+		msgs[i].fn(&w, NULL);
+		cbor_len = nrf_cloud_json_writer_finish(&w);
+
+		zassert_true(json_len > 0, NULL);
+		zassert_true(cbor_len > 0, NULL);
+
+		TC_PRINT("%-14s JSON: %4d bytes, CBOR: %4d bytes (%d%%)\n",
+			 msgs[i].name, json_len, cbor_len,
+			 (100 * cbor_len) / json_len);
+
+		zassert_true(cbor_len < json_len, NULL);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_json_writer_test,
+			 ztest_unit_test(test_json_output),
+			 ztest_unit_test(test_cbor_sensor_data),
+			 ztest_unit_test(test_cbor_values),
+			 ztest_unit_test(test_cbor_errors),
+			 ztest_unit_test(test_size_comparison)
+			 );
+
+	ztest_run_test_suite(nrf_cloud_json_writer_test);
+}
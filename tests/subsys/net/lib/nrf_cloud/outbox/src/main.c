@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <nrf_cloud_outbox.h>
+
+#define MAX_MSGS	CONFIG_NRF_CLOUD_OUTBOX_MAX_MSGS
+#define WINDOW		CONFIG_NRF_CLOUD_OUTBOX_INFLIGHT_MAX
+#define COALESCE_MAX	CONFIG_NRF_CLOUD_OUTBOX_COALESCE_MAX_LEN
+
+#define PUBLISH_MAX	32
+#define USER_TAG	(NCT_MSG_ID_USER_TAG_BEGIN + 1)
+
+struct publish {
+	enum nct_outbox_topic topic;
+	uint16_t message_id;
+	bool dup;
+	bool acked;
+	size_t len;
+	char data[COALESCE_MAX + 1];
+};
+
+static struct publish publishes[PUBLISH_MAX];
+static size_t publish_cnt;
+static uint16_t next_message_id = NCT_MSG_ID_INCREMENT_BEGIN;
+static int publish_err;
+
+int nct_outbox_publish(enum nct_outbox_topic topic, uint16_t *message_id, bool dup,
+		       const void *data, size_t len)
+{
+	struct publish *p;
+
+	if (publish_err) {
+		return publish_err;
+	}
+
+	zassert_true(publish_cnt < PUBLISH_MAX, "Too many publishes");
+	zassert_true(len <= COALESCE_MAX, "Message too long");
+
+	if (*message_id == NCT_MSG_ID_USE_NEXT_INCREMENT) {
+		*message_id = next_message_id++;
+	}
+
+	p = &publishes[publish_cnt++];
+	p->topic = topic;
+	p->message_id = *message_id;
+	p->dup = dup;
+	p->acked = false;
+	p->len = len;
+	memcpy(p->data, data, len);
+
+	return 0;
+}
+
+static int add(enum nct_outbox_topic topic, const char *str, uint16_t message_id)
+{
+	const struct nrf_cloud_data data = {
+		.ptr = str,
+		.len = strlen(str)
+	};
+
+	return nct_outbox_add(topic, &data, message_id);
+}
+
+static void ack(size_t index)
+{
+	zassert_true(index < publish_cnt, "No such publish");
+	zassert_true(nct_outbox_ack(publishes[index].message_id), "Ack not matched");
+	publishes[index].acked = true;
+}
+
+static void publish_check(size_t index, const char *str, bool dup)
+{
+	zassert_true(index < publish_cnt, "Message not published");
+	zassert_equal(publishes[index].len, strlen(str), "Wrong length");
+	zassert_mem_equal(publishes[index].data, str, strlen(str), "Wrong payload");
+	zassert_equal(publishes[index].dup, dup, "Wrong DUP flag");
+}
+
+/* Acknowledge everything, so that each test starts with an empty outbox. */
+static void outbox_drain(void)
+{
+	publish_err = 0;
+	nct_outbox_connected();
+
+	for (size_t i = 0; i < publish_cnt; i++) {
+		if (!publishes[i].acked) {
+			ack(i);
+		}
+	}
+
+	nct_outbox_disconnected();
+	memset(publishes, 0, sizeof(publishes));
+	publish_cnt = 0;
+}
+
+static void test_queue_offline(void)
+{
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "a", 0), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "b", 0), 0, "Add failed");
+	zassert_equal(publish_cnt, 0, "Published while offline");
+
+	nct_outbox_connected();
+	zassert_equal(publish_cnt, 2, "Queue not published on connect");
+	publish_check(0, "a", false);
+	publish_check(1, "b", false);
+
+	outbox_drain();
+}
+
+static void test_window(void)
+{
+	nct_outbox_connected();
+
+	for (int i = 0; i < WINDOW + 2; i++) {
+		zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), 0, "Add failed");
+	}
+
+	zassert_equal(publish_cnt, WINDOW, "Window not respected");
+
+	/* Unknown message IDs are not handled by the outbox. */
+	zassert_false(nct_outbox_ack(USER_TAG + 100), "Unknown ack matched");
+	zassert_equal(publish_cnt, WINDOW, "Published on unknown ack");
+
+	ack(0);
+	zassert_equal(publish_cnt, WINDOW + 1, "Not published on ack");
+	ack(1);
+	zassert_equal(publish_cnt, WINDOW + 2, "Not published on ack");
+
+	outbox_drain();
+}
+
+static void test_full(void)
+{
+	for (int i = 0; i < MAX_MSGS; i++) {
+		zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), 0, "Add failed");
+	}
+
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), -ENOBUFS, "Outbox not full");
+
+	nct_outbox_connected();
+	ack(0);
+
+	/* Slots are released when the message is acknowledged. */
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), 0, "Slot not released");
+
+	outbox_drain();
+}
+
+static void test_resend_after_disconnect(void)
+{
+	nct_outbox_connected();
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "{\"a\":1}", USER_TAG), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "{\"b\":2}", 0), 0, "Add failed");
+	zassert_equal(publish_cnt, 2, "Not published");
+	publish_check(0, "{\"a\":1}", false);
+	zassert_equal(publishes[0].message_id, USER_TAG, "Requested ID not used");
+
+	nct_outbox_disconnected();
+	nct_outbox_connected();
+
+	/* Resent with the same message IDs and the DUP flag, never coalesced. */
+	zassert_equal(publish_cnt, 4, "Not resent");
+	publish_check(2, "{\"a\":1}", true);
+	publish_check(3, "{\"b\":2}", true);
+	zassert_equal(publishes[2].message_id, publishes[0].message_id, "ID changed");
+	zassert_equal(publishes[3].message_id, publishes[1].message_id, "ID changed");
+
+	ack(2);
+	ack(3);
+	zassert_false(nct_outbox_ack(publishes[0].message_id), "Released twice");
+	publishes[0].acked = true;
+	publishes[1].acked = true;
+
+	outbox_drain();
+}
+
+static void test_publish_error(void)
+{
+	nct_outbox_connected();
+
+	publish_err = -EAGAIN;
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), 0, "Add failed");
+	zassert_equal(publish_cnt, 0, "Published");
+
+	/* The message is kept and published with the next one. */
+	publish_err = 0;
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "y", 0), 0, "Add failed");
+	zassert_equal(publish_cnt, 2, "Kept message not published");
+	publish_check(0, "x", false);
+	publish_check(1, "y", false);
+
+	outbox_drain();
+}
+
+static void test_coalesce(void)
+{
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "{\"a\":1}", 0), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_BULK, "[{\"b\":2},{\"c\":3}]", 0), 0, "Add failed");
+	/* Not JSON, not coalesced. */
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "x", 0), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "{\"d\":4}", 0), 0, "Add failed");
+	/* Requested message ID, not coalesced. */
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "{\"e\":5}", USER_TAG), 0, "Add failed");
+
+	nct_outbox_connected();
+	zassert_equal(publish_cnt, 2, "Window not respected");
+	zassert_equal(publishes[0].topic, NCT_OUTBOX_TOPIC_BULK, "Not sent on bulk topic");
+	publish_check(0, "[{\"a\":1},{\"b\":2},{\"c\":3}]", false);
+	publish_check(1, "x", false);
+
+	ack(0);
+	ack(1);
+	zassert_equal(publish_cnt, 4, "Queue not published");
+	zassert_equal(publishes[2].topic, NCT_OUTBOX_TOPIC_DC, "Single message coalesced");
+	publish_check(2, "{\"d\":4}", false);
+	publish_check(3, "{\"e\":5}", false);
+	zassert_equal(publishes[3].message_id, USER_TAG, "Requested ID not used");
+
+	outbox_drain();
+}
+
+static void test_coalesce_max_len(void)
+{
+	/* 15 and 14 byte objects, merged with the brackets and the comma into
+	 * exactly COALESCE_MAX bytes.
+	 */
+	const char *obj_15 = "{\"a\":123456789}";
+	const char *obj_14 = "{\"a\":12345678}";
+
+	zassert_equal(1 + strlen(obj_15) + 1 + strlen(obj_14) + 1, COALESCE_MAX,
+		      "Test data does not match the configuration");
+
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, obj_15, 0), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, obj_14, 0), 0, "Add failed");
+	nct_outbox_connected();
+	zassert_equal(publish_cnt, 1, "Not coalesced");
+	zassert_equal(publishes[0].len, COALESCE_MAX, "Wrong length");
+	outbox_drain();
+
+	/* One byte more does not fit. */
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, obj_15, 0), 0, "Add failed");
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, obj_15, 0), 0, "Add failed");
+	nct_outbox_connected();
+	zassert_equal(publish_cnt, 2, "Coalesced above the maximum length");
+	publish_check(0, obj_15, false);
+	publish_check(1, obj_15, false);
+	outbox_drain();
+}
+
+struct stored_msg {
+	struct {
+		uint32_t seq;
+		uint16_t message_id;
+		uint8_t topic;
+		uint8_t flags;
+	} __packed rec;
+	char data[1];
+} __packed;
+
+static ssize_t stored_read(void *cb_arg, void *data, size_t len)
+{
+	memcpy(data, cb_arg, len);
+	return len;
+}
+
+static void test_settings_load(void)
+{
+	struct stored_msg msgs[] = {
+		{ .rec = { .seq = 7, .topic = NCT_OUTBOX_TOPIC_DC }, .data = "c" },
+		{ .rec = { .seq = 3, .topic = NCT_OUTBOX_TOPIC_DC }, .data = "a" },
+		{ .rec = { .seq = 5, .topic = NCT_OUTBOX_TOPIC_DC }, .data = "b" },
+	};
+
+	zassert_equal(nct_outbox_settings_set("4", sizeof(msgs[0]), stored_read, &msgs[0]), 0,
+		      "Load failed");
+	zassert_equal(nct_outbox_settings_set("0", sizeof(msgs[1]), stored_read, &msgs[1]), 0,
+		      "Load failed");
+	zassert_equal(nct_outbox_settings_set("2", sizeof(msgs[2]), stored_read, &msgs[2]), 0,
+		      "Load failed");
+
+	/* Invalid keys and records are rejected. */
+	zassert_equal(nct_outbox_settings_set("x", sizeof(msgs[0]), stored_read, &msgs[0]),
+		      -EINVAL, "Invalid key accepted");
+	zassert_equal(nct_outbox_settings_set("99", sizeof(msgs[0]), stored_read, &msgs[0]),
+		      -EINVAL, "Invalid slot accepted");
+	zassert_equal(nct_outbox_settings_set("1", 2, stored_read, &msgs[0]),
+		      -EINVAL, "Short record accepted");
+
+	/* New messages are sent after the stored ones. */
+	zassert_equal(add(NCT_OUTBOX_TOPIC_DC, "d", 0), 0, "Add failed");
+
+	nct_outbox_connected();
+	publish_check(0, "a", false);
+	publish_check(1, "b", false);
+	ack(0);
+	ack(1);
+	publish_check(2, "c", false);
+	publish_check(3, "d", false);
+
+	outbox_drain();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_outbox_test,
+			 ztest_unit_test(test_queue_offline),
+			 ztest_unit_test(test_window),
+			 ztest_unit_test(test_full),
+			 ztest_unit_test(test_resend_after_disconnect),
+			 ztest_unit_test(test_publish_error),
+			 ztest_unit_test(test_coalesce),
+			 ztest_unit_test(test_coalesce_max_len),
+			 ztest_unit_test(test_settings_load)
+			 );
+
+	ztest_run_test_suite(nrf_cloud_outbox_test);
+}
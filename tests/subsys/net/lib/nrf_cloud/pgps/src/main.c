@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <storage/stream_flash.h>
+#include <net/nrf_cloud_agps.h>
+#include <net/nrf_cloud_pgps.h>
+#include <nrf_cloud_pgps_schema_v1.h>
+#include <nrf_cloud_pgps_utils.h>
+#include <nrf_cloud_codec.h>
+
+#define PERIOD_MIN	CONFIG_NRF_CLOUD_PGPS_PREDICTION_PERIOD
+#define PERIOD_SEC	(PERIOD_MIN * SEC_PER_MIN)
+#define START_DAY	15000
+#define START_TIME	(2 * SEC_PER_HOUR)
+#define CUR_PNUM	2
+
+static uint8_t storage[NUM_BLOCKS * BLOCK_SIZE] __aligned(4);
+static struct nrf_cloud_pgps_header saved_header;
+static struct npgps_index saved_index;
+static struct gps_location saved_location;
+static int64_t now_sec;
+
+static struct {
+	int first_free;
+	bool used[NUM_BLOCKS];
+} pool;
+
+static struct {
+	int init;
+	int request;
+	int ready;
+	int unavailable;
+	struct gps_pgps_request last_request;
+} events;
+
+/* Storage, settings, time and download fakes for nrf_cloud_pgps_utils.c */
+
+int npgps_save_header(struct nrf_cloud_pgps_header *header)
+{
+	memcpy(&saved_header, header, sizeof(saved_header));
+	return 0;
+}
+
+const struct nrf_cloud_pgps_header *npgps_get_saved_header(void)
+{
+	return &saved_header;
+}
+
+int npgps_save_index(const struct npgps_index *idx)
+{
+	memcpy(&saved_index, idx, sizeof(saved_index));
+	return 0;
+}
+
+const struct npgps_index *npgps_get_saved_index(void)
+{
+	return &saved_index;
+}
+
+const struct gps_location *npgps_get_saved_location(void)
+{
+	return &saved_location;
+}
+
+int npgps_settings_init(void)
+{
+	return 0;
+}
+
+int64_t npgps_gps_day_time_to_sec(uint16_t gps_day, uint32_t gps_time_of_day)
+{
+	return (int64_t)gps_day * SEC_PER_DAY + gps_time_of_day;
+}
+
+void npgps_gps_sec_to_day_time(int64_t gps_sec, uint16_t *gps_day, uint32_t *gps_time_of_day)
+{
+	if (gps_day) {
+		*gps_day = (uint16_t)(gps_sec / SEC_PER_DAY);
+	}
+	if (gps_time_of_day) {
+		*gps_time_of_day = (uint32_t)(gps_sec % SEC_PER_DAY);
+	}
+}
+
+/* The shift is ignored; now_sec is the shifted time the library looks up. */
+int npgps_get_shifted_time(int64_t *gps_sec, uint16_t *gps_day, uint32_t *gps_time_of_day,
+			   uint32_t shift)
+{
+	ARG_UNUSED(shift);
+
+	npgps_gps_sec_to_day_time(now_sec, gps_day, gps_time_of_day);
+	if (gps_sec) {
+		*gps_sec = now_sec;
+	}
+	return 0;
+}
+
+int npgps_get_time(int64_t *gps_sec, uint16_t *gps_day, uint32_t *gps_time_of_day)
+{
+	return npgps_get_shifted_time(gps_sec, gps_day, gps_time_of_day, 0);
+}
+
+int ngps_block_pool_init(uint32_t base_address, int num)
+{
+	zassert_equal(base_address, (uint32_t)storage, "Unexpected storage");
+	zassert_equal(num, NUM_BLOCKS, "Unexpected block count");
+	return 0;
+}
+
+int npgps_alloc_block(void)
+{
+	int block = pool.first_free;
+
+	if (block == NO_BLOCK) {
+		return NO_BLOCK;
+	}
+	pool.used[block] = true;
+	pool.first_free = (block + 1) % NUM_BLOCKS;
+	if (pool.used[pool.first_free]) {
+		pool.first_free = NO_BLOCK;
+	}
+	return block;
+}
+
+void npgps_free_block(int block)
+{
+	if (pool.first_free == NO_BLOCK) {
+		pool.first_free = block;
+	}
+	pool.used[block] = false;
+}
+
+int npgps_get_block_extent(int block)
+{
+	int len = 0;
+
+	while ((len < NUM_BLOCKS) && !pool.used[block]) {
+		block = (block + 1) % NUM_BLOCKS;
+		len++;
+	}
+	return len;
+}
+
+void npgps_reset_block_pool(void)
+{
+	memset(pool.used, 0, sizeof(pool.used));
+	pool.first_free = 0;
+}
+
+void npgps_mark_block_used(int block, bool used)
+{
+	pool.used[block] = used;
+}
+
+void npgps_print_blocks(void)
+{
+}
+
+int npgps_num_free(void)
+{
+	int num = 0;
+	int i;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		num += pool.used[i] ? 0 : 1;
+	}
+	return num;
+}
+
+int npgps_find_first_free(int from_block)
+{
+	int i;
+
+	pool.first_free = NO_BLOCK;
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (!pool.used[from_block]) {
+			pool.first_free = from_block;
+			break;
+		}
+		from_block = (from_block + 1) % NUM_BLOCKS;
+	}
+	return pool.first_free;
+}
+
+int npgps_offset_to_block(uint32_t offset)
+{
+	return offset / BLOCK_SIZE;
+}
+
+uint32_t npgps_block_to_offset(int block)
+{
+	return block * BLOCK_SIZE;
+}
+
+int npgps_pointer_to_block(uint8_t *p)
+{
+	if ((p < storage) || (p >= &storage[sizeof(storage)])) {
+		return NO_BLOCK;
+	}
+	return (p - storage) / BLOCK_SIZE;
+}
+
+void *npgps_block_to_pointer(int block)
+{
+	return &storage[block * BLOCK_SIZE];
+}
+
+int npgps_download_init(npgps_buffer_handler_t handler)
+{
+	return 0;
+}
+
+int npgps_download_start(const char *host, const char *file, int sec_tag,
+			 uint8_t pdn_id, size_t fragment_size)
+{
+	return -ENOTSUP;
+}
+
+/* Not exercised: only used when predictions are downloaded or injected */
+
+int nrf_cloud_agps_process(const char *buf, size_t buf_len)
+{
+	return -ENOTSUP;
+}
+
+void nrf_cloud_agps_processed(struct nrf_modem_gnss_agps_data_frame *received_elements)
+{
+}
+
+int nrf_cloud_parse_pgps_response(const char *const response,
+				  struct nrf_cloud_pgps_result *const result)
+{
+	return -ENOTSUP;
+}
+
+int stream_flash_init(struct stream_flash_ctx *ctx, const struct device *fdev,
+		      uint8_t *buf, size_t buf_len, size_t offset, size_t size,
+		      stream_flash_callback_t cb)
+{
+	return -ENOTSUP;
+}
+
+int stream_flash_buffered_write(struct stream_flash_ctx *ctx, const uint8_t *data,
+				size_t len, bool flush)
+{
+	return -ENOTSUP;
+}
+
+static void pgps_event_handler(struct nrf_cloud_pgps_event *event)
+{
+	switch (event->type) {
+	case PGPS_EVT_INIT:
+		events.init++;
+		break;
+	case PGPS_EVT_UNAVAILABLE:
+		events.unavailable++;
+		break;
+	case PGPS_EVT_REQUEST:
+		events.request++;
+		memcpy(&events.last_request, event->request, sizeof(events.last_request));
+		break;
+	case PGPS_EVT_READY:
+		events.ready++;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Store a full set of predictions in reverse block order, with an index
+ * matching the saved header, so that the library trusts the index.
+ */
+static void store_predictions(void)
+{
+	struct nrf_cloud_pgps_prediction *pred;
+	int64_t start_sec = npgps_gps_day_time_to_sec(START_DAY, START_TIME);
+	int pnum;
+	int block;
+
+	memset(storage, 0xFF, sizeof(storage));
+	memset(&events, 0, sizeof(events));
+
+	saved_header = (struct nrf_cloud_pgps_header) {
+		.schema_version = NRF_CLOUD_PGPS_BIN_SCHEMA_VERSION,
+		.array_type = NRF_CLOUD_PGPS_PREDICTION_HEADER,
+		.num_items = 1,
+		.prediction_count = NUM_PREDICTIONS,
+		.prediction_size = sizeof(struct nrf_cloud_pgps_prediction),
+		.prediction_period_min = PERIOD_MIN,
+		.gps_day = START_DAY,
+		.gps_time_of_day = START_TIME,
+	};
+	saved_index = (struct npgps_index) {
+		.gps_day = START_DAY,
+		.gps_time_of_day = START_TIME,
+		.prediction_count = NUM_PREDICTIONS,
+	};
+
+	for (pnum = 0; pnum < NUM_PREDICTIONS; pnum++) {
+		block = NUM_BLOCKS - 1 - pnum;
+		pred = npgps_block_to_pointer(block);
+		memset(pred, 0, sizeof(*pred));
+		pred->time_type = NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK;
+		pred->time_count = 1;
+		npgps_gps_sec_to_day_time(start_sec + pnum * PERIOD_SEC,
+					  &pred->time.date_day, &pred->time.time_full_s);
+		pred->schema_version = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+		pred->ephemeris_type = NRF_CLOUD_AGPS_EPHEMERIDES;
+		pred->ephemeris_count = NRF_CLOUD_PGPS_NUM_SV;
+		pred->sentinel = (uint32_t)(start_sec + pnum * PERIOD_SEC);
+		saved_index.block[pnum] = block;
+	}
+
+	/* in the middle of the current prediction */
+	now_sec = start_sec + CUR_PNUM * PERIOD_SEC + PERIOD_SEC / 2;
+}
+
+static int pgps_init(void)
+{
+	struct nrf_cloud_pgps_init_param param = {
+		.event_handler = pgps_event_handler,
+		.storage_base = (uint32_t)storage,
+		.storage_size = sizeof(storage),
+	};
+
+	return nrf_cloud_pgps_init(&param);
+}
+
+static void test_indexed_ready(void)
+{
+	struct nrf_cloud_pgps_prediction *pred;
+
+	store_predictions();
+
+	zassert_equal(pgps_init(), 0, "Init failed");
+	zassert_equal(events.init, 1, "No init event");
+	zassert_equal(events.ready, 1, "Stored predictions not used");
+	zassert_equal(events.request, 0, "Unexpected request");
+
+	zassert_equal(nrf_cloud_pgps_find_prediction(&pred), CUR_PNUM,
+		      "Wrong prediction");
+	zassert_equal_ptr(pred, npgps_block_to_pointer(NUM_BLOCKS - 1 - CUR_PNUM),
+			  "Wrong prediction block");
+}
+
+static void test_indexed_corrupt(void)
+{
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
+	int pnum;
+
+	store_predictions();
+
+	/* the block the index points to for the current prediction is erased */
+	memset(npgps_block_to_pointer(saved_index.block[CUR_PNUM]), 0xFF, BLOCK_SIZE);
+
+	zassert_equal(pgps_init(), 0, "Init failed");
+	zassert_equal(events.ready, 0, "Corrupted prediction reported ready");
+	zassert_equal(events.unavailable, 0, "Valid predictions discarded");
+	zassert_equal(events.request, 1, "Missing predictions not requested");
+
+	npgps_gps_sec_to_day_time(npgps_gps_day_time_to_sec(START_DAY, START_TIME) +
+				  CUR_PNUM * PERIOD_SEC, &gps_day, &gps_time_of_day);
+	zassert_equal(events.last_request.prediction_count, NUM_PREDICTIONS - CUR_PNUM,
+		      "Wrong request count");
+	zassert_equal(events.last_request.prediction_period_min, PERIOD_MIN,
+		      "Wrong request period");
+	zassert_equal(events.last_request.gps_day, gps_day, "Wrong request day");
+	zassert_equal(events.last_request.gps_time_of_day, gps_time_of_day,
+		      "Wrong request time");
+
+	/* the dropped predictions are no longer indexed and their blocks are free */
+	for (pnum = 0; pnum < NUM_PREDICTIONS; pnum++) {
+		if (pnum < CUR_PNUM) {
+			zassert_equal(saved_index.block[pnum], NUM_BLOCKS - 1 - pnum,
+				      "Valid prediction %d dropped", pnum);
+		} else {
+			zassert_equal(saved_index.block[pnum], INDEX_NO_BLOCK,
+				      "Prediction %d still indexed", pnum);
+		}
+	}
+	zassert_equal(npgps_num_free(), NUM_PREDICTIONS - CUR_PNUM, "Blocks not freed");
+
+	nrf_cloud_pgps_request_reset();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_pgps_test,
+			 ztest_unit_test(test_indexed_ready),
+			 ztest_unit_test(test_indexed_corrupt)
+			 );
+
+	ztest_run_test_suite(nrf_cloud_pgps_test);
+}